@@ -0,0 +1,31 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 vertexColor;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) flat in uint bindlessHandle;
+layout(location = 0) out vec4 fragColor;
+
+layout(push_constant) uniform DrawParams{
+    vec4 offsetDepth;
+    uint shadingIterations;
+} params;
+
+//全局 bindless 描述符集 (src/bindless.hpp)  按实例的句柄索引 同一次绘制内句柄不同 需要 nonuniformEXT
+layout(set = 0 , binding = 0) uniform sampler2D textures[];
+
+layout(std430 , set = 0 , binding = 1) readonly buffer MaterialBuffer{
+    vec4 tint;
+} buffers[];
+
+void main(){
+    uint textureHandle = bindlessHandle & 0xFFFu;
+    uint bufferHandle = bindlessHandle >> 12;
+    vec3 color = texture(textures[nonuniformEXT(textureHandle)] , texCoord).rgb
+        * buffers[nonuniformEXT(bufferHandle)].tint.rgb;
+    for(uint i = 0 ; i < params.shadingIterations ; i++){
+        color = abs(sin(color * 1.0001 + 0.0001));
+    }
+    fragColor = vec4(color ,1.0);
+}
@@ -0,0 +1,46 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//实例属性 每个属性一个独立的流(binding)
+layout(location = 0) in vec4 instanceTransform;//xy 位置  z 深度  w 缩放
+layout(location = 1) in vec4 instanceColor;
+layout(location = 2) in vec2 instanceCustom;//x 旋转角度  y 自定义 (材质2: bindless 句柄)
+
+layout(location = 0) out vec3 vertexColor;
+layout(location = 1) out vec2 texCoord;
+layout(location = 2) flat out uint bindlessHandle;//低12位 纹理  高12位 材质buffer
+
+layout(push_constant) uniform DrawParams{
+    vec4 offsetDepth;//xy 整体偏移  w 缩放
+    uint shadingIterations;
+} params;
+
+//材质  0: 网格顶点颜色  1: 实例颜色  2: bindless 纹理 x 材质buffer (shaders/bindless.frag)
+layout(constant_id = 0) const int MATERIAL = 0;
+
+invariant gl_Position;
+
+//内置网格 (与 src/instancing.hpp 中的 MeshRange 对应)
+//网格0 三角形 顶点0-2  网格1 四边形 顶点3-8
+vec2 positions[9] = vec2[](
+    vec2(0.0 , -0.5),vec2(0.5 , 0.5),vec2(-0.5 , 0.5),
+    vec2(-0.5 , -0.5),vec2(0.5 , -0.5),vec2(0.5 , 0.5),
+    vec2(-0.5 , -0.5),vec2(0.5 , 0.5),vec2(-0.5 , 0.5)
+);
+
+vec3 colors[9] = vec3[](
+    vec3(1.0 , 0.0 , 0.0),vec3(0.0 , 1.0 , 0.0),vec3(0.0 , 0.0 , 1.0),
+    vec3(1.0 , 1.0 , 0.0),vec3(0.0 , 1.0 , 1.0),vec3(1.0 , 0.0 , 1.0),
+    vec3(1.0 , 1.0 , 0.0),vec3(1.0 , 0.0 , 1.0),vec3(0.5 , 0.5 , 0.5)
+);
+
+void main(){
+    float c = cos(instanceCustom.x);
+    float s = sin(instanceCustom.x);
+    vec2 local = positions[gl_VertexIndex] * instanceTransform.w;
+    vec2 rotated = vec2(local.x * c - local.y * s , local.x * s + local.y * c);
+    gl_Position = vec4((rotated + instanceTransform.xy + params.offsetDepth.xy) * params.offsetDepth.w , instanceTransform.z , 1.0);
+    vertexColor = MATERIAL == 0 ? colors[gl_VertexIndex] : instanceColor.rgb;
+    texCoord = positions[gl_VertexIndex] + 0.5;
+    bindlessHandle = uint(instanceCustom.y);
+}
@@ -4,6 +4,15 @@
 layout(location = 0) in vec3 vertexColor;
 layout(location = 0) out vec4 fragColor;
 
+layout(push_constant) uniform DrawParams{
+    vec4 offsetDepth;
+    uint shadingIterations;
+} params;
+
 void main(){
-    fragColor = vec4(vertexColor ,1.0);
+    vec3 color = vertexColor;
+    for(uint i = 0 ; i < params.shadingIterations ; i++){
+        color = abs(sin(color * 1.0001 + 0.0001));
+    }
+    fragColor = vec4(color ,1.0);
 }
@@ -3,6 +3,26 @@
 
 layout(location = 0) out vec3 vertexColor;
 
+//每次绘制的参数
+layout(push_constant) uniform DrawParams{
+    vec4 offsetDepth;//xy 偏移  z 深度  w 缩放
+    uint shadingIterations;//片元着色器的额外计算量 用于模拟复杂着色
+    uint gridColumns;//非 0 时实例在屏幕上按 gridColumns 列的网格排列 (光栅化基准测试)
+} params;
+
+//特化常量 为 true 时顶点参数从动态 uniform 读取 (src/per_draw_data.hpp)  片元着色器仍使用 push constant
+layout(constant_id = 0) const bool UNIFORM_PARAMS = false;
+
+//与 DrawParams 布局相同  较大的每次绘制数据放在其后
+layout(set = 0 , binding = 0) uniform UniformDrawParams{
+    vec4 offsetDepth;
+    uint shadingIterations;
+    uint gridColumns;
+} uniformParams;
+
+//深度预处理与主pass 需要得到完全相同的深度值
+invariant gl_Position;
+
 vec2 positions[3] = vec2[](
     vec2(0.0 , -0.5),vec2(0.5 , 0.5),vec2(-0.5 , 0.5)
 );
@@ -14,6 +34,15 @@ vec3 colors[3] = vec3[](
 );
 
 void main(){
-    gl_Position = vec4(positions[gl_VertexIndex] , 0.0 , 1.0);
+    vec4 offsetDepth = UNIFORM_PARAMS ? uniformParams.offsetDepth : params.offsetDepth;
+    uint columns = UNIFORM_PARAMS ? uniformParams.gridColumns : params.gridColumns;
+    vec2 offset = offsetDepth.xy;
+    //每个格子放一个三角形 一屏放满后从头重叠
+    if(columns > 0){
+        float pitch = 2.0 / float(columns);
+        uint cell = uint(gl_InstanceIndex) % (columns * columns);
+        offset += vec2(float(cell % columns) , float(cell / columns)) * pitch + vec2(pitch * 0.5 - 1.0);
+    }
+    gl_Position = vec4(positions[gl_VertexIndex] * offsetDepth.w + offset , offsetDepth.z , 1.0);
     vertexColor = colors[gl_VertexIndex];
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef _BENCHMARK_REPORT_H_
+#define _BENCHMARK_REPORT_H_
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//基准测试结果  --bench-json=file 时写出 JSON  便于不同驱动 / 版本之间对比
+//{"device":{...},"results":[{"name":"depth.prepass","params":{"prepass":"on"},"metrics":{"frame_us":812.5}}]}
+//params 为字符串 (区分同名测试的不同配置)  metrics 为数值
+
+struct BenchmarkResult{
+    std::string name;
+    std::vector<std::pair<std::string , std::string>> params;
+    std::vector<std::pair<std::string , double>> metrics;
+
+    BenchmarkResult &param(const std::string &key , const std::string &value){
+        params.emplace_back(key , value);
+        return *this;
+    }
+
+    BenchmarkResult &metric(const std::string &key , double value){
+        metrics.emplace_back(key , value);
+        return *this;
+    }
+};
+
+class BenchmarkReport{
+public:
+    //运行环境 写在 device 对象中
+    void setDeviceInfo(const std::string &key , const std::string &value){
+        deviceInfo.emplace_back(key , value);
+    }
+
+    //返回的引用在下一次 add 之前有效
+    BenchmarkResult &add(const std::string &name){
+        results.emplace_back();
+        results.back().name = name;
+        return results.back();
+    }
+
+    bool empty() const{
+        return results.empty();
+    }
+
+    bool writeJson(const std::string &path) const{
+        std::ofstream file(path);
+        if(!file.is_open()){
+            std::cout << "failed to write benchmark results " << path << std::endl;
+            return false;
+        }
+        file << "{\"device\":{";
+        writeStrings(file , deviceInfo);
+        file << "},\n\"results\":[";
+        for(size_t i = 0 ; i < results.size() ; i++){
+            const BenchmarkResult &result = results[i];
+            file << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << escapeJson(result.name) << "\",\"params\":{";
+            writeStrings(file , result.params);
+            file << "},\"metrics\":{";
+            for(size_t m = 0 ; m < result.metrics.size() ; m++){
+                file << (m > 0 ? "," : "") << "\"" << escapeJson(result.metrics[m].first) << "\":"
+                    << formatNumber(result.metrics[m].second);
+            }//end for m
+            file << "}}";
+        }//end for i
+        file << "\n]}\n";
+        std::cout << "write benchmark results " << path << " entries : " << results.size() << std::endl;
+        return true;
+    }
+
+private:
+    std::vector<std::pair<std::string , std::string>> deviceInfo;
+    std::vector<BenchmarkResult> results;
+
+    static void writeStrings(std::ofstream &file , const std::vector<std::pair<std::string , std::string>> &values){
+        for(size_t i = 0 ; i < values.size() ; i++){
+            file << (i > 0 ? "," : "") << "\"" << escapeJson(values[i].first) << "\":\""
+                << escapeJson(values[i].second) << "\"";
+        }//end for i
+    }
+
+    //JSON 没有 inf / nan
+    static std::string formatNumber(double value){
+        if(!std::isfinite(value)){
+            return "null";
+        }
+        char buffer[32];
+        std::snprintf(buffer , sizeof(buffer) , "%.6g" , value);
+        return buffer;
+    }
+
+    static std::string escapeJson(const std::string &text){
+        std::string result;
+        for(char c : text){
+            if(c == '"' || c == '\\'){
+                result.push_back('\\');
+            }
+            result.push_back(c);
+        }//end for each
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef _BINDLESS_H_
+#define _BINDLESS_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "device_dispatch.hpp"
+
+//全局 bindless 描述符集 (descriptor indexing)
+//整个程序只有一个 set  着色器用整数句柄索引其中的运行时数组:
+//  binding 0 纹理     uniform sampler2D textures[]
+//  binding 1 storage  buffer ... buffers[]
+//绑定标记 PARTIALLY_BOUND: 未注册的槽位可以不写  UPDATE_AFTER_BIND: 绑定之后(包括录制期间)仍可注册新资源
+//槽位由空闲链表分配  释放的槽位等到使用它的飞行帧结束后才重新分配
+//不同材质的物体只要句柄不同 就可以在同一个批次中绘制 不需要切换描述符集
+
+typedef uint32_t BindlessHandle;
+static const BindlessHandle BINDLESS_INVALID_HANDLE = 0xFFFFFFFFu;
+
+enum BindlessBinding{
+    BINDLESS_BINDING_TEXTURE = 0,
+    BINDLESS_BINDING_BUFFER,
+    BINDLESS_BINDING_COUNT
+};
+
+class BindlessDescriptors{
+public:
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    //容量不超过设备 update after bind 的限制
+    void init(VkInstance instance , VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd ,
+            uint32_t framesInFlight , uint32_t textureCapacity = 4096 , uint32_t bufferCapacity = 4096){
+        this->device = device;
+        this->vkd = vkd;
+        retired.assign(framesInFlight , std::vector<Retired>());
+
+        VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+        indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &indexingProperties;
+        auto getProperties2 = (PFN_vkGetPhysicalDeviceProperties2)vkGetInstanceProcAddr(instance , "vkGetPhysicalDeviceProperties2");
+        if(getProperties2 != nullptr){
+            getProperties2(physicalDevice , &properties2);
+            textureCapacity = std::min({textureCapacity , indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages ,
+                indexingProperties.maxDescriptorSetUpdateAfterBindSamplers ,
+                indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages});
+            bufferCapacity = std::min({bufferCapacity , indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers ,
+                indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+        }
+        slots[BINDLESS_BINDING_TEXTURE].capacity = textureCapacity;
+        slots[BINDLESS_BINDING_BUFFER].capacity = bufferCapacity;
+
+        const VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT
+            | VK_SHADER_STAGE_COMPUTE_BIT;
+        VkDescriptorSetLayoutBinding bindings[BINDLESS_BINDING_COUNT] = {};
+        bindings[BINDLESS_BINDING_TEXTURE].binding = BINDLESS_BINDING_TEXTURE;
+        bindings[BINDLESS_BINDING_TEXTURE].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[BINDLESS_BINDING_TEXTURE].descriptorCount = textureCapacity;
+        bindings[BINDLESS_BINDING_TEXTURE].stageFlags = stages;
+        bindings[BINDLESS_BINDING_BUFFER].binding = BINDLESS_BINDING_BUFFER;
+        bindings[BINDLESS_BINDING_BUFFER].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[BINDLESS_BINDING_BUFFER].descriptorCount = bufferCapacity;
+        bindings[BINDLESS_BINDING_BUFFER].stageFlags = stages;
+
+        const VkDescriptorBindingFlags bindingFlags[BINDLESS_BINDING_COUNT] = {
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT ,
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+        };
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo = {};
+        bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsCreateInfo.bindingCount = BINDLESS_BINDING_COUNT;
+        bindingFlagsCreateInfo.pBindingFlags = bindingFlags;
+
+        VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
+        setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+        setLayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        setLayoutCreateInfo.bindingCount = BINDLESS_BINDING_COUNT;
+        setLayoutCreateInfo.pBindings = bindings;
+        if(vkCreateDescriptorSetLayout(device , &setLayoutCreateInfo , nullptr , &setLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create bindless descriptor set layout!");
+        }
+
+        VkDescriptorPoolSize poolSizes[BINDLESS_BINDING_COUNT] = {
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , textureCapacity},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER , bufferCapacity}
+        };
+        VkDescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolCreateInfo.maxSets = 1;
+        poolCreateInfo.poolSizeCount = BINDLESS_BINDING_COUNT;
+        poolCreateInfo.pPoolSizes = poolSizes;
+        if(vkCreateDescriptorPool(device , &poolCreateInfo , nullptr , &descriptorPool) != VK_SUCCESS){
+            throw std::runtime_error("failed to create bindless descriptor pool!");
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &setLayout;
+        if(vkAllocateDescriptorSets(device , &allocateInfo , &set) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate bindless descriptor set!");
+        }
+
+        std::cout << "create bindless descriptor set textures : " << textureCapacity
+            << " buffers : " << bufferCapacity << std::endl;
+    }
+
+    bool isCreated() const{
+        return set != VK_NULL_HANDLE;
+    }
+
+    void destroy(){
+        if(device == VK_NULL_HANDLE){
+            return;
+        }
+        vkDestroyDescriptorPool(device , descriptorPool , nullptr);
+        vkDestroyDescriptorSetLayout(device , setLayout , nullptr);
+        descriptorPool = VK_NULL_HANDLE;
+        setLayout = VK_NULL_HANDLE;
+        set = VK_NULL_HANDLE;
+        for(SlotList &list : slots){
+            list.next = 0;
+            list.freeSlots.clear();
+        }//end for each
+        retired.clear();
+        device = VK_NULL_HANDLE;
+    }
+
+    //注册纹理 返回 textures[] 中的下标
+    BindlessHandle registerTexture(VkImageView view , VkSampler sampler ,
+            VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL){
+        const BindlessHandle handle = allocate(BINDLESS_BINDING_TEXTURE);
+
+        VkDescriptorImageInfo imageInfo = {};
+        imageInfo.sampler = sampler;
+        imageInfo.imageView = view;
+        imageInfo.imageLayout = layout;
+
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = BINDLESS_BINDING_TEXTURE;
+        write.dstArrayElement = handle;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &imageInfo;
+        vkd->vkUpdateDescriptorSets(device , 1 , &write , 0 , nullptr);
+        return handle;
+    }
+
+    //注册 storage buffer 的一段 返回 buffers[] 中的下标
+    BindlessHandle registerBuffer(VkBuffer buffer , VkDeviceSize offset , VkDeviceSize range){
+        const BindlessHandle handle = allocate(BINDLESS_BINDING_BUFFER);
+
+        VkDescriptorBufferInfo bufferInfo = {buffer , offset , range};
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = BINDLESS_BINDING_BUFFER;
+        write.dstArrayElement = handle;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &bufferInfo;
+        vkd->vkUpdateDescriptorSets(device , 1 , &write , 0 , nullptr);
+        return handle;
+    }
+
+    //frame 为当前录制的飞行帧  该帧下一次 beginFrame 时槽位才回到空闲链表
+    void releaseTexture(BindlessHandle handle , uint32_t frame){
+        release(BINDLESS_BINDING_TEXTURE , handle , frame);
+    }
+
+    void releaseBuffer(BindlessHandle handle , uint32_t frame){
+        release(BINDLESS_BINDING_BUFFER , handle , frame);
+    }
+
+    //在该帧的fence等待之后调用  上一次使用这一帧时释放的槽位不再被GPU读取
+    void beginFrame(uint32_t frame){
+        if(frame >= retired.size()){
+            return;
+        }
+        for(const Retired &entry : retired[frame]){
+            slots[entry.binding].freeSlots.push_back(entry.handle);
+        }//end for each
+        retired[frame].clear();
+    }
+
+    //整个帧只需绑定一次  之后切换管线不会使其失效(管线布局的 set 0 相同)
+    void bind(VkCommandBuffer cmd , VkPipelineBindPoint bindPoint , VkPipelineLayout layout) const{
+        vkd->vkCmdBindDescriptorSets(cmd , bindPoint , layout , 0 , 1 , &set , 0 , nullptr);
+    }
+
+    uint32_t textureCount() const{
+        return slots[BINDLESS_BINDING_TEXTURE].used();
+    }
+
+    uint32_t bufferCount() const{
+        return slots[BINDLESS_BINDING_BUFFER].used();
+    }
+
+private:
+    struct SlotList{
+        uint32_t capacity = 0;
+        uint32_t next = 0;//从未分配过的第一个槽位
+        std::vector<uint32_t> freeSlots;
+
+        uint32_t used() const{
+            return next - static_cast<uint32_t>(freeSlots.size());
+        }
+    };
+
+    struct Retired{
+        uint32_t binding;
+        BindlessHandle handle;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    SlotList slots[BINDLESS_BINDING_COUNT];
+    std::vector<std::vector<Retired>> retired;//每个飞行帧释放的槽位
+
+    BindlessHandle allocate(uint32_t binding){
+        SlotList &list = slots[binding];
+        if(!list.freeSlots.empty()){
+            const BindlessHandle handle = list.freeSlots.back();
+            list.freeSlots.pop_back();
+            return handle;
+        }
+        if(list.next >= list.capacity){
+            throw std::runtime_error("bindless descriptor slots exhausted!");
+        }
+        return list.next++;
+    }
+
+    //槽位里的描述符保持不变 PARTIALLY_BOUND 只要求着色器不访问它
+    void release(uint32_t binding , BindlessHandle handle , uint32_t frame){
+        if(handle == BINDLESS_INVALID_HANDLE){
+            return;
+        }
+        if(frame >= retired.size()){
+            slots[binding].freeSlots.push_back(handle);
+            return;
+        }
+        retired[frame].push_back({binding , handle});
+    }
+};
+
+#endif
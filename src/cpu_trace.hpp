@@ -0,0 +1,253 @@
+#ifndef _CPU_TRACE_H_
+#define _CPU_TRACE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+//CPU 热点路径计时
+//CPU_TRACE_SCOPE(name) 在作用域结束时写入一条 (开始 , 结束) 事件到当前线程的环形缓冲
+//每个线程一个单生产者单消费者的无锁环形缓冲  写入只有两次原子读写 不加锁
+//后台线程定期取走所有缓冲中的事件 以 Chrome trace_event JSON 流式写入文件 (chrome://tracing 或 Perfetto 打开)
+//缓冲写满时丢弃新事件并计数  不阻塞被计时的线程
+//未定义 ENABLE_CPU_TRACE 时宏展开为空  定义了但未 start 时每个作用域只有一次原子读
+
+//名称必须是字符串常量 (只保存指针)
+struct CpuTraceEvent{
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+//单生产者 (所属线程) 单消费者 (后台写出线程)
+class CpuTraceRing{
+public:
+    static const uint32_t CAPACITY = 1 << 16;
+
+    uint32_t threadId = 0;
+    std::string threadName;
+    std::atomic<uint64_t> dropped{0};
+
+    bool push(const CpuTraceEvent &event){
+        const uint64_t head = this->head.load(std::memory_order_relaxed);
+        if(head - tail.load(std::memory_order_acquire) >= CAPACITY){
+            dropped.fetch_add(1 , std::memory_order_relaxed);
+            return false;
+        }
+        events[head & (CAPACITY - 1)] = event;
+        this->head.store(head + 1 , std::memory_order_release);
+        return true;
+    }
+
+    //取出所有已写入的事件  只能由消费者调用
+    template<typename Visit>
+    size_t drain(Visit visit){
+        const uint64_t tail = this->tail.load(std::memory_order_relaxed);
+        const uint64_t head = this->head.load(std::memory_order_acquire);
+        for(uint64_t i = tail ; i < head ; i++){
+            visit(events[i & (CAPACITY - 1)]);
+        }//end for i
+        this->tail.store(head , std::memory_order_release);
+        return static_cast<size_t>(head - tail);
+    }
+
+private:
+    CpuTraceEvent events[CAPACITY];
+    //生产者与消费者的位置放在不同缓存行
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+};
+
+class CpuTracer{
+public:
+    static CpuTracer &instance(){
+        static CpuTracer tracer;
+        return tracer;
+    }
+
+    bool enabled() const{
+        return running.load(std::memory_order_relaxed);
+    }
+
+    //打开输出文件并启动后台写出线程  flushIntervalMs 为写出间隔
+    bool start(const std::string &path , uint32_t flushIntervalMs = 20){
+        if(enabled()){
+            return true;
+        }
+        file.open(path);
+        if(!file.is_open()){
+            std::cout << "failed to open cpu trace " << path << std::endl;
+            return false;
+        }
+        this->path = path;
+        flushInterval = flushIntervalMs;
+        startNanos = currentTimeNanos();
+        eventCount = 0;
+        file << "{\"traceEvents\":[\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU threads\"}}";
+        stopRequested = false;
+        running.store(true , std::memory_order_release);
+        flusher = std::thread([this](){
+            flushLoop();
+        });
+        return true;
+    }
+
+    //停止计时 写出剩余事件并关闭文件
+    void stop(){
+        if(!enabled()){
+            return;
+        }
+        running.store(false , std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        wakeup.notify_all();
+        flusher.join();
+
+        flush();
+        uint64_t dropped = 0;
+        for(const std::unique_ptr<CpuTraceRing> &ring : rings){
+            dropped += ring->dropped.load(std::memory_order_relaxed);
+        }//end for each
+        file << "\n]}\n";
+        file.close();
+        std::cout << "write cpu trace " << path << " events : " << eventCount
+            << " dropped : " << dropped << std::endl;
+    }
+
+    //当前线程的缓冲  第一次调用时注册 (加锁 只发生一次)
+    CpuTraceRing *threadRing(){
+        thread_local CpuTraceRing *ring = nullptr;
+        if(ring == nullptr){
+            std::lock_guard<std::mutex> lock(ringMutex);
+            rings.emplace_back(new CpuTraceRing());
+            ring = rings.back().get();
+            ring->threadId = static_cast<uint32_t>(rings.size());
+        }
+        return ring;
+    }
+
+    //为当前线程命名  在 trace 中显示为线程名
+    void nameThread(const std::string &name){
+        CpuTraceRing *ring = threadRing();
+        std::lock_guard<std::mutex> lock(ringMutex);
+        ring->threadName = name;
+    }
+
+    ~CpuTracer(){
+        stop();
+    }
+
+private:
+    std::atomic<bool> running{false};
+    std::vector<std::unique_ptr<CpuTraceRing>> rings;
+    std::mutex ringMutex;//保护 rings 的增加与线程名
+
+    std::thread flusher;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopRequested = false;
+    uint32_t flushInterval = 20;
+
+    std::ofstream file;
+    std::string path;
+    uint64_t startNanos = 0;
+    uint64_t eventCount = 0;
+    std::vector<uint32_t> namedThreads;//已写出线程名的 threadId
+
+    CpuTracer() = default;
+
+    void flushLoop(){
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!stopRequested){
+            wakeup.wait_for(lock , std::chrono::milliseconds(flushInterval));
+            lock.unlock();
+            flush();
+            lock.lock();
+        }//end while
+    }
+
+    //只由写出线程 (或 stop 之后的调用线程) 执行
+    void flush(){
+        std::vector<CpuTraceRing *> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(ringMutex);
+            for(const std::unique_ptr<CpuTraceRing> &ring : rings){
+                snapshot.push_back(ring.get());
+                if(!ring->threadName.empty()
+                        && std::find(namedThreads.begin() , namedThreads.end() , ring->threadId) == namedThreads.end()){
+                    file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << ring->threadId
+                        << ",\"args\":{\"name\":\"" << ring->threadName << "\"}}";
+                    namedThreads.push_back(ring->threadId);
+                }
+            }//end for each
+        }
+
+        char buffer[96];
+        for(CpuTraceRing *ring : snapshot){
+            const uint32_t threadId = ring->threadId;
+            eventCount += ring->drain([this , threadId , &buffer](const CpuTraceEvent &event){
+                //开始计时之前打开的作用域从起点算起
+                const uint64_t begin = event.begin > startNanos ? event.begin - startNanos : 0;
+                const uint64_t end = event.end > startNanos ? event.end - startNanos : 0;
+                file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\"";
+                std::snprintf(buffer , sizeof(buffer) , ",\"ts\":%.3f,\"dur\":%.3f" ,
+                    begin / 1000.0 , (end - begin) / 1000.0);
+                file << buffer << ",\"pid\":0,\"tid\":" << threadId << "}";
+            });
+        }//end for each
+        file.flush();
+    }
+};
+
+//作用域计时  未启动时不读时钟
+class CpuTraceScope{
+public:
+    explicit CpuTraceScope(const char *name){
+        if(CpuTracer::instance().enabled()){
+            this->name = name;
+            begin = currentTimeNanos();
+        }
+    }
+
+    ~CpuTraceScope(){
+        if(name != nullptr && CpuTracer::instance().enabled()){
+            CpuTracer::instance().threadRing()->push({name , begin , currentTimeNanos()});
+        }
+    }
+
+    CpuTraceScope(const CpuTraceScope &) = delete;
+    CpuTraceScope &operator=(const CpuTraceScope &) = delete;
+
+private:
+    const char *name = nullptr;
+    uint64_t begin = 0;
+};
+
+#define CPU_TRACE_CONCAT_INNER(a , b) a##b
+#define CPU_TRACE_CONCAT(a , b) CPU_TRACE_CONCAT_INNER(a , b)
+
+#ifdef ENABLE_CPU_TRACE
+#define CPU_TRACE_SCOPE(name) CpuTraceScope CPU_TRACE_CONCAT(cpuTraceScope , __LINE__)(name)
+#define CPU_TRACE_FUNCTION() CpuTraceScope CPU_TRACE_CONCAT(cpuTraceScope , __LINE__)(__func__)
+#define CPU_TRACE_THREAD(name) CpuTracer::instance().nameThread(name)
+#else
+#define CPU_TRACE_SCOPE(name) do{}while(0)
+#define CPU_TRACE_FUNCTION() do{}while(0)
+#define CPU_TRACE_THREAD(name) do{}while(0)
+#endif
+
+#endif
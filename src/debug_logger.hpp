@@ -0,0 +1,314 @@
+#ifndef _DEBUG_LOGGER_H_
+#define _DEBUG_LOGGER_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.hpp"
+
+//验证层 / 调试消息的异步输出
+//回调在驱动的任意线程上调用  只做过滤与一次无锁入队 (有界多生产者队列 满时丢弃并计数)
+//后台线程取出消息后去重 (同一消息 ID 最多输出 maxRepeats 次) 限速 (每秒最多 maxPerSecond 条)  错误不去重也不限速 再批量写 std::cerr
+//级别与类型的过滤掩码是原子变量  运行中可以修改
+//stop 时输出剩余消息与被抑制的统计
+
+struct DebugMessage{
+    static const size_t MAX_TEXT = 1024;//超出部分截断
+
+    VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+    VkDebugUtilsMessageTypeFlagsEXT type;
+    int32_t id;//messageIdNumber  0 时按文本去重
+    char text[MAX_TEXT];
+};
+
+//级别名称 --vk-log 的取值
+static VkDebugUtilsMessageSeverityFlagsEXT debugSeverityMaskFromName(const std::string &name){
+    //不低于指定级别的所有级别
+    if(name == "error"){
+        return VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    }
+    if(name == "warning"){
+        return VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+    }
+    if(name == "verbose"){
+        return VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT
+            | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+    }
+    if(name == "info"){
+        return VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT
+            | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+    }
+    throw std::runtime_error("unknown log severity " + name);
+}
+
+//逗号分隔的类型名称 --vk-log-types 的取值
+static VkDebugUtilsMessageTypeFlagsEXT debugTypeMaskFromNames(const std::string &names){
+    VkDebugUtilsMessageTypeFlagsEXT mask = 0;
+    size_t begin = 0;
+    while(begin <= names.size()){
+        size_t end = names.find(',' , begin);
+        if(end == std::string::npos){
+            end = names.size();
+        }
+        const std::string name = names.substr(begin , end - begin);
+        if(name == "general"){
+            mask |= VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT;
+        }else if(name == "validation"){
+            mask |= VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+        }else if(name == "performance"){
+            mask |= VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        }else if(!name.empty()){
+            throw std::runtime_error("unknown log type " + name);
+        }
+        begin = end + 1;
+    }//end while
+    return mask;
+}
+
+class DebugLogger{
+public:
+    static const size_t QUEUE_CAPACITY = 1024;//2 的幂
+
+    DebugLogger(){
+        for(size_t i = 0 ; i < QUEUE_CAPACITY ; i++){
+            cells[i].sequence.store(i , std::memory_order_relaxed);
+        }//end for i
+    }
+
+    ~DebugLogger(){
+        stop();
+    }
+
+    //运行中可以修改的过滤条件
+    void setSeverityMask(VkDebugUtilsMessageSeverityFlagsEXT mask){
+        severityMask.store(mask , std::memory_order_relaxed);
+    }
+
+    void setTypeMask(VkDebugUtilsMessageTypeFlagsEXT mask){
+        typeMask.store(mask , std::memory_order_relaxed);
+    }
+
+    //同一消息 ID 最多输出的次数  0 不限
+    void setMaxRepeats(uint32_t count){
+        maxRepeats.store(count , std::memory_order_relaxed);
+    }
+
+    //每秒最多输出的条数 (错误不计)  0 不限
+    void setMaxPerSecond(uint32_t count){
+        maxPerSecond.store(count , std::memory_order_relaxed);
+    }
+
+    void start(){
+        if(running){
+            return;
+        }
+        running = true;
+        stopRequested = false;
+        writer = std::thread([this](){
+            writeLoop();
+        });
+    }
+
+    //输出剩余消息与统计
+    void stop(){
+        if(!running){
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        wakeup.notify_all();
+        writer.join();
+        running = false;
+        printSummary();
+    }
+
+    //回调中调用  过滤后入队 不加锁 不做 I/O
+    void post(VkDebugUtilsMessageSeverityFlagBitsEXT severity , VkDebugUtilsMessageTypeFlagsEXT type ,
+            const VkDebugUtilsMessengerCallbackDataEXT *data){
+        if(!(severity & severityMask.load(std::memory_order_relaxed)) || !(type & typeMask.load(std::memory_order_relaxed))){
+            return;
+        }
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Cell *cell = nullptr;
+        for(;;){
+            cell = &cells[position & (QUEUE_CAPACITY - 1)];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if(diff == 0){
+                if(enqueuePosition.compare_exchange_weak(position , position + 1 , std::memory_order_relaxed)){
+                    break;
+                }
+            }else if(diff < 0){
+                dropped.fetch_add(1 , std::memory_order_relaxed);
+                return;
+            }else{
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }//end for
+
+        DebugMessage &message = cell->message;
+        message.severity = severity;
+        message.type = type;
+        message.id = data->messageIdNumber;
+        const char *text = data->pMessage != nullptr ? data->pMessage : "";
+        const size_t length = std::min(std::strlen(text) , DebugMessage::MAX_TEXT - 1);
+        std::memcpy(message.text , text , length);
+        message.text[length] = '\0';
+        cell->sequence.store(position + 1 , std::memory_order_release);
+    }
+
+    //Vulkan 回调  pUserData 为 DebugLogger
+    static VKAPI_ATTR VkBool32 VKAPI_CALL callback(
+            VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity , VkDebugUtilsMessageTypeFlagsEXT messageType ,
+            const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData , void *pUserData){
+        if(pUserData != nullptr){
+            static_cast<DebugLogger *>(pUserData)->post(messageSeverity , messageType , pCallbackData);
+        }
+        return VK_FALSE;
+    }
+
+private:
+    struct Cell{
+        std::atomic<size_t> sequence;
+        DebugMessage message;
+    };
+
+    Cell cells[QUEUE_CAPACITY];
+    alignas(64) std::atomic<size_t> enqueuePosition{0};
+    alignas(64) size_t dequeuePosition = 0;//只有写出线程访问
+
+    std::atomic<VkDebugUtilsMessageSeverityFlagsEXT> severityMask{
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT};
+    std::atomic<VkDebugUtilsMessageTypeFlagsEXT> typeMask{
+        VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
+        | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT};
+    std::atomic<uint32_t> maxRepeats{3};
+    std::atomic<uint32_t> maxPerSecond{50};
+
+    std::atomic<uint64_t> dropped{0};//队列满时丢弃
+    uint64_t written = 0;
+    uint64_t duplicates = 0;//超过 maxRepeats 的重复消息
+    uint64_t rateLimited = 0;
+    std::unordered_map<uint64_t , uint64_t> seen;//去重键 -> 次数
+
+    uint64_t windowStart = 0;//限速窗口 (1 秒)
+    uint32_t windowCount = 0;
+
+    bool running = false;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopRequested = false;
+
+    void writeLoop(){
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!stopRequested){
+            wakeup.wait_for(lock , std::chrono::milliseconds(10));
+            lock.unlock();
+            drain();
+            lock.lock();
+        }//end while
+        lock.unlock();
+        drain();
+    }
+
+    bool pop(DebugMessage &message){
+        Cell &cell = cells[dequeuePosition & (QUEUE_CAPACITY - 1)];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if(static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePosition + 1) < 0){
+            return false;
+        }
+        message = cell.message;
+        cell.sequence.store(dequeuePosition + QUEUE_CAPACITY , std::memory_order_release);
+        dequeuePosition++;
+        return true;
+    }
+
+    void drain(){
+        DebugMessage message;
+        bool any = false;
+        while(pop(message)){
+            if(!accept(message)){
+                continue;
+            }
+            std::cerr << "validation layer " << severityName(message.severity) << " : " << message.text << '\n';
+            written++;
+            any = true;
+        }//end while
+        if(any){
+            std::cerr.flush();
+        }
+    }
+
+    //去重与限速  错误总是输出
+    bool accept(const DebugMessage &message){
+        if(message.severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT){
+            return true;
+        }
+
+        const uint64_t key = message.id != 0
+            ? static_cast<uint32_t>(message.id)
+            : (std::hash<std::string>()(message.text) | (1ull << 63));
+        const uint64_t count = ++seen[key];
+        const uint32_t repeats = maxRepeats.load(std::memory_order_relaxed);
+        if(repeats != 0 && count > repeats){
+            duplicates++;
+            return false;
+        }
+
+        const uint32_t limit = maxPerSecond.load(std::memory_order_relaxed);
+        const uint64_t now = currentTimeNanos();
+        if(now - windowStart >= 1000000000ull){
+            windowStart = now;
+            windowCount = 0;
+        }
+        if(limit != 0 && windowCount >= limit){
+            rateLimited++;
+            return false;
+        }
+        windowCount++;
+        return true;
+    }
+
+    void printSummary(){
+        const uint64_t droppedCount = dropped.load(std::memory_order_relaxed);
+        if(written == 0 && duplicates == 0 && rateLimited == 0 && droppedCount == 0){
+            return;
+        }
+        std::cerr << "validation messages written : " << written
+            << " duplicates suppressed : " << duplicates
+            << " rate limited : " << rateLimited
+            << " dropped : " << droppedCount << std::endl;
+    }
+
+    static const char *severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity){
+        if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT){
+            return "error";
+        }
+        if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT){
+            return "warning";
+        }
+        if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT){
+            return "info";
+        }
+        return "verbose";
+    }
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef _DEPTH_BUFFER_H_
+#define _DEPTH_BUFFER_H_
+
+#include <vulkan/vulkan.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "transient_attachment.hpp"
+
+//深度缓冲
+//只在一次渲染内使用 (storeOp DONT_CARE) 时只用 configure() 确定格式  图像由帧图按飞行帧分配 (TRANSIENT_ATTACHMENT)
+//sampled 时(遮挡剔除要读取深度构建 Hi-Z) 深度需要保存 create() 创建常驻图像 并额外创建只含深度 aspect 的 sampledView
+//reverse-Z: 近处深度为1 远处为0  配合浮点格式 精度在远处分布更均匀
+class DepthBuffer{
+public:
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkImageView sampledView = VK_NULL_HANDLE;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    bool reverseZ = false;
+    bool lazilyAllocated = false;
+    VkDeviceSize memorySize = 0;
+
+    //按优先级选择支持作为深度附件的格式  reverse-Z 优先浮点格式  sampled 时还需支持着色器采样 (Hi-Z 构建)
+    static VkFormat chooseFormat(VkPhysicalDevice physicalDevice , bool reverseZ , bool sampled = false){
+        std::vector<VkFormat> candidates;
+        if(reverseZ){
+            candidates = {VK_FORMAT_D32_SFLOAT , VK_FORMAT_D32_SFLOAT_S8_UINT ,
+                VK_FORMAT_X8_D24_UNORM_PACK32 , VK_FORMAT_D24_UNORM_S8_UINT , VK_FORMAT_D16_UNORM};
+        }else{
+            candidates = {VK_FORMAT_X8_D24_UNORM_PACK32 , VK_FORMAT_D32_SFLOAT , VK_FORMAT_D24_UNORM_S8_UINT ,
+                VK_FORMAT_D32_SFLOAT_S8_UINT , VK_FORMAT_D16_UNORM};
+        }
+
+        VkFormatFeatureFlags required = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        if(sampled){
+            required |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+        }
+
+        for(VkFormat candidate : candidates){
+            VkFormatProperties properties;
+            vkGetPhysicalDeviceFormatProperties(physicalDevice , candidate , &properties);
+            if((properties.optimalTilingFeatures & required) == required){
+                return candidate;
+            }
+        }//end for each
+        throw std::runtime_error("failed to find supported depth format!");
+    }
+
+    static bool hasStencil(VkFormat format){
+        return format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT
+            || format == VK_FORMAT_D16_UNORM_S8_UINT;
+    }
+
+    static bool isFloatFormat(VkFormat format){
+        return format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+    //只确定格式 采样数 不创建图像
+    void configure(VkPhysicalDevice physicalDevice , VkSampleCountFlagBits samples , bool reverseZ , bool sampled = false){
+        this->reverseZ = reverseZ;
+        this->samples = samples;
+        format = chooseFormat(physicalDevice , reverseZ , sampled);
+        aspect = VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencil(format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+    }
+
+    void create(VkDevice device , VkPhysicalDevice physicalDevice , VkExtent2D extent ,
+            VkSampleCountFlagBits samples , bool reverseZ , bool sampled = false){
+        this->device = device;
+        configure(physicalDevice , samples , reverseZ , sampled);
+        attachment.create(device , physicalDevice , format , aspect , extent , samples ,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT , sampled ? VK_IMAGE_USAGE_SAMPLED_BIT : 0);
+        image = attachment.image;
+        view = attachment.view;
+        lazilyAllocated = attachment.lazilyAllocated;
+        memorySize = attachment.memorySize;
+
+        if(sampled){
+            VkImageViewCreateInfo viewCreateInfo = {};
+            viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewCreateInfo.image = image;
+            viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewCreateInfo.format = format;
+            viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            viewCreateInfo.subresourceRange.levelCount = 1;
+            viewCreateInfo.subresourceRange.layerCount = 1;
+            if(vkCreateImageView(device , &viewCreateInfo , nullptr , &sampledView) != VK_SUCCESS){
+                throw std::runtime_error("failed to create depth sampled view!");
+            }
+        }
+
+        std::cout << "create depth buffer format : " << format
+            << " samples : " << samples
+            << (reverseZ ? " reverse-Z" : "")
+            << (lazilyAllocated ? " lazily allocated" : " device local")
+            << (sampled ? " sampled" : "")
+            << " size : " << (memorySize >> 10) << " KB" << std::endl;
+    }
+
+    bool isCreated() const{
+        return image != VK_NULL_HANDLE;
+    }
+
+    void destroy(){
+        if(sampledView != VK_NULL_HANDLE){
+            vkDestroyImageView(device , sampledView , nullptr);
+            sampledView = VK_NULL_HANDLE;
+        }
+        attachment.destroy();
+        image = VK_NULL_HANDLE;
+        view = VK_NULL_HANDLE;
+        lazilyAllocated = false;
+        memorySize = 0;
+    }
+
+    VkDeviceSize committedSize() const{
+        return attachment.committedSize();
+    }
+
+    //清除值与比较方式
+    float clearDepth() const{
+        return reverseZ ? 0.0f : 1.0f;
+    }
+
+    VkCompareOp compareOp() const{
+        return reverseZ ? VK_COMPARE_OP_GREATER_OR_EQUAL : VK_COMPARE_OP_LESS_OR_EQUAL;
+    }
+
+    //线性的 [0,1] 距离(0 最近) 映射到写入的深度值
+    float depthValue(float distance) const{
+        return reverseZ ? 1.0f - distance : distance;
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    TransientAttachment attachment;
+};
+
+#endif
@@ -0,0 +1,342 @@
+#ifndef _DESCRIPTOR_ALLOCATOR_H_
+#define _DESCRIPTOR_ALLOCATOR_H_
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "device_dispatch.hpp"
+
+//描述符集布局缓存  相同的 binding 列表只创建一次  按内容的哈希查找
+//返回的布局由缓存持有 在 destroy 时统一销毁
+class DescriptorLayoutCache{
+public:
+    void init(VkDevice device){
+        this->device = device;
+    }
+
+    void destroy(){
+        for(auto &bucket : layouts){
+            for(Entry &entry : bucket.second){
+                vkDestroyDescriptorSetLayout(device , entry.layout , nullptr);
+            }//end for each
+        }//end for each
+        layouts.clear();
+        layoutCount = 0;
+    }
+
+    VkDescriptorSetLayout get(const std::vector<VkDescriptorSetLayoutBinding> &bindings ,
+            VkDescriptorSetLayoutCreateFlags flags = 0){
+        const size_t key = hash(bindings , flags);
+        std::vector<Entry> &bucket = layouts[key];
+        for(const Entry &entry : bucket){
+            if(entry.flags == flags && equals(entry.bindings , bindings)){
+                hits++;
+                return entry.layout;
+            }
+        }//end for each
+
+        VkDescriptorSetLayoutCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        createInfo.flags = flags;
+        createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        createInfo.pBindings = bindings.data();
+
+        Entry entry;
+        entry.bindings = bindings;
+        entry.flags = flags;
+        if(vkCreateDescriptorSetLayout(device , &createInfo , nullptr , &entry.layout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create cached descriptor set layout!");
+        }
+        bucket.push_back(entry);
+        layoutCount++;
+        return entry.layout;
+    }
+
+    uint32_t size() const{
+        return layoutCount;
+    }
+
+    uint32_t hitCount() const{
+        return hits;
+    }
+
+private:
+    struct Entry{
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        VkDescriptorSetLayoutCreateFlags flags = 0;
+        VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    std::unordered_map<size_t , std::vector<Entry>> layouts;
+    uint32_t layoutCount = 0;
+    uint32_t hits = 0;
+
+    //immutable sampler 不参与比较 (不使用)
+    static size_t hash(const std::vector<VkDescriptorSetLayoutBinding> &bindings , VkDescriptorSetLayoutCreateFlags flags){
+        size_t result = flags;
+        for(const VkDescriptorSetLayoutBinding &binding : bindings){
+            const size_t packed = binding.binding | (binding.descriptorType << 8) | (binding.descriptorCount << 16)
+                | (static_cast<size_t>(binding.stageFlags) << 32);
+            result ^= packed + 0x9e3779b97f4a7c15ull + (result << 6) + (result >> 2);
+        }//end for each
+        return result;
+    }
+
+    static bool equals(const std::vector<VkDescriptorSetLayoutBinding> &a , const std::vector<VkDescriptorSetLayoutBinding> &b){
+        if(a.size() != b.size()){
+            return false;
+        }
+        for(size_t i = 0 ; i < a.size() ; i++){
+            if(a[i].binding != b[i].binding || a[i].descriptorType != b[i].descriptorType
+                || a[i].descriptorCount != b[i].descriptorCount || a[i].stageFlags != b[i].stageFlags){
+                return false;
+            }
+        }//end for i
+        return true;
+    }
+};
+
+//描述符更新模板  一次调用按模板从一块连续内存写入整个集
+//设备不支持 (1.0 且没有 VK_KHR_descriptor_update_template) 时按同样的条目退回 vkUpdateDescriptorSets
+class DescriptorUpdateTemplate{
+public:
+    void create(VkDevice device , DeviceDispatchTable *vkd , VkDescriptorSetLayout layout ,
+            const std::vector<VkDescriptorUpdateTemplateEntry> &entries){
+        this->device = device;
+        this->vkd = vkd;
+        this->entries = entries;
+        if(vkd->vkCreateDescriptorUpdateTemplate == nullptr){
+            return;
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+        createInfo.pDescriptorUpdateEntries = entries.data();
+        createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        createInfo.descriptorSetLayout = layout;
+        if(vkd->vkCreateDescriptorUpdateTemplate(device , &createInfo , nullptr , &handle) != VK_SUCCESS){
+            throw std::runtime_error("failed to create descriptor update template!");
+        }
+    }
+
+    void destroy(){
+        if(handle != VK_NULL_HANDLE){
+            vkd->vkDestroyDescriptorUpdateTemplate(device , handle , nullptr);
+            handle = VK_NULL_HANDLE;
+        }
+        entries.clear();
+    }
+
+    //data 的布局由模板条目的 offset / stride 描述
+    void update(VkDescriptorSet set , const void *data) const{
+        if(handle != VK_NULL_HANDLE){
+            vkd->vkUpdateDescriptorSetWithTemplate(device , set , handle , data);
+            return;
+        }
+
+        std::vector<VkWriteDescriptorSet> writes(entries.size());
+        std::vector<VkDescriptorImageInfo> imageInfos;
+        std::vector<VkDescriptorBufferInfo> bufferInfos;
+        for(const VkDescriptorUpdateTemplateEntry &entry : entries){
+            for(uint32_t i = 0 ; i < entry.descriptorCount ; i++){
+                const char *element = static_cast<const char *>(data) + entry.offset + entry.stride * i;
+                if(isImageType(entry.descriptorType)){
+                    imageInfos.push_back(*reinterpret_cast<const VkDescriptorImageInfo *>(element));
+                }else{
+                    bufferInfos.push_back(*reinterpret_cast<const VkDescriptorBufferInfo *>(element));
+                }
+            }//end for i
+        }//end for each
+
+        size_t imageIndex = 0;
+        size_t bufferIndex = 0;
+        for(size_t i = 0 ; i < entries.size() ; i++){
+            const VkDescriptorUpdateTemplateEntry &entry = entries[i];
+            writes[i] = {};
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = set;
+            writes[i].dstBinding = entry.dstBinding;
+            writes[i].dstArrayElement = entry.dstArrayElement;
+            writes[i].descriptorCount = entry.descriptorCount;
+            writes[i].descriptorType = entry.descriptorType;
+            if(isImageType(entry.descriptorType)){
+                writes[i].pImageInfo = imageInfos.data() + imageIndex;
+                imageIndex += entry.descriptorCount;
+            }else{
+                writes[i].pBufferInfo = bufferInfos.data() + bufferIndex;
+                bufferIndex += entry.descriptorCount;
+            }
+        }//end for i
+        vkd->vkUpdateDescriptorSets(device , static_cast<uint32_t>(writes.size()) , writes.data() , 0 , nullptr);
+    }
+
+    //buffer 类描述符的条目  offset 为 data 中 VkDescriptorBufferInfo 的位置
+    static VkDescriptorUpdateTemplateEntry bufferEntry(uint32_t binding , VkDescriptorType type , size_t offset){
+        return {binding , 0 , 1 , type , offset , sizeof(VkDescriptorBufferInfo)};
+    }
+
+    static VkDescriptorUpdateTemplateEntry imageEntry(uint32_t binding , VkDescriptorType type , size_t offset){
+        return {binding , 0 , 1 , type , offset , sizeof(VkDescriptorImageInfo)};
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkDescriptorUpdateTemplate handle = VK_NULL_HANDLE;
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+
+    static bool isImageType(VkDescriptorType type){
+        return type == VK_DESCRIPTOR_TYPE_SAMPLER || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+            || type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+            || type == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    }
+};
+
+struct DescriptorAllocatorStats{
+    uint32_t sets = 0;//本帧分配的集
+    uint32_t pools = 0;//本帧用到的池
+    uint32_t poolsCreated = 0;//累计创建的池
+};
+
+//每帧的描述符分配器
+//每个飞行帧一组 VkDescriptorPool  集只分配不单独释放  当前池满了取下一个(空闲池或新建)
+//该帧的fence等待之后 beginFrame 用 vkResetDescriptorPool 整池重置 池回到空闲列表
+//避免单独释放造成的池碎片 与驱动内部的锁竞争
+class DescriptorAllocator{
+public:
+    //每个池的容量 = setsPerPool * 各类型的比例
+    void init(VkDevice device , DeviceDispatchTable *vkd , uint32_t framesInFlight , uint32_t setsPerPool = 256){
+        this->device = device;
+        this->vkd = vkd;
+        this->setsPerPool = setsPerPool;
+        frames.assign(framesInFlight , FramePools());
+    }
+
+    void destroy(){
+        for(FramePools &frame : frames){
+            for(VkDescriptorPool pool : frame.used){
+                vkDestroyDescriptorPool(device , pool , nullptr);
+            }//end for each
+        }//end for each
+        for(VkDescriptorPool pool : freePools){
+            vkDestroyDescriptorPool(device , pool , nullptr);
+        }//end for each
+        frames.clear();
+        freePools.clear();
+    }
+
+    //在该帧的fence等待之后调用  上一次使用这一帧分配的集全部失效
+    void beginFrame(uint32_t frame){
+        FramePools &pools = frames[frame];
+        lastStats = pools.stats;
+        for(VkDescriptorPool pool : pools.used){
+            vkd->vkResetDescriptorPool(device , pool , 0);
+            freePools.push_back(pool);
+        }//end for each
+        pools.used.clear();
+        pools.stats.sets = 0;
+        pools.stats.pools = 0;
+    }
+
+    //分配只在本帧内有效的集
+    VkDescriptorSet allocate(uint32_t frame , VkDescriptorSetLayout layout){
+        FramePools &pools = frames[frame];
+        if(pools.used.empty()){
+            pools.used.push_back(acquirePool());
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = pools.used.back();
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &layout;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult result = vkd->vkAllocateDescriptorSets(device , &allocateInfo , &set);
+        if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL){
+            //当前池已满 换一个池重试
+            pools.used.push_back(acquirePool());
+            allocateInfo.descriptorPool = pools.used.back();
+            result = vkd->vkAllocateDescriptorSets(device , &allocateInfo , &set);
+        }
+        if(result != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate frame descriptor set!");
+        }
+
+        pools.stats.sets++;
+        pools.stats.pools = static_cast<uint32_t>(pools.used.size());
+        return set;
+    }
+
+    //上一次完成的帧 (最近一次 beginFrame 重置之前) 的统计
+    const DescriptorAllocatorStats &stats() const{
+        return lastStats;
+    }
+
+    uint32_t poolCount() const{
+        return poolsCreated;
+    }
+
+private:
+    struct FramePools{
+        std::vector<VkDescriptorPool> used;
+        DescriptorAllocatorStats stats;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    uint32_t setsPerPool = 256;
+    std::vector<FramePools> frames;
+    std::vector<VkDescriptorPool> freePools;//已重置 可被任意帧取用
+    DescriptorAllocatorStats lastStats;
+    uint32_t poolsCreated = 0;
+
+    VkDescriptorPool acquirePool(){
+        if(!freePools.empty()){
+            VkDescriptorPool pool = freePools.back();
+            freePools.pop_back();
+            return pool;
+        }
+
+        //每个集平均使用的各类描述符数
+        const struct{
+            VkDescriptorType type;
+            float ratio;
+        } ratios[] = {
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER , 6.0f},
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , 2.0f},
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC , 1.0f},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , 2.0f},
+            {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE , 1.0f},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE , 1.0f}
+        };
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for(const auto &ratio : ratios){
+            poolSizes.push_back({ratio.type , static_cast<uint32_t>(ratio.ratio * setsPerPool)});
+        }//end for each
+
+        VkDescriptorPoolCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        createInfo.maxSets = setsPerPool;
+        createInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        createInfo.pPoolSizes = poolSizes.data();
+
+        VkDescriptorPool pool;
+        if(vkd->vkCreateDescriptorPool(device , &createInfo , nullptr , &pool) != VK_SUCCESS){
+            throw std::runtime_error("failed to create frame descriptor pool!");
+        }
+        poolsCreated++;
+        for(FramePools &frame : frames){
+            frame.stats.poolsCreated = poolsCreated;
+        }//end for each
+        return pool;
+    }
+};
+
+#endif
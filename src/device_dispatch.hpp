@@ -0,0 +1,47 @@
+#ifndef _DEVICE_DISPATCH_H_
+#define _DEVICE_DISPATCH_H_
+
+#include <vulkan/vulkan.h>
+
+#include "vk_compat.hpp"
+
+//设备级函数分发表
+//通过 vkGetDeviceProcAddr 直接取得驱动中的函数地址 绕过loader的trampoline
+//函数列表由 tools/gen_device_dispatch.py 从 vulkan_core.h 生成
+struct DeviceDispatchTable{
+#define VK_DEVICE_FUNCTION(name) PFN_##name name = nullptr;
+#include "vk_device_dispatch.inl"
+#undef VK_DEVICE_FUNCTION
+
+    //头文件中没有的函数 (见 vk_compat.hpp)
+#ifdef VK_COMPAT_KHR_dynamic_rendering
+    PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR = nullptr;
+    PFN_vkCmdEndRenderingKHR vkCmdEndRenderingKHR = nullptr;
+#endif
+
+    //未启用的扩展函数 取得的地址为nullptr
+    void load(VkDevice device){
+#define VK_DEVICE_FUNCTION(name) name = (PFN_##name)vkGetDeviceProcAddr(device , #name);
+#include "vk_device_dispatch.inl"
+#undef VK_DEVICE_FUNCTION
+
+        //1.3 核心名称优先 其次扩展名称
+        vkCmdBeginRenderingKHR = (PFN_vkCmdBeginRenderingKHR)loadPromoted(device , "vkCmdBeginRendering" , "vkCmdBeginRenderingKHR");
+        vkCmdEndRenderingKHR = (PFN_vkCmdEndRenderingKHR)loadPromoted(device , "vkCmdEndRendering" , "vkCmdEndRenderingKHR");
+        //1.2 核心名称优先 其次扩展名称
+        vkCmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCount)loadPromoted(device ,
+            "vkCmdDrawIndexedIndirectCount" , "vkCmdDrawIndexedIndirectCountKHR");
+#ifdef VK_KHR_synchronization2
+        vkCmdPipelineBarrier2KHR = (PFN_vkCmdPipelineBarrier2KHR)loadPromoted(device , "vkCmdPipelineBarrier2" , "vkCmdPipelineBarrier2KHR");
+        vkQueueSubmit2KHR = (PFN_vkQueueSubmit2KHR)loadPromoted(device , "vkQueueSubmit2" , "vkQueueSubmit2KHR");
+        vkCmdWriteTimestamp2KHR = (PFN_vkCmdWriteTimestamp2KHR)loadPromoted(device , "vkCmdWriteTimestamp2" , "vkCmdWriteTimestamp2KHR");
+#endif
+    }
+
+    static PFN_vkVoidFunction loadPromoted(VkDevice device , const char *coreName , const char *extensionName){
+        PFN_vkVoidFunction func = vkGetDeviceProcAddr(device , coreName);
+        return func != nullptr ? func : vkGetDeviceProcAddr(device , extensionName);
+    }
+};
+
+#endif
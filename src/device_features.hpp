@@ -0,0 +1,320 @@
+#ifndef _DEVICE_FEATURES_H_
+#define _DEVICE_FEATURES_H_
+
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "vk_compat.hpp"
+
+//引擎可以利用的设备能力  各子系统据此选择快速路径 不支持时回退
+enum DeviceCapabilityBits : uint32_t {
+    CAP_TIMELINE_SEMAPHORE    = 1u << 0,
+    CAP_DYNAMIC_RENDERING     = 1u << 1,
+    CAP_DESCRIPTOR_INDEXING   = 1u << 2,
+    CAP_BUFFER_DEVICE_ADDRESS = 1u << 3,
+    CAP_SYNCHRONIZATION2      = 1u << 4,
+    CAP_DRAW_INDIRECT_COUNT   = 1u << 5,
+    CAP_PUSH_DESCRIPTOR       = 1u << 6,
+};
+typedef uint32_t DeviceCapabilities;
+
+static const char* deviceCapabilityName(DeviceCapabilityBits bit){
+    switch(bit){
+        case CAP_TIMELINE_SEMAPHORE:
+            return "timelineSemaphore";
+        case CAP_DYNAMIC_RENDERING:
+            return "dynamicRendering";
+        case CAP_DESCRIPTOR_INDEXING:
+            return "descriptorIndexing";
+        case CAP_BUFFER_DEVICE_ADDRESS:
+            return "bufferDeviceAddress";
+        case CAP_SYNCHRONIZATION2:
+            return "synchronization2";
+        case CAP_DRAW_INDIRECT_COUNT:
+            return "drawIndirectCount";
+        case CAP_PUSH_DESCRIPTOR:
+            return "pushDescriptor";
+        default:
+            return "unknown";
+    }
+}
+
+//设备特性协商
+//query() 通过 pNext 链查询 Vulkan11/12/13 特性 (低版本驱动查询对应扩展)
+//negotiate() 只开启引擎用得到的特性 并生成能力位 与需要额外开启的设备扩展
+//vulkan 1.0 驱动只走 VkPhysicalDeviceFeatures  能力位为0
+class DeviceFeatures{
+public:
+    uint32_t apiVersion = VK_API_VERSION_1_0;//实例与设备版本中较低者
+    DeviceCapabilities capabilities = 0;
+
+    VkPhysicalDeviceFeatures supportedCore = {};
+    VkPhysicalDeviceFeatures enabledCore = {};//vulkan 1.0 特性 由调用者按需开启
+
+    std::vector<const char*> extensions;//协商后需要开启的设备扩展
+
+    DeviceFeatures() = default;
+    DeviceFeatures(const DeviceFeatures &) = delete;
+    DeviceFeatures& operator=(const DeviceFeatures &) = delete;
+
+    bool has(DeviceCapabilityBits bit) const{
+        return (capabilities & bit) != 0;
+    }
+
+    void query(VkInstance instance , VkPhysicalDevice physicalDevice , uint32_t instanceApiVersion){
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice , &properties);
+        apiVersion = properties.apiVersion < instanceApiVersion ? properties.apiVersion : instanceApiVersion;
+
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice , nullptr , &extensionCount , nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice , nullptr , &extensionCount , availableExtensions.data());
+        availableExtensionNames.clear();
+        for(VkExtensionProperties &prop : availableExtensions){
+            availableExtensionNames.insert(prop.extensionName);
+        }//end for each
+
+        auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(instance , "vkGetPhysicalDeviceFeatures2");
+        if(apiVersion < VK_API_VERSION_1_1 || getFeatures2 == nullptr){
+            vkGetPhysicalDeviceFeatures(physicalDevice , &supportedCore);
+            return;
+        }
+
+        resetStructs(supported);
+        linkChain(supported , false);
+        getFeatures2(physicalDevice , &supported.features2);
+        supportedCore = supported.features2.features;
+    }
+
+    void negotiate(){
+        capabilities = 0;
+        extensions.clear();
+        resetStructs(enabled);
+
+        if(apiVersion < VK_API_VERSION_1_1){
+            return;
+        }
+
+        if(apiVersion >= VK_API_VERSION_1_2){
+            const VkPhysicalDeviceVulkan12Features &s = supported.vulkan12;
+            VkPhysicalDeviceVulkan12Features &e = enabled.vulkan12;
+
+            if(s.timelineSemaphore){
+                e.timelineSemaphore = VK_TRUE;
+                capabilities |= CAP_TIMELINE_SEMAPHORE;
+            }
+
+            //bindless 按实例的句柄索引 需要非一致索引
+            if(s.descriptorIndexing && s.runtimeDescriptorArray && s.descriptorBindingPartiallyBound
+                && s.descriptorBindingSampledImageUpdateAfterBind && s.descriptorBindingStorageBufferUpdateAfterBind
+                && s.shaderSampledImageArrayNonUniformIndexing && s.shaderStorageBufferArrayNonUniformIndexing){
+                e.descriptorIndexing = VK_TRUE;
+                e.runtimeDescriptorArray = VK_TRUE;
+                e.descriptorBindingPartiallyBound = VK_TRUE;
+                e.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+                e.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+                e.descriptorBindingVariableDescriptorCount = s.descriptorBindingVariableDescriptorCount;
+                e.shaderSampledImageArrayNonUniformIndexing = s.shaderSampledImageArrayNonUniformIndexing;
+                e.shaderStorageBufferArrayNonUniformIndexing = s.shaderStorageBufferArrayNonUniformIndexing;
+                capabilities |= CAP_DESCRIPTOR_INDEXING;
+            }
+
+            if(s.bufferDeviceAddress){
+                e.bufferDeviceAddress = VK_TRUE;
+                capabilities |= CAP_BUFFER_DEVICE_ADDRESS;
+            }
+
+            if(s.drawIndirectCount){
+                e.drawIndirectCount = VK_TRUE;
+                capabilities |= CAP_DRAW_INDIRECT_COUNT;
+            }
+        }else{
+            if(supported.timeline.timelineSemaphore){
+                enabled.timeline.timelineSemaphore = VK_TRUE;
+                enableExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+                capabilities |= CAP_TIMELINE_SEMAPHORE;
+            }
+
+            const VkPhysicalDeviceDescriptorIndexingFeatures &s = supported.descriptorIndexing;
+            if(s.runtimeDescriptorArray && s.descriptorBindingPartiallyBound
+                && s.descriptorBindingSampledImageUpdateAfterBind && s.descriptorBindingStorageBufferUpdateAfterBind
+                && s.shaderSampledImageArrayNonUniformIndexing && s.shaderStorageBufferArrayNonUniformIndexing){
+                VkPhysicalDeviceDescriptorIndexingFeatures &e = enabled.descriptorIndexing;
+                e.runtimeDescriptorArray = VK_TRUE;
+                e.descriptorBindingPartiallyBound = VK_TRUE;
+                e.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+                e.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+                e.descriptorBindingVariableDescriptorCount = s.descriptorBindingVariableDescriptorCount;
+                e.shaderSampledImageArrayNonUniformIndexing = s.shaderSampledImageArrayNonUniformIndexing;
+                e.shaderStorageBufferArrayNonUniformIndexing = s.shaderStorageBufferArrayNonUniformIndexing;
+                enableExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+                capabilities |= CAP_DESCRIPTOR_INDEXING;
+            }
+
+            if(supported.bufferDeviceAddress.bufferDeviceAddress){
+                enabled.bufferDeviceAddress.bufferDeviceAddress = VK_TRUE;
+                enableExtension(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+                capabilities |= CAP_BUFFER_DEVICE_ADDRESS;
+            }
+
+            if(isExtensionAvailable(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)){
+                enableExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+                capabilities |= CAP_DRAW_INDIRECT_COUNT;
+            }
+        }
+
+        //没有特性结构体 只需开启扩展
+        if(isExtensionAvailable(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)){
+            enableExtension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+            capabilities |= CAP_PUSH_DESCRIPTOR;
+        }
+
+        if(apiVersion >= VK_API_VERSION_1_3){
+            if(supported.vulkan13.synchronization2){
+                enabled.vulkan13.synchronization2 = VK_TRUE;
+                capabilities |= CAP_SYNCHRONIZATION2;
+            }
+            if(supported.vulkan13.dynamicRendering){
+                enabled.vulkan13.dynamicRendering = VK_TRUE;
+                capabilities |= CAP_DYNAMIC_RENDERING;
+            }
+        }else{
+            if(supported.synchronization2.synchronization2){
+                enabled.synchronization2.synchronization2 = VK_TRUE;
+                enableExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+                capabilities |= CAP_SYNCHRONIZATION2;
+            }
+            if(supported.dynamicRendering.dynamicRendering){
+                enabled.dynamicRendering.dynamicRendering = VK_TRUE;
+                enableExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+                capabilities |= CAP_DYNAMIC_RENDERING;
+            }
+        }
+    }
+
+    //填入 VkDeviceCreateInfo  1.1以上通过 pNext 传入 VkPhysicalDeviceFeatures2
+    void fillDeviceCreateInfo(VkDeviceCreateInfo &deviceCreateInfo){
+        if(apiVersion < VK_API_VERSION_1_1){
+            deviceCreateInfo.pNext = nullptr;
+            deviceCreateInfo.pEnabledFeatures = &enabledCore;
+            return;
+        }
+
+        linkChain(enabled , true);
+        enabled.features2.features = enabledCore;
+        deviceCreateInfo.pNext = &enabled.features2;
+        deviceCreateInfo.pEnabledFeatures = nullptr;
+    }
+
+    bool isExtensionAvailable(const char *name) const{
+        return availableExtensionNames.count(name) > 0;
+    }
+
+    bool isExtensionEnabled(const char *name) const{
+        for(const char *extension : extensions){
+            if(std::strcmp(extension , name) == 0){
+                return true;
+            }
+        }//end for each
+        return false;
+    }
+
+    void print() const{
+        std::cout << "device api version " << VK_API_VERSION_MAJOR(apiVersion) << "."
+            << VK_API_VERSION_MINOR(apiVersion) << " capabilities :";
+        for(uint32_t bit = 1 ; bit != 0 && bit <= capabilities ; bit <<= 1){
+            if(capabilities & bit){
+                std::cout << " " << deviceCapabilityName(static_cast<DeviceCapabilityBits>(bit));
+            }
+        }//end for bit
+        std::cout << std::endl;
+    }
+
+private:
+    //一组特性结构体  查询与开启各用一组
+    struct FeatureChain{
+        VkPhysicalDeviceFeatures2 features2;
+        VkPhysicalDeviceVulkan11Features vulkan11;
+        VkPhysicalDeviceVulkan12Features vulkan12;
+        VkPhysicalDeviceVulkan13Features vulkan13;
+
+        //1.2 以下通过扩展提供
+        VkPhysicalDeviceTimelineSemaphoreFeatures timeline;
+        VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexing;
+        VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddress;
+
+        //1.3 以下通过扩展提供
+        VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2;
+        VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRendering;
+    };
+
+    FeatureChain supported;
+    FeatureChain enabled;
+    std::set<std::string> availableExtensionNames;
+
+    void resetStructs(FeatureChain &chain){
+        std::memset(&chain , 0 , sizeof(FeatureChain));
+        chain.features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        chain.vulkan11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+        chain.vulkan12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        chain.vulkan13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        chain.timeline.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        chain.descriptorIndexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        chain.bufferDeviceAddress.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+        chain.synchronization2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+        chain.dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    }
+
+    //按版本串联 pNext  核心版本结构体与其包含的扩展结构体不能同时出现
+    //开启时 只串联已开启扩展的结构体
+    void linkChain(FeatureChain &chain , bool forEnable){
+        void **next = &chain.features2.pNext;
+        auto append = [&next](void *feature , void **featureNext){
+            *next = feature;
+            next = featureNext;
+        };
+        auto useExtension = [this , forEnable](const char *name){
+            return forEnable ? isExtensionEnabled(name) : isExtensionAvailable(name);
+        };
+
+        if(apiVersion >= VK_API_VERSION_1_2){
+            append(&chain.vulkan11 , &chain.vulkan11.pNext);
+            append(&chain.vulkan12 , &chain.vulkan12.pNext);
+        }else{
+            if(useExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)){
+                append(&chain.timeline , &chain.timeline.pNext);
+            }
+            if(useExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)){
+                append(&chain.descriptorIndexing , &chain.descriptorIndexing.pNext);
+            }
+            if(useExtension(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME)){
+                append(&chain.bufferDeviceAddress , &chain.bufferDeviceAddress.pNext);
+            }
+        }
+
+        if(apiVersion >= VK_API_VERSION_1_3){
+            append(&chain.vulkan13 , &chain.vulkan13.pNext);
+        }else{
+            if(useExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)){
+                append(&chain.synchronization2 , &chain.synchronization2.pNext);
+            }
+            //dynamic rendering 扩展依赖的 depth_stencil_resolve / create_renderpass2 在1.2为核心
+            if(apiVersion >= VK_API_VERSION_1_2 && useExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)){
+                append(&chain.dynamicRendering , &chain.dynamicRendering.pNext);
+            }
+        }
+        *next = nullptr;
+    }
+
+    void enableExtension(const char *name){
+        extensions.push_back(name);
+    }
+};
+
+#endif
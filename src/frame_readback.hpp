@@ -0,0 +1,374 @@
+#ifndef _FRAME_READBACK_H_
+#define _FRAME_READBACK_H_
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "device_dispatch.hpp"
+#include "image_io.hpp"
+#include "render_graph.hpp"
+#include "utils.hpp"
+#include "vk_utils.hpp"
+
+//帧回读 (截图 / 帧转储)
+//帧图末尾的复制pass 把交换链图像复制到回读环中一个空闲的 buffer (HOST_VISIBLE | HOST_CACHED 持久映射)
+//该飞行帧的 fence 等待之后 buffer 交给工作线程: invalidate -> 转换为 RGBA (SSE2) -> 写 PNG 或 raw
+//渲染线程从不等待回读: 没有空闲 buffer 时跳过这一帧并计数
+//captureNext 请求回读下一帧 (与间隔无关)  转换后的图像交给回调而不写文件  回归检查使用
+
+enum FrameDumpFormat{
+    FRAME_DUMP_PNG,
+    FRAME_DUMP_RAW
+};
+
+//回读图像的回调  在工作线程上调用 rgba 只在调用期间有效
+using FrameCaptureCallback = std::function<void(const uint8_t *rgba , uint32_t width , uint32_t height)>;
+
+struct FrameReadbackStats{
+    uint64_t captured = 0;//录制了复制的帧
+    uint64_t skipped = 0;//回读环已满 跳过
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> convertNanos{0};
+    std::atomic<uint64_t> encodeNanos{0};
+};
+
+class FrameReadback{
+public:
+    FrameReadbackStats stats;
+
+    //interval: 每 interval 帧回读一次 0 只回读 captureNext 请求的帧  maxFrames: 最多回读的帧数 0 不限
+    //slotCount 个回读 buffer  至少要覆盖飞行帧数 多出的部分给工作线程留出处理时间
+    void init(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd , VkExtent2D extent ,
+            VkFormat format , uint32_t framesInFlight , const std::string &directory , FrameDumpFormat dumpFormat ,
+            uint32_t interval , uint32_t maxFrames , uint32_t slotCount = 4){
+        if(!readbackFormatSupported(format , swapRedBlue)){
+            std::cout << "frame readback disabled : unsupported swapchain format " << format << std::endl;
+            return;
+        }
+        this->device = device;
+        this->vkd = vkd;
+        this->extent = extent;
+        this->directory = directory;
+        this->dumpFormat = dumpFormat;
+        this->interval = interval;
+        this->maxFrames = maxFrames;
+        this->framesInFlight = framesInFlight;
+        std::filesystem::create_directories(directory);
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+        imageBytes = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+        slots.resize(std::max(slotCount , framesInFlight));
+        for(Slot &slot : slots){
+            VkBufferCreateInfo bufferInfo = {};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = imageBytes;
+            bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if(vkCreateBuffer(device , &bufferInfo , nullptr , &slot.buffer) != VK_SUCCESS){
+                throw std::runtime_error("failed to create readback buffer!");
+            }
+
+            VkMemoryRequirements requirements;
+            vkGetBufferMemoryRequirements(device , slot.buffer , &requirements);
+            //CPU 读取 优先带缓存的内存  没有时退回 HOST_COHERENT (读取很慢)
+            int typeIndex = findMemoryTypeIndex(memoryProperties , requirements.memoryTypeBits ,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+            if(typeIndex < 0){
+                typeIndex = static_cast<int>(findMemoryType(memoryProperties , requirements.memoryTypeBits ,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+            }
+            slot.coherent = (memoryProperties.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+            hostCached = (memoryProperties.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0;
+
+            VkMemoryAllocateInfo allocateInfo = {};
+            allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocateInfo.allocationSize = requirements.size;
+            allocateInfo.memoryTypeIndex = static_cast<uint32_t>(typeIndex);
+            if(vkAllocateMemory(device , &allocateInfo , nullptr , &slot.memory) != VK_SUCCESS){
+                throw std::runtime_error("failed to allocate readback memory!");
+            }
+            vkBindBufferMemory(device , slot.buffer , slot.memory , 0);
+            vkMapMemory(device , slot.memory , 0 , VK_WHOLE_SIZE , 0 , &slot.mapped);
+        }//end for each
+        rgba.resize(imageBytes);
+
+        stopRequested = false;
+        worker = std::thread([this](){
+            workLoop();
+        });
+        std::cout << "create frame readback slots : " << slots.size();
+        if(interval > 0){
+            std::cout << " every " << interval << " frames";
+        }else{
+            std::cout << " on request";
+        }
+        std::cout << " format : " << (dumpFormat == FRAME_DUMP_PNG ? "png" : "raw")
+            << (hostCached ? " (host cached)" : " (host coherent)")
+            << " dir : " << directory << std::endl;
+    }
+
+    bool isCreated() const{
+        return !slots.empty();
+    }
+
+    //下一次 addPass 回读该帧 交给 callback  回读环已满时顺延到之后的帧
+    void captureNext(FrameCaptureCallback callback){
+        pendingCapture = std::move(callback);
+    }
+
+    //帧图声明完主pass 之后调用  需要回读时加入复制pass  frameNumber 为帧序号 inFlightIndex 为飞行帧下标
+    void addPass(RenderGraph &graph , RGHandle backbuffer , VkImage image , uint64_t frameNumber , uint32_t inFlightIndex){
+        if(!isCreated()){
+            return;
+        }
+        const bool requested = static_cast<bool>(pendingCapture);
+        const bool periodic = interval > 0 && frameNumber % interval == 0 && (maxFrames == 0 || stats.captured < maxFrames);
+        if(!requested && !periodic){
+            return;
+        }
+        Slot *slot = nullptr;
+        for(Slot &candidate : slots){
+            if(candidate.state.load(std::memory_order_acquire) == SLOT_FREE){
+                slot = &candidate;
+                break;
+            }
+        }//end for each
+        if(slot == nullptr){
+            stats.skipped++;
+            return;
+        }
+        slot->state.store(SLOT_RECORDED , std::memory_order_relaxed);
+        slot->frameNumber = frameNumber;
+        slot->inFlightIndex = inFlightIndex;
+        slot->callback = std::move(pendingCapture);
+        pendingCapture = nullptr;
+        if(periodic){
+            stats.captured++;
+        }
+
+        //复制完成后对主机可见 由帧图在末尾插入到 HOST 阶段的屏障
+        RGResourceState unused;
+        RGHandle target = graph.importBuffer("readback" , slot->buffer , imageBytes , unused);
+        RGResourceState hostRead;
+        hostRead.stage = VK_PIPELINE_STAGE_HOST_BIT;
+        hostRead.access = VK_ACCESS_HOST_READ_BIT;
+        graph.markOutput(target , hostRead);
+
+        const VkBuffer buffer = slot->buffer;
+        const VkExtent2D imageExtent = extent;
+        DeviceDispatchTable *vkd = this->vkd;
+        graph.addPass("readback" , RG_PASS_TRANSFER)
+            .read(backbuffer , RG_ACCESS_TRANSFER_SRC)
+            .write(target , RG_ACCESS_TRANSFER_DST)
+            .setSideEffect()
+            .setExecute([vkd , image , buffer , imageExtent](VkCommandBuffer cmd){
+                VkBufferImageCopy region = {};
+                region.bufferOffset = 0;
+                region.bufferRowLength = 0;//紧密排列
+                region.bufferImageHeight = 0;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel = 0;
+                region.imageSubresource.baseArrayLayer = 0;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = {imageExtent.width , imageExtent.height , 1};
+                vkd->vkCmdCopyImageToBuffer(cmd , image , VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL , buffer , 1 , &region);
+            });
+    }
+
+    //该飞行帧的 fence 等待之后调用  把其中录制的回读交给工作线程
+    void frameCompleted(uint32_t inFlightIndex){
+        if(!isCreated()){
+            return;
+        }
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(uint32_t i = 0 ; i < slots.size() ; i++){
+                Slot &slot = slots[i];
+                if(slot.state.load(std::memory_order_relaxed) == SLOT_RECORDED && slot.inFlightIndex == inFlightIndex){
+                    slot.state.store(SLOT_QUEUED , std::memory_order_relaxed);
+                    queue.push_back(i);
+                    queued = true;
+                }
+            }//end for i
+        }
+        if(queued){
+            wakeup.notify_one();
+        }
+    }
+
+    //设备空闲后调用  把已录制的回读全部交给工作线程 并等待处理完
+    void flush(){
+        if(!isCreated()){
+            return;
+        }
+        for(uint32_t frame = 0 ; frame < framesInFlight ; frame++){
+            frameCompleted(frame);
+        }//end for frame
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock , [this](){ return queue.empty() && !processing; });
+    }
+
+    //设备空闲后调用  等待工作线程写完 释放资源
+    void destroy(){
+        if(!isCreated()){
+            return;
+        }
+        for(uint32_t frame = 0 ; frame < framesInFlight ; frame++){
+            frameCompleted(frame);
+        }//end for frame
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        wakeup.notify_all();
+        worker.join();
+
+        for(Slot &slot : slots){
+            vkUnmapMemory(device , slot.memory);
+            vkDestroyBuffer(device , slot.buffer , nullptr);
+            vkFreeMemory(device , slot.memory , nullptr);
+        }//end for each
+        slots.clear();
+        report();
+    }
+
+    void report() const{
+        const uint64_t written = stats.written.load();
+        std::cout << "frame readback written : " << written
+            << " skipped (ring full) : " << stats.skipped
+            << " failed : " << stats.failed.load();
+        if(written > 0){
+            std::cout << " convert : " << stats.convertNanos.load() / 1e6 / written << " ms"
+                << " encode : " << stats.encodeNanos.load() / 1e6 / written << " ms";
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    enum SlotState{
+        SLOT_FREE = 0,
+        SLOT_RECORDED,//复制已录制 GPU 尚未完成
+        SLOT_QUEUED//等待或正在由工作线程处理
+    };
+
+    struct Slot{
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void *mapped = nullptr;
+        bool coherent = false;
+        std::atomic<int> state{SLOT_FREE};
+        uint64_t frameNumber = 0;
+        uint32_t inFlightIndex = 0;
+        FrameCaptureCallback callback;//非空时交给回调 不写文件
+
+        Slot() = default;
+        Slot(const Slot &other) : buffer(other.buffer) , memory(other.memory) , mapped(other.mapped) ,
+            coherent(other.coherent) , state(other.state.load()) , frameNumber(other.frameNumber) ,
+            inFlightIndex(other.inFlightIndex) , callback(other.callback){}
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkExtent2D extent = {0 , 0};
+    VkDeviceSize imageBytes = 0;
+    bool swapRedBlue = false;
+    bool hostCached = false;
+    std::string directory;
+    FrameDumpFormat dumpFormat = FRAME_DUMP_PNG;
+    uint32_t interval = 0;
+    uint32_t maxFrames = 0;
+    uint32_t framesInFlight = 0;
+
+    std::vector<Slot> slots;
+    std::deque<uint32_t> queue;//等待处理的 slot 下标
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable idle;//队列为空且工作线程空闲 (flush 等待)
+    std::thread worker;
+    bool stopRequested = false;
+    bool processing = false;
+    FrameCaptureCallback pendingCapture;//只由渲染线程访问
+
+    //只由工作线程使用
+    std::vector<uint8_t> rgba;
+    std::vector<uint8_t> encodeScratch;
+
+    void workLoop(){
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;){
+            wakeup.wait(lock , [this](){ return stopRequested || !queue.empty(); });
+            if(queue.empty()){
+                break;
+            }
+            const uint32_t index = queue.front();
+            queue.pop_front();
+            processing = true;
+            lock.unlock();
+            process(slots[index]);
+            slots[index].callback = nullptr;
+            slots[index].state.store(SLOT_FREE , std::memory_order_release);
+            lock.lock();
+            processing = false;
+            if(queue.empty()){
+                idle.notify_all();
+            }
+        }//end for
+    }
+
+    void process(Slot &slot){
+        if(!slot.coherent){
+            VkMappedMemoryRange range = {};
+            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = slot.memory;
+            range.offset = 0;
+            range.size = VK_WHOLE_SIZE;
+            vkInvalidateMappedMemoryRanges(device , 1 , &range);
+        }
+
+        uint64_t start = currentTimeNanos();
+        convertToRgba(static_cast<const uint8_t *>(slot.mapped) , rgba.data() ,
+            static_cast<size_t>(extent.width) * extent.height , swapRedBlue);
+        stats.convertNanos += currentTimeNanos() - start;
+
+        if(slot.callback){
+            slot.callback(rgba.data() , extent.width , extent.height);
+            return;
+        }
+
+        start = currentTimeNanos();
+        char name[64];
+        bool ok = false;
+        if(dumpFormat == FRAME_DUMP_PNG){
+            std::snprintf(name , sizeof(name) , "frame_%06llu.png" , static_cast<unsigned long long>(slot.frameNumber));
+            ok = writePng(directory + "/" + name , rgba.data() , extent.width , extent.height , encodeScratch);
+        }else{
+            std::snprintf(name , sizeof(name) , "frame_%06llu_%ux%u.rgba" , static_cast<unsigned long long>(slot.frameNumber) ,
+                extent.width , extent.height);
+            ok = writeRaw(directory + "/" + name , rgba.data() , extent.width , extent.height);
+        }
+        stats.encodeNanos += currentTimeNanos() - start;
+        if(ok){
+            stats.written++;
+        }else{
+            stats.failed++;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,600 @@
+#ifndef _GPU_DRIVEN_H_
+#define _GPU_DRIVEN_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "descriptor_allocator.hpp"
+#include "device_dispatch.hpp"
+#include "instancing.hpp"
+#include "vk_utils.hpp"
+
+//GPU 驱动的绘制
+//物体数据 (实例流 + 包围球 + 网格/材质) 上传一次 常驻
+//每帧由计算着色器 (shaders/cull.comp) 对包围球做视锥剔除  可见物体写入一条 VkDrawIndexedIndirectCommand
+//  firstInstance 为物体序号 顶点着色器通过实例流读取该物体的数据
+//  每个材质一段命令区域 大小为该材质的物体数  数量由 atomicAdd 累加到 count 区域  绘制时每个材质一次 vkCmdDrawIndexedIndirectCount
+//不支持 drawIndirectCount 时在CPU剔除 写入同样的命令  使用 vkCmdDrawIndexedIndirect
+//两种方式的录制开销都只与材质数有关 与物体数无关
+//
+//两阶段遮挡剔除 (enableOcclusion 之后 upload)  每个物体一个可见性标记 跨帧保留:
+//  phase 1 绘制上一帧可见的物体 (命令区域A) -> 由此时的深度生成 Hi-Z (HiZPyramid)
+//  phase 2 用 Hi-Z 测试全部物体 更新可见性  新变为可见的物体写入命令区域B 在第二次渲染中绘制
+//剔除的描述符集每帧从 DescriptorAllocator 分配 用更新模板一次写入
+
+//平面 (n.xyz , d)  dot(n , c) + d >= -r 时包围球可见
+struct FrustumPlanes{
+    float planes[6][4];
+};
+
+//与 shaders/cull.comp 中的 CullParams 对应 (push constant)
+struct CullParams{
+    float planes[6][4];
+    float view[4];//xy 相机偏移  z 缩放  w reverse-Z
+    uint32_t objectCount;
+    uint32_t drawsPerRegion;//每个命令区域的命令数 (物体数)
+    uint32_t materialCount;
+    uint32_t phase;//0 只做视锥剔除  1/2 遮挡剔除的两个阶段
+};
+
+//剔除描述符集的内容  与更新模板的条目对应
+struct CullDescriptors{
+    VkDescriptorBufferInfo buffers[6];//0 bounds  1 drawInfos  2 meshes  3 commands  4 counts  5 visibility
+    VkDescriptorImageInfo hiz;//6
+};
+
+struct CullStats{
+    uint32_t objects = 0;
+    uint32_t visible = 0;
+    uint32_t frustumCulled = 0;//只在遮挡剔除时统计
+    uint32_t occluded = 0;
+    uint32_t drawCalls = 0;
+};
+
+class GpuDrivenScene{
+public:
+    CullStats stats;
+
+    //cullShaderCode 为空时只能使用CPU剔除  occlusionShaderCode 为空时不支持遮挡剔除
+    //布局来自 layoutCache  每帧的描述符集来自 descriptorAllocator
+    void init(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd , uint32_t framesInFlight ,
+            uint32_t materialCount , bool multiDrawIndirect , const std::vector<char> &cullShaderCode ,
+            const std::vector<char> &occlusionShaderCode , DescriptorLayoutCache *layoutCache ,
+            DescriptorAllocator *descriptorAllocator){
+        this->device = device;
+        this->vkd = vkd;
+        this->layoutCache = layoutCache;
+        this->descriptorAllocator = descriptorAllocator;
+        this->materialCount = materialCount;
+        this->multiDrawIndirect = multiDrawIndirect;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice , &properties);
+        storageAlignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment , 16);
+
+        frames.resize(framesInFlight);
+        if(!cullShaderCode.empty()){
+            createCullPipeline(cullShaderCode , false , frustumCull);
+        }
+        if(!occlusionShaderCode.empty()){
+            createCullPipeline(occlusionShaderCode , true , occlusionCull);
+        }
+    }
+
+    void destroy(){
+        destroyBuffers();
+        frames.clear();
+        for(CullPipeline *cull : {&frustumCull , &occlusionCull}){
+            cull->updateTemplate.destroy();
+            vkDestroyPipeline(device , cull->pipeline , nullptr);
+            vkDestroyPipelineLayout(device , cull->layout , nullptr);
+            *cull = CullPipeline();
+        }//end for each
+    }
+
+    bool gpuCullingAvailable() const{
+        return frustumCull.pipeline != VK_NULL_HANDLE && vkd->vkCmdDrawIndexedIndirectCount != nullptr;
+    }
+
+    bool occlusionAvailable() const{
+        return gpuCullingAvailable() && occlusionCull.pipeline != VK_NULL_HANDLE;
+    }
+
+    //异步计算队列做剔除时 buffer 需要在两个队列簇之间共享  下一次 upload 时生效
+    void setQueueFamilies(int graphicsFamily , int asyncFamily){
+        queueFamilies.clear();
+        if(asyncFamily >= 0 && asyncFamily != graphicsFamily){
+            queueFamilies = {static_cast<uint32_t>(graphicsFamily) , static_cast<uint32_t>(asyncFamily)};
+        }
+    }
+
+    //下一次 upload 时生效
+    void enableOcclusion(bool enable){
+        occlusion = enable && occlusionAvailable();
+    }
+
+    bool occlusionEnabled() const{
+        return occlusion;
+    }
+
+    //Hi-Z 重建后需要重新设置  下一次 recordCull 生效
+    void setHiZ(VkImageView view , VkSampler sampler){
+        hizView = view;
+        hizSampler = sampler;
+    }
+
+    uint32_t addMesh(const MeshRange &mesh){
+        meshes.push_back(mesh);
+        return static_cast<uint32_t>(meshes.size() - 1);
+    }
+
+    void clear(){
+        objects.clear();
+        bounds.clear();
+        drawInfos.clear();
+    }
+
+    //radius 为物体包围球半径
+    void add(uint32_t mesh , uint32_t material , const InstanceData &data , float radius){
+        objects.push_back(data);
+        bounds.push_back({data.transform[0] , data.transform[1] , data.transform[2] , radius});
+        drawInfos.push_back((material << 16) | (mesh & 0xFFFFu));
+    }
+
+    uint32_t count() const{
+        return static_cast<uint32_t>(objects.size());
+    }
+
+    //物体数据上传到常驻buffer  调用前需保证GPU不再使用旧的buffer
+    void upload(){
+        destroyBuffers();
+        if(objects.empty()){
+            return;
+        }
+
+        const uint32_t objectCount = count();
+        drawsPerRegion = objectCount;
+
+        //每个材质的命令段从 materialFirstDraw 开始 长度为该材质的物体数
+        materialDraws.assign(materialCount , 0);
+        for(uint32_t info : drawInfos){
+            materialDraws[info >> 16]++;
+        }//end for each
+        materialFirstDraw.assign(materialCount , 0);
+        for(uint32_t material = 1 ; material < materialCount ; material++){
+            materialFirstDraw[material] = materialFirstDraw[material - 1] + materialDraws[material - 1];
+        }//end for material
+
+        //实例流 (顶点输入) 与剔除输入 (storage) 放在同一个buffer
+        VkDeviceSize offset = 0;
+        auto region = [this , &offset](VkDeviceSize size){
+            VkDeviceSize start = offset;
+            offset = alignUp(offset + size , storageAlignment);
+            return start;
+        };
+        for(uint32_t i = 0 ; i < INSTANCE_STREAM_COUNT ; i++){
+            streamOffsets[i] = region(static_cast<VkDeviceSize>(objectCount) * INSTANCE_STREAM_STRIDES[i]);
+        }//end for i
+        boundsOffset = region(sizeof(float) * 4 * objectCount);
+        drawInfoOffset = region(sizeof(uint32_t) * (objectCount + materialCount));
+        visibilityOffset = region(occlusion ? sizeof(uint32_t) * objectCount : 0);
+        meshOffset = region(sizeof(uint32_t) * 2 * meshes.size());
+        indexOffset = region(sizeof(uint16_t) * indexTableSize());
+
+        void *mapped = nullptr;
+        createMappedBuffer(offset , VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT , objectBuffer , objectMemory , &mapped);
+        objectBufferSize = offset;
+
+        char *base = static_cast<char *>(mapped);
+        float *transforms = reinterpret_cast<float *>(base + streamOffsets[INSTANCE_STREAM_TRANSFORM]);
+        uint32_t *colors = reinterpret_cast<uint32_t *>(base + streamOffsets[INSTANCE_STREAM_COLOR]);
+        float *customs = reinterpret_cast<float *>(base + streamOffsets[INSTANCE_STREAM_CUSTOM]);
+        for(uint32_t i = 0 ; i < objectCount ; i++){
+            std::memcpy(transforms + i * 4 , objects[i].transform , sizeof(objects[i].transform));
+            colors[i] = objects[i].color;
+            std::memcpy(customs + i * 2 , objects[i].custom , sizeof(objects[i].custom));
+        }//end for i
+        std::memcpy(base + boundsOffset , bounds.data() , sizeof(BoundsEntry) * objectCount);
+        std::memcpy(base + drawInfoOffset , drawInfos.data() , sizeof(uint32_t) * objectCount);
+        //drawInfos 之后是每个材质第一条命令的序号
+        std::memcpy(base + drawInfoOffset + sizeof(uint32_t) * objectCount , materialFirstDraw.data() ,
+            sizeof(uint32_t) * materialCount);
+        if(occlusion){
+            //第一帧没有物体可见 phase 2 对照空的 Hi-Z 全部通过
+            std::memset(base + visibilityOffset , 0 , sizeof(uint32_t) * objectCount);
+        }
+
+        //网格 firstIndex/indexCount  索引表是恒等映射 gl_VertexIndex 即内置顶点表下标
+        uint32_t *meshTable = reinterpret_cast<uint32_t *>(base + meshOffset);
+        for(size_t i = 0 ; i < meshes.size() ; i++){
+            meshTable[i * 2] = meshes[i].firstVertex;
+            meshTable[i * 2 + 1] = meshes[i].vertexCount;
+        }//end for i
+        uint16_t *indices = reinterpret_cast<uint16_t *>(base + indexOffset);
+        for(uint32_t i = 0 ; i < indexTableSize() ; i++){
+            indices[i] = static_cast<uint16_t>(i);
+        }//end for i
+        vkUnmapMemory(device , objectMemory);
+
+        //每个飞行帧一份绘制命令  count 区域在前 命令区域在后
+        //遮挡剔除时两个阶段各一组区域  count 区域最后是视锥内物体数与被遮挡物体数
+        regionCount = occlusion ? 2 : 1;
+        commandsOffset = alignUp(countRegionSize() , storageAlignment);
+        const VkDeviceSize drawSize = commandsOffset + sizeof(VkDrawIndexedIndirectCommand)
+            * static_cast<VkDeviceSize>(drawsPerRegion) * regionCount;
+        for(FrameDraws &frame : frames){
+            createMappedBuffer(drawSize , VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT , frame.buffer , frame.memory , &frame.mapped);
+            frame.size = drawSize;
+        }//end for each
+
+        stats.objects = objectCount;
+    }
+
+    //常驻的物体数据  遮挡剔除时其中的可见性标记由 phase 2 写入 下一帧 phase 1 读取
+    VkBuffer sceneBuffer() const{
+        return objectBuffer;
+    }
+
+    VkDeviceSize sceneBufferSize() const{
+        return objectBufferSize;
+    }
+
+    VkBuffer drawBuffer(uint32_t frame) const{
+        return frames[frame].buffer;
+    }
+
+    VkDeviceSize drawBufferSize(uint32_t frame) const{
+        return frames[frame].size;
+    }
+
+    //清零本帧的 count 区域  在剔除之前执行
+    void recordReset(VkCommandBuffer cmd , uint32_t frame){
+        vkd->vkCmdFillBuffer(cmd , frames[frame].buffer , 0 , countRegionSize() , 0);
+    }
+
+    //view 用于把包围球投影到 Hi-Z  phase 为 0 时只做视锥剔除
+    void recordCull(VkCommandBuffer cmd , uint32_t frame , const FrustumPlanes &frustum , const float view[4] ,
+            uint32_t phase){
+        CullParams params = {};
+        std::memcpy(params.planes , frustum.planes , sizeof(params.planes));
+        std::memcpy(params.view , view , sizeof(params.view));
+        params.objectCount = count();
+        params.drawsPerRegion = drawsPerRegion;
+        params.materialCount = materialCount;
+        params.phase = phase;
+
+        const CullPipeline &cull = phase == 0 ? frustumCull : occlusionCull;
+        const VkDescriptorSet set = allocateCullSet(frame , cull);
+        vkd->vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_COMPUTE , cull.pipeline);
+        vkd->vkCmdBindDescriptorSets(cmd , VK_PIPELINE_BIND_POINT_COMPUTE , cull.layout , 0 , 1 , &set , 0 , nullptr);
+        vkd->vkCmdPushConstants(cmd , cull.layout , VK_SHADER_STAGE_COMPUTE_BIT , 0 , sizeof(CullParams) , &params);
+        vkd->vkCmdDispatch(cmd , (params.objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE , 1 , 1);
+    }
+
+    //CPU剔除  直接写入本帧的绘制命令 (该帧的fence等待之后调用)
+    void cullOnCpu(uint32_t frame , const FrustumPlanes &frustum){
+        FrameDraws &draws = frames[frame];
+        draws.cpuCounts.assign(materialCount , 0);
+        VkDrawIndexedIndirectCommand *commands = reinterpret_cast<VkDrawIndexedIndirectCommand *>(
+            static_cast<char *>(draws.mapped) + commandsOffset);
+
+        const uint32_t objectCount = count();
+        for(uint32_t i = 0 ; i < objectCount ; i++){
+            if(!isVisible(bounds[i].sphere , frustum)){
+                continue;
+            }
+            const uint32_t material = drawInfos[i] >> 16;
+            const MeshRange &mesh = meshes[drawInfos[i] & 0xFFFFu];
+
+            VkDrawIndexedIndirectCommand &command = commands[materialFirstDraw[material] + draws.cpuCounts[material]++];
+            command.indexCount = mesh.vertexCount;
+            command.instanceCount = 1;
+            command.firstIndex = mesh.firstVertex;
+            command.vertexOffset = 0;
+            command.firstInstance = i;
+        }//end for i
+        std::memcpy(draws.mapped , draws.cpuCounts.data() , sizeof(uint32_t) * materialCount);
+    }
+
+    //gpuCulled 为 true 时数量来自 count 区域  否则来自 cullOnCpu 的结果
+    //region 为遮挡剔除的命令区域 0: phase 1  1: phase 2
+    void recordDraw(VkCommandBuffer cmd , uint32_t frame , bool gpuCulled ,
+            const std::vector<VkPipeline> &materialPipelines , VkPipeline overridePipeline , uint32_t region = 0){
+        const FrameDraws &draws = frames[frame];
+        if(draws.buffer == VK_NULL_HANDLE){
+            return;
+        }
+
+        VkBuffer buffers[INSTANCE_STREAM_COUNT] = {objectBuffer , objectBuffer , objectBuffer};
+        vkd->vkCmdBindVertexBuffers(cmd , 0 , INSTANCE_STREAM_COUNT , buffers , streamOffsets);
+        vkd->vkCmdBindIndexBuffer(cmd , objectBuffer , indexOffset , VK_INDEX_TYPE_UINT16);
+
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        if(region == 0){
+            stats.drawCalls = 0;
+        }
+        VkPipeline bound = VK_NULL_HANDLE;
+        for(uint32_t material = 0 ; material < materialCount ; material++){
+            if(materialDraws[material] == 0){
+                continue;
+            }
+            VkPipeline pipeline = overridePipeline != VK_NULL_HANDLE ? overridePipeline : materialPipelines[material];
+            if(pipeline != bound){
+                vkd->vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , pipeline);
+                bound = pipeline;
+            }
+
+            const uint32_t slot = region * materialCount + material;
+            const VkDeviceSize offset = commandsOffset
+                + (static_cast<VkDeviceSize>(region) * drawsPerRegion + materialFirstDraw[material]) * stride;
+            if(gpuCulled){
+                vkd->vkCmdDrawIndexedIndirectCount(cmd , draws.buffer , offset , draws.buffer ,
+                    sizeof(uint32_t) * slot , materialDraws[material] , stride);
+                stats.drawCalls++;
+            }else if(multiDrawIndirect){
+                if(draws.cpuCounts[material] > 0){
+                    vkd->vkCmdDrawIndexedIndirect(cmd , draws.buffer , offset , draws.cpuCounts[material] , stride);
+                    stats.drawCalls++;
+                }
+            }else{
+                //不支持 multiDrawIndirect 时 drawCount 只能为1
+                for(uint32_t i = 0 ; i < draws.cpuCounts[material] ; i++){
+                    vkd->vkCmdDrawIndexedIndirect(cmd , draws.buffer , offset + i * stride , 1 , stride);
+                    stats.drawCalls++;
+                }//end for i
+            }
+        }//end for material
+    }
+
+    //上一次使用该帧数据的可见物体数  需在该帧的fence等待之后读取
+    uint32_t visibleCount(uint32_t frame) const{
+        const FrameDraws &draws = frames[frame];
+        if(draws.mapped == nullptr){
+            return 0;
+        }
+        const uint32_t *counts = static_cast<const uint32_t *>(draws.mapped);
+        uint32_t visible = 0;
+        for(uint32_t slot = 0 ; slot < materialCount * regionCount ; slot++){
+            visible += counts[slot];
+        }//end for slot
+        return visible;
+    }
+
+    //可见数 与遮挡剔除的统计写入 stats
+    void readStats(uint32_t frame){
+        stats.visible = visibleCount(frame);
+        stats.frustumCulled = 0;
+        stats.occluded = 0;
+        if(occlusion && frames[frame].mapped != nullptr){
+            const uint32_t *counts = static_cast<const uint32_t *>(frames[frame].mapped);
+            const uint32_t inFrustum = counts[materialCount * 2];
+            stats.frustumCulled = inFrustum <= count() ? count() - inFrustum : 0;
+            stats.occluded = counts[materialCount * 2 + 1];
+        }
+    }
+
+    static bool isVisible(const float sphere[4] , const FrustumPlanes &frustum){
+        for(int i = 0 ; i < 6 ; i++){
+            const float *plane = frustum.planes[i];
+            if(plane[0] * sphere[0] + plane[1] * sphere[1] + plane[2] * sphere[2] + plane[3] < -sphere[3]){
+                return false;
+            }
+        }//end for i
+        return true;
+    }
+
+private:
+    static const uint32_t CULL_GROUP_SIZE = 64;//与 cull.comp 的 local_size_x 一致
+
+    struct BoundsEntry{
+        float sphere[4];
+    };
+
+    struct FrameDraws{
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void *mapped = nullptr;
+        VkDeviceSize size = 0;
+        std::vector<uint32_t> cpuCounts;
+    };
+
+    struct CullPipeline{
+        VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;//由 layoutCache 持有
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        DescriptorUpdateTemplate updateTemplate;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    VkDeviceSize storageAlignment = 16;
+    uint32_t materialCount = 1;
+    bool multiDrawIndirect = false;
+    std::vector<uint32_t> queueFamilies;//非空时 buffer 为 CONCURRENT
+
+    std::vector<MeshRange> meshes;
+    std::vector<InstanceData> objects;
+    std::vector<BoundsEntry> bounds;
+    std::vector<uint32_t> drawInfos;
+
+    VkBuffer objectBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory objectMemory = VK_NULL_HANDLE;
+    VkDeviceSize objectBufferSize = 0;
+    VkDeviceSize streamOffsets[INSTANCE_STREAM_COUNT] = {};
+    VkDeviceSize boundsOffset = 0;
+    VkDeviceSize drawInfoOffset = 0;
+    VkDeviceSize visibilityOffset = 0;
+    VkDeviceSize meshOffset = 0;
+    VkDeviceSize indexOffset = 0;
+    VkDeviceSize commandsOffset = 0;
+    uint32_t drawsPerRegion = 0;
+    std::vector<uint32_t> materialDraws;//每个材质的物体数
+    std::vector<uint32_t> materialFirstDraw;//每个材质在命令区域中的起点
+    uint32_t regionCount = 1;
+    std::vector<FrameDraws> frames;
+
+    DescriptorLayoutCache *layoutCache = nullptr;
+    DescriptorAllocator *descriptorAllocator = nullptr;
+    CullPipeline frustumCull;
+    CullPipeline occlusionCull;//cull.comp 定义 OCCLUSION 编译  多出可见性与 Hi-Z 两个 binding
+    bool occlusion = false;
+    VkImageView hizView = VK_NULL_HANDLE;
+    VkSampler hizSampler = VK_NULL_HANDLE;
+
+    //每个区域每个材质一个数量  遮挡剔除时最后两个为统计
+    VkDeviceSize countRegionSize() const{
+        return sizeof(uint32_t) * (materialCount * regionCount + (occlusion ? 2 : 0));
+    }
+
+    uint32_t indexTableSize() const{
+        uint32_t size = 0;
+        for(const MeshRange &mesh : meshes){
+            size = std::max(size , mesh.firstVertex + mesh.vertexCount);
+        }//end for each
+        return size;
+    }
+
+    //host可见的buffer 优先同时是显存
+    void createMappedBuffer(VkDeviceSize size , VkBufferUsageFlags usage , VkBuffer &buffer ,
+            VkDeviceMemory &memory , void **mapped){
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = size;
+        bufferCreateInfo.usage = usage;
+        if(queueFamilies.size() > 1){
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            bufferCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+        }else{
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+        if(vkCreateBuffer(device , &bufferCreateInfo , nullptr , &buffer) != VK_SUCCESS){
+            throw std::runtime_error("failed to create gpu driven buffer!");
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device , buffer , &requirements);
+
+        const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        int memoryType = findMemoryTypeIndex(memoryProperties , requirements.memoryTypeBits ,
+            hostVisible | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(memoryType < 0){
+            memoryType = static_cast<int>(findMemoryType(memoryProperties , requirements.memoryTypeBits , hostVisible));
+        }
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = static_cast<uint32_t>(memoryType);
+        if(vkAllocateMemory(device , &allocateInfo , nullptr , &memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate gpu driven buffer memory!");
+        }
+        vkBindBufferMemory(device , buffer , memory , 0);
+        vkMapMemory(device , memory , 0 , VK_WHOLE_SIZE , 0 , mapped);
+    }
+
+    void destroyBuffers(){
+        for(FrameDraws &frame : frames){
+            if(frame.buffer != VK_NULL_HANDLE){
+                vkUnmapMemory(device , frame.memory);
+                vkDestroyBuffer(device , frame.buffer , nullptr);
+                vkFreeMemory(device , frame.memory , nullptr);
+            }
+            frame = FrameDraws();
+        }//end for each
+
+        vkDestroyBuffer(device , objectBuffer , nullptr);
+        vkFreeMemory(device , objectMemory , nullptr);
+        objectBuffer = VK_NULL_HANDLE;
+        objectMemory = VK_NULL_HANDLE;
+        objectBufferSize = 0;
+    }
+
+    //0 bounds  1 drawInfos  2 meshes  3 commands  4 counts  (遮挡剔除) 5 visibility  6 hiz
+    void createCullPipeline(const std::vector<char> &code , bool withOcclusion , CullPipeline &cull){
+        const uint32_t bindingCount = withOcclusion ? 7 : 5;
+        std::vector<VkDescriptorSetLayoutBinding> bindings(bindingCount);
+        std::vector<VkDescriptorUpdateTemplateEntry> entries(bindingCount);
+        for(uint32_t i = 0 ; i < bindingCount ; i++){
+            const bool image = i == 6;
+            bindings[i] = {};
+            bindings[i].binding = i;
+            bindings[i].descriptorType = image ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            entries[i] = image
+                ? DescriptorUpdateTemplate::imageEntry(i , bindings[i].descriptorType , offsetof(CullDescriptors , hiz))
+                : DescriptorUpdateTemplate::bufferEntry(i , bindings[i].descriptorType ,
+                    offsetof(CullDescriptors , buffers) + sizeof(VkDescriptorBufferInfo) * i);
+        }//end for i
+        cull.setLayout = layoutCache->get(bindings);
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullParams);
+
+        VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutCreateInfo.setLayoutCount = 1;
+        layoutCreateInfo.pSetLayouts = &cull.setLayout;
+        layoutCreateInfo.pushConstantRangeCount = 1;
+        layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        if(vkCreatePipelineLayout(device , &layoutCreateInfo , nullptr , &cull.layout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create cull pipeline layout!");
+        }
+
+        VkShaderModuleCreateInfo moduleCreateInfo = {};
+        moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleCreateInfo.codeSize = code.size();
+        moduleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        VkShaderModule module;
+        if(vkCreateShaderModule(device , &moduleCreateInfo , nullptr , &module) != VK_SUCCESS){
+            throw std::runtime_error("failed to create cull shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreateInfo.stage.module = module;
+        pipelineCreateInfo.stage.pName = "main";
+        pipelineCreateInfo.layout = cull.layout;
+        VkResult result = vkCreateComputePipelines(device , VK_NULL_HANDLE , 1 , &pipelineCreateInfo , nullptr , &cull.pipeline);
+        vkDestroyShaderModule(device , module , nullptr);
+        if(result != VK_SUCCESS){
+            throw std::runtime_error("failed to create cull pipeline!");
+        }
+        cull.updateTemplate.create(device , vkd , cull.setLayout , entries);
+    }
+
+    //本帧的剔除描述符集  物体数据或 Hi-Z 变化后不需要额外处理
+    VkDescriptorSet allocateCullSet(uint32_t frame , const CullPipeline &cull){
+        const FrameDraws &draws = frames[frame];
+        const uint32_t objectCount = count();
+
+        CullDescriptors descriptors = {};
+        descriptors.buffers[0] = {objectBuffer , boundsOffset , sizeof(float) * 4 * objectCount};
+        descriptors.buffers[1] = {objectBuffer , drawInfoOffset , sizeof(uint32_t) * (objectCount + materialCount)};
+        descriptors.buffers[2] = {objectBuffer , meshOffset , sizeof(uint32_t) * 2 * meshes.size()};
+        descriptors.buffers[3] = {draws.buffer , commandsOffset , draws.size - commandsOffset};
+        descriptors.buffers[4] = {draws.buffer , 0 , countRegionSize()};
+        descriptors.buffers[5] = {objectBuffer , visibilityOffset , sizeof(uint32_t) * objectCount};
+        descriptors.hiz = {hizSampler , hizView , VK_IMAGE_LAYOUT_GENERAL};
+
+        const VkDescriptorSet set = descriptorAllocator->allocate(frame , cull.setLayout);
+        cull.updateTemplate.update(set , &descriptors);
+        return set;
+    }
+};
+
+#endif
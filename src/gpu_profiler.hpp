@@ -0,0 +1,512 @@
+#ifndef _GPU_PROFILER_H_
+#define _GPU_PROFILER_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "device_dispatch.hpp"
+#include "utils.hpp"
+
+//GPU 计时 (VK_QUERY_TYPE_TIMESTAMP)
+//作用域在指令缓存中写入开始与结束时间戳  同时记录录制该作用域的 CPU 时间
+//每个飞行帧占用查询池中的一段: 前半段图形队列 后半段异步计算队列  各自在该帧第一次使用时重置
+//结果在同一飞行帧下一次开始时 (fence 等待之后) 读回  不使用 VK_QUERY_RESULT_WAIT_BIT
+//trace 导出为 Chrome trace_event 格式 (chrome://tracing 或 Perfetto 打开)
+//GPU 时间戳与 CPU 时钟不同源  每帧以提交时刻的 CPU 时间对齐该帧第一个图形时间戳
+//设备开启 pipelineStatisticsQuery 时 图形队列上每个pass 的作用域同时包一个 VK_QUERY_TYPE_PIPELINE_STATISTICS 查询
+//同一类型的查询不能嵌套  整帧作用域只有时间戳  异步计算队列不统计
+
+static const uint32_t GPU_SCOPE_INVALID = ~0u;
+
+//统计的计数器 与 GPU_STATISTIC_FLAGS 中位的顺序一致 (查询结果按位从低到高排列)
+enum GpuStatistic{
+    GPU_STATISTIC_VERTICES = 0,//输入装配的顶点数
+    GPU_STATISTIC_PRIMITIVES,//输入装配的图元数
+    GPU_STATISTIC_VERTEX_INVOCATIONS,
+    GPU_STATISTIC_CLIPPING_INVOCATIONS,//进入裁剪阶段的图元数
+    GPU_STATISTIC_CLIPPING_PRIMITIVES,//裁剪后输出的图元数
+    GPU_STATISTIC_FRAGMENT_INVOCATIONS,
+    GPU_STATISTIC_COMPUTE_INVOCATIONS,
+    GPU_STATISTIC_COUNT
+};
+
+static const VkQueryPipelineStatisticFlags GPU_STATISTIC_FLAGS =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+static const char *gpuStatisticName(uint32_t statistic){
+    static const char *names[GPU_STATISTIC_COUNT] = {
+        "vertices" , "primitives" , "vs" , "clip in" , "clip out" , "fs" , "cs"
+    };
+    return statistic < GPU_STATISTIC_COUNT ? names[statistic] : "unknown";
+}
+
+//按名称汇总的耗时
+struct GpuScopeStats{
+    uint64_t count = 0;
+    double gpuTotalMs = 0.0;
+    double gpuMinMs = 1e30;
+    double gpuMaxMs = 0.0;
+    double cpuTotalMs = 0.0;
+
+    //管线统计  statisticsCount 为有效样本数
+    uint64_t statisticsCount = 0;
+    uint64_t statistics[GPU_STATISTIC_COUNT] = {};
+
+    //每个样本的平均值
+    double averageStatistic(uint32_t statistic) const{
+        return statisticsCount > 0 ? static_cast<double>(statistics[statistic]) / statisticsCount : 0.0;
+    }
+};
+
+class GpuProfiler{
+public:
+    //maxScopes 为每帧每个队列最多的作用域数  pipelineStatistics 为设备是否开启了 pipelineStatisticsQuery
+    void init(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd , uint32_t framesInFlight ,
+            int graphicsFamily , int asyncFamily , bool pipelineStatistics , uint32_t maxScopes = 64){
+        this->device = device;
+        this->vkd = vkd;
+        this->maxScopes = maxScopes;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice , &properties);
+        timestampPeriod = properties.limits.timestampPeriod;
+
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice , &familyCount , nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice , &familyCount , families.data());
+        graphicsBits = graphicsFamily >= 0 ? families[graphicsFamily].timestampValidBits : 0;
+        asyncBits = asyncFamily >= 0 && asyncFamily != graphicsFamily ? families[asyncFamily].timestampValidBits : 0;
+        if(graphicsBits == 0){
+            std::cout << "gpu profiler disabled : graphics queue has no timestamp support" << std::endl;
+            return;
+        }
+
+        VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+        queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCreateInfo.queryCount = framesInFlight * maxScopes * 2 * 2;
+        if(vkCreateQueryPool(device , &queryPoolCreateInfo , nullptr , &queryPool) != VK_SUCCESS){
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        if(pipelineStatistics){
+            VkQueryPoolCreateInfo statisticsPoolCreateInfo = {};
+            statisticsPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            statisticsPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            statisticsPoolCreateInfo.queryCount = framesInFlight * maxScopes;
+            statisticsPoolCreateInfo.pipelineStatistics = GPU_STATISTIC_FLAGS;
+            if(vkCreateQueryPool(device , &statisticsPoolCreateInfo , nullptr , &statisticsPool) != VK_SUCCESS){
+                throw std::runtime_error("failed to create pipeline statistics query pool!");
+            }
+            statisticsResults.resize(maxScopes * (GPU_STATISTIC_COUNT + 1));
+        }
+        frames.assign(framesInFlight , FrameSlot());
+        graphicsResults.resize(maxScopes * 4);
+        asyncResults.resize(maxScopes * 4);
+
+        std::cout << "create gpu profiler period : " << timestampPeriod << " ns"
+            << " valid bits : " << graphicsBits
+            << " async : " << (asyncBits > 0 ? "on" : "off")
+            << " pipeline statistics : " << (statisticsPool != VK_NULL_HANDLE ? "on" : "off") << std::endl;
+    }
+
+    void destroy(){
+        if(device == VK_NULL_HANDLE){
+            return;
+        }
+        vkDestroyQueryPool(device , queryPool , nullptr);
+        vkDestroyQueryPool(device , statisticsPool , nullptr);
+        queryPool = VK_NULL_HANDLE;
+        statisticsPool = VK_NULL_HANDLE;
+        frames.clear();
+        device = VK_NULL_HANDLE;
+    }
+
+    bool isCreated() const{
+        return queryPool != VK_NULL_HANDLE;
+    }
+
+    bool hasPipelineStatistics() const{
+        return statisticsPool != VK_NULL_HANDLE;
+    }
+
+    //开始记录 trace 事件  超过 maxEvents 后不再记录
+    void enableTrace(size_t maxEvents = 200000){
+        traceEnabled = true;
+        traceLimit = maxEvents;
+        traceStartNanos = currentTimeNanos();
+    }
+
+    //该飞行帧的 fence 等待之后调用  读回上一次使用这一段时写入的结果
+    void collect(uint32_t frame){
+        if(!isCreated()){
+            return;
+        }
+        FrameSlot &slot = frames[frame];
+        if(slot.pending){
+            readResults(frame , slot);
+        }
+        slot = FrameSlot();
+    }
+
+    //指令缓存开始录制之后调用  开启整帧的作用域
+    void beginFrame(uint32_t frame , VkCommandBuffer graphicsCmd){
+        if(!isCreated()){
+            return;
+        }
+        currentFrame = frame;
+        frameScope = beginScope(graphicsCmd , "frame" , false , false);
+    }
+
+    void endFrame(VkCommandBuffer graphicsCmd){
+        if(!isCreated()){
+            return;
+        }
+        endScope(graphicsCmd , frameScope);
+        frameScope = GPU_SCOPE_INVALID;
+    }
+
+    //提交之前调用  用于对齐 trace 中 GPU 与 CPU 的时间
+    void markSubmit(){
+        if(!isCreated()){
+            return;
+        }
+        FrameSlot &slot = frames[currentFrame];
+        slot.submitNanos = currentTimeNanos();
+        slot.pending = !slot.scopes.empty();
+    }
+
+    //在 cmd 中写入开始时间戳  返回作用域编号 查询用完时返回 GPU_SCOPE_INVALID
+    //statistics 为 true 时同时开始管线统计查询  必须在渲染通道之外调用 且作用域之间不能嵌套
+    uint32_t beginScope(VkCommandBuffer cmd , const std::string &name , bool async , bool statistics = true){
+        if(!isCreated() || (async && asyncBits == 0)){
+            return GPU_SCOPE_INVALID;
+        }
+        FrameSlot &slot = frames[currentFrame];
+        uint32_t &used = async ? slot.asyncQueries : slot.graphicsQueries;
+        if(used + 2 > maxScopes * 2){
+            return GPU_SCOPE_INVALID;
+        }
+        //每个队列的那一段在第一次使用时重置  重置必须在渲染通道之外
+        const uint32_t rangeBase = queryBase(currentFrame , async);
+        if(used == 0){
+            vkd->vkCmdResetQueryPool(cmd , queryPool , rangeBase , maxScopes * 2);
+        }
+
+        ScopeRecord record;
+        record.name = internName(name);
+        record.async = async;
+        record.query = used;
+        record.cpuBegin = currentTimeNanos();
+        used += 2;
+        vkd->vkCmdWriteTimestamp(cmd , VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT , queryPool , rangeBase + record.query);
+        if(statistics && !async && statisticsPool != VK_NULL_HANDLE && slot.statisticsQueries < maxScopes){
+            const uint32_t statisticsBase = currentFrame * maxScopes;
+            if(slot.statisticsQueries == 0){
+                vkd->vkCmdResetQueryPool(cmd , statisticsPool , statisticsBase , maxScopes);
+            }
+            record.statisticsQuery = slot.statisticsQueries++;
+            vkd->vkCmdBeginQuery(cmd , statisticsPool , statisticsBase + record.statisticsQuery , 0);
+        }
+        slot.scopes.push_back(record);
+        return static_cast<uint32_t>(slot.scopes.size() - 1);
+    }
+
+    void endScope(VkCommandBuffer cmd , uint32_t scope){
+        if(scope == GPU_SCOPE_INVALID){
+            return;
+        }
+        FrameSlot &slot = frames[currentFrame];
+        ScopeRecord &record = slot.scopes[scope];
+        if(record.statisticsQuery != GPU_SCOPE_INVALID){
+            vkd->vkCmdEndQuery(cmd , statisticsPool , currentFrame * maxScopes + record.statisticsQuery);
+        }
+        vkd->vkCmdWriteTimestamp(cmd , VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT , queryPool ,
+            queryBase(currentFrame , record.async) + record.query + 1);
+        record.cpuEnd = currentTimeNanos();
+    }
+
+    const std::map<std::string , GpuScopeStats> &aggregated() const{
+        return stats;
+    }
+
+    //按名称查找汇总结果 没有时返回 nullptr
+    const GpuScopeStats *find(const std::string &name) const{
+        auto it = stats.find(name);
+        return it != stats.end() ? &it->second : nullptr;
+    }
+
+    void clearStats(){
+        stats.clear();
+    }
+
+    //按名称输出平均耗时与平均管线统计 然后清空统计
+    void report(std::ostream &out){
+        for(const auto &entry : stats){
+            const GpuScopeStats &scope = entry.second;
+            if(scope.count == 0){
+                continue;
+            }
+            out << "gpu " << entry.first
+                << " avg : " << scope.gpuTotalMs / scope.count << " ms"
+                << " min : " << scope.gpuMinMs << " ms"
+                << " max : " << scope.gpuMaxMs << " ms"
+                << " cpu record : " << scope.cpuTotalMs / scope.count << " ms"
+                << " samples : " << scope.count;
+            if(scope.statisticsCount > 0){
+                for(uint32_t statistic = 0 ; statistic < GPU_STATISTIC_COUNT ; statistic++){
+                    out << " " << gpuStatisticName(statistic) << " : "
+                        << static_cast<uint64_t>(scope.averageStatistic(statistic));
+                }//end for statistic
+            }
+            out << std::endl;
+        }//end for each
+        stats.clear();
+    }
+
+    //写出 Chrome trace_event JSON  pid 1 为 CPU 录制  pid 2 为 GPU (tid 1 图形 tid 2 异步计算)
+    bool writeTrace(const std::string &path) const{
+        std::ofstream file(path);
+        if(!file.is_open()){
+            std::cout << "failed to write trace " << path << std::endl;
+            return false;
+        }
+        file << "{\"traceEvents\":[\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU\"}},\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"record\"}},\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":1,\"args\":{\"name\":\"graphics queue\"}},\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":2,\"args\":{\"name\":\"async compute queue\"}}";
+        char buffer[64];
+        for(const TraceEvent &event : traceEvents){
+            file << ",\n{\"name\":\"" << escapeJson(names[event.name]) << "\",\"ph\":\"X\"";
+            std::snprintf(buffer , sizeof(buffer) , ",\"ts\":%.3f,\"dur\":%.3f" , event.start / 1000.0 , event.duration / 1000.0);
+            file << buffer << ",\"pid\":" << (event.gpu ? 2 : 1) << ",\"tid\":" << event.thread;
+            //管线统计作为事件参数 在选中事件时显示
+            if(event.statistics >= 0){
+                const uint64_t *values = &traceStatistics[event.statistics * GPU_STATISTIC_COUNT];
+                file << ",\"args\":{";
+                for(uint32_t statistic = 0 ; statistic < GPU_STATISTIC_COUNT ; statistic++){
+                    file << (statistic > 0 ? "," : "") << "\"" << gpuStatisticName(statistic) << "\":" << values[statistic];
+                }//end for statistic
+                file << "}";
+            }
+            file << "}";
+        }//end for each
+        file << "\n]}\n";
+        std::cout << "write trace " << path << " events : " << traceEvents.size() << std::endl;
+        return true;
+    }
+
+private:
+    struct ScopeRecord{
+        uint32_t name = 0;
+        uint32_t query = 0;//该队列那一段中的偏移
+        bool async = false;
+        uint32_t statisticsQuery = GPU_SCOPE_INVALID;//管线统计查询在该帧那一段中的偏移
+        uint64_t cpuBegin = 0;
+        uint64_t cpuEnd = 0;
+    };
+
+    struct FrameSlot{
+        std::vector<ScopeRecord> scopes;
+        uint32_t graphicsQueries = 0;
+        uint32_t asyncQueries = 0;
+        uint32_t statisticsQueries = 0;
+        uint64_t submitNanos = 0;
+        bool pending = false;
+    };
+
+    //时间相对 traceStartNanos (ns)
+    struct TraceEvent{
+        uint32_t name;
+        bool gpu;
+        uint32_t thread;
+        int64_t start;
+        int64_t duration;
+        int32_t statistics;//traceStatistics 中的序号  -1 表示没有
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    VkQueryPool statisticsPool = VK_NULL_HANDLE;
+    uint32_t maxScopes = 0;
+    float timestampPeriod = 1.0f;
+    uint32_t graphicsBits = 0;
+    uint32_t asyncBits = 0;
+
+    std::vector<FrameSlot> frames;
+    uint32_t currentFrame = 0;
+    uint32_t frameScope = GPU_SCOPE_INVALID;
+    std::vector<uint64_t> graphicsResults;//每个查询 (值 , 可用标记)
+    std::vector<uint64_t> asyncResults;
+    std::vector<uint64_t> statisticsResults;//每个查询 GPU_STATISTIC_COUNT 个值 + 可用标记
+
+    std::map<std::string , uint32_t> nameIds;
+    std::vector<std::string> names;
+    std::map<std::string , GpuScopeStats> stats;
+
+    bool traceEnabled = false;
+    size_t traceLimit = 0;
+    uint64_t traceStartNanos = 0;
+    std::vector<TraceEvent> traceEvents;
+    std::vector<uint64_t> traceStatistics;//每个带统计的 GPU 事件 GPU_STATISTIC_COUNT 个值
+
+    uint32_t queryBase(uint32_t frame , bool async) const{
+        return (frame * 2 + (async ? 1 : 0)) * maxScopes * 2;
+    }
+
+    uint32_t internName(const std::string &name){
+        auto it = nameIds.find(name);
+        if(it != nameIds.end()){
+            return it->second;
+        }
+        const uint32_t id = static_cast<uint32_t>(names.size());
+        names.push_back(name);
+        nameIds[name] = id;
+        return id;
+    }
+
+    static uint64_t maskBits(uint64_t value , uint32_t bits){
+        return bits >= 64 ? value : value & ((1ull << bits) - 1);
+    }
+
+    //读回一个队列的那一段 不可用的查询保持 available = false
+    bool readRange(uint32_t frame , bool async , uint32_t count , uint64_t *values){
+        if(count == 0){
+            return false;
+        }
+        const VkResult result = vkd->vkGetQueryPoolResults(device , queryPool , queryBase(frame , async) , count ,
+            count * sizeof(uint64_t) * 2 , values , sizeof(uint64_t) * 2 ,
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        return result == VK_SUCCESS || result == VK_NOT_READY;
+    }
+
+    void readResults(uint32_t frame , const FrameSlot &slot){
+        const uint64_t *graphicsValues = graphicsResults.data();
+        const uint64_t *asyncValues = asyncResults.data();
+        const bool graphicsRead = readRange(frame , false , slot.graphicsQueries , graphicsResults.data());
+        const bool asyncRead = readRange(frame , true , slot.asyncQueries , asyncResults.data());
+        bool statisticsRead = false;
+        if(slot.statisticsQueries > 0){
+            const uint32_t stride = GPU_STATISTIC_COUNT + 1;
+            const VkResult result = vkd->vkGetQueryPoolResults(device , statisticsPool , frame * maxScopes , slot.statisticsQueries ,
+                slot.statisticsQueries * stride * sizeof(uint64_t) , statisticsResults.data() , stride * sizeof(uint64_t) ,
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+            statisticsRead = result == VK_SUCCESS || result == VK_NOT_READY;
+        }
+
+        //整帧作用域的开始时间戳对齐到提交时刻
+        uint64_t frameBeginTick = 0;
+        bool aligned = false;
+        if(graphicsRead && !slot.scopes.empty() && !slot.scopes[0].async && graphicsValues[1] != 0){
+            frameBeginTick = maskBits(graphicsValues[0] , graphicsBits);
+            aligned = true;
+        }
+
+        for(const ScopeRecord &record : slot.scopes){
+            const uint64_t *values = record.async ? asyncValues : graphicsValues;
+            if(!(record.async ? asyncRead : graphicsRead)){
+                continue;
+            }
+            //(值 , 可用) 成对存放
+            const uint64_t *begin = values + record.query * 2;
+            const uint64_t *end = values + (record.query + 1) * 2;
+            if(begin[1] == 0 || end[1] == 0){
+                continue;
+            }
+            const uint32_t bits = record.async ? asyncBits : graphicsBits;
+            const uint64_t beginTick = maskBits(begin[0] , bits);
+            const uint64_t endTick = maskBits(end[0] , bits);
+            const double gpuNs = endTick >= beginTick ? (endTick - beginTick) * static_cast<double>(timestampPeriod) : 0.0;
+            const double cpuNs = record.cpuEnd >= record.cpuBegin ? static_cast<double>(record.cpuEnd - record.cpuBegin) : 0.0;
+
+            GpuScopeStats &scope = stats[names[record.name]];
+            scope.count++;
+            scope.gpuTotalMs += gpuNs / 1e6;
+            scope.gpuMinMs = std::min(scope.gpuMinMs , gpuNs / 1e6);
+            scope.gpuMaxMs = std::max(scope.gpuMaxMs , gpuNs / 1e6);
+            scope.cpuTotalMs += cpuNs / 1e6;
+
+            const uint64_t *statisticValues = nullptr;
+            if(statisticsRead && record.statisticsQuery != GPU_SCOPE_INVALID){
+                const uint64_t *values = statisticsResults.data() + record.statisticsQuery * (GPU_STATISTIC_COUNT + 1);
+                if(values[GPU_STATISTIC_COUNT] != 0){
+                    statisticValues = values;
+                    scope.statisticsCount++;
+                    for(uint32_t statistic = 0 ; statistic < GPU_STATISTIC_COUNT ; statistic++){
+                        scope.statistics[statistic] += values[statistic];
+                    }//end for statistic
+                }
+            }
+
+            if(traceEnabled && traceEvents.size() + 2 <= traceLimit && record.cpuBegin >= traceStartNanos){
+                traceEvents.push_back({record.name , false , 0 ,
+                    static_cast<int64_t>(record.cpuBegin - traceStartNanos) , static_cast<int64_t>(cpuNs) , -1});
+                if(aligned){
+                    const double offsetNs = (static_cast<double>(beginTick) - static_cast<double>(frameBeginTick)) * timestampPeriod;
+                    const int64_t start = static_cast<int64_t>(slot.submitNanos - traceStartNanos) + static_cast<int64_t>(offsetNs);
+                    int32_t statisticsIndex = -1;
+                    if(statisticValues != nullptr){
+                        statisticsIndex = static_cast<int32_t>(traceStatistics.size() / GPU_STATISTIC_COUNT);
+                        traceStatistics.insert(traceStatistics.end() , statisticValues , statisticValues + GPU_STATISTIC_COUNT);
+                    }
+                    traceEvents.push_back({record.name , true , record.async ? 2u : 1u , start , static_cast<int64_t>(gpuNs) , statisticsIndex});
+                }
+            }
+        }//end for each
+    }
+
+    static std::string escapeJson(const std::string &text){
+        std::string result;
+        for(char c : text){
+            if(c == '"' || c == '\\'){
+                result.push_back('\\');
+            }
+            result.push_back(c);
+        }//end for each
+        return result;
+    }
+};
+
+//RAII 作用域  profiler 为空或未创建时什么都不做
+class GpuScope{
+public:
+    GpuScope(GpuProfiler *profiler , VkCommandBuffer cmd , const std::string &name , bool async = false)
+        : profiler(profiler) , cmd(cmd){
+        if(profiler != nullptr){
+            scope = profiler->beginScope(cmd , name , async);
+        }
+    }
+
+    ~GpuScope(){
+        if(profiler != nullptr){
+            profiler->endScope(cmd , scope);
+        }
+    }
+
+    GpuScope(const GpuScope &) = delete;
+    GpuScope &operator=(const GpuScope &) = delete;
+
+private:
+    GpuProfiler *profiler;
+    VkCommandBuffer cmd;
+    uint32_t scope = GPU_SCOPE_INVALID;
+};
+
+#endif
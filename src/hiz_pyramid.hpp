@@ -0,0 +1,321 @@
+#ifndef _HIZ_PYRAMID_H_
+#define _HIZ_PYRAMID_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "device_dispatch.hpp"
+#include "vk_utils.hpp"
+
+//与 shaders/hiz.comp 中的 HiZParams 对应 (push constant)
+struct HiZParams{
+    int32_t sourceSize[2];
+    int32_t destinationSize[2];
+    uint32_t reverseZ;
+};
+
+//层级深度 (Hi-Z) 金字塔
+//mip 0 为深度缓冲的 1/2  之后每级再减半  每个texel保存其覆盖区域内最远的深度
+//由计算着色器逐级下采样  图像始终处于 GENERAL 布局  级与级之间在 build 内部插入屏障
+class HiZPyramid{
+public:
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;//全部 mip  供剔除着色器采样
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkExtent2D extent = {0 , 0};//mip 0 的尺寸
+    uint32_t mipLevels = 0;
+
+    //depthView 只包含深度 aspect  采样时处于 SHADER_READ_ONLY_OPTIMAL
+    void create(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd ,
+            VkExtent2D depthExtent , VkImageView depthView , bool reverseZ , const std::vector<char> &shaderCode){
+        this->device = device;
+        this->vkd = vkd;
+        this->depthExtent = depthExtent;
+        this->reverseZ = reverseZ;
+
+        extent.width = std::max(depthExtent.width / 2 , 1u);
+        extent.height = std::max(depthExtent.height / 2 , 1u);
+        mipLevels = 1;
+        while((extent.width >> mipLevels) > 0 || (extent.height >> mipLevels) > 0){
+            mipLevels++;
+        }
+
+        createImage(physicalDevice);
+        createSampler();
+        createPipeline(shaderCode);
+        createDescriptorSets(depthView);
+
+        std::cout << "create hi-z pyramid " << extent.width << "x" << extent.height
+            << " mips : " << mipLevels << std::endl;
+    }
+
+    bool isCreated() const{
+        return image != VK_NULL_HANDLE;
+    }
+
+    void destroy(){
+        if(device == VK_NULL_HANDLE){
+            return;
+        }
+        vkDestroyDescriptorPool(device , descriptorPool , nullptr);
+        vkDestroyPipeline(device , pipeline , nullptr);
+        vkDestroyPipelineLayout(device , pipelineLayout , nullptr);
+        vkDestroyDescriptorSetLayout(device , setLayout , nullptr);
+        vkDestroySampler(device , sampler , nullptr);
+        for(VkImageView mipView : mipViews){
+            vkDestroyImageView(device , mipView , nullptr);
+        }//end for each
+        vkDestroyImageView(device , view , nullptr);
+        vkDestroyImage(device , image , nullptr);
+        vkFreeMemory(device , memory , nullptr);
+
+        mipViews.clear();
+        descriptorSets.clear();
+        descriptorPool = VK_NULL_HANDLE;
+        pipeline = VK_NULL_HANDLE;
+        pipelineLayout = VK_NULL_HANDLE;
+        setLayout = VK_NULL_HANDLE;
+        sampler = VK_NULL_HANDLE;
+        view = VK_NULL_HANDLE;
+        image = VK_NULL_HANDLE;
+        memory = VK_NULL_HANDLE;
+        device = VK_NULL_HANDLE;
+    }
+
+    //逐级下采样  调用前深度处于 SHADER_READ_ONLY_OPTIMAL 金字塔处于 GENERAL 且之前的读取已完成
+    void recordBuild(VkCommandBuffer cmd){
+        vkd->vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_COMPUTE , pipeline);
+
+        VkExtent2D source = depthExtent;
+        for(uint32_t mip = 0 ; mip < mipLevels ; mip++){
+            const VkExtent2D destination = {std::max(extent.width >> mip , 1u) , std::max(extent.height >> mip , 1u)};
+
+            HiZParams params = {};
+            params.sourceSize[0] = static_cast<int32_t>(source.width);
+            params.sourceSize[1] = static_cast<int32_t>(source.height);
+            params.destinationSize[0] = static_cast<int32_t>(destination.width);
+            params.destinationSize[1] = static_cast<int32_t>(destination.height);
+            params.reverseZ = reverseZ ? 1 : 0;
+
+            vkd->vkCmdBindDescriptorSets(cmd , VK_PIPELINE_BIND_POINT_COMPUTE , pipelineLayout , 0 , 1 ,
+                &descriptorSets[mip] , 0 , nullptr);
+            vkd->vkCmdPushConstants(cmd , pipelineLayout , VK_SHADER_STAGE_COMPUTE_BIT , 0 , sizeof(HiZParams) , &params);
+            vkd->vkCmdDispatch(cmd , (destination.width + 7) / 8 , (destination.height + 7) / 8 , 1);
+
+            //下一级读取这一级
+            VkImageMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT , mip , 1 , 0 , 1};
+            if(mip + 1 < mipLevels){
+                vkd->vkCmdPipelineBarrier(cmd , VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT , VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT ,
+                    0 , 0 , nullptr , 0 , nullptr , 1 , &barrier);
+            }
+            source = destination;
+        }//end for mip
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkExtent2D depthExtent = {0 , 0};
+    bool reverseZ = false;
+
+    std::vector<VkImageView> mipViews;//每级一个 用于写入 与作为下一级的源
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> descriptorSets;//每级一个
+
+    void createImage(VkPhysicalDevice physicalDevice){
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageCreateInfo.extent = {extent.width , extent.height , 1};
+        imageCreateInfo.mipLevels = mipLevels;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if(vkCreateImage(device , &imageCreateInfo , nullptr , &image) != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z image!");
+        }
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device , image , &requirements);
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = findMemoryType(memoryProperties , requirements.memoryTypeBits ,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(vkAllocateMemory(device , &allocateInfo , nullptr , &memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate hi-z memory!");
+        }
+        vkBindImageMemory(device , image , memory , 0);
+
+        VkImageViewCreateInfo viewCreateInfo = {};
+        viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewCreateInfo.image = image;
+        viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewCreateInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT , 0 , mipLevels , 0 , 1};
+        if(vkCreateImageView(device , &viewCreateInfo , nullptr , &view) != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z view!");
+        }
+
+        mipViews.resize(mipLevels);
+        for(uint32_t mip = 0 ; mip < mipLevels ; mip++){
+            viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT , mip , 1 , 0 , 1};
+            if(vkCreateImageView(device , &viewCreateInfo , nullptr , &mipViews[mip]) != VK_SUCCESS){
+                throw std::runtime_error("failed to create hi-z mip view!");
+            }
+        }//end for mip
+    }
+
+    //只用 texelFetch 读取  采样器参数不影响结果
+    void createSampler(){
+        VkSamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.maxLod = static_cast<float>(mipLevels);
+        if(vkCreateSampler(device , &samplerCreateInfo , nullptr , &sampler) != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z sampler!");
+        }
+    }
+
+    void createPipeline(const std::vector<char> &code){
+        VkDescriptorSetLayoutBinding bindings[2] = {};
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].descriptorCount = 1;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
+        setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutCreateInfo.bindingCount = 2;
+        setLayoutCreateInfo.pBindings = bindings;
+        if(vkCreateDescriptorSetLayout(device , &setLayoutCreateInfo , nullptr , &setLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z descriptor set layout!");
+        }
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(HiZParams);
+
+        VkPipelineLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutCreateInfo.setLayoutCount = 1;
+        layoutCreateInfo.pSetLayouts = &setLayout;
+        layoutCreateInfo.pushConstantRangeCount = 1;
+        layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        if(vkCreatePipelineLayout(device , &layoutCreateInfo , nullptr , &pipelineLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z pipeline layout!");
+        }
+
+        VkShaderModuleCreateInfo moduleCreateInfo = {};
+        moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleCreateInfo.codeSize = code.size();
+        moduleCreateInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+        VkShaderModule module;
+        if(vkCreateShaderModule(device , &moduleCreateInfo , nullptr , &module) != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineCreateInfo.stage.module = module;
+        pipelineCreateInfo.stage.pName = "main";
+        pipelineCreateInfo.layout = pipelineLayout;
+        VkResult result = vkCreateComputePipelines(device , VK_NULL_HANDLE , 1 , &pipelineCreateInfo , nullptr , &pipeline);
+        vkDestroyShaderModule(device , module , nullptr);
+        if(result != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z pipeline!");
+        }
+    }
+
+    void createDescriptorSets(VkImageView depthView){
+        VkDescriptorPoolSize poolSizes[2] = {};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[0].descriptorCount = mipLevels;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        poolSizes[1].descriptorCount = mipLevels;
+
+        VkDescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.maxSets = mipLevels;
+        poolCreateInfo.poolSizeCount = 2;
+        poolCreateInfo.pPoolSizes = poolSizes;
+        if(vkCreateDescriptorPool(device , &poolCreateInfo , nullptr , &descriptorPool) != VK_SUCCESS){
+            throw std::runtime_error("failed to create hi-z descriptor pool!");
+        }
+
+        std::vector<VkDescriptorSetLayout> layouts(mipLevels , setLayout);
+        descriptorSets.resize(mipLevels);
+        VkDescriptorSetAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = descriptorPool;
+        allocateInfo.descriptorSetCount = mipLevels;
+        allocateInfo.pSetLayouts = layouts.data();
+        if(vkAllocateDescriptorSets(device , &allocateInfo , descriptorSets.data()) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate hi-z descriptor sets!");
+        }
+
+        for(uint32_t mip = 0 ; mip < mipLevels ; mip++){
+            VkDescriptorImageInfo sourceInfo = {};
+            sourceInfo.sampler = sampler;
+            sourceInfo.imageView = mip == 0 ? depthView : mipViews[mip - 1];
+            sourceInfo.imageLayout = mip == 0 ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+            VkDescriptorImageInfo destinationInfo = {};
+            destinationInfo.imageView = mipViews[mip];
+            destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            VkWriteDescriptorSet writes[2] = {};
+            writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[0].dstSet = descriptorSets[mip];
+            writes[0].dstBinding = 0;
+            writes[0].descriptorCount = 1;
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            writes[0].pImageInfo = &sourceInfo;
+            writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[1].dstSet = descriptorSets[mip];
+            writes[1].dstBinding = 1;
+            writes[1].descriptorCount = 1;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[1].pImageInfo = &destinationInfo;
+            vkUpdateDescriptorSets(device , 2 , writes , 0 , nullptr);
+        }//end for mip
+    }
+};
+
+#endif
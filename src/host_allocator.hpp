@@ -0,0 +1,358 @@
+#ifndef _HOST_ALLOCATOR_H_
+#define _HOST_ALLOCATOR_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+//驱动的主机内存分配 (VkAllocationCallbacks)
+//每种对象类型一组回调  pUserData 指向该类型的计数  创建与销毁同一对象时使用同一组回调
+//计数按对象类型与分配范围 (VkSystemAllocationScope) 分别统计
+//OBJECT 范围的小块分配来自按大小分级的内存池 其余使用 malloc
+//每块内存前有 16 字节的头 记录大小 范围 与来源
+
+static const uint32_t HOST_SCOPE_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+//对象类型的计数槽  核心类型按枚举值  扩展类型单独几个槽
+static const uint32_t HOST_TYPE_CORE_COUNT = VK_OBJECT_TYPE_COMMAND_POOL + 1;
+static const uint32_t HOST_TYPE_SURFACE = HOST_TYPE_CORE_COUNT;
+static const uint32_t HOST_TYPE_SWAPCHAIN = HOST_TYPE_CORE_COUNT + 1;
+static const uint32_t HOST_TYPE_DEBUG_MESSENGER = HOST_TYPE_CORE_COUNT + 2;
+static const uint32_t HOST_TYPE_OTHER = HOST_TYPE_CORE_COUNT + 3;
+static const uint32_t HOST_TYPE_COUNT = HOST_TYPE_CORE_COUNT + 4;
+
+struct HostAllocationCounters{
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> reallocations{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<int64_t> liveBytes{0};
+    std::atomic<int64_t> peakBytes{0};
+    std::atomic<int64_t> internalBytes{0};//驱动自行分配 只通知的内存
+
+    void add(int64_t bytes){
+        const int64_t live = liveBytes.fetch_add(bytes) + bytes;
+        int64_t peak = peakBytes.load();
+        while(live > peak && !peakBytes.compare_exchange_weak(peak , live)){
+        }
+    }
+};
+
+//某一时刻每个范围的分配次数  两次之差为这段时间内的分配
+struct HostAllocationSnapshot{
+    uint64_t allocations[HOST_SCOPE_COUNT] = {};
+    uint64_t total() const{
+        uint64_t sum = 0;
+        for(uint32_t scope = 0 ; scope < HOST_SCOPE_COUNT ; scope++){
+            sum += allocations[scope];
+        }//end for scope
+        return sum;
+    }
+};
+
+class HostAllocator{
+public:
+    HostAllocator(){
+        for(uint32_t i = 0 ; i < HOST_TYPE_COUNT ; i++){
+            types[i].owner = this;
+            types[i].index = i;
+            VkAllocationCallbacks &callbacks = types[i].callbacks;
+            callbacks.pUserData = &types[i];
+            callbacks.pfnAllocation = allocation;
+            callbacks.pfnReallocation = reallocation;
+            callbacks.pfnFree = release;
+            callbacks.pfnInternalAllocation = internalAllocation;
+            callbacks.pfnInternalFree = internalFree;
+        }//end for i
+    }
+
+    ~HostAllocator(){
+        for(void *chunk : chunks){
+            std::free(chunk);
+        }//end for each
+    }
+
+    HostAllocator(const HostAllocator &) = delete;
+    HostAllocator &operator=(const HostAllocator &) = delete;
+
+    //创建与销毁 type 类型的对象时传入
+    const VkAllocationCallbacks *callbacks(VkObjectType type) const{
+        return &types[typeSlot(type)].callbacks;
+    }
+
+    HostAllocationSnapshot snapshot() const{
+        HostAllocationSnapshot result;
+        for(uint32_t scope = 0 ; scope < HOST_SCOPE_COUNT ; scope++){
+            result.allocations[scope] = scopes[scope].allocations.load(std::memory_order_relaxed);
+        }//end for scope
+        return result;
+    }
+
+    const HostAllocationCounters &scopeCounters(VkSystemAllocationScope scope) const{
+        return scopes[scope];
+    }
+
+    uint64_t pooledAllocations() const{
+        return pooled.load(std::memory_order_relaxed);
+    }
+
+    //按范围与对象类型输出  只列出有分配的类型
+    void report(std::ostream &out) const{
+        static const char *scopeNames[HOST_SCOPE_COUNT] = {"command" , "object" , "cache" , "device" , "instance"};
+        out << "host allocations (pooled : " << pooledAllocations() << ")" << std::endl;
+        for(uint32_t scope = 0 ; scope < HOST_SCOPE_COUNT ; scope++){
+            printCounters(out , scopeNames[scope] , scopes[scope]);
+        }//end for scope
+        for(uint32_t i = 0 ; i < HOST_TYPE_COUNT ; i++){
+            if(types[i].counters.allocations.load() == 0 && types[i].counters.internalBytes.load() == 0){
+                continue;
+            }
+            printCounters(out , typeName(i) , types[i].counters);
+        }//end for i
+    }
+
+private:
+    struct TypeSlot{
+        HostAllocator *owner = nullptr;
+        uint32_t index = 0;
+        VkAllocationCallbacks callbacks = {};
+        HostAllocationCounters counters;
+    };
+
+    //放在每块内存之前  pool 为 POOL_MALLOC 时来自 malloc
+    struct alignas(16) Header{
+        uint64_t size;
+        uint8_t scope;
+        uint8_t pool;
+        uint16_t type;
+        uint32_t offset;//用户指针到 malloc 返回地址的距离
+    };
+    static_assert(sizeof(Header) == 16 , "host allocation header must be 16 bytes");
+
+    static const uint8_t POOL_MALLOC = 0xFF;
+    static const uint32_t POOL_CLASS_COUNT = 5;//32 64 128 256 512 (含头)
+    static const size_t POOL_CHUNK_SIZE = 64 * 1024;
+
+    //一个大小级别的空闲链表
+    struct PoolClass{
+        std::mutex mutex;
+        void *freeList = nullptr;
+    };
+
+    mutable TypeSlot types[HOST_TYPE_COUNT];
+    HostAllocationCounters scopes[HOST_SCOPE_COUNT];
+    PoolClass pools[POOL_CLASS_COUNT];
+    std::mutex chunkMutex;
+    std::vector<void *> chunks;
+    std::atomic<uint64_t> pooled{0};
+
+    static uint32_t typeSlot(VkObjectType type){
+        if(static_cast<uint32_t>(type) < HOST_TYPE_CORE_COUNT){
+            return static_cast<uint32_t>(type);
+        }
+        switch(type){
+            case VK_OBJECT_TYPE_SURFACE_KHR:
+                return HOST_TYPE_SURFACE;
+            case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+                return HOST_TYPE_SWAPCHAIN;
+            case VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT:
+                return HOST_TYPE_DEBUG_MESSENGER;
+            default:
+                return HOST_TYPE_OTHER;
+        }
+    }
+
+    static const char *typeName(uint32_t slot){
+        static const char *names[HOST_TYPE_CORE_COUNT] = {
+            "unknown" , "instance" , "physical device" , "device" , "queue" , "semaphore" , "command buffer" ,
+            "fence" , "device memory" , "buffer" , "image" , "event" , "query pool" , "buffer view" , "image view" ,
+            "shader module" , "pipeline cache" , "pipeline layout" , "render pass" , "pipeline" ,
+            "descriptor set layout" , "sampler" , "descriptor pool" , "descriptor set" , "framebuffer" , "command pool"
+        };
+        if(slot < HOST_TYPE_CORE_COUNT){
+            return names[slot];
+        }
+        switch(slot){
+            case HOST_TYPE_SURFACE:
+                return "surface";
+            case HOST_TYPE_SWAPCHAIN:
+                return "swapchain";
+            case HOST_TYPE_DEBUG_MESSENGER:
+                return "debug messenger";
+            default:
+                return "other";
+        }
+    }
+
+    static void printCounters(std::ostream &out , const char *name , const HostAllocationCounters &counters){
+        out << "    " << name
+            << " allocations : " << counters.allocations.load()
+            << " reallocations : " << counters.reallocations.load()
+            << " frees : " << counters.frees.load()
+            << " live : " << counters.liveBytes.load() << " bytes"
+            << " peak : " << counters.peakBytes.load() << " bytes"
+            << " internal : " << counters.internalBytes.load() << " bytes" << std::endl;
+    }
+
+    //size 含头  返回大小级别  放不进内存池时返回 POOL_MALLOC
+    static uint8_t poolClass(size_t size){
+        size_t classSize = 32;
+        for(uint8_t index = 0 ; index < POOL_CLASS_COUNT ; index++){
+            if(size <= classSize){
+                return index;
+            }
+            classSize <<= 1;
+        }//end for index
+        return POOL_MALLOC;
+    }
+
+    void *poolAllocate(uint8_t index){
+        const size_t blockSize = static_cast<size_t>(32) << index;
+        PoolClass &pool = pools[index];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if(pool.freeList == nullptr){
+            char *chunk = static_cast<char *>(std::malloc(POOL_CHUNK_SIZE));
+            if(chunk == nullptr){
+                return nullptr;
+            }
+            {
+                std::lock_guard<std::mutex> chunkLock(chunkMutex);
+                chunks.push_back(chunk);
+            }
+            //整块切分后串成空闲链表
+            for(size_t offset = 0 ; offset + blockSize <= POOL_CHUNK_SIZE ; offset += blockSize){
+                void *block = chunk + offset;
+                *static_cast<void **>(block) = pool.freeList;
+                pool.freeList = block;
+            }//end for offset
+        }
+        void *block = pool.freeList;
+        pool.freeList = *static_cast<void **>(block);
+        return block;
+    }
+
+    void poolFree(uint8_t index , void *block){
+        PoolClass &pool = pools[index];
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        *static_cast<void **>(block) = pool.freeList;
+        pool.freeList = block;
+    }
+
+    void *allocate(TypeSlot &slot , size_t size , size_t alignment , VkSystemAllocationScope scope){
+        if(size == 0){
+            return nullptr;
+        }
+        alignment = alignment < 16 ? 16 : alignment;
+
+        uint8_t pool = POOL_MALLOC;
+        char *raw = nullptr;
+        char *user = nullptr;
+        if(scope == VK_SYSTEM_ALLOCATION_SCOPE_OBJECT && alignment == 16){
+            pool = poolClass(size + sizeof(Header));
+        }
+        if(pool != POOL_MALLOC){
+            raw = static_cast<char *>(poolAllocate(pool));
+            user = raw != nullptr ? raw + sizeof(Header) : nullptr;
+            pooled.fetch_add(1 , std::memory_order_relaxed);
+        }else{
+            raw = static_cast<char *>(std::malloc(size + alignment + sizeof(Header)));
+            if(raw != nullptr){
+                const uintptr_t start = reinterpret_cast<uintptr_t>(raw) + sizeof(Header);
+                user = reinterpret_cast<char *>((start + alignment - 1) / alignment * alignment);
+            }
+        }
+        if(user == nullptr){
+            return nullptr;
+        }
+
+        Header *header = reinterpret_cast<Header *>(user) - 1;
+        header->size = size;
+        header->scope = static_cast<uint8_t>(scope);
+        header->pool = pool;
+        header->type = static_cast<uint16_t>(slot.index);
+        header->offset = static_cast<uint32_t>(user - raw);
+
+        const int64_t bytes = static_cast<int64_t>(size);
+        scopes[scope].allocations.fetch_add(1 , std::memory_order_relaxed);
+        scopes[scope].add(bytes);
+        slot.counters.allocations.fetch_add(1 , std::memory_order_relaxed);
+        slot.counters.add(bytes);
+        return user;
+    }
+
+    void deallocate(void *memory){
+        if(memory == nullptr){
+            return;
+        }
+        Header *header = static_cast<Header *>(memory) - 1;
+        const int64_t bytes = static_cast<int64_t>(header->size);
+        HostAllocationCounters &slotCounters = types[header->type].counters;
+        scopes[header->scope].frees.fetch_add(1 , std::memory_order_relaxed);
+        scopes[header->scope].add(-bytes);
+        slotCounters.frees.fetch_add(1 , std::memory_order_relaxed);
+        slotCounters.add(-bytes);
+
+        char *raw = static_cast<char *>(memory) - header->offset;
+        if(header->pool != POOL_MALLOC){
+            poolFree(header->pool , raw);
+        }else{
+            std::free(raw);
+        }
+    }
+
+    static VKAPI_ATTR void *VKAPI_CALL allocation(void *userData , size_t size , size_t alignment ,
+            VkSystemAllocationScope scope){
+        TypeSlot *slot = static_cast<TypeSlot *>(userData);
+        return slot->owner->allocate(*slot , size , alignment , scope);
+    }
+
+    //新分配 拷贝 释放旧的  size 为 0 时等同于释放
+    static VKAPI_ATTR void *VKAPI_CALL reallocation(void *userData , void *original , size_t size , size_t alignment ,
+            VkSystemAllocationScope scope){
+        TypeSlot *slot = static_cast<TypeSlot *>(userData);
+        HostAllocator *owner = slot->owner;
+        if(original == nullptr){
+            return owner->allocate(*slot , size , alignment , scope);
+        }
+        if(size == 0){
+            owner->deallocate(original);
+            return nullptr;
+        }
+        void *memory = owner->allocate(*slot , size , alignment , scope);
+        if(memory == nullptr){
+            return nullptr;
+        }
+        const Header *header = static_cast<const Header *>(original) - 1;
+        std::memcpy(memory , original , static_cast<size_t>(std::min<uint64_t>(header->size , size)));
+        owner->deallocate(original);
+        owner->scopes[scope].reallocations.fetch_add(1 , std::memory_order_relaxed);
+        slot->counters.reallocations.fetch_add(1 , std::memory_order_relaxed);
+        return memory;
+    }
+
+    static VKAPI_ATTR void VKAPI_CALL release(void *userData , void *memory){
+        static_cast<TypeSlot *>(userData)->owner->deallocate(memory);
+    }
+
+    static VKAPI_ATTR void VKAPI_CALL internalAllocation(void *userData , size_t size ,
+            VkInternalAllocationType , VkSystemAllocationScope scope){
+        TypeSlot *slot = static_cast<TypeSlot *>(userData);
+        slot->owner->scopes[scope].internalBytes.fetch_add(static_cast<int64_t>(size));
+        slot->counters.internalBytes.fetch_add(static_cast<int64_t>(size));
+    }
+
+    static VKAPI_ATTR void VKAPI_CALL internalFree(void *userData , size_t size ,
+            VkInternalAllocationType , VkSystemAllocationScope scope){
+        TypeSlot *slot = static_cast<TypeSlot *>(userData);
+        slot->owner->scopes[scope].internalBytes.fetch_sub(static_cast<int64_t>(size));
+        slot->counters.internalBytes.fetch_sub(static_cast<int64_t>(size));
+    }
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef _IMAGE_COMPARE_H_
+#define _IMAGE_COMPARE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "image_io.hpp"
+
+//渲染结果与基准图像的差异  回归检查使用
+//输入为 RGBA8  alpha 不参与比较 (交换链回读的 alpha 固定为 255)
+//逐像素差 (最大值 平均值 超出容差的像素数) 与 PSNR 每次处理 4 个像素 (SSE2)
+//SSIM 在亮度上按不重叠的 8x8 块计算后取平均 (不做高斯加权)  块的各项和用 SSE2 累加  不足 8 像素的边缘忽略
+
+struct ImageDiff{
+    uint32_t maxDiff = 0;//单个通道的最大差值
+    double meanAbsDiff = 0.0;//每个通道的平均差值
+    uint64_t pixelsOverTolerance = 0;//任一通道差值超过容差的像素数
+    double psnr = std::numeric_limits<double>::infinity();//dB  完全相同时为无穷大
+    double ssim = 1.0;
+};
+
+//4 位掩码中 1 的个数
+static uint32_t countMaskBits(int mask){
+    return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+}
+
+//逐像素差  sumAbs / sumSquares 为 RGB 通道差值之和与平方和
+static void diffPixels(const uint8_t *a , const uint8_t *b , size_t pixelCount , uint8_t tolerance ,
+        uint64_t &sumAbs , uint64_t &sumSquares , uint32_t &maxDiff , uint64_t &overTolerance){
+    sumAbs = 0;
+    sumSquares = 0;
+    maxDiff = 0;
+    overTolerance = 0;
+    size_t i = 0;
+#ifdef IMAGE_IO_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i toleranceBytes = _mm_set1_epi8(static_cast<char>(tolerance));
+    __m128i maxBytes = zero;
+    __m128i absSums = zero;//两个 64 位和
+    while(i + 4 <= pixelCount){
+        //平方和的 32 位累加器每次最多增加 4 * 65025  每 4096 次迭代转存到 64 位
+        __m128i squareSums = zero;
+        const size_t blockEnd = std::min(pixelCount & ~static_cast<size_t>(3) , i + 4096 * 4);
+        for(; i < blockEnd ; i += 4){
+            const __m128i pixelsA = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i * 4)) , colorMask);
+            const __m128i pixelsB = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i * 4)) , colorMask);
+            const __m128i absDiff = _mm_or_si128(_mm_subs_epu8(pixelsA , pixelsB) , _mm_subs_epu8(pixelsB , pixelsA));
+
+            maxBytes = _mm_max_epu8(maxBytes , absDiff);
+            absSums = _mm_add_epi64(absSums , _mm_sad_epu8(absDiff , zero));
+            const __m128i low = _mm_unpacklo_epi8(absDiff , zero);
+            const __m128i high = _mm_unpackhi_epi8(absDiff , zero);
+            squareSums = _mm_add_epi32(squareSums , _mm_add_epi32(_mm_madd_epi16(low , low) , _mm_madd_epi16(high , high)));
+
+            //4 个字节都不超过容差的像素 减去容差后为 0
+            const __m128i withinTolerance = _mm_cmpeq_epi32(_mm_subs_epu8(absDiff , toleranceBytes) , zero);
+            overTolerance += 4 - countMaskBits(_mm_movemask_ps(_mm_castsi128_ps(withinTolerance)));
+        }//end for i
+        uint32_t squares[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(squares) , squareSums);
+        sumSquares += static_cast<uint64_t>(squares[0]) + squares[1] + squares[2] + squares[3];
+    }//end while
+    uint8_t maxLanes[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(maxLanes) , maxBytes);
+    for(uint8_t lane : maxLanes){
+        maxDiff = std::max<uint32_t>(maxDiff , lane);
+    }//end for each
+    uint64_t absLanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(absLanes) , absSums);
+    sumAbs = absLanes[0] + absLanes[1];
+#endif
+    for(; i < pixelCount ; i++){
+        bool over = false;
+        for(int channel = 0 ; channel < 3 ; channel++){
+            const int diff = std::abs(static_cast<int>(a[i * 4 + channel]) - static_cast<int>(b[i * 4 + channel]));
+            sumAbs += diff;
+            sumSquares += diff * diff;
+            maxDiff = std::max<uint32_t>(maxDiff , diff);
+            over = over || diff > tolerance;
+        }//end for channel
+        overTolerance += over ? 1 : 0;
+    }//end for i
+}
+
+//RGBA -> 亮度  权重和为 256
+static void rgbaToLuma(const uint8_t *rgba , uint8_t *luma , size_t pixelCount){
+    for(size_t i = 0 ; i < pixelCount ; i++){
+        const uint8_t *pixel = rgba + i * 4;
+        luma[i] = static_cast<uint8_t>((77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8);
+    }//end for i
+}
+
+struct SsimBlockSums{
+    uint32_t sumA = 0;
+    uint32_t sumB = 0;
+    uint32_t sumAA = 0;
+    uint32_t sumBB = 0;
+    uint32_t sumAB = 0;
+};
+
+//8x8 块的和 平方和 互相关和
+static SsimBlockSums ssimBlockSums(const uint8_t *a , const uint8_t *b , size_t stride){
+    SsimBlockSums sums;
+#ifdef IMAGE_IO_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sumA = zero;
+    __m128i sumB = zero;
+    __m128i sumAA = zero;
+    __m128i sumBB = zero;
+    __m128i sumAB = zero;
+    for(int row = 0 ; row < 8 ; row++){
+        const __m128i rowA = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(a + row * stride));
+        const __m128i rowB = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(b + row * stride));
+        sumA = _mm_add_epi32(sumA , _mm_sad_epu8(rowA , zero));
+        sumB = _mm_add_epi32(sumB , _mm_sad_epu8(rowB , zero));
+        const __m128i wideA = _mm_unpacklo_epi8(rowA , zero);
+        const __m128i wideB = _mm_unpacklo_epi8(rowB , zero);
+        sumAA = _mm_add_epi32(sumAA , _mm_madd_epi16(wideA , wideA));
+        sumBB = _mm_add_epi32(sumBB , _mm_madd_epi16(wideB , wideB));
+        sumAB = _mm_add_epi32(sumAB , _mm_madd_epi16(wideA , wideB));
+    }//end for row
+    auto horizontalSum = [](__m128i value) -> uint32_t {
+        uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes) , value);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    };
+    sums.sumA = horizontalSum(sumA);
+    sums.sumB = horizontalSum(sumB);
+    sums.sumAA = horizontalSum(sumAA);
+    sums.sumBB = horizontalSum(sumBB);
+    sums.sumAB = horizontalSum(sumAB);
+#else
+    for(int row = 0 ; row < 8 ; row++){
+        for(int x = 0 ; x < 8 ; x++){
+            const uint32_t valueA = a[row * stride + x];
+            const uint32_t valueB = b[row * stride + x];
+            sums.sumA += valueA;
+            sums.sumB += valueB;
+            sums.sumAA += valueA * valueA;
+            sums.sumBB += valueB * valueB;
+            sums.sumAB += valueA * valueB;
+        }//end for x
+    }//end for row
+#endif
+    return sums;
+}
+
+//两幅亮度图的平均 SSIM  图像小于一个块时返回 1
+static double computeSsim(const uint8_t *lumaA , const uint8_t *lumaB , uint32_t width , uint32_t height){
+    const double c1 = (0.01 * 255.0) * (0.01 * 255.0);
+    const double c2 = (0.03 * 255.0) * (0.03 * 255.0);
+    const double n = 64.0;
+    double total = 0.0;
+    uint64_t blocks = 0;
+    for(uint32_t y = 0 ; y + 8 <= height ; y += 8){
+        for(uint32_t x = 0 ; x + 8 <= width ; x += 8){
+            const size_t offset = static_cast<size_t>(y) * width + x;
+            const SsimBlockSums sums = ssimBlockSums(lumaA + offset , lumaB + offset , width);
+            const double meanA = sums.sumA / n;
+            const double meanB = sums.sumB / n;
+            const double varianceA = sums.sumAA / n - meanA * meanA;
+            const double varianceB = sums.sumBB / n - meanB * meanB;
+            const double covariance = sums.sumAB / n - meanA * meanB;
+            total += ((2.0 * meanA * meanB + c1) * (2.0 * covariance + c2))
+                / ((meanA * meanA + meanB * meanB + c1) * (varianceA + varianceB + c2));
+            blocks++;
+        }//end for x
+    }//end for y
+    return blocks > 0 ? total / blocks : 1.0;
+}
+
+//比较两幅同样尺寸的 RGBA8 图像  tolerance 为单个通道允许的差值
+static ImageDiff compareImages(const uint8_t *a , const uint8_t *b , uint32_t width , uint32_t height , uint8_t tolerance){
+    ImageDiff result;
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    if(pixelCount == 0){
+        return result;
+    }
+    uint64_t sumAbs = 0;
+    uint64_t sumSquares = 0;
+    diffPixels(a , b , pixelCount , tolerance , sumAbs , sumSquares , result.maxDiff , result.pixelsOverTolerance);
+    result.meanAbsDiff = static_cast<double>(sumAbs) / (pixelCount * 3);
+    if(sumSquares > 0){
+        const double mse = static_cast<double>(sumSquares) / (pixelCount * 3);
+        result.psnr = 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+    std::vector<uint8_t> lumaA(pixelCount);
+    std::vector<uint8_t> lumaB(pixelCount);
+    rgbaToLuma(a , lumaA.data() , pixelCount);
+    rgbaToLuma(b , lumaB.data() , pixelCount);
+    result.ssim = computeSsim(lumaA.data() , lumaB.data() , width , height);
+    return result;
+}
+
+//差异图: 每个通道差值放大 8 倍 (饱和)  alpha 为 255
+static void makeDiffImage(const uint8_t *a , const uint8_t *b , uint8_t *out , size_t pixelCount){
+    size_t i = 0;
+#ifdef IMAGE_IO_SSE2
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    for(; i + 4 <= pixelCount ; i += 4){
+        const __m128i pixelsA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i * 4));
+        const __m128i pixelsB = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i * 4));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(pixelsA , pixelsB) , _mm_subs_epu8(pixelsB , pixelsA));
+        for(int doubling = 0 ; doubling < 3 ; doubling++){
+            diff = _mm_adds_epu8(diff , diff);
+        }//end for doubling
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i * 4) , _mm_or_si128(diff , alpha));
+    }//end for i
+#endif
+    for(; i < pixelCount ; i++){
+        for(int channel = 0 ; channel < 3 ; channel++){
+            const int diff = std::abs(static_cast<int>(a[i * 4 + channel]) - static_cast<int>(b[i * 4 + channel]));
+            out[i * 4 + channel] = static_cast<uint8_t>(std::min(diff * 8 , 255));
+        }//end for channel
+        out[i * 4 + 3] = 255;
+    }//end for i
+}
+
+#endif
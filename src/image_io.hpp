@@ -0,0 +1,284 @@
+#ifndef _IMAGE_IO_H_
+#define _IMAGE_IO_H_
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_IO_SSE2
+#endif
+
+//图像像素转换与文件读写  截图 / 帧转储 / 回归检查使用
+//输出统一为 RGBA8  交换链的 sRGB 格式中存放的已经是 sRGB 编码后的值 与 PNG 的约定一致 只需要调整通道顺序
+//PNG 使用不压缩的 deflate 块 (编码几乎不占 CPU  文件较大)
+
+//交换链格式能否转换为 RGBA8  swapRedBlue 表示源数据为 BGRA 顺序
+static bool readbackFormatSupported(VkFormat format , bool &swapRedBlue){
+    switch(format){
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            swapRedBlue = true;
+            return true;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            swapRedBlue = false;
+            return true;
+        default:
+            return false;
+    }
+}
+
+//pixelCount 个 32 位像素转换为 RGBA  alpha 固定为 255 (交换链的 alpha 不代表透明度)
+//SSE2 每次 4 个像素:  R B 两个字节互换 = 取出 0x00FF00FF 位置的字节 循环移位 16 位
+static void convertToRgba(const uint8_t *src , uint8_t *dst , size_t pixelCount , bool swapRedBlue){
+    size_t i = 0;
+#ifdef IMAGE_IO_SSE2
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m128i redBlueMask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i greenMask = _mm_set1_epi32(0x0000FF00);
+    for(; i + 4 <= pixelCount ; i += 4){
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        if(swapRedBlue){
+            const __m128i redBlue = _mm_and_si128(pixels , redBlueMask);
+            const __m128i swapped = _mm_or_si128(_mm_slli_epi32(redBlue , 16) , _mm_srli_epi32(redBlue , 16));
+            pixels = _mm_or_si128(_mm_and_si128(swapped , redBlueMask) , _mm_and_si128(pixels , greenMask));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4) , _mm_or_si128(pixels , alpha));
+    }//end for i
+#endif
+    for(; i < pixelCount ; i++){
+        const uint8_t *pixel = src + i * 4;
+        uint8_t *out = dst + i * 4;
+        out[0] = swapRedBlue ? pixel[2] : pixel[0];
+        out[1] = pixel[1];
+        out[2] = swapRedBlue ? pixel[0] : pixel[2];
+        out[3] = 255;
+    }//end for i
+}
+
+//CRC32 (PNG 块校验)
+static uint32_t crc32Update(uint32_t crc , const uint8_t *data , size_t size){
+    //局部静态变量的初始化是线程安全的
+    static const std::vector<uint32_t> table = [](){
+        std::vector<uint32_t> result(256);
+        for(uint32_t n = 0 ; n < 256 ; n++){
+            uint32_t c = n;
+            for(int k = 0 ; k < 8 ; k++){
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }//end for k
+            result[n] = c;
+        }//end for n
+        return result;
+    }();
+    crc = ~crc;
+    for(size_t i = 0 ; i < size ; i++){
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }//end for i
+    return ~crc;
+}
+
+static void appendBigEndian(std::vector<uint8_t> &out , uint32_t value){
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void appendPngChunk(std::vector<uint8_t> &out , const char *type , const uint8_t *data , size_t size){
+    appendBigEndian(out , static_cast<uint32_t>(size));
+    const size_t typeOffset = out.size();
+    out.insert(out.end() , type , type + 4);
+    out.insert(out.end() , data , data + size);
+    appendBigEndian(out , crc32Update(0 , out.data() + typeOffset , size + 4));
+}
+
+//RGBA8 写为 PNG  scratch 为可重复使用的缓冲
+static bool writePng(const std::string &path , const uint8_t *rgba , uint32_t width , uint32_t height ,
+        std::vector<uint8_t> &scratch){
+    //zlib 流: 头 + 不压缩的 deflate 块 (每块最多 65535 字节) + adler32
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const size_t rawSize = (rowBytes + 1) * height;
+    std::vector<uint8_t> &zlib = scratch;
+    zlib.clear();
+    zlib.reserve(rawSize + rawSize / 65535 * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+    size_t blockRemaining = 0;
+    size_t remaining = rawSize;
+    auto emit = [&](const uint8_t *data , size_t size){
+        while(size > 0){
+            if(blockRemaining == 0){
+                blockRemaining = remaining < 65535 ? remaining : 65535;
+                remaining -= blockRemaining;
+                const uint16_t length = static_cast<uint16_t>(blockRemaining);
+                const uint16_t inverse = static_cast<uint16_t>(~length);
+                zlib.push_back(remaining == 0 ? 1 : 0);
+                zlib.push_back(static_cast<uint8_t>(length));
+                zlib.push_back(static_cast<uint8_t>(length >> 8));
+                zlib.push_back(static_cast<uint8_t>(inverse));
+                zlib.push_back(static_cast<uint8_t>(inverse >> 8));
+            }
+            const size_t count = size < blockRemaining ? size : blockRemaining;
+            zlib.insert(zlib.end() , data , data + count);
+            for(size_t i = 0 ; i < count ; i++){
+                adlerA = (adlerA + data[i]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }//end for i
+            data += count;
+            size -= count;
+            blockRemaining -= count;
+        }//end while
+    };
+    const uint8_t filterNone = 0;
+    for(uint32_t y = 0 ; y < height ; y++){
+        emit(&filterNone , 1);
+        emit(rgba + y * rowBytes , rowBytes);
+    }//end for y
+    appendBigEndian(zlib , (adlerB << 16) | adlerA);
+
+    std::vector<uint8_t> png;
+    png.reserve(zlib.size() + 64);
+    const uint8_t signature[8] = {0x89 , 'P' , 'N' , 'G' , 0x0D , 0x0A , 0x1A , 0x0A};
+    png.insert(png.end() , signature , signature + 8);
+    std::vector<uint8_t> header;
+    appendBigEndian(header , width);
+    appendBigEndian(header , height);
+    header.push_back(8);//位深
+    header.push_back(6);//RGBA
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    appendPngChunk(png , "IHDR" , header.data() , header.size());
+    appendPngChunk(png , "IDAT" , zlib.data() , zlib.size());
+    appendPngChunk(png , "IEND" , nullptr , 0);
+
+    std::ofstream file(path , std::ios::binary);
+    if(!file.is_open()){
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(png.data()) , png.size());
+    return file.good();
+}
+
+static uint32_t readBigEndian(const uint8_t *data){
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16)
+        | (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+//读取 writePng 写出的 PNG (RGBA8  不压缩的 deflate 块  行过滤为 None)  其它 PNG 返回 false 并给出原因
+//回归检查的基准图像由本程序写出 不需要完整的 inflate
+static bool readPng(const std::string &path , std::vector<uint8_t> &rgba , uint32_t &width , uint32_t &height ,
+        std::string &error){
+    std::ifstream file(path , std::ios::binary | std::ios::ate);
+    if(!file.is_open()){
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> png(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(png.data()) , png.size());
+
+    const uint8_t signature[8] = {0x89 , 'P' , 'N' , 'G' , 0x0D , 0x0A , 0x1A , 0x0A};
+    if(png.size() < 8 || std::memcmp(png.data() , signature , 8) != 0){
+        error = "not a png file " + path;
+        return false;
+    }
+    std::vector<uint8_t> zlib;
+    bool header = false;
+    size_t offset = 8;
+    while(offset + 12 <= png.size()){
+        const uint32_t size = readBigEndian(png.data() + offset);
+        if(size > png.size() - offset - 12){
+            error = "truncated png chunk in " + path;
+            return false;
+        }
+        const uint8_t *type = png.data() + offset + 4;
+        const uint8_t *data = type + 4;
+        if(crc32Update(0 , type , size + 4) != readBigEndian(data + size)){
+            error = "png crc mismatch in " + path;
+            return false;
+        }
+        if(std::memcmp(type , "IHDR" , 4) == 0 && size == 13){
+            width = readBigEndian(data);
+            height = readBigEndian(data + 4);
+            //位深 8  RGBA  无隔行
+            if(data[8] != 8 || data[9] != 6 || data[12] != 0){
+                error = "unsupported png format (rgba8 only) " + path;
+                return false;
+            }
+            header = true;
+        }else if(std::memcmp(type , "IDAT" , 4) == 0){
+            zlib.insert(zlib.end() , data , data + size);
+        }else if(std::memcmp(type , "IEND" , 4) == 0){
+            break;
+        }
+        offset += size + 12;
+    }//end while
+    if(!header || zlib.size() < 2 || (zlib[0] & 0x0F) != 8){
+        error = "invalid png stream " + path;
+        return false;
+    }
+
+    //拼接不压缩块的数据  每块的 3 位块头后补齐到字节边界
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * height);
+    size_t position = 2;
+    bool last = false;
+    while(!last){
+        if(position + 5 > zlib.size()){
+            error = "truncated deflate stream " + path;
+            return false;
+        }
+        last = (zlib[position] & 1) != 0;
+        if(((zlib[position] >> 1) & 3) != 0){
+            error = "compressed png not supported " + path;
+            return false;
+        }
+        const uint16_t length = static_cast<uint16_t>(zlib[position + 1] | (zlib[position + 2] << 8));
+        const uint16_t inverse = static_cast<uint16_t>(zlib[position + 3] | (zlib[position + 4] << 8));
+        position += 5;
+        if(length != static_cast<uint16_t>(~inverse) || position + length > zlib.size()){
+            error = "invalid deflate block " + path;
+            return false;
+        }
+        raw.insert(raw.end() , zlib.begin() + position , zlib.begin() + position + length);
+        position += length;
+    }//end while
+    if(raw.size() != (rowBytes + 1) * height){
+        error = "png size mismatch " + path;
+        return false;
+    }
+
+    rgba.resize(rowBytes * height);
+    for(uint32_t y = 0 ; y < height ; y++){
+        const uint8_t *row = raw.data() + y * (rowBytes + 1);
+        if(row[0] != 0){
+            error = "unsupported png row filter " + path;
+            return false;
+        }
+        std::memcpy(rgba.data() + y * rowBytes , row + 1 , rowBytes);
+    }//end for y
+    return true;
+}
+
+//不带文件头的 RGBA8  尺寸写在文件名中 (ffmpeg -f rawvideo -pix_fmt rgba -s WxH)
+static bool writeRaw(const std::string &path , const uint8_t *rgba , uint32_t width , uint32_t height){
+    std::ofstream file(path , std::ios::binary);
+    if(!file.is_open()){
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(rgba) , static_cast<std::streamsize>(width) * height * 4);
+    return file.good();
+}
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef _INSTANCING_H_
+#define _INSTANCING_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "device_dispatch.hpp"
+#include "vk_utils.hpp"
+#include "render_queue.hpp"
+
+//实例化渲染
+//物体按 (材质 , 网格) 自动分组 每组一次 instanced draw
+//实例属性按流(SoA)存放 每种属性一个 binding 紧密排列:
+//  binding 0 transform  vec4  (xy 位置 z 深度 w 缩放)
+//  binding 1 color      RGBA8 UNORM
+//  binding 2 custom     vec2  (x 旋转 y 自定义)
+//每个飞行帧一个实例buffer 常驻映射 在该帧的fence等待之后重写
+//批次作为 DrawPacket 加入渲染队列 由队列排序并录制
+
+struct InstanceData{
+    float transform[4];
+    uint32_t color;
+    float custom[2];
+};
+
+enum InstanceStream{
+    INSTANCE_STREAM_TRANSFORM = 0,
+    INSTANCE_STREAM_COLOR,
+    INSTANCE_STREAM_CUSTOM,
+    INSTANCE_STREAM_COUNT
+};
+
+static const uint32_t INSTANCE_STREAM_STRIDES[INSTANCE_STREAM_COUNT] = {
+    sizeof(float) * 4 , sizeof(uint32_t) , sizeof(float) * 2
+};
+
+//网格在 shaders/instanced.vert 内置顶点表中的范围
+struct MeshRange{
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+};
+
+static const MeshRange MESH_TRIANGLE = {0 , 3};
+static const MeshRange MESH_QUAD = {3 , 6};
+
+struct InstanceBatch{
+    uint32_t material;
+    uint32_t mesh;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+struct InstanceStats{
+    uint32_t objects = 0;
+    uint32_t batches = 0;
+};
+
+class InstanceRenderer{
+public:
+    std::vector<MeshRange> meshes;
+    std::vector<InstanceBatch> batches;//build 的结果
+    InstanceStats stats;
+
+    void init(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd , uint32_t framesInFlight){
+        this->device = device;
+        this->vkd = vkd;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+        frames.resize(framesInFlight);
+    }
+
+    void destroy(){
+        for(FrameStreams &frame : frames){
+            destroyFrame(frame);
+        }//end for each
+        frames.clear();
+    }
+
+    uint32_t addMesh(const MeshRange &mesh){
+        meshes.push_back(mesh);
+        return static_cast<uint32_t>(meshes.size() - 1);
+    }
+
+    void clear(){
+        groups.clear();
+        lastGroup = -1;
+        objectCount = 0;
+    }
+
+    //添加一个物体  相同 (材质 , 网格) 的物体进入同一组
+    void add(uint32_t mesh , uint32_t material , const InstanceData &data){
+        const uint64_t key = (static_cast<uint64_t>(material) << 32) | mesh;
+        if(lastGroup < 0 || groups[lastGroup].key != key){
+            lastGroup = -1;
+            for(size_t i = 0 ; i < groups.size() ; i++){
+                if(groups[i].key == key){
+                    lastGroup = static_cast<int>(i);
+                    break;
+                }
+            }//end for i
+            if(lastGroup < 0){
+                Group group;
+                group.key = key;
+                groups.push_back(group);
+                lastGroup = static_cast<int>(groups.size() - 1);
+            }
+        }
+        groups[lastGroup].instances.push_back(data);
+        objectCount++;
+    }
+
+    uint32_t count() const{
+        return objectCount;
+    }
+
+    //分组结果写入 frame 的实例流  按材质排序 减少管线切换
+    void build(uint32_t frame){
+        FrameStreams &streams = frames[frame];
+        if(streams.capacity < objectCount){
+            destroyFrame(streams);
+            createFrame(streams , std::max(objectCount , streams.capacity * 2));
+        }
+
+        std::vector<size_t> order(groups.size());
+        for(size_t i = 0 ; i < order.size() ; i++){
+            order[i] = i;
+        }
+        std::sort(order.begin() , order.end() , [this](size_t a , size_t b){
+            return groups[a].key < groups[b].key;
+        });
+
+        batches.clear();
+        char *base = static_cast<char *>(streams.mapped);
+        float *transforms = reinterpret_cast<float *>(base + streams.offsets[INSTANCE_STREAM_TRANSFORM]);
+        uint32_t *colors = reinterpret_cast<uint32_t *>(base + streams.offsets[INSTANCE_STREAM_COLOR]);
+        float *customs = reinterpret_cast<float *>(base + streams.offsets[INSTANCE_STREAM_CUSTOM]);
+
+        uint32_t firstInstance = 0;
+        for(size_t index : order){
+            const Group &group = groups[index];
+            if(group.instances.empty()){
+                continue;
+            }
+
+            InstanceBatch batch;
+            batch.material = static_cast<uint32_t>(group.key >> 32);
+            batch.mesh = static_cast<uint32_t>(group.key & 0xFFFFFFFFu);
+            batch.firstInstance = firstInstance;
+            batch.instanceCount = static_cast<uint32_t>(group.instances.size());
+            batches.push_back(batch);
+
+            for(const InstanceData &data : group.instances){
+                std::memcpy(transforms + firstInstance * 4 , data.transform , sizeof(data.transform));
+                colors[firstInstance] = data.color;
+                std::memcpy(customs + firstInstance * 2 , data.custom , sizeof(data.custom));
+                firstInstance++;
+            }//end for each
+        }//end for each
+
+        stats.objects = objectCount;
+        stats.batches = static_cast<uint32_t>(batches.size());
+    }
+
+    VkBuffer buffer(uint32_t frame) const{
+        return frames[frame].buffer;
+    }
+
+    VkDeviceSize bufferSize(uint32_t frame) const{
+        return frames[frame].size;
+    }
+
+    //frame 的实例流 每个流一个 binding
+    RenderQueueVertexInput vertexInput(uint32_t frame) const{
+        const FrameStreams &streams = frames[frame];
+        RenderQueueVertexInput input;
+        input.count = INSTANCE_STREAM_COUNT;
+        for(uint32_t i = 0 ; i < INSTANCE_STREAM_COUNT ; i++){
+            input.buffers[i] = streams.buffer;
+            input.offsets[i] = streams.offsets[i];
+        }//end for i
+        return input;
+    }
+
+    //本帧的批次加入渲染队列  管线下标默认为材质  pipelineOverride >= 0 时所有批次使用它 (例如深度预处理)
+    //vertexInput 为 vertexInput(frame) 在队列资源中的下标
+    void enqueue(RenderQueue &queue , uint32_t pass , int32_t pipelineOverride , uint16_t vertexInput) const{
+        for(const InstanceBatch &batch : batches){
+            const MeshRange &mesh = meshes[batch.mesh];
+            DrawPacket packet = {};
+            packet.pipeline = static_cast<uint16_t>(pipelineOverride >= 0 ? pipelineOverride : batch.material);
+            packet.material = static_cast<uint16_t>(batch.material);
+            packet.vertexInput = vertexInput;
+            packet.firstVertex = mesh.firstVertex;
+            packet.vertexCount = mesh.vertexCount;
+            packet.firstInstance = batch.firstInstance;
+            packet.instanceCount = batch.instanceCount;
+            packet.key = makeRenderKey(pass , packet.pipeline , packet.material , 0.0f);
+            queue.push(packet);
+        }//end for each
+    }
+
+    //管线的顶点输入  每个流一个 binding
+    static std::vector<VkVertexInputBindingDescription> bindingDescriptions(){
+        std::vector<VkVertexInputBindingDescription> bindings(INSTANCE_STREAM_COUNT);
+        for(uint32_t i = 0 ; i < INSTANCE_STREAM_COUNT ; i++){
+            bindings[i].binding = i;
+            bindings[i].stride = INSTANCE_STREAM_STRIDES[i];
+            bindings[i].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        }//end for i
+        return bindings;
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> attributeDescriptions(){
+        std::vector<VkVertexInputAttributeDescription> attributes(INSTANCE_STREAM_COUNT);
+        const VkFormat formats[INSTANCE_STREAM_COUNT] = {
+            VK_FORMAT_R32G32B32A32_SFLOAT , VK_FORMAT_R8G8B8A8_UNORM , VK_FORMAT_R32G32_SFLOAT
+        };
+        for(uint32_t i = 0 ; i < INSTANCE_STREAM_COUNT ; i++){
+            attributes[i].location = i;
+            attributes[i].binding = i;
+            attributes[i].format = formats[i];
+            attributes[i].offset = 0;
+        }//end for i
+        return attributes;
+    }
+
+private:
+    struct Group{
+        uint64_t key = 0;
+        std::vector<InstanceData> instances;
+    };
+
+    struct FrameStreams{
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void *mapped = nullptr;
+        VkDeviceSize size = 0;
+        uint32_t capacity = 0;
+        VkDeviceSize offsets[INSTANCE_STREAM_COUNT] = {};
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+
+    std::vector<Group> groups;
+    int lastGroup = -1;
+    uint32_t objectCount = 0;
+    std::vector<FrameStreams> frames;
+
+    void createFrame(FrameStreams &streams , uint32_t capacity){
+        streams.capacity = capacity;
+        VkDeviceSize offset = 0;
+        for(uint32_t i = 0 ; i < INSTANCE_STREAM_COUNT ; i++){
+            streams.offsets[i] = offset;
+            offset = alignUp(offset + static_cast<VkDeviceSize>(capacity) * INSTANCE_STREAM_STRIDES[i] , 16);
+        }//end for i
+        streams.size = offset;
+
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = streams.size;
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if(vkCreateBuffer(device , &bufferCreateInfo , nullptr , &streams.buffer) != VK_SUCCESS){
+            throw std::runtime_error("failed to create instance buffer!");
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device , streams.buffer , &requirements);
+
+        //优先 CPU 可写的显存
+        const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        int memoryType = findMemoryTypeIndex(memoryProperties , requirements.memoryTypeBits ,
+            hostVisible | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(memoryType < 0){
+            memoryType = static_cast<int>(findMemoryType(memoryProperties , requirements.memoryTypeBits , hostVisible));
+        }
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = static_cast<uint32_t>(memoryType);
+        if(vkAllocateMemory(device , &allocateInfo , nullptr , &streams.memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate instance buffer memory!");
+        }
+        vkBindBufferMemory(device , streams.buffer , streams.memory , 0);
+        vkMapMemory(device , streams.memory , 0 , VK_WHOLE_SIZE , 0 , &streams.mapped);
+    }
+
+    void destroyFrame(FrameStreams &streams){
+        if(streams.buffer == VK_NULL_HANDLE){
+            return;
+        }
+        vkUnmapMemory(device , streams.memory);
+        vkDestroyBuffer(device , streams.buffer , nullptr);
+        vkFreeMemory(device , streams.memory , nullptr);
+        uint32_t capacity = streams.capacity;
+        streams = FrameStreams();
+        streams.capacity = capacity;
+    }
+};
+
+#endif
@@ -10,21 +10,55 @@
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
+#include <cmath>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
 
 #include <string>
 #include <vector>
 #include <set>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <future>
+#include <functional>
 
 #include "utils.hpp"
+#include "device_dispatch.hpp"
+#include "device_features.hpp"
+#include "render_graph.hpp"
+#include "depth_buffer.hpp"
+#include "instancing.hpp"
+#include "gpu_driven.hpp"
+#include "hiz_pyramid.hpp"
+#include "bindless.hpp"
+#include "descriptor_allocator.hpp"
+#include "texture.hpp"
+#include "per_draw_data.hpp"
+#include "host_allocator.hpp"
+#include "shader_library.hpp"
+#include "startup_profile.hpp"
+#include "debug_logger.hpp"
+#include "frame_readback.hpp"
+#include "image_compare.hpp"
+#include "benchmark_report.hpp"
 
 #define DEBUG
 
+//CPU 计时宏 (cpu_trace.hpp)  注释掉后所有 CPU_TRACE_* 展开为空
+#define ENABLE_CPU_TRACE
+#include "cpu_trace.hpp"
+
 #ifdef DEBUG
-const bool enableValidateLayers = true;
+const bool validationDefault = true;
 #else
-const bool enableValidateLayers = false;
+const bool validationDefault = false;
 #endif
 
+//是否开启验证层  默认由 DEBUG 决定  运行时由 --validation=on|off 覆盖
+static bool enableValidateLayers = validationDefault;
+
 /**
  * main
  * */
@@ -35,6 +69,7 @@ const uint32_t HEIGHT = 800;
 struct QueueFamilyIndices{
     int graphicsIndex = -1;//图形队列
     int presentIndex = -1;//显示队列
+    int computeIndex = -1;//独立的计算队列 用于异步计算 可选
 
     bool isComplete(){
         return graphicsIndex >= 0 && presentIndex >= 0;
@@ -59,49 +94,302 @@ const std::vector<const char *> deviceExtensions = {
 
 const int MAX_FRAMES_IN_FLIGHT = 2;//可同时并行处理的帧数
 
+//静态初始化时刻 近似进程启动  time to first frame 从这里算起
+static const uint64_t processStartNanos = currentTimeNanos();
+
+//预读的着色器  当前配置用不到的文件读取失败不影响启动
+const std::vector<std::string> preloadShaders = {
+    "shaders/vert.spv" , "shaders/frag.spv" , "shaders/instanced_vert.spv" , "shaders/bindless_frag.spv" ,
+    "shaders/cull.spv" , "shaders/cull_occlusion.spv" , "shaders/hiz.spv"
+};
+
+//运行配置 来自命令行与环境变量
+struct AppConfig{
+    //指定GPU  序号 / 名称(子串) / UUID / "cpu"(选择软件实现 如lavapipe)
+    //命令行 --device=xxx  或环境变量 VK_DEVICE
+    std::string deviceSelector;
+
+    //基准测试名称 非空时初始化后只运行基准测试  --bench=dispatch|renderpath|depth|msaa|instancing|culling|perdraw|sort|api|raster
+    //--bench-json=file 把支持的基准测试 (api raster depth culling) 的结果写为 JSON
+    std::string benchmark;
+    std::string benchmarkJson;
+
+    //渲染路径 auto: 设备支持时使用 dynamic rendering  legacy: 强制 VkRenderPass/VkFramebuffer
+    //命令行 --render-path=auto|legacy|dynamic
+    std::string renderPath = "auto";
+
+    //深度  --reverse-z=on|off  --depth-prepass 先只写深度 主pass 以 EQUAL 测试 每个像素只着色一次
+    bool reverseZ = true;
+    bool depthPrepass = false;
+
+    //场景复杂度  --overdraw=N 重叠的三角形层数  --shading=N 片元着色器的循环次数
+    uint32_t overdrawLayers = 1;
+    uint32_t shadingIterations = 0;
+
+    //光栅化场景  --triangles=N 每层一次实例化绘制 N 个三角形 按网格铺满屏幕 (0 时为 overdraw 的单个大三角形)
+    //N 超过网格的格子数时 多出的三角形从头开始重叠
+    //--triangle-size=A 网格中每个三角形的面积 (像素)  --blend=on|off 场景管线开启 alpha 混合
+    //--cull=back|none|front 场景管线的剔除模式 (场景三角形都是正面 front 时全部被剔除)
+    uint32_t gridTriangles = 0;
+    float triangleArea = 64.0f;
+    bool blend = false;
+    std::string cullMode = "back";
+
+    //多重采样数  --msaa=1|2|4|8  超过设备支持时取支持的最大值
+    uint32_t msaaSamples = 1;
+
+    //实例化绘制的物体数  --instances=N  0 时使用 overdraw 的单实例绘制
+    uint32_t instanceCount = 0;
+
+    //实例的视锥剔除  --culling=off|cpu|gpu
+    //gpu: 计算着色器剔除 vkCmdDrawIndexedIndirectCount  不支持时退回cpu
+    std::string culling = "off";
+
+    //两阶段 Hi-Z 遮挡剔除  --occlusion  需要 gpu 剔除且不开启 MSAA
+    bool occlusion = false;
+
+    //场景每次绘制参数的提交路径  --per-draw=auto|push|uniform
+    //auto: 放得进 push constant 时使用 push constant  否则使用动态偏移的 uniform buffer
+    std::string perDraw = "auto";
+
+    //驱动的主机内存分配经过 HostAllocator 统计  --host-alloc=off 时使用驱动默认的分配器
+    //--alloc-report 每 120 帧输出 drawFrame 期间的分配次数 退出时输出按对象类型的统计
+    bool trackHostAllocations = true;
+    bool allocationReport = false;
+
+    //GPU 计时  --gpu-profile 每 120 帧输出每个pass 的平均耗时与管线统计 (顶点 图元 各着色器调用次数)
+    //--trace=file.json 同时记录 CPU 录制与 GPU 执行的时间线 退出时写出 (Chrome trace_event 格式)
+    bool gpuProfile = false;
+    std::string traceFile;
+
+    //CPU 时间线  --cpu-trace=file.json 记录初始化各阶段与每帧各阶段 (等待fence 获取图像 录制 提交 显示)
+    //后台线程边运行边写出  需要编译时定义 ENABLE_CPU_TRACE
+    std::string cpuTraceFile;
+
+    //验证层  --validation=on|off 默认由编译时的 DEBUG 决定
+    //消息异步输出  --vk-log=error|warning|info|verbose 最低级别  --vk-log-types=general,validation,performance
+    //--vk-log-repeat=N 同一消息 ID 最多输出 N 次  --vk-log-rate=N 每秒最多输出 N 条 (错误不限)  0 不限
+    bool validation = validationDefault;
+    std::string logSeverity = "warning";
+    std::string logTypes = "general,validation,performance";
+    uint32_t logRepeats = 3;
+    uint32_t logRate = 50;
+
+    //帧转储  --dump-frames=N 每 N 帧把交换链图像异步回读并写入 --dump-dir (默认 frames)
+    //--dump-format=png|raw  --dump-count=M 最多转储 M 帧 0 不限  渲染不会因回读等待
+    uint32_t dumpInterval = 0;
+    std::string dumpDir = "frames";
+    std::string dumpFormat = "png";
+    uint32_t dumpCount = 0;
+
+    //渲染回归检查  --regression=dir 依次渲染固定的场景 回读一帧与 dir/<场景>.png 比较  有场景不通过时返回非零
+    //--regression-update 写入新的基准图像  不通过的场景另存 <场景>_actual.png 与 <场景>_diff.png
+    //阈值 --regression-psnr=dB 下限  --regression-ssim=x 下限  --regression-tolerance=N 单个通道允许的差值
+    //--regression-pixels=x 超出容差的像素比例上限  不创建窗口与交换链 渲染到离屏图像 不需要显示服务器
+    //CI 中使用软件实现 --device=cpu  make regression / make test 运行 tests/regression 中的基准图像
+    std::string regressionDir;
+    bool regressionUpdate = false;
+    double regressionPsnr = 40.0;
+    double regressionSsim = 0.98;
+    uint32_t regressionTolerance = 2;
+    double regressionPixels = 0.001;
+};
+
+//回归检查的固定场景  在启动配置的基础上修改场景参数
+struct RegressionScene{
+    const char *name;
+    std::function<void(AppConfig &)> configure;
+};
+
+//与 shader 中的 DrawParams 对应 (push constant)
+struct DrawParams{
+    float offsetDepth[4];//xy 偏移  z 深度  w 缩放
+    uint32_t shadingIterations;
+    uint32_t gridColumns;//非 0 时实例按网格排列 (triangle.vert)
+};
+
+//主渲染的深度与多重采样颜色附件  由帧图按飞行帧分配 (遮挡剔除时深度为常驻的 depthBuffer)
+struct MainTargets{
+    uint32_t frame = 0;//分配附件的飞行帧
+    VkImageView depth = VK_NULL_HANDLE;
+    VkImageView msaa = VK_NULL_HANDLE;//不开 msaa 时为空
+};
+
+//legacy 路径的 framebuffer  附件与创建时不同就重建
+struct CachedFramebuffer{
+    std::vector<VkImageView> attachments;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+};
+
+//--cull 的取值
+static VkCullModeFlags cullModeFromName(const std::string &name){
+    if(name == "none"){
+        return VK_CULL_MODE_NONE;
+    }
+    if(name == "front"){
+        return VK_CULL_MODE_FRONT_BIT;
+    }
+    if(name == "back"){
+        return VK_CULL_MODE_BACK_BIT;
+    }
+    throw std::runtime_error("unknown cull mode " + name);
+}
+
+//--per-draw 的取值
+static PerDrawStrategy perDrawStrategyFromName(const std::string &name){
+    if(name == "push"){
+        return PER_DRAW_PUSH_CONSTANTS;
+    }
+    if(name == "uniform"){
+        return PER_DRAW_DYNAMIC_UNIFORM;
+    }
+    return PER_DRAW_AUTO;
+}
+
+//实例化管线的材质 (shaders/instanced.vert 的特化常量)
+//MATERIAL_BINDLESS 的物体通过 custom[1] 中的句柄索引全局 bindless 描述符集 不同纹理的物体同一批次绘制
+static const int32_t MATERIAL_BINDLESS = 2;
+
+//物理设备评分结果
+struct PhysicalDeviceScore{
+    VkPhysicalDevice device = VK_NULL_HANDLE;
+    uint32_t index = 0;
+    std::string name;
+    std::string uuid;
+    VkPhysicalDeviceType type = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+    bool suitable = false;
+    uint64_t score = 0;
+};
+
 class HelloTriangleApplication{
 public: 
     std::string appName = "Hello Vulkan";
+    AppConfig config;
 
     int run(){
-        initWindow();
+        enableValidateLayers = config.validation;
+        offscreen = !config.regressionDir.empty();
+        if(!config.cpuTraceFile.empty() && CpuTracer::instance().start(config.cpuTraceFile)){
+            CPU_TRACE_THREAD("main");
+        }
+        startup.run("initWindow" , [this](){ initWindow(); });
         initVulkan();
 
+        if(!config.benchmark.empty()){
+            runBenchmark(config.benchmark);
+            if(!config.benchmarkJson.empty()){
+                benchmarkReport.writeJson(config.benchmarkJson);
+            }
+            cleanup();
+            CpuTracer::instance().stop();
+            return 0;
+        }
+
+        if(!config.regressionDir.empty()){
+            const bool passed = runRegression();
+            cleanup();
+            CpuTracer::instance().stop();
+            return passed ? 0 : 1;
+        }
+
         mainloop();
         cleanup();
+        CpuTracer::instance().stop();
         return 0;
     }
 
 private:
     GLFWwindow *window = nullptr;
+    bool offscreen = false;//回归检查时没有窗口 表面与交换链  渲染到离屏图像
     VkInstance instance;
+    uint32_t instanceApiVersion = VK_API_VERSION_1_0;//实例请求的api版本
+    bool instanceIdProperties = false;//1.0 实例开启了 properties2 / external_memory_capabilities 扩展 可查询设备UUID
 
     VkDebugUtilsMessengerEXT debugMessenger;
 
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;//物理设备
     VkDevice device = VK_NULL_HANDLE;//逻辑设备
+    DeviceDispatchTable vkd;//逻辑设备函数表 热路径直接调用驱动
+    DeviceFeatures deviceFeatures;//协商后开启的设备特性与能力位
 
     VkQueue graphicsQueue;//图形队列
     VkQueue presentQueue;//显示队列
+    VkQueue computeQueue = VK_NULL_HANDLE;//异步计算队列
 
-    VkSurfaceKHR surface; //窗口表面
+    VkSurfaceKHR surface = VK_NULL_HANDLE; //窗口表面
 
-    VkSwapchainKHR swapChain;//交换链
-    std::vector<VkImage> swapChainImages;//交换链上的图像
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;//交换链
+    std::vector<VkImage> swapChainImages;//交换链上的图像  离屏时为每个飞行帧一张的离屏图像
+    std::vector<VkDeviceMemory> offscreenMemories;//离屏图像的内存
     VkFormat swapChainImageFormat;
     VkExtent2D swapChainExtent;//交换链图像分辨率
 
     std::vector<VkImageView> swapChainImageViews;//交换链imageView
 
-    VkRenderPass renderPass;
+    bool useDynamicRendering = false;//true 时不创建 renderPass 与 framebuffer
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkRenderPass renderPassLoad = VK_NULL_HANDLE;//保留已有内容的第二次渲染 (遮挡剔除 phase 2)
     VkPipelineLayout pipelineLayout;
 
     VkPipeline graphicsPipeline;//图形管线
-
-    std::vector<VkFramebuffer> swapChainFramebuffers;
+    VkPipeline depthPrepassPipeline = VK_NULL_HANDLE;//只写深度的管线 开启深度预处理时创建
+
+    PerDrawData perDraw;//场景管线的布局  每次绘制参数走 push constant 或动态 uniform
+    PerDrawStrategy sceneStrategy = PER_DRAW_PUSH_CONSTANTS;//创建场景管线时确定 作为顶点着色器的特化常量
+    uint32_t scenePayloadBytes = sizeof(DrawParams);//每次绘制提交的字节数 DrawParams 之后补零  基准测试时修改
+
+    InstanceRenderer instanceRenderer;//按 (材质 , 网格) 分组的实例化绘制
+    std::vector<VkPipeline> instancedPipelines;//每个材质一条实例化管线
+    VkPipeline instancedDepthPipeline = VK_NULL_HANDLE;
+    uint64_t instanceBuildNanos = 0;//累计的实例流写入耗时
+    RenderQueue instanceQueue;//实例批次排序后录制  只绑定变化的状态
+    RenderQueueResources instanceQueueResources;
+
+    BindlessDescriptors bindless;//支持 descriptor indexing 时创建  管线布局的 set 0
+    std::vector<Texture2D> bindlessTextures;
+    std::vector<BindlessHandle> textureHandles;
+    std::vector<BindlessHandle> materialHandles;//材质参数 (storage buffer 中的一段)
+    VkSampler bindlessSampler = VK_NULL_HANDLE;
+    VkBuffer materialBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory materialMemory = VK_NULL_HANDLE;
+
+    DescriptorLayoutCache layoutCache;//描述符集布局按内容复用
+    DescriptorAllocator frameDescriptors;//每帧重置的描述符池  分配只在本帧有效的集
+
+    GpuDrivenScene gpuScene;//开启剔除时 实例由它绘制
+    bool gpuCulling = false;
+    bool occlusionCulling = false;//深度需要保存并采样 在创建渲染目标之前确定
+    HiZPyramid hiz;
+
+    DepthBuffer depthBuffer;
+    VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+    MainTargets lastMainTargets;//最近一帧的附件  只录制不提交的基准测试使用
+
+    //按 (飞行帧 , 交换链图像) 缓存  每个飞行帧的临时附件在该帧的 fence 等待之后才会重建
+    //因此附件变化时 旧的 framebuffer 不再被任何飞行中的帧使用 可以直接销毁
+    std::vector<CachedFramebuffer> swapChainFramebuffers;
 
     VkCommandPool cmdPool;//指令池
-    std::vector<VkCommandBuffer> cmdBuffers;//指令缓存
+    std::vector<VkCommandBuffer> cmdBuffers;//指令缓存 每个飞行帧一个 每帧重新录制
+
+    VkCommandPool computeCmdPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> asyncCmdBuffers;//异步计算指令缓存
+    std::vector<VkSemaphore> asyncFinishedSemaphores;
+
+    RenderGraph renderGraph;//帧图 每帧声明并编译
+    DebugLogger debugLogger;//验证层消息 后台线程去重 限速后输出
+    FrameReadback frameReadback;//--dump-frames 或 --regression 时创建
+    bool swapChainTransferSrc = false;//交换链图像可以作为复制源 (帧转储需要)
+    ShaderLibrary shaderLibrary;//SPIR-V 缓存 启动时后台预读
+    StartupProfile startup{processStartNanos};//初始化各步骤耗时与 time to first frame
+    GpuProfiler gpuProfiler;//--gpu-profile 或 --trace 时创建  每个帧图pass 一个作用域
+    uint64_t recordNanos = 0;//累计的指令录制耗时
+    BenchmarkReport benchmarkReport;//--bench-json 时写出
+    uint64_t frameCounter = 0;
+
+    HostAllocator hostAllocator;//比 instance 与 device 存在得更久
+    HostAllocationSnapshot lastHostSnapshot;//上一帧开始时的分配次数
+    HostAllocationSnapshot frameHostAllocations;//本统计周期内每帧分配次数之和
 
     //同步信号量
     // VkSemaphore imageAvailableSemaphore;
@@ -113,38 +401,142 @@ private:
     int currentFrame = 0;//指示当前渲染的是哪一帧
 
     void initWindow(){
+        CPU_TRACE_FUNCTION();
+        if(offscreen){
+            return;
+        }
         glfwInit();
 
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
         window = glfwCreateWindow(WIDTH, HEIGHT, appName.c_str(), nullptr, nullptr);
+        if(window == nullptr){
+            throw std::runtime_error("failed to create window!");
+        }
     }
 
+    //初始化的每一步记录墙钟时间 (startup)
+    //着色器文件在后台线程读取 与实例 设备 交换链的创建并行
+    //管线只依赖布局与渲染通道 在另一个线程创建 与帧缓冲 指令缓存 同步对象 纹理 描述符 实例流的创建并行
     void initVulkan(){
-        createInstance();
-        setupDebugMessenger();
-
-        createSurface();
-        pickPhysicalDevice();
-        createLogicalDevice();
-        createSwapChain();
-        createImageViews();
-        createRenderPass();
-        createGraphicsPipeline();
-        createFramebuffers();
-        createCommandPool();
-        createCommandBuffers();
-        createSyncObjects();
+        CPU_TRACE_FUNCTION();
+        shaderLibrary.preload(preloadShaders);
+        if(enableValidateLayers){
+            //实例创建期间的消息同样经过 debugLogger
+            debugLogger.setSeverityMask(debugSeverityMaskFromName(config.logSeverity));
+            debugLogger.setTypeMask(debugTypeMaskFromNames(config.logTypes));
+            debugLogger.setMaxRepeats(config.logRepeats);
+            debugLogger.setMaxPerSecond(config.logRate);
+            debugLogger.start();
+        }
+
+        startup.run("createInstance" , [this](){ createInstance(); });
+        startup.run("setupDebugMessenger" , [this](){ setupDebugMessenger(); });
+
+        startup.run("createSurface" , [this](){ createSurface(); });
+        startup.run("pickPhysicalDevice" , [this](){ pickPhysicalDevice(); });
+        startup.run("createLogicalDevice" , [this](){ createLogicalDevice(); });
+        startup.run("createSwapChain" , [this](){
+            createSwapChain();
+            createImageViews();
+        });
+        chooseRenderPath();
+        chooseOcclusion();
+        startup.run("createRenderTargets" , [this](){ createRenderTargets(); });
+        startup.run("createLayouts" , [this](){
+            if(deviceFeatures.has(CAP_DESCRIPTOR_INDEXING)){
+                CPU_TRACE_SCOPE("bindless.init");
+                bindless.init(instance , device , physicalDevice , &vkd , MAX_FRAMES_IN_FLIGHT);
+            }
+            CPU_TRACE_SCOPE("perDraw.init");
+            perDraw.init(device , physicalDevice , &vkd , MAX_FRAMES_IN_FLIGHT ,
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+        });
+        if(!useDynamicRendering){
+            startup.run("createRenderPass" , [this](){ createRenderPass(); });
+        }
+
+        //管线线程只写管线相关的成员  主线程在 get 之前不读取它们
+        std::future<void> pipelines = std::async(std::launch::async , [this](){
+            CPU_TRACE_THREAD("pipeline builder");
+            startup.run("createGraphicsPipeline" , [this](){ createGraphicsPipeline(); } , true);
+        });
+
+        if(!useDynamicRendering){
+            startup.run("createFramebuffers" , [this](){ createFramebuffers(); });
+        }
+        startup.run("createCommandBuffers" , [this](){
+            createCommandPool();
+            createCommandBuffers();
+            createSyncObjects();
+        });
+        startup.run("createBindlessResources" , [this](){ createBindlessResources(); });
+        startup.run("descriptors.init" , [this](){
+            layoutCache.init(device);
+            frameDescriptors.init(device , &vkd , MAX_FRAMES_IN_FLIGHT);
+        });
+        startup.run("instanceRenderer.init" , [this](){
+            instanceRenderer.init(device , physicalDevice , &vkd , MAX_FRAMES_IN_FLIGHT);
+            instanceRenderer.addMesh(MESH_TRIANGLE);
+            instanceRenderer.addMesh(MESH_QUAD);
+        });
+        startup.run("wait pipelines" , [&pipelines](){ pipelines.get(); });
+
+        QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
+        //剔除着色器只在支持 drawIndirectCount 时需要
+        startup.run("gpuScene.init" , [this , &indices](){
+            gpuScene.init(device , physicalDevice , &vkd , MAX_FRAMES_IN_FLIGHT , static_cast<uint32_t>(instancedPipelines.size()) ,
+                deviceFeatures.enabledCore.multiDrawIndirect == VK_TRUE ,
+                deviceFeatures.has(CAP_DRAW_INDIRECT_COUNT) ? shaderLibrary.get("shaders/cull.spv") : std::vector<char>() ,
+                occlusionCulling ? shaderLibrary.get("shaders/cull_occlusion.spv") : std::vector<char>() ,
+                &layoutCache , &frameDescriptors);
+            gpuScene.setQueueFamilies(indices.graphicsIndex , computeQueue != VK_NULL_HANDLE ? indices.computeIndex : -1);
+            gpuScene.setHiZ(hiz.view , hiz.sampler);
+            gpuScene.addMesh(MESH_TRIANGLE);
+            gpuScene.addMesh(MESH_QUAD);
+            chooseCulling();
+            gpuScene.enableOcclusion(occlusionCulling && gpuCulling);
+        });
+        startup.run("populateInstances" , [this](){ populateInstances(config.instanceCount); });
+
+        startup.run("renderGraph.init" , [this , &indices](){
+            renderGraph.init(device , physicalDevice , &vkd , indices.graphicsIndex ,
+                computeQueue != VK_NULL_HANDLE ? indices.computeIndex : -1 , MAX_FRAMES_IN_FLIGHT + 1 ,
+                deviceFeatures.has(CAP_SYNCHRONIZATION2));
+        });
+        //基准测试输出每个pass 的管线统计 同样需要计时器
+        if(config.gpuProfile || !config.traceFile.empty() || !config.benchmark.empty()){
+            CPU_TRACE_SCOPE("gpuProfiler.init");
+            gpuProfiler.init(device , physicalDevice , &vkd , MAX_FRAMES_IN_FLIGHT , indices.graphicsIndex ,
+                computeQueue != VK_NULL_HANDLE ? indices.computeIndex : -1 ,
+                deviceFeatures.enabledCore.pipelineStatisticsQuery == VK_TRUE);
+            if(!config.traceFile.empty()){
+                gpuProfiler.enableTrace();
+            }
+            renderGraph.setProfiler(gpuProfiler.isCreated() ? &gpuProfiler : nullptr);
+        }
+        if(swapChainTransferSrc){
+            startup.run("frameReadback.init" , [this](){
+                frameReadback.init(device , physicalDevice , &vkd , swapChainExtent , swapChainImageFormat , MAX_FRAMES_IN_FLIGHT ,
+                    config.dumpDir , config.dumpFormat == "raw" ? FRAME_DUMP_RAW : FRAME_DUMP_PNG ,
+                    config.dumpInterval , config.dumpCount);
+            });
+        }
+        shaderLibrary.wait();
+        startup.record("preload shaders" , shaderLibrary.preloadBeginTime() , shaderLibrary.preloadEndTime() , true);
+        lastHostSnapshot = hostAllocator.snapshot();
     }
 
     //创建信号量
     void createSyncObjects(){
+        CPU_TRACE_FUNCTION();
         VkSemaphoreCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
         imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+        asyncFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
         VkFenceCreateInfo fenceCreateInfo = {};
@@ -152,9 +544,10 @@ private:
         fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
         for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ;i++){
-            if(vkCreateSemaphore(device , &createInfo , nullptr , &imageAvailableSemaphores[i]) != VK_SUCCESS
-                || vkCreateSemaphore(device , &createInfo , nullptr , &renderFinishedSemaphores[i]) != VK_SUCCESS
-                || vkCreateFence(device , &fenceCreateInfo , nullptr , &inFlightFences[i]) != VK_SUCCESS){
+            if(vkCreateSemaphore(device , &createInfo , allocator(VK_OBJECT_TYPE_SEMAPHORE) , &imageAvailableSemaphores[i]) != VK_SUCCESS
+                || vkCreateSemaphore(device , &createInfo , allocator(VK_OBJECT_TYPE_SEMAPHORE) , &renderFinishedSemaphores[i]) != VK_SUCCESS
+                || vkCreateSemaphore(device , &createInfo , allocator(VK_OBJECT_TYPE_SEMAPHORE) , &asyncFinishedSemaphores[i]) != VK_SUCCESS
+                || vkCreateFence(device , &fenceCreateInfo , allocator(VK_OBJECT_TYPE_FENCE) , &inFlightFences[i]) != VK_SUCCESS){
                 throw std::runtime_error("failed create semaphore");
             }
         }//end for i
@@ -162,11 +555,11 @@ private:
         std::cout << "create semaphores success " << std::endl;
     }
 
-    //创建指令缓存
+    //创建指令缓存  每个飞行帧一个 在 drawFrame 中重新录制
     void createCommandBuffers(){
-        cmdBuffers.resize(swapChainFramebuffers.size());
+        CPU_TRACE_FUNCTION();
+        cmdBuffers.resize(MAX_FRAMES_IN_FLIGHT);
 
-        //创建与帧缓存个数相等的 指令缓冲区
         VkCommandBufferAllocateInfo cmdBufAllocateInfo = {};
         cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         cmdBufAllocateInfo.commandPool = cmdPool;
@@ -178,141 +571,1058 @@ private:
             throw std::runtime_error("failed create command buffers");
         }
 
+        if(computeCmdPool != VK_NULL_HANDLE){
+            asyncCmdBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+            cmdBufAllocateInfo.commandPool = computeCmdPool;
+            cmdBufAllocateInfo.commandBufferCount = static_cast<uint32_t>(asyncCmdBuffers.size());
+            if(vkAllocateCommandBuffers(device , &cmdBufAllocateInfo , asyncCmdBuffers.data()) != VK_SUCCESS){
+                throw std::runtime_error("failed create async compute command buffers");
+            }
+        }
+
         std::cout << "create command buffers success." << std::endl;
+    }
 
-        //start record command buffer
-        for(int i = 0 ; i < cmdBuffers.size() ;i++){
-            VkCommandBufferBeginInfo beginInfo = {};
-            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-            beginInfo.pInheritanceInfo = nullptr;
+    //声明本帧的帧图
+    void buildFrameGraph(uint32_t imageIndex){
+        renderGraph.reset(currentFrame);
+
+        RGImageDesc backbufferDesc;
+        backbufferDesc.format = swapChainImageFormat;
+        backbufferDesc.extent = swapChainExtent;
+        backbufferDesc.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+        //交换链图像 在 imageAvailable 信号量等待的阶段之后可用 内容不需要保留
+        RGResourceState acquiredState;
+        acquiredState.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        acquiredState.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        RGHandle backbuffer = renderGraph.importImage("backbuffer" , swapChainImages[imageIndex] , 
+            swapChainImageViews[imageIndex] , backbufferDesc , acquiredState);
+
+        //离屏图像不显示 没有开启交换链扩展时不能使用 PRESENT_SRC 布局
+        RGResourceState presentState;
+        presentState.layout = offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        presentState.stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        presentState.access = 0;
+        renderGraph.markOutput(backbuffer , presentState);
+
+        //深度内容不跨帧保留  只在渲染内使用 由帧图按飞行帧分配
+        //遮挡剔除时深度要被 Hi-Z 采样 使用常驻的 depthBuffer  需要等待上一帧对同一张深度图的写入
+        RGImageDesc depthDesc;
+        depthDesc.format = depthBuffer.format;
+        depthDesc.extent = swapChainExtent;
+        depthDesc.samples = depthBuffer.samples;
+        depthDesc.aspect = depthBuffer.aspect;
+
+        RGHandle depth = RG_INVALID_HANDLE;
+        if(depthBuffer.isCreated()){
+            RGResourceState depthState;
+            depthState.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            depthState.stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            depthState.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            depthState.write = true;
+            depth = renderGraph.importImage("depth" , depthBuffer.image , depthBuffer.view , depthDesc , depthState);
+        }else{
+            depthDesc.extraUsage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            depth = renderGraph.createImage("depth" , depthDesc);
+        }
+
+        //多重采样颜色同样不跨帧保留  在渲染结束时resolve到交换链图像
+        RGHandle msaa = RG_INVALID_HANDLE;
+        if(msaaSamples != VK_SAMPLE_COUNT_1_BIT){
+            RGImageDesc msaaDesc = backbufferDesc;
+            msaaDesc.samples = msaaSamples;
+            msaaDesc.extraUsage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            msaa = renderGraph.createImage("msaaColor" , msaaDesc);
+        }
+
+        //GPU驱动: 清零计数 -> 计算着色器剔除写入间接绘制命令 -> 主pass间接绘制
+        //只做视锥剔除时 清零与剔除只访问本飞行帧的绘制命令 放到异步计算队列 主pass在间接绘制阶段等待
+        //遮挡剔除要读取上一帧 phase 2 在图形队列写入的可见性 留在图形队列
+        //CPU剔除时命令在录制前直接写入 提交时主机写入自动可见
+        //遮挡剔除: 剔除 phase 1 -> 主pass -> 由深度生成 Hi-Z -> 剔除 phase 2 -> 第二次渲染补画新变为可见的物体
+        RGHandle drawCommands = RG_INVALID_HANDLE;
+        RGHandle objects = RG_INVALID_HANDLE;
+        const bool gpuDriven = gpuScene.count() > 0;
+        const bool occlusion = gpuDriven && gpuCulling && gpuScene.occlusionEnabled();
+        const FrustumPlanes frustum = viewFrustum();
+        float view[4] = {};
+        viewCamera(view[0] , view[1] , view[2]);
+        view[3] = depthBuffer.reverseZ ? 1.0f : 0.0f;
+        if(gpuDriven){
+            RGResourceState hostWritten;
+            drawCommands = renderGraph.importBuffer("drawCommands" , gpuScene.drawBuffer(currentFrame) ,
+                gpuScene.drawBufferSize(currentFrame) , hostWritten);
+
+            if(gpuCulling){
+                //上一次使用这一帧数据的剔除结果 fence 之后可读
+                gpuScene.readStats(currentFrame);
+                if(occlusion){
+                    reportOcclusionStats();
+                }
+                renderGraph.addPass("cullReset" , occlusion ? RG_PASS_TRANSFER : RG_PASS_ASYNC_COMPUTE)
+                    .write(drawCommands , RG_ACCESS_TRANSFER_DST)
+                    .setExecute([this](VkCommandBuffer cmd){
+                        gpuScene.recordReset(cmd , currentFrame);
+                    });
+                RGPass &cullPass = renderGraph.addPass("cull" , occlusion ? RG_PASS_COMPUTE : RG_PASS_ASYNC_COMPUTE)
+                    .read(drawCommands , RG_ACCESS_STORAGE_READ)
+                    .write(drawCommands , RG_ACCESS_STORAGE_WRITE);
+                if(occlusion){
+                    //可见性标记由上一帧的 phase 2 写入
+                    RGResourceState visibilityWritten;
+                    visibilityWritten.stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                    visibilityWritten.access = VK_ACCESS_SHADER_WRITE_BIT;
+                    visibilityWritten.write = true;
+                    objects = renderGraph.importBuffer("objects" , gpuScene.sceneBuffer() ,
+                        gpuScene.sceneBufferSize() , visibilityWritten);
+                    cullPass.read(objects , RG_ACCESS_STORAGE_READ);
+                }
+                cullPass.setExecute([this , frustum , view , occlusion](VkCommandBuffer cmd){
+                        gpuScene.recordCull(cmd , currentFrame , frustum , view , occlusion ? 1 : 0);
+                    });
+            }else{
+                gpuScene.cullOnCpu(currentFrame , frustum);
+                gpuScene.stats.visible = gpuScene.visibleCount(currentFrame);
+            }
+        }
+
+        //深度预处理与主绘制在同一次渲染内  深度一直留在片上 不需要写回
+        RGPass &mainPass = renderGraph.addPass("main" , RG_PASS_GRAPHICS)
+            .write(backbuffer , RG_ACCESS_COLOR_ATTACHMENT)
+            .write(depth , RG_ACCESS_DEPTH_ATTACHMENT);
+        if(msaa != RG_INVALID_HANDLE){
+            mainPass.write(msaa , RG_ACCESS_COLOR_ATTACHMENT);
+        }
+
+        //实例流在该帧的fence等待之后由CPU重写  提交时主机写入自动可见
+        const bool instancing = instanceRenderer.count() > 0;
+        if(instancing){
+            const uint64_t start = currentTimeNanos();
+            instanceRenderer.build(currentFrame);
+            instanceBuildNanos += currentTimeNanos() - start;
+
+            RGResourceState hostWritten;
+            RGHandle instances = renderGraph.importBuffer("instances" , instanceRenderer.buffer(currentFrame) ,
+                instanceRenderer.bufferSize(currentFrame) , hostWritten);
+            mainPass.read(instances , RG_ACCESS_VERTEX);
+        }
+        if(drawCommands != RG_INVALID_HANDLE){
+            mainPass.read(drawCommands , RG_ACCESS_INDIRECT);
+        }
+
+        mainPass.setExecute([this , imageIndex , instancing , gpuDriven , depth , msaa](VkCommandBuffer cmd){
+                beginMainRendering(cmd , imageIndex , mainTargets(depth , msaa));
+
+                if(instancing || gpuDriven){
+                    if(gpuDriven){
+                        drawGpuScene(cmd , 0);
+                    }else{
+                        drawInstances(cmd);
+                    }
+                    endMainRendering(cmd);
+                    return;
+                }
+
+                if(depthPrepassPipeline != VK_NULL_HANDLE){
+                    vkd.vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , depthPrepassPipeline);
+                    drawScene(cmd);
+                }
+
+                //bind graphic pipeline
+                vkd.vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS ,graphicsPipeline);
+                drawScene(cmd);
+
+                endMainRendering(cmd);
+            });
+
+        if(occlusion){
+            buildOcclusionPasses(backbuffer , depth , drawCommands , objects , frustum , view , imageIndex);
+        }
+
+        //帧转储: 最后一个写交换链图像的pass 之后复制到回读环  环已满时跳过 不等待
+        frameReadback.addPass(renderGraph , backbuffer , swapChainImages[imageIndex] , frameCounter , currentFrame);
+    }
+
+    //phase 1 的深度 -> Hi-Z -> phase 2 剔除 -> 保留颜色与深度 补画区域B
+    //第二次渲染读写同样的附件 使主pass不会被帧图剔除
+    void buildOcclusionPasses(RGHandle backbuffer , RGHandle depth , RGHandle drawCommands , RGHandle objects ,
+            const FrustumPlanes &frustum , const float view[4] , uint32_t imageIndex){
+        RGImageDesc hizDesc;
+        hizDesc.format = VK_FORMAT_R32_SFLOAT;
+        hizDesc.extent = hiz.extent;
+        hizDesc.mipLevels = hiz.mipLevels;
+        hizDesc.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+        //每帧完全重建 不需要保留内容  等待上一帧 phase 2 的读取
+        RGResourceState hizState;
+        hizState.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        hizState.stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        RGHandle hizImage = renderGraph.importImage("hiz" , hiz.image , hiz.view , hizDesc , hizState);
+
+        renderGraph.addPass("hiz" , RG_PASS_COMPUTE)
+            .read(depth , RG_ACCESS_SAMPLED)
+            .write(hizImage , RG_ACCESS_STORAGE_WRITE)
+            .setExecute([this](VkCommandBuffer cmd){
+                hiz.recordBuild(cmd);
+            });
+
+        float cullView[4];
+        std::memcpy(cullView , view , sizeof(cullView));
+        renderGraph.addPass("occlusionCull" , RG_PASS_COMPUTE)
+            .read(hizImage , RG_ACCESS_STORAGE_READ)
+            .read(objects , RG_ACCESS_STORAGE_READ)
+            .write(objects , RG_ACCESS_STORAGE_WRITE)
+            .read(drawCommands , RG_ACCESS_STORAGE_READ)
+            .write(drawCommands , RG_ACCESS_STORAGE_WRITE)
+            .setExecute([this , frustum , cullView](VkCommandBuffer cmd){
+                gpuScene.recordCull(cmd , currentFrame , frustum , cullView , 2);
+            });
+
+        renderGraph.addPass("occlusionMain" , RG_PASS_GRAPHICS)
+            .read(backbuffer , RG_ACCESS_COLOR_ATTACHMENT)
+            .write(backbuffer , RG_ACCESS_COLOR_ATTACHMENT)
+            .read(depth , RG_ACCESS_DEPTH_ATTACHMENT)
+            .write(depth , RG_ACCESS_DEPTH_ATTACHMENT)
+            .read(drawCommands , RG_ACCESS_INDIRECT)
+            .setExecute([this , imageIndex , depth](VkCommandBuffer cmd){
+                //遮挡剔除不支持 msaa
+                beginMainRendering(cmd , imageIndex , mainTargets(depth , RG_INVALID_HANDLE) , true);
+                drawGpuScene(cmd , 1);
+                endMainRendering(cmd);
+            });
+    }
+
+    //帧图 compile 之后 取本帧主渲染的附件
+    MainTargets mainTargets(RGHandle depth , RGHandle msaa){
+        MainTargets targets;
+        targets.frame = currentFrame;
+        targets.depth = renderGraph.imageView(depth);
+        targets.msaa = msaa != RG_INVALID_HANDLE ? renderGraph.imageView(msaa) : VK_NULL_HANDLE;
+        lastMainTargets = targets;
+        return targets;
+    }
+
+    //创建与销毁 type 类型对象时的 pAllocator  两者必须一致
+    const VkAllocationCallbacks *allocator(VkObjectType type) const{
+        return config.trackHostAllocations ? hostAllocator.callbacks(type) : nullptr;
+    }
+
+    //累计两次 drawFrame 之间驱动的主机内存分配  每 120 帧输出每帧的平均次数
+    //稳定运行时应为 0  不为 0 说明驱动在提交或呈现时分配内存
+    void reportHostAllocations(){
+        if(!config.trackHostAllocations || !config.allocationReport){
+            return;
+        }
+        const HostAllocationSnapshot now = hostAllocator.snapshot();
+        for(uint32_t scope = 0 ; scope < HOST_SCOPE_COUNT ; scope++){
+            frameHostAllocations.allocations[scope] += now.allocations[scope] - lastHostSnapshot.allocations[scope];
+        }//end for scope
+        lastHostSnapshot = now;
+
+        if(frameCounter % 120 != 0 || frameCounter == 0){
+            return;
+        }
+        std::cout << "host allocations per frame : " << frameHostAllocations.total() / 120.0
+            << " command : " << frameHostAllocations.allocations[VK_SYSTEM_ALLOCATION_SCOPE_COMMAND] / 120.0
+            << " object : " << frameHostAllocations.allocations[VK_SYSTEM_ALLOCATION_SCOPE_OBJECT] / 120.0 << std::endl;
+        frameHostAllocations = HostAllocationSnapshot();
+    }
+
+    //每 120 帧输出一次 上一次完成的帧分配的描述符集与用到的池
+    void reportDescriptorStats(){
+        if(frameCounter % 120 != 0 || frameDescriptors.poolCount() == 0){
+            return;
+        }
+        const DescriptorAllocatorStats &stats = frameDescriptors.stats();
+        std::cout << "frame descriptors sets : " << stats.sets
+            << " pools : " << stats.pools
+            << " pools created : " << stats.poolsCreated
+            << " cached layouts : " << layoutCache.size() << std::endl;
+    }
+
+    //每 120 帧输出一次遮挡剔除的结果
+    void reportOcclusionStats(){
+        if(frameCounter % 120 != 0){
+            return;
+        }
+        const CullStats &stats = gpuScene.stats;
+        const uint32_t culled = stats.frustumCulled + stats.occluded;
+        std::cout << "occlusion culling objects : " << stats.objects
+            << " frustum culled : " << stats.frustumCulled
+            << " occluded : " << stats.occluded
+            << " visible : " << stats.visible
+            << " culled ratio : " << (stats.objects > 0 ? 100.0 * culled / stats.objects : 0.0) << "%" << std::endl;
+    }
+
+    //绘制场景  overdrawLayers 层三角形由远到近叠加 (对early-Z 最不利的顺序)
+    //每层的参数经 perDraw 提交 录制期间不分配描述符集
+    void drawScene(VkCommandBuffer cmd){
+        const uint32_t layers = std::max(config.overdrawLayers , 1u);
+        perDraw.bindFrame(cmd);
+        //uniform 路径下 片元着色器的参数仍来自 push constant 整个场景只需写一次
+        if(sceneStrategy == PER_DRAW_DYNAMIC_UNIFORM){
+            DrawParams params = {};
+            params.shadingIterations = config.shadingIterations;
+            vkd.vkCmdPushConstants(cmd , perDraw.pipelineLayout , VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ,
+                0 , sizeof(DrawParams) , &params);
+        }
+
+        //网格模式 每层一次实例化绘制  三角形的位置由 triangle.vert 按实例序号计算
+        const bool grid = config.gridTriangles > 0;
+        float gridScale = 1.0f;
+        uint32_t gridColumns = 0;
+        if(grid){
+            triangleGridLayout(gridScale , gridColumns);
+        }
+
+        uint8_t payload[512] = {};
+        const uint32_t payloadBytes = std::min<uint32_t>(scenePayloadBytes , sizeof(payload));
+        for(uint32_t i = 0 ; i < layers ; i++){
+            const float t = layers > 1 ? static_cast<float>(i) / (layers - 1) : 0.0f;
+
+            DrawParams params = {};
+            params.offsetDepth[0] = layers > 1 && !grid ? 0.1f * t - 0.05f : 0.0f;
+            params.offsetDepth[1] = layers > 1 && !grid ? 0.05f - 0.1f * t : 0.0f;
+            params.offsetDepth[2] = depthBuffer.depthValue(layers > 1 ? 0.9f - 0.8f * t : 0.5f);
+            params.offsetDepth[3] = grid ? gridScale : (layers > 1 ? 2.0f : 1.0f);
+            params.shadingIterations = config.shadingIterations;
+            params.gridColumns = gridColumns;
+
+            std::memcpy(payload , &params , sizeof(DrawParams));
+            perDraw.write(cmd , payload , payloadBytes , sceneStrategy);
+            vkd.vkCmdDraw(cmd , 3 , grid ? config.gridTriangles : 1 , 0 , 0);
+        }//end for i
+    }
+
+    //网格模式下三角形的缩放与列数
+    //缩放为 1 时三角形在 NDC 中宽高都是 1  像素面积 = 宽 * 高 * scale^2 / 8
+    //列间距 (2 / columns) 不小于三角形的宽度 三角形之间不重叠  格子数为 columns * columns
+    void triangleGridLayout(float &scale , uint32_t &columns) const{
+        const float screenPixels = static_cast<float>(swapChainExtent.width) * swapChainExtent.height;
+        scale = std::sqrt(8.0f * std::max(config.triangleArea , 0.5f) / screenPixels);
+        columns = std::max(1u , static_cast<uint32_t>(2.0f / scale));
+    }
+
+    //实例化绘制  每个 (材质 , 网格) 分组一次 vkCmdDraw
+    void drawInstances(VkCommandBuffer cmd){
+        DrawParams params = {};
+        params.offsetDepth[3] = 1.0f;
+        params.shadingIterations = config.shadingIterations;
+        vkd.vkCmdPushConstants(cmd , pipelineLayout , VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ,
+            0 , sizeof(DrawParams) , &params);
+        if(bindless.isCreated()){
+            bindless.bind(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , pipelineLayout);
+        }
+
+        //深度预处理与主pass 的批次进入同一个队列 由排序键的 pass 字段分开
+        instanceQueue.clear();
+        instanceQueueResources.pipelines = instancedPipelines;
+        instanceQueueResources.vertexInputs.assign(1 , instanceRenderer.vertexInput(currentFrame));
+        if(instancedDepthPipeline != VK_NULL_HANDLE){
+            instanceQueueResources.pipelines.push_back(instancedDepthPipeline);
+            instanceRenderer.enqueue(instanceQueue , QUEUE_PASS_DEPTH_PREPASS ,
+                static_cast<int32_t>(instanceQueueResources.pipelines.size() - 1) , 0);
+        }
+        instanceRenderer.enqueue(instanceQueue , QUEUE_PASS_OPAQUE , -1 , 0);
+        instanceQueue.sort();
+        instanceQueue.record(cmd , &vkd , instanceQueueResources);
+    }
+
+    //GPU驱动的绘制  每个材质一次间接绘制 录制开销与物体数无关
+    //region 为遮挡剔除的命令区域 0: phase 1  1: phase 2 新变为可见的物体
+    void drawGpuScene(VkCommandBuffer cmd , uint32_t region){
+        DrawParams params = {};
+        viewCamera(params.offsetDepth[0] , params.offsetDepth[1] , params.offsetDepth[3]);
+        params.shadingIterations = config.shadingIterations;
+        vkd.vkCmdPushConstants(cmd , pipelineLayout , VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ,
+            0 , sizeof(DrawParams) , &params);
+        if(bindless.isCreated()){
+            bindless.bind(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , pipelineLayout);
+        }
+
+        if(instancedDepthPipeline != VK_NULL_HANDLE){
+            gpuScene.recordDraw(cmd , currentFrame , gpuCulling , instancedPipelines , instancedDepthPipeline , region);
+        }
+        gpuScene.recordDraw(cmd , currentFrame , gpuCulling , instancedPipelines , VK_NULL_HANDLE , region);
+    }
+
+    //剔除时的相机  在世界中来回平移 (与 instanced.vert 的变换一致: (p + offset) * zoom)
+    void viewCamera(float &offsetX , float &offsetY , float &zoom) const{
+        offsetX = 2.5f * std::sin(frameCounter * 0.005f);
+        offsetY = 2.5f * std::cos(frameCounter * 0.003f);
+        zoom = 1.0f;
+    }
+
+    //相机可见范围 世界坐标 x 在 [-1/zoom - offsetX , 1/zoom - offsetX] 之间  深度在 [0 , 1] 之间
+    FrustumPlanes viewFrustum() const{
+        float offsetX , offsetY , zoom;
+        viewCamera(offsetX , offsetY , zoom);
+        const float halfSize = 1.0f / zoom;
+
+        FrustumPlanes frustum = {{
+            {1.0f , 0.0f , 0.0f , halfSize + offsetX},
+            {-1.0f , 0.0f , 0.0f , halfSize - offsetX},
+            {0.0f , 1.0f , 0.0f , halfSize + offsetY},
+            {0.0f , -1.0f , 0.0f , halfSize - offsetY},
+            {0.0f , 0.0f , 1.0f , 0.0f},
+            {0.0f , 0.0f , -1.0f , 1.0f}
+        }};
+        return frustum;
+    }
+
+    //剔除需要间接绘制命令中的 firstInstance 指向物体
+    void chooseCulling(){
+        CPU_TRACE_FUNCTION();
+        gpuCulling = false;
+        if(config.culling == "off"){
+            return;
+        }
+        if(deviceFeatures.enabledCore.drawIndirectFirstInstance != VK_TRUE){
+            std::cout << "drawIndirectFirstInstance not supported , culling off" << std::endl;
+            config.culling = "off";
+            return;
+        }
+        if(config.culling == "gpu" && !gpuScene.gpuCullingAvailable()){
+            std::cout << "drawIndirectCount not supported , fall back to cpu culling" << std::endl;
+            config.culling = "cpu";
+        }
+        gpuCulling = config.culling == "gpu";
+        std::cout << "culling : " << config.culling << std::endl;
+    }
+
+    //遮挡剔除的各项前提  决定深度是否需要保存并采样 因此在创建渲染目标之前调用
+    void chooseOcclusion(){
+        CPU_TRACE_FUNCTION();
+        occlusionCulling = false;
+        if(!config.occlusion){
+            return;
+        }
+        if(config.culling != "gpu" || !deviceFeatures.has(CAP_DRAW_INDIRECT_COUNT)
+            || deviceFeatures.enabledCore.drawIndirectFirstInstance != VK_TRUE){
+            std::cout << "occlusion culling needs --culling=gpu with drawIndirectCount , occlusion off" << std::endl;
+            return;
+        }
+        if(config.msaaSamples > 1){
+            std::cout << "occlusion culling does not support msaa , occlusion off" << std::endl;
+            return;
+        }
+        occlusionCulling = true;
+        std::cout << "occlusion culling : hi-z two phase" << std::endl;
+    }
+
+    //生成 count 个物体  网格与材质交错添加 由 InstanceRenderer 自动分组
+    //开启剔除时交给 GpuDrivenScene  物体分布在 8x8 的世界中 相机只看到其中 2x2
+    void populateInstances(uint32_t count){
+        CPU_TRACE_FUNCTION();
+        instanceRenderer.clear();
+        gpuScene.clear();
+        const bool culling = config.culling != "off";
+        if(count == 0){
+            gpuScene.upload();
+            return;
+        }
+        if(gpuScene.occlusionEnabled()){
+            populateOccludedScene(count);
+            return;
+        }
+
+        uint32_t side = 1;
+        while(side * side < count){
+            side++;
+        }
+        const float extent = culling ? 4.0f : 1.0f;
+        const float cell = 2.0f * extent / side;
+        const uint32_t materialCount = static_cast<uint32_t>(instancedPipelines.size());
+
+        for(uint32_t i = 0 ; i < count ; i++){
+            uint32_t hash = i * 2654435761u;
+            hash ^= hash >> 16;
+
+            InstanceData data = {};
+            data.transform[0] = -extent + cell * (i % side + 0.5f);
+            data.transform[1] = -extent + cell * (i / side + 0.5f);
+            data.transform[2] = depthBuffer.depthValue(static_cast<float>(i) / count);
+            data.transform[3] = cell * 0.8f;
+            data.color = hash | 0xFF000000u;
+            data.custom[0] = (hash & 0xFFFF) / 65535.0f * 6.2831853f;
+            const uint32_t material = (i / 2) % materialCount;
+            data.custom[1] = material == MATERIAL_BINDLESS ? bindlessInstanceHandle(hash) : 0.0f;
+            if(culling){
+                //内置网格的顶点到中心距离不超过 0.71
+                gpuScene.add(i % 2 , material , data , data.transform[3] * 0.71f);
+            }else{
+                instanceRenderer.add(i % 2 , material , data);
+            }
+        }//end for i
+
+        if(culling){
+            gpuScene.upload();
+        }
+    }
+
+    //遮挡剔除的场景  每个格子 1 个靠近相机 铺满格子的四边形遮挡物 与 3 个在它后面的小物体
+    void populateOccludedScene(uint32_t count){
+        const uint32_t cells = (count + 3) / 4;
+        uint32_t side = 1;
+        while(side * side < cells){
+            side++;
+        }
+        const float extent = 4.0f;
+        const float cell = 2.0f * extent / side;
+
+        for(uint32_t i = 0 ; i < count ; i++){
+            uint32_t hash = i * 2654435761u;
+            hash ^= hash >> 16;
+            const uint32_t index = i / 4;
+            const uint32_t layer = i % 4;
+
+            InstanceData data = {};
+            data.transform[0] = -extent + cell * (index % side + 0.5f);
+            data.transform[1] = -extent + cell * (index / side + 0.5f);
+            data.color = hash | 0xFF000000u;
+            if(layer == 0){
+                data.transform[2] = depthBuffer.depthValue(0.1f);
+                data.transform[3] = cell;
+                gpuScene.add(1 , 0 , data , data.transform[3] * 0.71f);
+                continue;
+            }
+
+            //包围球不超出遮挡物  偏移 0.2 + 半径 0.4 * 0.71 < 0.5
+            data.transform[0] += cell * ((hash & 0xFF) / 255.0f - 0.5f) * 0.4f;
+            data.transform[1] += cell * (((hash >> 8) & 0xFF) / 255.0f - 0.5f) * 0.4f;
+            data.transform[2] = depthBuffer.depthValue(0.3f + 0.2f * layer);
+            data.transform[3] = cell * 0.4f;
+            data.custom[0] = (hash & 0xFFFF) / 65535.0f * 6.2831853f;
+            gpuScene.add(layer % 2 , (layer / 2) % 2 , data , data.transform[3] * 0.71f);
+        }//end for i
+
+        gpuScene.upload();
+    }
+
+    //纹理与材质句柄打包进实例的 custom[1]  各12位 (容量不超过4096) 以浮点存储是精确的
+    float bindlessInstanceHandle(uint32_t hash) const{
+        if(textureHandles.empty()){
+            return 0.0f;
+        }
+        const uint32_t texture = textureHandles[hash % textureHandles.size()];
+        const uint32_t material = materialHandles[(hash >> 8) % materialHandles.size()];
+        return static_cast<float>(texture | (material << 12));
+    }
+
+    //bindless 使用的纹理与材质参数  全部注册到同一个描述符集
+    void createBindlessResources(){
+        CPU_TRACE_FUNCTION();
+        if(!bindless.isCreated()){
+            return;
+        }
+
+        VkSamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerCreateInfo.magFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.minFilter = VK_FILTER_NEAREST;
+        samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerCreateInfo.maxLod = 0.0f;
+        if(vkCreateSampler(device , &samplerCreateInfo , allocator(VK_OBJECT_TYPE_SAMPLER) , &bindlessSampler) != VK_SUCCESS){
+            throw std::runtime_error("failed to create bindless sampler!");
+        }
+
+        //棋盘格纹理 格子大小与颜色各不相同
+        const uint32_t textureCount = 8;
+        const uint32_t size = 64;
+        std::vector<uint32_t> pixels(size * size);
+        bindlessTextures.resize(textureCount);
+        for(uint32_t t = 0 ; t < textureCount ; t++){
+            const uint32_t checker = 4u << (t % 4);
+            const uint32_t color = (t * 2654435761u) | 0xFF000000u;
+            for(uint32_t y = 0 ; y < size ; y++){
+                for(uint32_t x = 0 ; x < size ; x++){
+                    pixels[y * size + x] = ((x / checker + y / checker) % 2) != 0 ? color : 0xFFFFFFFFu;
+                }//end for x
+            }//end for y
+            bindlessTextures[t].create(device , physicalDevice , &vkd , cmdPool , graphicsQueue , size , size , pixels.data());
+            textureHandles.push_back(bindless.registerTexture(bindlessTextures[t].view , bindlessSampler));
+        }//end for t
+
+        //材质参数 每个材质一段 按 storage buffer 偏移对齐
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice , &properties);
+        const uint32_t materialCount = 8;
+        const VkDeviceSize stride = alignUp(sizeof(float) * 4 ,
+            std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment , 16));
+
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = stride * materialCount;
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if(vkCreateBuffer(device , &bufferCreateInfo , allocator(VK_OBJECT_TYPE_BUFFER) , &materialBuffer) != VK_SUCCESS){
+            throw std::runtime_error("failed to create material buffer!");
+        }
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device , materialBuffer , &requirements);
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = findMemoryType(memoryProperties , requirements.memoryTypeBits ,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if(vkAllocateMemory(device , &allocateInfo , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY) , &materialMemory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate material buffer memory!");
+        }
+        vkBindBufferMemory(device , materialBuffer , materialMemory , 0);
+
+        void *mapped = nullptr;
+        vkMapMemory(device , materialMemory , 0 , VK_WHOLE_SIZE , 0 , &mapped);
+        for(uint32_t m = 0 ; m < materialCount ; m++){
+            float *tint = reinterpret_cast<float *>(static_cast<char *>(mapped) + stride * m);
+            tint[0] = 0.5f + 0.5f * ((m >> 0) & 1);
+            tint[1] = 0.5f + 0.5f * ((m >> 1) & 1);
+            tint[2] = 0.5f + 0.5f * ((m >> 2) & 1);
+            tint[3] = 1.0f;
+            materialHandles.push_back(bindless.registerBuffer(materialBuffer , stride * m , sizeof(float) * 4));
+        }//end for m
+        vkUnmapMemory(device , materialMemory);
+
+        std::cout << "bindless textures : " << bindless.textureCount()
+            << " buffers : " << bindless.bufferCount() << std::endl;
+    }
+
+    void destroyBindlessResources(){
+        for(Texture2D &texture : bindlessTextures){
+            texture.destroy();
+        }//end for each
+        bindlessTextures.clear();
+        textureHandles.clear();
+        materialHandles.clear();
+        vkDestroySampler(device , bindlessSampler , allocator(VK_OBJECT_TYPE_SAMPLER));
+        vkDestroyBuffer(device , materialBuffer , allocator(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(device , materialMemory , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        bindlessSampler = VK_NULL_HANDLE;
+        materialBuffer = VK_NULL_HANDLE;
+        materialMemory = VK_NULL_HANDLE;
+        bindless.destroy();
+    }
+
+    //录制一帧的绘制指令  帧图负责布局转换与屏障
+    RGExecuteResult recordCommandBuffer(VkCommandBuffer cmd , VkCommandBuffer asyncCmd , uint32_t imageIndex){
+        CPU_TRACE_FUNCTION();
+        const uint64_t start = currentTimeNanos();
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = nullptr;
 
-            if(vkBeginCommandBuffer(cmdBuffers[i] , &beginInfo) != VK_SUCCESS){
-                throw std::runtime_error("failed to begin command buffer");
+        if(vkd.vkBeginCommandBuffer(cmd , &beginInfo) != VK_SUCCESS){
+            throw std::runtime_error("failed to begin command buffer");
+        }
+        if(asyncCmd != VK_NULL_HANDLE && vkd.vkBeginCommandBuffer(asyncCmd , &beginInfo) != VK_SUCCESS){
+            throw std::runtime_error("failed to begin async command buffer");
+        }
+        gpuProfiler.beginFrame(currentFrame , cmd);
+
+        {
+            CPU_TRACE_SCOPE("build frame graph");
+            buildFrameGraph(imageIndex);
+            renderGraph.compile();
+        }
+        RGExecuteResult result;
+        {
+            CPU_TRACE_SCOPE("execute frame graph");
+            result = renderGraph.execute(cmd , asyncCmd);
+        }
+        gpuProfiler.endFrame(cmd);
+
+        if(vkd.vkEndCommandBuffer(cmd) != VK_SUCCESS){
+            throw std::runtime_error("failed to recoder render pass !");
+        }
+        if(asyncCmd != VK_NULL_HANDLE && vkd.vkEndCommandBuffer(asyncCmd) != VK_SUCCESS){
+            throw std::runtime_error("failed to record async command buffer !");
+        }
+
+        recordNanos += currentTimeNanos() - start;
+        return result;
+    }
+
+    //load 为 true 时保留已有的颜色与深度 (遮挡剔除的第二次渲染)
+    void beginMainRendering(VkCommandBuffer cmd , uint32_t imageIndex , const MainTargets &targets , bool load = false){
+        const VkAttachmentLoadOp loadOp = load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+        VkClearValue clearValues[2] = {};
+        clearValues[0].color = {1.0f , 1.0f, 1.0 , 1.0f};
+        clearValues[1].depthStencil = {depthBuffer.clearDepth() , 0};
+
+        if(useDynamicRendering){
+            VkRenderingAttachmentInfoKHR colorAttachment = {};
+            colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+            colorAttachment.imageView = swapChainImageViews[imageIndex];
+            colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorAttachment.resolveMode = VK_RESOLVE_MODE_NONE;
+            colorAttachment.loadOp = loadOp;
+            colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.clearValue = clearValues[0];
+            if(targets.msaa != VK_NULL_HANDLE){
+                //多重采样数据在渲染结束时resolve 本身不写回
+                colorAttachment.imageView = targets.msaa;
+                colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                colorAttachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+                colorAttachment.resolveImageView = swapChainImageViews[imageIndex];
+                colorAttachment.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
             }
 
+            VkRenderingAttachmentInfoKHR depthAttachment = {};
+            depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+            depthAttachment.imageView = targets.depth;
+            depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            depthAttachment.resolveMode = VK_RESOLVE_MODE_NONE;
+            depthAttachment.loadOp = loadOp;
+            depthAttachment.storeOp = occlusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.clearValue = clearValues[1];
+
+            VkRenderingInfoKHR renderingInfo = {};
+            renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+            renderingInfo.renderArea.offset = {0 , 0};
+            renderingInfo.renderArea.extent = swapChainExtent;
+            renderingInfo.layerCount = 1;
+            renderingInfo.colorAttachmentCount = 1;
+            renderingInfo.pColorAttachments = &colorAttachment;
+            renderingInfo.pDepthAttachment = &depthAttachment;
+            renderingInfo.pStencilAttachment = DepthBuffer::hasStencil(depthBuffer.format) ? &depthAttachment : nullptr;
+
+            vkd.vkCmdBeginRenderingKHR(cmd , &renderingInfo);
+        }else{
             VkRenderPassBeginInfo renderPassInfo = {};
             renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass = renderPass;
-            renderPassInfo.framebuffer = swapChainFramebuffers[i];
+            renderPassInfo.renderPass = load ? renderPassLoad : renderPass;
+            renderPassInfo.framebuffer = frameFramebuffer(imageIndex , targets);
 
             renderPassInfo.renderArea.offset = {0 , 0};
             renderPassInfo.renderArea.extent = swapChainExtent;
 
-            VkClearValue clearColor = {1.0f , 1.0f, 1.0 , 1.0f};
-            renderPassInfo.clearValueCount = 1;
-            renderPassInfo.pClearValues = &clearColor;
+            renderPassInfo.clearValueCount = 2;
+            renderPassInfo.pClearValues = clearValues;
 
-            vkCmdBeginRenderPass(cmdBuffers[i] , &renderPassInfo , VK_SUBPASS_CONTENTS_INLINE);
+            vkd.vkCmdBeginRenderPass(cmd , &renderPassInfo , VK_SUBPASS_CONTENTS_INLINE);
+        }
+    }
 
-            //bind graphic pipeline
-            vkCmdBindPipeline(cmdBuffers[i] , VK_PIPELINE_BIND_POINT_GRAPHICS ,graphicsPipeline);
-            vkCmdDraw(cmdBuffers[i] , 3 , 1 , 0 , 0);
+    void endMainRendering(VkCommandBuffer cmd){
+        if(useDynamicRendering){
+            vkd.vkCmdEndRenderingKHR(cmd);
+        }else{
+            vkd.vkCmdEndRenderPass(cmd);
+        }
+    }
 
-            vkCmdEndRenderPass(cmdBuffers[i]);
+    //颜色与深度附件都支持的采样数
+    VkSampleCountFlags supportedSampleCounts(){
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice , &properties);
+        return properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+    }
 
-            if(vkEndCommandBuffer(cmdBuffers[i]) != VK_SUCCESS){
-                throw std::runtime_error("failed to recoder render pass !");
+    //不超过请求值的最大支持采样数
+    VkSampleCountFlagBits chooseSampleCount(uint32_t requested){
+        const VkSampleCountFlags supported = supportedSampleCounts();
+        uint32_t samples = 1;
+        for(uint32_t count = 2 ; count <= 64 && count <= requested ; count <<= 1){
+            if(supported & count){
+                samples = count;
             }
-        }//end for i
+        }//end for count
+        if(samples != requested){
+            std::cout << "msaa " << requested << "x not supported , use " << samples << "x" << std::endl;
+        }
+        return static_cast<VkSampleCountFlagBits>(samples);
+    }
+
+    //深度与多重采样颜色附件
+    //只在渲染内使用的深度与多重采样颜色由帧图分配 这里只确定格式与采样数
+    //遮挡剔除时深度要保存并采样 创建常驻的深度图与 Hi-Z
+    void createRenderTargets(){
+        CPU_TRACE_FUNCTION();
+        msaaSamples = chooseSampleCount(std::max(config.msaaSamples , 1u));
+        if(occlusionCulling){
+            depthBuffer.create(device , physicalDevice , swapChainExtent , msaaSamples , config.reverseZ , true);
+            hiz.create(device , physicalDevice , &vkd , swapChainExtent , depthBuffer.sampledView , config.reverseZ ,
+                shaderLibrary.get("shaders/hiz.spv"));
+            gpuScene.setHiZ(hiz.view , hiz.sampler);
+        }else{
+            depthBuffer.configure(physicalDevice , msaaSamples , config.reverseZ);
+        }
+        std::cout << "render targets depth format : " << depthBuffer.format
+            << " samples : " << msaaSamples
+            << (depthBuffer.isCreated() ? " (persistent depth)" : " (frame graph transients)") << std::endl;
+    }
+
+    void destroyRenderTargets(){
+        hiz.destroy();
+        depthBuffer.destroy();
+        lastMainTargets = MainTargets();
+    }
+
+    //采样数变化时 附件/renderPass/framebuffer/管线 都要重建
+    void recreateRenderTargets(){
+        vkDeviceWaitIdle(device);
+        destroyRenderPathObjects();
+        destroyRenderTargets();
+
+        createRenderTargets();
+        if(!useDynamicRendering){
+            createRenderPass();
+        }
+        createGraphicsPipeline();
+        if(!useDynamicRendering){
+            createFramebuffers();
+        }
+    }
+
+    //场景参数 (采样数 剔除 物体数) 变化后调用  遮挡剔除与 msaa 互斥 决定深度是否常驻
+    //因此先重新确定剔除方式 再重建渲染目标  开关遮挡剔除后物体要重新上传
+    void applyRenderConfig(){
+        chooseCulling();
+        chooseOcclusion();
+        recreateRenderTargets();
+        gpuScene.enableOcclusion(occlusionCulling && gpuCulling);
+        populateInstances(config.instanceCount);
+    }
 
+    //选择渲染路径  dynamic rendering 省去 renderPass 与每个交换链图像一个的 framebuffer
+    void chooseRenderPath(){
+        CPU_TRACE_FUNCTION();
+        const bool supported = deviceFeatures.has(CAP_DYNAMIC_RENDERING) && vkd.vkCmdBeginRenderingKHR != nullptr;
+        if(config.renderPath == "legacy"){
+            useDynamicRendering = false;
+        }else if(config.renderPath == "dynamic"){
+            if(!supported){
+                throw std::runtime_error("dynamic rendering requested but not supported!");
+            }
+            useDynamicRendering = true;
+        }else{
+            useDynamicRendering = supported;
+        }
+        std::cout << "render path : " << (useDynamicRendering ? "dynamic rendering" : "render pass") << std::endl;
     }
 
     //创建指令池  池的目的是为了以后分配指令
     void createCommandPool(){
+        CPU_TRACE_FUNCTION();
         QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
 
         VkCommandPoolCreateInfo cmdPoolCreateInfo = {};
         cmdPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         cmdPoolCreateInfo.queueFamilyIndex = queueFamilyIndices.graphicsIndex;
-        cmdPoolCreateInfo.flags = 0;
+        cmdPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        if(vkCreateCommandPool(device , &cmdPoolCreateInfo , nullptr , &cmdPool) != VK_SUCCESS){
+        if(vkCreateCommandPool(device , &cmdPoolCreateInfo , allocator(VK_OBJECT_TYPE_COMMAND_POOL) , &cmdPool) != VK_SUCCESS){
             throw std::runtime_error("failed create command pool !");
         }
 
+        if(computeQueue != VK_NULL_HANDLE){
+            cmdPoolCreateInfo.queueFamilyIndex = queueFamilyIndices.computeIndex;
+            if(vkCreateCommandPool(device , &cmdPoolCreateInfo , allocator(VK_OBJECT_TYPE_COMMAND_POOL) , &computeCmdPool) != VK_SUCCESS){
+                throw std::runtime_error("failed create compute command pool !");
+            }
+        }
+
         std::cout << "create command pool success" << std::endl;
     }
 
     //创建与swapchain 关联的framebuffer
+    //附件来自帧图 每个 (飞行帧 , 交换链图像) 一个  第一次使用时创建 (frameFramebuffer)
+    //已经记录过附件的 (例如 renderpath 基准测试的重建) 在这里重新创建
     void createFramebuffers(){
-        swapChainFramebuffers.resize(swapChainImageViews.size());
-
-        for(int i = 0; i < swapChainFramebuffers.size(); i++){
-            const VkImageView attachments[] = {swapChainImageViews[i]};
-
-            VkFramebufferCreateInfo framebufferCreateInfo = {};
-            framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferCreateInfo.renderPass = renderPass;
-            framebufferCreateInfo.attachmentCount = 1;
-            framebufferCreateInfo.pAttachments = attachments;
-            framebufferCreateInfo.width = swapChainExtent.width;
-            framebufferCreateInfo.height = swapChainExtent.height;
-            framebufferCreateInfo.layers = 1;
-
-            if(vkCreateFramebuffer(device , &framebufferCreateInfo , nullptr , 
-                &swapChainFramebuffers[i]) != VK_SUCCESS){
-                throw std::runtime_error("failed create framebuffer!");
+        CPU_TRACE_FUNCTION();
+        swapChainFramebuffers.resize(MAX_FRAMES_IN_FLIGHT * swapChainImageViews.size());
+
+        uint32_t count = 0;
+        for(CachedFramebuffer &cached : swapChainFramebuffers){
+            if(cached.attachments.empty()){
+                continue;
             }
-        }//end for i
+            if(cached.framebuffer != VK_NULL_HANDLE){
+                vkDestroyFramebuffer(device , cached.framebuffer , allocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+            }
+            cached.framebuffer = createFramebuffer(cached.attachments);
+            count++;
+        }//end for each
+
+        std::cout << "create frame buffer success count = " << count << std::endl;
+    }
+
+    VkFramebuffer createFramebuffer(const std::vector<VkImageView> &attachments){
+        VkFramebufferCreateInfo framebufferCreateInfo = {};
+        framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferCreateInfo.renderPass = renderPass;
+        framebufferCreateInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferCreateInfo.pAttachments = attachments.data();
+        framebufferCreateInfo.width = swapChainExtent.width;
+        framebufferCreateInfo.height = swapChainExtent.height;
+        framebufferCreateInfo.layers = 1;
+
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        if(vkCreateFramebuffer(device , &framebufferCreateInfo , allocator(VK_OBJECT_TYPE_FRAMEBUFFER) , 
+            &framebuffer) != VK_SUCCESS){
+            throw std::runtime_error("failed create framebuffer!");
+        }
+        return framebuffer;
+    }
 
-        std::cout << "create frame buffer success count = " <<swapChainFramebuffers.size() << std::endl;
+    //该飞行帧渲染到 imageIndex 的 framebuffer  附件变化 (帧图重建了临时图像) 时重建
+    VkFramebuffer frameFramebuffer(uint32_t imageIndex , const MainTargets &targets){
+        //与 createRenderPass 的附件顺序一致
+        std::vector<VkImageView> attachments = {swapChainImageViews[imageIndex] , targets.depth};
+        if(targets.msaa != VK_NULL_HANDLE){
+            attachments = {targets.msaa , targets.depth , swapChainImageViews[imageIndex]};
+        }
+
+        CachedFramebuffer &cached = swapChainFramebuffers[targets.frame * swapChainImageViews.size() + imageIndex];
+        if(cached.framebuffer != VK_NULL_HANDLE && cached.attachments == attachments){
+            return cached.framebuffer;
+        }
+        if(cached.framebuffer != VK_NULL_HANDLE){
+            vkDestroyFramebuffer(device , cached.framebuffer , allocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+        }
+        cached.attachments = attachments;
+        cached.framebuffer = createFramebuffer(attachments);
+        return cached.framebuffer;
     }
     
     //创建渲染帧缓冲附着对象
     void createRenderPass(){
+        CPU_TRACE_FUNCTION();
+        //多重采样时 颜色附件0 为多重采样图像 只在片上使用 在subpass结束时resolve到交换链图像(附件2)
+        const bool multisampled = msaaSamples != VK_SAMPLE_COUNT_1_BIT;
         VkAttachmentDescription colorAttachment = {};
         colorAttachment.format = swapChainImageFormat;
-        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.samples = msaaSamples;
         colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
 
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        //布局转换由帧图在render pass之外完成
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        //深度只在本次渲染内使用 不写回  遮挡剔除时要由它生成 Hi-Z
+        VkAttachmentDescription depthAttachment = {};
+        depthAttachment.format = depthBuffer.format;
+        depthAttachment.samples = depthBuffer.samples;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = occlusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
         colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+        VkAttachmentReference depthAttachmentRef = {};
+        depthAttachmentRef.attachment = 1;
+        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentDescription resolveAttachment = {};
+        resolveAttachment.format = swapChainImageFormat;
+        resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        resolveAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference resolveAttachmentRef = {};
+        resolveAttachmentRef.attachment = 2;
+        resolveAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
         VkSubpassDescription subpass = {};
         subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
         subpass.colorAttachmentCount = 1;
         subpass.pColorAttachments = &colorAttachmentRef;
+        subpass.pDepthStencilAttachment = &depthAttachmentRef;
+        subpass.pResolveAttachments = multisampled ? &resolveAttachmentRef : nullptr;
+
+        VkAttachmentDescription attachments[] = {colorAttachment , depthAttachment , resolveAttachment};
 
         VkRenderPassCreateInfo renderPassCreateInfo = {};
         renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassCreateInfo.attachmentCount = 1;
-        renderPassCreateInfo.pAttachments = &colorAttachment;
+        renderPassCreateInfo.attachmentCount = multisampled ? 3 : 2;
+        renderPassCreateInfo.pAttachments = attachments;
         renderPassCreateInfo.subpassCount = 1;
         renderPassCreateInfo.pSubpasses = &subpass;
 
-        VkSubpassDependency dependency = {};
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.dstSubpass = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.srcAccessMask = 0;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        //与外部的同步由帧图的屏障完成
+        renderPassCreateInfo.dependencyCount = 0;
+        renderPassCreateInfo.pDependencies = nullptr;
 
-        renderPassCreateInfo.dependencyCount = 1;
-        renderPassCreateInfo.pDependencies = &dependency;
-
-        if(vkCreateRenderPass(device , &renderPassCreateInfo , nullptr , &renderPass) != VK_SUCCESS){
+        if(vkCreateRenderPass(device , &renderPassCreateInfo , allocator(VK_OBJECT_TYPE_RENDER_PASS) , &renderPass) != VK_SUCCESS){
             throw std::runtime_error("failed to create render pass");
         }
 
+        //只有 loadOp 不同 与 renderPass 兼容 共用 framebuffer 与管线
+        if(occlusionCulling){
+            attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            if(vkCreateRenderPass(device , &renderPassCreateInfo , allocator(VK_OBJECT_TYPE_RENDER_PASS) , &renderPassLoad) != VK_SUCCESS){
+                throw std::runtime_error("failed to create load render pass");
+            }
+        }
+
         std::cout << "create render pass success." << std::endl;
     }
 
-    //创建图形管线
+    //创建图形管线  开启深度预处理时 额外创建只写深度的管线
     void createGraphicsPipeline(){
-        auto vertShaderCode = readFile("shaders/vert.spv");
+        CPU_TRACE_FUNCTION();
+        //Pipeline layout
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(DrawParams);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        //set 0 为全局 bindless 描述符集  所有管线共用 一帧只绑定一次
+        pipelineLayoutCreateInfo.setLayoutCount = bindless.isCreated() ? 1 : 0;
+        pipelineLayoutCreateInfo.pSetLayouts = bindless.isCreated() ? &bindless.setLayout : nullptr;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+        if(vkCreatePipelineLayout(device , &pipelineLayoutCreateInfo , allocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT) , &pipelineLayout) != VK_SUCCESS){
+            throw std::runtime_error("create pipeline layout failed.");
+        }
+
+        //场景管线使用 perDraw 的布局  参数的提交路径由数据大小与 --per-draw 决定
+        sceneStrategy = perDraw.resolve(scenePayloadBytes , perDrawStrategyFromName(config.perDraw));
+        graphicsPipeline = createScenePipeline(false);
+        depthPrepassPipeline = config.depthPrepass ? createScenePipeline(true) : VK_NULL_HANDLE;
+
+        //材质0 网格顶点颜色  材质1 实例颜色  由特化常量区分  材质2 bindless 纹理
+        instancedPipelines = {createScenePipeline(false , true , 0) , createScenePipeline(false , true , 1)};
+        if(bindless.isCreated()){
+            instancedPipelines.push_back(createScenePipeline(false , true , MATERIAL_BINDLESS));
+        }
+        instancedDepthPipeline = config.depthPrepass ? createScenePipeline(true , true , 0) : VK_NULL_HANDLE;
+        std::cout << "create graphics pipeline success." << (config.depthPrepass ? " (depth prepass)" : "") << std::endl;
+    }
+
+    //depthOnly: 深度预处理管线 只有顶点着色器 不写颜色
+    //instanced: 使用实例属性流的顶点着色器  material 作为特化常量
+    VkPipeline createScenePipeline(bool depthOnly , bool instanced = false , int32_t material = 0){
+        const std::vector<char> &vertShaderCode = shaderLibrary.get(instanced ? "shaders/instanced_vert.spv" : "shaders/vert.spv");
         VkShaderModule vertShaderModule = createShaderModule(vertShaderCode);
 
-        auto fragShaderCode = readFile("shaders/frag.spv");
+        const std::vector<char> &fragShaderCode = shaderLibrary.get(
+            instanced && material == MATERIAL_BINDLESS ? "shaders/bindless_frag.spv" : "shaders/frag.spv");
         VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
 
         VkPipelineShaderStageCreateInfo vertCreateInfo = {};
@@ -322,6 +1632,28 @@ private:
         vertCreateInfo.pName = "main";
         vertCreateInfo.pSpecializationInfo = nullptr;//importent 重要优化点
 
+        VkSpecializationMapEntry materialEntry = {};
+        materialEntry.constantID = 0;
+        materialEntry.offset = 0;
+        materialEntry.size = sizeof(int32_t);
+
+        VkSpecializationInfo specializationInfo = {};
+        specializationInfo.mapEntryCount = 1;
+        specializationInfo.pMapEntries = &materialEntry;
+        specializationInfo.dataSize = sizeof(int32_t);
+        specializationInfo.pData = &material;
+        if(instanced){
+            vertCreateInfo.pSpecializationInfo = &specializationInfo;
+        }
+
+        //非实例化管线: 特化常量 UNIFORM_PARAMS
+        const VkBool32 uniformParams = sceneStrategy == PER_DRAW_DYNAMIC_UNIFORM ? VK_TRUE : VK_FALSE;
+        VkSpecializationMapEntry uniformEntry = {0 , 0 , sizeof(VkBool32)};
+        VkSpecializationInfo uniformSpecialization = {1 , &uniformEntry , sizeof(VkBool32) , &uniformParams};
+        if(!instanced){
+            vertCreateInfo.pSpecializationInfo = &uniformSpecialization;
+        }
+
         VkPipelineShaderStageCreateInfo fragCreateInfo = {};
         fragCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         fragCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -331,6 +1663,7 @@ private:
 
         //着色器阶段
         VkPipelineShaderStageCreateInfo shaderStages[] = {vertCreateInfo , fragCreateInfo};
+        const uint32_t stageCount = depthOnly ? 1 : 2;
 
         //pipline fixed function
         //vertex input
@@ -341,6 +1674,16 @@ private:
         vertexStateCreateInfo.vertexBindingDescriptionCount = 0;
         vertexStateCreateInfo.pVertexBindingDescriptions = nullptr;
 
+        //实例属性流 每个流一个 binding 按实例步进
+        const std::vector<VkVertexInputBindingDescription> instanceBindings = InstanceRenderer::bindingDescriptions();
+        const std::vector<VkVertexInputAttributeDescription> instanceAttributes = InstanceRenderer::attributeDescriptions();
+        if(instanced){
+            vertexStateCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(instanceBindings.size());
+            vertexStateCreateInfo.pVertexBindingDescriptions = instanceBindings.data();
+            vertexStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(instanceAttributes.size());
+            vertexStateCreateInfo.pVertexAttributeDescriptions = instanceAttributes.data();
+        }
+
         //Input assembly
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo = {};
         inputAssemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -374,7 +1717,7 @@ private:
         rasterizationCreateInfo.rasterizerDiscardEnable = VK_FALSE;
         rasterizationCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
         rasterizationCreateInfo.lineWidth = 1.0f;
-        rasterizationCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+        rasterizationCreateInfo.cullMode = cullModeFromName(config.cullMode);
         rasterizationCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
         rasterizationCreateInfo.depthBiasEnable = VK_FALSE;
         rasterizationCreateInfo.depthBiasConstantFactor = 0.0f;
@@ -385,22 +1728,33 @@ private:
         VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
         multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
         multisamplingCreateInfo.sampleShadingEnable = VK_FALSE;
-        multisamplingCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        multisamplingCreateInfo.rasterizationSamples = msaaSamples;
         multisamplingCreateInfo.minSampleShading = 1.0f;
         multisamplingCreateInfo.pSampleMask = nullptr;
         multisamplingCreateInfo.alphaToCoverageEnable = VK_FALSE;
         multisamplingCreateInfo.alphaToOneEnable = VK_FALSE;
 
         //Depth and stencil testing
-        //todo
+        //深度预处理之后 主pass 只有与深度相等的(最前面的)片元通过 且不再写深度
+        const bool afterPrepass = !depthOnly && config.depthPrepass;
+        VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
+        depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencilCreateInfo.depthTestEnable = VK_TRUE;
+        depthStencilCreateInfo.depthWriteEnable = afterPrepass ? VK_FALSE : VK_TRUE;
+        depthStencilCreateInfo.depthCompareOp = afterPrepass ? VK_COMPARE_OP_EQUAL : depthBuffer.compareOp();
+        depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
+        depthStencilCreateInfo.minDepthBounds = 0.0f;
+        depthStencilCreateInfo.maxDepthBounds = 1.0f;
+        depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
 
         //Color blending
         VkPipelineColorBlendAttachmentState colorBlendAttach = {};
-        colorBlendAttach.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT 
-                                        | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colorBlendAttach.blendEnable = VK_FALSE;
-        colorBlendAttach.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-        colorBlendAttach.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+        colorBlendAttach.colorWriteMask = depthOnly ? 0 : (VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT 
+                                        | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+        //--blend: 标准 alpha 混合  片元的 alpha 为 1 画面不变 只增加混合单元的读写
+        colorBlendAttach.blendEnable = config.blend && !depthOnly ? VK_TRUE : VK_FALSE;
+        colorBlendAttach.srcColorBlendFactor = config.blend ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+        colorBlendAttach.dstColorBlendFactor = config.blend ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
         colorBlendAttach.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
         colorBlendAttach.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
         colorBlendAttach.colorBlendOp = VK_BLEND_OP_ADD;
@@ -429,22 +1783,10 @@ private:
         dynamicStateCreateInfo.dynamicStateCount = 0;
         dynamicStateCreateInfo.pDynamicStates = nullptr;
 
-        //Pipeline layout
-        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
-        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutCreateInfo.setLayoutCount = 0;
-        pipelineLayoutCreateInfo.pSetLayouts = nullptr;
-        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-        pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-
-        if(vkCreatePipelineLayout(device , &pipelineLayoutCreateInfo , nullptr , &pipelineLayout) != VK_SUCCESS){
-            throw std::runtime_error("create pipeline layout failed.");
-        }
-
         //create graphics pipeline
         VkGraphicsPipelineCreateInfo graphicPipelineCreateInfo = {};
         graphicPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        graphicPipelineCreateInfo.stageCount = 2;
+        graphicPipelineCreateInfo.stageCount = stageCount;
         graphicPipelineCreateInfo.pStages = shaderStages;
 
         graphicPipelineCreateInfo.pVertexInputState = &vertexStateCreateInfo;
@@ -452,31 +1794,46 @@ private:
         graphicPipelineCreateInfo.pViewportState = &viewportCreateInfo;
         graphicPipelineCreateInfo.pRasterizationState = &rasterizationCreateInfo;
         graphicPipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
-        graphicPipelineCreateInfo.pDepthStencilState = nullptr;
+        graphicPipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
         graphicPipelineCreateInfo.pColorBlendState = &blendCreateInfo;
         graphicPipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
 
-        graphicPipelineCreateInfo.layout = pipelineLayout;
+        graphicPipelineCreateInfo.layout = instanced ? pipelineLayout : perDraw.pipelineLayout;
 
-        graphicPipelineCreateInfo.renderPass = renderPass;
+        //dynamic rendering 在创建管线时只需要附件格式
+        VkPipelineRenderingCreateInfoKHR renderingCreateInfo = {};
+        renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+        renderingCreateInfo.colorAttachmentCount = 1;
+        renderingCreateInfo.pColorAttachmentFormats = &swapChainImageFormat;
+        renderingCreateInfo.depthAttachmentFormat = depthBuffer.format;
+        renderingCreateInfo.stencilAttachmentFormat = DepthBuffer::hasStencil(depthBuffer.format)
+            ? depthBuffer.format : VK_FORMAT_UNDEFINED;
+
+        if(useDynamicRendering){
+            graphicPipelineCreateInfo.pNext = &renderingCreateInfo;
+            graphicPipelineCreateInfo.renderPass = VK_NULL_HANDLE;
+        }else{
+            graphicPipelineCreateInfo.renderPass = renderPass;
+        }
         graphicPipelineCreateInfo.subpass = 0;
 
         graphicPipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
         graphicPipelineCreateInfo.basePipelineIndex = -1;
 
+        VkPipeline pipeline;
         if(vkCreateGraphicsPipelines(device , VK_NULL_HANDLE , 1 , 
-            &graphicPipelineCreateInfo, nullptr , &graphicsPipeline) != VK_SUCCESS){
+            &graphicPipelineCreateInfo, allocator(VK_OBJECT_TYPE_PIPELINE) , &pipeline) != VK_SUCCESS){
             throw std::runtime_error("failed to create graphic pipeline.");
         }
-        std::cout << "create graphics pipeline success." << std::endl;
 
         //destory shader modules
-        vkDestroyShaderModule(device , vertShaderModule ,nullptr);
-        vkDestroyShaderModule(device , fragShaderModule ,nullptr);
+        vkDestroyShaderModule(device , vertShaderModule , allocator(VK_OBJECT_TYPE_SHADER_MODULE));
+        vkDestroyShaderModule(device , fragShaderModule , allocator(VK_OBJECT_TYPE_SHADER_MODULE));
+        return pipeline;
     }
 
     //从spir-v文件 构造出shaderModule
-    VkShaderModule createShaderModule(std::vector<char> &code){
+    VkShaderModule createShaderModule(const std::vector<char> &code){
         VkShaderModuleCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
         createInfo.codeSize = code.size();
@@ -485,7 +1842,7 @@ private:
 
         VkShaderModule shaderModule;
 
-        if(vkCreateShaderModule(device , &createInfo , nullptr , &shaderModule) != VK_SUCCESS){
+        if(vkCreateShaderModule(device , &createInfo , allocator(VK_OBJECT_TYPE_SHADER_MODULE) , &shaderModule) != VK_SUCCESS){
             throw std::runtime_error("create shader module error.");
         }
         return shaderModule;
@@ -493,6 +1850,7 @@ private:
 
     //创建与image关联的imageview
     void createImageViews(){
+        CPU_TRACE_FUNCTION();
         swapChainImageViews.resize(swapChainImages.size());
 
         for(int i = 0 ; i < swapChainImages.size(); i++){
@@ -514,7 +1872,7 @@ private:
             imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
             imageViewCreateInfo.subresourceRange.layerCount = 1;    
 
-            if(vkCreateImageView(device , &imageViewCreateInfo , nullptr , &swapChainImageViews[i]) != VK_SUCCESS){
+            if(vkCreateImageView(device , &imageViewCreateInfo , allocator(VK_OBJECT_TYPE_IMAGE_VIEW) , &swapChainImageViews[i]) != VK_SUCCESS){
                throw std::runtime_error("failed to create imageview.");
             }
         }//end for i
@@ -524,6 +1882,11 @@ private:
 
     //创建交换链 用于展示图像
     void createSwapChain(){
+        CPU_TRACE_FUNCTION();
+        if(offscreen){
+            createOffscreenImages();
+            return;
+        }
         SwapChainSupportDetail details = querySwapChainSupport(physicalDevice);
 
         //select 1. surface format  2. presentMode  3. set resolution 
@@ -553,6 +1916,15 @@ private:
         swapChainCreateInfo.presentMode = presentMode;
         swapChainCreateInfo.imageArrayLayers = 1;
         swapChainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        //帧转储 回归检查从交换链图像复制
+        const bool readback = config.dumpInterval > 0 || !config.regressionDir.empty();
+        swapChainTransferSrc = readback
+            && (details.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+        if(swapChainTransferSrc){
+            swapChainCreateInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }else if(readback){
+            std::cout << "frame readback disabled : swapchain images do not support transfer src" << std::endl;
+        }
 
         QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
         if(queueFamilyIndices.graphicsIndex == queueFamilyIndices.presentIndex){//图形队列簇与呈现队列簇是同一个
@@ -574,7 +1946,7 @@ private:
         swapChainCreateInfo.oldSwapchain = VK_NULL_HANDLE;
 
         //create swap chain
-        if(vkCreateSwapchainKHR(device , &swapChainCreateInfo , nullptr , &swapChain) != VK_SUCCESS){
+        if(vkCreateSwapchainKHR(device , &swapChainCreateInfo , allocator(VK_OBJECT_TYPE_SWAPCHAIN_KHR) , &swapChain) != VK_SUCCESS){
             throw std::runtime_error("Failed to create swap chain!");
         }
 
@@ -594,6 +1966,51 @@ private:
         }
     }
 
+    //离屏渲染代替交换链  每个飞行帧一张图像 图像下标即飞行帧下标 在该帧的 fence 之后才会再次写入
+    //B8G8R8A8_SRGB 是必须支持颜色附件的格式  与常见交换链的格式相同
+    void createOffscreenImages(){
+        swapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+        swapChainExtent = {WIDTH , HEIGHT};
+        swapChainTransferSrc = true;
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+
+        swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+        offscreenMemories.resize(MAX_FRAMES_IN_FLIGHT);
+        for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ; i++){
+            VkImageCreateInfo imageCreateInfo = {};
+            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageCreateInfo.format = swapChainImageFormat;
+            imageCreateInfo.extent = {swapChainExtent.width , swapChainExtent.height , 1};
+            imageCreateInfo.mipLevels = 1;
+            imageCreateInfo.arrayLayers = 1;
+            imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            if(vkCreateImage(device , &imageCreateInfo , allocator(VK_OBJECT_TYPE_IMAGE) , &swapChainImages[i]) != VK_SUCCESS){
+                throw std::runtime_error("failed to create offscreen image!");
+            }
+
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(device , swapChainImages[i] , &requirements);
+            VkMemoryAllocateInfo allocateInfo = {};
+            allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocateInfo.allocationSize = requirements.size;
+            allocateInfo.memoryTypeIndex = findMemoryType(memoryProperties , requirements.memoryTypeBits ,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            if(vkAllocateMemory(device , &allocateInfo , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY) , &offscreenMemories[i]) != VK_SUCCESS){
+                throw std::runtime_error("failed to allocate offscreen image memory!");
+            }
+            vkBindImageMemory(device , swapChainImages[i] , offscreenMemories[i] , 0);
+        }//end for i
+
+        std::cout << "create offscreen images " << swapChainImages.size() << " success" << std::endl;
+    }
+
     //选择合适的格式
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(std::vector<VkSurfaceFormatKHR> &formatList){
         for(const auto &availableFormat : formatList){
@@ -668,230 +2085,1689 @@ private:
         return details;
     }
 
-    //创建窗口表面
-    void createSurface(){
-        if(glfwCreateWindowSurface(instance , window , nullptr , &surface) != VK_SUCCESS){
-            throw std::runtime_error("failed to create window surface!");
-        }
+    //创建窗口表面
+    void createSurface(){
+        CPU_TRACE_FUNCTION();
+        if(offscreen){
+            return;
+        }
+        if(glfwCreateWindowSurface(instance , window , allocator(VK_OBJECT_TYPE_SURFACE_KHR) , &surface) != VK_SUCCESS){
+            throw std::runtime_error("failed to create window surface!");
+        }
+    }
+
+    //create vulkan instance
+    void createInstance(){
+        CPU_TRACE_FUNCTION();
+        std::cout << "create vulkan instance " << std::endl;
+        //std::cout << "checkValidationLayerSupport " << checkValidationLayerSupport() << std::endl;
+        if(enableValidateLayers && !checkValidationLayerSupport()){
+            throw std::runtime_error("validate layer request but not available!");
+        }
+
+        getRequiredExtensions();
+
+        VkApplicationInfo appInfo = {};
+        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.pApplicationName = "HelloTriangle";
+        appInfo.applicationVersion = VK_MAKE_VERSION(1,0,0);
+        appInfo.pEngineName = "NoEngine";
+        instanceApiVersion = queryInstanceApiVersion();
+        appInfo.apiVersion = instanceApiVersion;
+        appInfo.engineVersion = VK_MAKE_VERSION(1, 0 , 0);
+
+        VkInstanceCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &appInfo;
+
+        //注入扩展层配置
+        auto extensions = getRequiredExtensions();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        //注入验证层
+        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = {};
+        if(enableValidateLayers){
+            createInfo.enabledLayerCount = static_cast<uint32_t>(validateLayers.size());
+            createInfo.ppEnabledLayerNames = validateLayers.data();
+
+            populateDebugMessengerCreateInfo(debugCreateInfo);
+            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debugCreateInfo;
+        }else{
+            createInfo.enabledLayerCount = 0;
+            createInfo.pNext = nullptr;
+        }
+
+        if (vkCreateInstance(&createInfo, allocator(VK_OBJECT_TYPE_INSTANCE) , &instance) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create instance!");
+        }
+        std::cout << "create instance success" << std::endl;
+    }
+
+    //loader支持的最高版本 上限1.3  vulkan 1.0 loader 没有 vkEnumerateInstanceVersion
+    uint32_t queryInstanceApiVersion(){
+        auto func = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr , "vkEnumerateInstanceVersion");
+        uint32_t version = VK_API_VERSION_1_0;
+        if(func == nullptr || func(&version) != VK_SUCCESS){
+            return VK_API_VERSION_1_0;
+        }
+        version = VK_MAKE_API_VERSION(0 , VK_API_VERSION_MAJOR(version) , VK_API_VERSION_MINOR(version) , 0);
+        return version < VK_API_VERSION_1_3 ? version : VK_API_VERSION_1_3;
+    }
+
+    void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &debugCreateInfo){
+        debugCreateInfo = {};
+
+        debugCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+        //只订阅需要的级别  不需要的消息层内就不会生成
+        debugCreateInfo.messageSeverity = debugSeverityMaskFromName(config.logSeverity);
+        debugCreateInfo.messageType = debugTypeMaskFromNames(config.logTypes);
+        
+        debugCreateInfo.pfnUserCallback = DebugLogger::callback;
+        debugCreateInfo.pUserData = &debugLogger;
+    }
+
+    std::vector<const char*> getRequiredExtensions(){
+        //离屏时没有表面 不需要 glfw 要求的表面扩展
+        std::vector<const char*> extensions;
+        if(!offscreen){
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
+
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions , glfwExtensions + glfwExtensionCount);
+        }
+
+        if(enableValidateLayers){
+            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        //1.0 实例查询设备UUID 需要 KHR 扩展
+        instanceIdProperties = false;
+        if(queryInstanceApiVersion() < VK_API_VERSION_1_1
+            && isInstanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)
+            && isInstanceExtensionAvailable(VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME)){
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            extensions.push_back(VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME);
+            instanceIdProperties = true;
+        }
+        return extensions;
+    }
+
+    bool isInstanceExtensionAvailable(const char *name){
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr , &extensionCount , nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr , &extensionCount , availableExtensions.data());
+        for(VkExtensionProperties &prop : availableExtensions){
+            if(std::strcmp(prop.extensionName , name) == 0){
+                return true;
+            }
+        }//end for each
+        return false;
+    }
+    
+
+    //检查验证层的支持
+    bool checkValidationLayerSupport(){
+        uint32_t layerCount = 0;
+
+        vkEnumerateInstanceLayerProperties(&layerCount , nullptr);
+        //std::cout << "validate layer count = " << layerCount << std::endl;
+
+        std::vector<VkLayerProperties> availableLayers(layerCount);
+        VkResult result = vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+        //std::cout << "vkEnumerateInstanceLayerProperties result = " << result << std::endl;
+        
+        // std::cout << "layer properties:" << std::endl;
+        // for(int i = 0 ; i < layerCount ;i++){
+        //     std::cout << '\t' << availableLayers[i].layerName << std::endl;
+        // }//end for i
+
+        for(const std::string &layer : validateLayers){
+            bool layoutFound = false;
+
+            for(VkLayerProperties &vkLayout : availableLayers){
+                std::string vkLayerName = vkLayout.layerName;
+                //std::cout << "compare = " << layer << " with " << vkLayerName << std::endl;
+                if(layer == vkLayerName){
+                    layoutFound = true;
+                    break;
+                }
+            }
+
+            if(!layoutFound){
+                std::cout << "Not found validate " << layer << std::endl;
+                return false;
+            }
+        }//end for
+
+        return true;
+    }
+
+    //game loop
+    void mainloop(){
+        while(!glfwWindowShouldClose(window)){
+            {
+                CPU_TRACE_SCOPE("poll events");
+                glfwPollEvents();
+            }
+            drawFrame();
+        }//end while
+
+        vkDeviceWaitIdle(device);
+    }
+
+    //渲染一帧图像
+    void drawFrame(){
+        CPU_TRACE_FUNCTION();
+        //wait fence
+        {
+            CPU_TRACE_SCOPE("wait fence");
+            vkd.vkWaitForFences(device , 1 , &inFlightFences[currentFrame] , VK_TRUE , INT32_MAX);
+        }
+
+        vkd.vkResetFences(device , 1 , &inFlightFences[currentFrame]);
+        {
+            CPU_TRACE_SCOPE("begin frame");
+            bindless.beginFrame(currentFrame);
+            frameDescriptors.beginFrame(currentFrame);
+            perDraw.beginFrame(currentFrame);
+            reportDescriptorStats();
+            reportHostAllocations();
+            gpuProfiler.collect(currentFrame);
+            frameReadback.frameCompleted(currentFrame);
+            if(config.gpuProfile && frameCounter % 120 == 0 && frameCounter > 0){
+                gpuProfiler.report(std::cout);
+            }
+        }
+
+        //离屏时每个飞行帧使用自己的图像 上面的 fence 已保证它不再被读写
+        uint32_t imageIndex = static_cast<uint32_t>(currentFrame);
+
+        if(!offscreen){
+            CPU_TRACE_SCOPE("acquire image");
+            vkd.vkAcquireNextImageKHR(device , swapChain , UINT64_MAX , 
+                imageAvailableSemaphores[currentFrame] , VK_NULL_HANDLE , &imageIndex);
+        }
+
+        //std::cout << "imageIndex = " << imageIndex << std::endl;
+
+        VkCommandBuffer cmd = cmdBuffers[currentFrame];
+        VkCommandBuffer asyncCmd = asyncCmdBuffers.empty() ? VK_NULL_HANDLE : asyncCmdBuffers[currentFrame];
+        vkd.vkResetCommandBuffer(cmd , 0);
+        if(asyncCmd != VK_NULL_HANDLE){
+            vkd.vkResetCommandBuffer(asyncCmd , 0);
+        }
+        RGExecuteResult graphResult = recordCommandBuffer(cmd , asyncCmd , imageIndex);
+        if(frameCounter++ == 0){
+            renderGraph.printStats();
+        }
+
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkPipelineStageFlags> waitStages;
+        if(!offscreen){
+            waitSemaphores.push_back(imageAvailableSemaphores[currentFrame]);
+            waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        }
+
+        //异步计算先提交 图形队列在用到其结果的阶段等待
+        if(graphResult.asyncWork){
+            VkSubmitInfo asyncSubmitInfo = {};
+            asyncSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            asyncSubmitInfo.commandBufferCount = 1;
+            asyncSubmitInfo.pCommandBuffers = &asyncCmd;
+            asyncSubmitInfo.signalSemaphoreCount = 1;
+            asyncSubmitInfo.pSignalSemaphores = &asyncFinishedSemaphores[currentFrame];
+            if(vkd.vkQueueSubmit(computeQueue , 1 , &asyncSubmitInfo , VK_NULL_HANDLE) != VK_SUCCESS){
+                throw std::runtime_error("fail to submit async compute command buffer!");
+            }
+
+            waitSemaphores.push_back(asyncFinishedSemaphores[currentFrame]);
+            waitStages.push_back(graphResult.graphicsWaitStage != 0 
+                ? graphResult.graphicsWaitStage : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT));
+        }
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmd;
+
+        VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
+        submitInfo.signalSemaphoreCount = offscreen ? 0 : 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+
+        gpuProfiler.markSubmit();
+        {
+            CPU_TRACE_SCOPE("submit");
+            if(vkd.vkQueueSubmit(graphicsQueue , 1 , &submitInfo , inFlightFences[currentFrame]) != VK_SUCCESS){
+                throw std::runtime_error("fail to submit draw command buffer!");
+            }
+        }
+
+        if(!offscreen){
+            VkPresentInfoKHR presentInfo = {};
+            presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+            presentInfo.waitSemaphoreCount = 1;
+            presentInfo.pWaitSemaphores = signalSemaphores;
+
+            VkSwapchainKHR swapChains[] = {swapChain};
+            presentInfo.swapchainCount = 1;
+            presentInfo.pSwapchains = swapChains;
+            presentInfo.pImageIndices = &imageIndex;
+
+            presentInfo.pResults = nullptr;
+
+            CPU_TRACE_SCOPE("present");
+            vkd.vkQueuePresentKHR(presentQueue , &presentInfo);
+        }
+        if(!startup.hasFirstFrame()){
+            startup.markFirstFrame();
+            startup.report(std::cout);
+        }
+
+        //效率较低 会使GPU长期处于闲置状态
+        //vkQueueWaitIdle(presentQueue);
+
+        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        // std::cout << "currentFrame = " << currentFrame << std::endl;
+    }
+
+    //基准测试入口
+    void runBenchmark(const std::string &name){
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice , &properties);
+        benchmarkReport.setDeviceInfo("name" , properties.deviceName);
+        benchmarkReport.setDeviceInfo("apiVersion" , std::to_string(VK_API_VERSION_MAJOR(properties.apiVersion)) + "."
+            + std::to_string(VK_API_VERSION_MINOR(properties.apiVersion)) + "." + std::to_string(VK_API_VERSION_PATCH(properties.apiVersion)));
+        benchmarkReport.setDeviceInfo("driverVersion" , std::to_string(properties.driverVersion));
+        benchmarkReport.setDeviceInfo("vendorId" , std::to_string(properties.vendorID));
+        benchmarkReport.setDeviceInfo("validation" , enableValidateLayers ? "on" : "off");
+        benchmarkReport.setDeviceInfo("benchmark" , name);
+
+        if(name == "dispatch"){
+            benchmarkDispatch();
+        }else if(name == "renderpath"){
+            benchmarkRenderPath();
+        }else if(name == "depth"){
+            benchmarkDepthPrepass();
+        }else if(name == "msaa"){
+            benchmarkMsaa();
+        }else if(name == "instancing"){
+            benchmarkInstancing();
+        }else if(name == "culling"){
+            benchmarkCulling();
+        }else if(name == "perdraw"){
+            benchmarkPerDraw();
+        }else if(name == "sort"){
+            benchmarkRenderQueue();
+        }else if(name == "api"){
+            benchmarkApi();
+        }else if(name == "raster"){
+            benchmarkRaster();
+        }else{
+            throw std::runtime_error("unknown benchmark " + name);
+        }
+    }
+
+    //渲染回归检查  每个场景先渲染几帧 回读下一帧与基准图像比较 返回是否全部通过
+    //摄像机只在剔除时随帧序号移动 这些场景的画面与帧序号无关
+    bool runRegression(){
+        if(!frameReadback.isCreated()){
+            throw std::runtime_error("regression check needs frame readback (rgba8 / bgra8 format)");
+        }
+        const int warmupFrames = MAX_FRAMES_IN_FLIGHT + 1;
+        const std::vector<RegressionScene> scenes = {
+            {"triangle" , [](AppConfig &){}},
+            {"overdraw" , [](AppConfig &scene){
+                scene.overdrawLayers = 8;
+                scene.shadingIterations = 16;
+            }},
+            {"depth_prepass" , [](AppConfig &scene){
+                scene.overdrawLayers = 8;
+                scene.depthPrepass = true;
+            }},
+            {"msaa4" , [](AppConfig &scene){
+                scene.msaaSamples = 4;
+            }},
+            {"instancing" , [](AppConfig &scene){
+                scene.instanceCount = 1000;
+            }}
+        };
+
+        const AppConfig savedConfig = config;
+        std::filesystem::create_directories(config.regressionDir);
+        uint32_t failures = 0;
+        std::vector<uint8_t> actual;
+        std::vector<uint8_t> golden;
+        std::vector<uint8_t> scratch;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        for(const RegressionScene &scene : scenes){
+            //命令行中的场景参数不影响固定场景
+            config = savedConfig;
+            config.overdrawLayers = 1;
+            config.shadingIterations = 0;
+            config.depthPrepass = false;
+            config.msaaSamples = 1;
+            config.instanceCount = 0;
+            scene.configure(config);
+            if(config.msaaSamples > 1 && !(supportedSampleCounts() & config.msaaSamples)){
+                std::cout << "regression " << scene.name << " : skipped (" << config.msaaSamples << "x msaa not supported)" << std::endl;
+                continue;
+            }
+            applyRenderConfig();
+
+            for(int i = 0 ; i < warmupFrames ; i++){
+                drawFrame();
+            }//end for i
+
+            //回读环被帧转储占满时顺延到之后的帧
+            actual.clear();
+            frameReadback.captureNext([&actual , &width , &height](const uint8_t *rgba , uint32_t imageWidth , uint32_t imageHeight){
+                actual.assign(rgba , rgba + static_cast<size_t>(imageWidth) * imageHeight * 4);
+                width = imageWidth;
+                height = imageHeight;
+            });
+            for(int attempt = 0 ; actual.empty() && attempt < warmupFrames ; attempt++){
+                drawFrame();
+                vkDeviceWaitIdle(device);
+                frameReadback.flush();
+            }//end for attempt
+            frameReadback.captureNext(nullptr);
+            if(actual.empty()){
+                std::cout << "regression " << scene.name << " : FAIL (frame not captured)" << std::endl;
+                failures++;
+                continue;
+            }
+
+            const std::string goldenPath = config.regressionDir + "/" + scene.name + ".png";
+            if(config.regressionUpdate){
+                if(!writePng(goldenPath , actual.data() , width , height , scratch)){
+                    throw std::runtime_error("failed to write " + goldenPath);
+                }
+                std::cout << "regression " << scene.name << " : golden written " << goldenPath << std::endl;
+                continue;
+            }
+
+            if(!std::filesystem::exists(goldenPath)){
+                std::cout << "regression " << scene.name << " : FAIL (no golden image " << goldenPath
+                    << " , generate it with --regression-update)" << std::endl;
+                failures++;
+                continue;
+            }
+            uint32_t goldenWidth = 0;
+            uint32_t goldenHeight = 0;
+            std::string error;
+            if(!readPng(goldenPath , golden , goldenWidth , goldenHeight , error)){
+                std::cout << "regression " << scene.name << " : FAIL (" << error << ")" << std::endl;
+                failures++;
+                continue;
+            }
+            if(goldenWidth != width || goldenHeight != height){
+                std::cout << "regression " << scene.name << " : FAIL (size " << width << "x" << height
+                    << " golden " << goldenWidth << "x" << goldenHeight << ")" << std::endl;
+                failures++;
+                continue;
+            }
+
+            const ImageDiff diff = compareImages(actual.data() , golden.data() , width , height ,
+                static_cast<uint8_t>(std::min(config.regressionTolerance , 255u)));
+            const double overFraction = static_cast<double>(diff.pixelsOverTolerance) / (static_cast<double>(width) * height);
+            const bool passed = diff.psnr >= config.regressionPsnr && diff.ssim >= config.regressionSsim
+                && overFraction <= config.regressionPixels;
+            std::cout << "regression " << scene.name << " : " << (passed ? "pass" : "FAIL")
+                << " psnr : " << diff.psnr << " dB"
+                << " ssim : " << diff.ssim
+                << " max diff : " << diff.maxDiff
+                << " mean diff : " << diff.meanAbsDiff
+                << " pixels over tolerance : " << diff.pixelsOverTolerance << " (" << overFraction * 100.0 << "%)" << std::endl;
+            if(!passed){
+                failures++;
+                std::vector<uint8_t> diffImage(actual.size());
+                makeDiffImage(actual.data() , golden.data() , diffImage.data() , static_cast<size_t>(width) * height);
+                writePng(config.regressionDir + "/" + scene.name + "_actual.png" , actual.data() , width , height , scratch);
+                writePng(config.regressionDir + "/" + scene.name + "_diff.png" , diffImage.data() , width , height , scratch);
+            }
+        }//end for each
+
+        config = savedConfig;
+        applyRenderConfig();
+        std::cout << "regression " << (config.regressionUpdate ? "golden images updated" : (failures == 0 ? "passed" : "failed"))
+            << " scenes : " << scenes.size() << " failures : " << failures << std::endl;
+        return failures == 0;
+    }
+
+    //对比 loader trampoline 与 分发表直接调用 录制vkCmdDraw的开销
+    //开启验证层时 两者都会经过验证层 结果无参考意义
+    void benchmarkDispatch(){
+        const uint32_t drawCount = 100000;
+        const int rounds = 10;
+
+        VkCommandPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolCreateInfo.queueFamilyIndex = findQueueFamilies(physicalDevice).graphicsIndex;
+        poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        VkCommandPool benchPool;
+        if(vkCreateCommandPool(device , &poolCreateInfo , allocator(VK_OBJECT_TYPE_COMMAND_POOL) , &benchPool) != VK_SUCCESS){
+            throw std::runtime_error("failed create benchmark command pool !");
+        }
+
+        VkCommandBufferAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = benchPool;
+        allocateInfo.commandBufferCount = 1;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+        VkCommandBuffer cmd;
+        if(vkAllocateCommandBuffers(device , &allocateInfo , &cmd) != VK_SUCCESS){
+            throw std::runtime_error("failed create benchmark command buffer");
+        }
+
+        //录制drawCount次draw 返回每次draw的耗时(ns) 取多轮最小值
+        auto measure = [&](bool direct) -> double {
+            double best = 1e30;
+            for(int round = 0 ; round < rounds ; round++){
+                vkResetCommandPool(device , benchPool , 0);
+
+                VkCommandBufferBeginInfo beginInfo = {};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                vkBeginCommandBuffer(cmd , &beginInfo);
+
+                beginBenchmarkRendering(cmd);
+                vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , graphicsPipeline);
+                perDraw.bindFrame(cmd);
+                DrawParams params = {{0.0f , 0.0f , depthBuffer.depthValue(0.5f) , 1.0f} , 0 , 0};
+                vkCmdPushConstants(cmd , perDraw.pipelineLayout , VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ,
+                    0 , sizeof(DrawParams) , &params);
+
+                const uint64_t start = currentTimeNanos();
+                if(direct){
+                    PFN_vkCmdDraw cmdDraw = vkd.vkCmdDraw;
+                    for(uint32_t i = 0 ; i < drawCount ; i++){
+                        cmdDraw(cmd , 3 , 1 , 0 , 0);
+                    }
+                }else{
+                    for(uint32_t i = 0 ; i < drawCount ; i++){
+                        vkCmdDraw(cmd , 3 , 1 , 0 , 0);
+                    }
+                }
+                const uint64_t elapsed = currentTimeNanos() - start;
+
+                endBenchmarkRendering(cmd);
+                vkEndCommandBuffer(cmd);
+
+                best = std::min(best , static_cast<double>(elapsed) / drawCount);
+            }//end for round
+            return best;
+        };
+
+        const double loaderNs = measure(false);
+        const double directNs = measure(true);
+
+        std::cout << "benchmark dispatch draws : " << drawCount 
+            << " loader : " << loaderNs << " ns/draw"
+            << " direct : " << directNs << " ns/draw"
+            << " reduction : " << (loaderNs > 0.0 ? (1.0 - directNs / loaderNs) * 100.0 : 0.0) << "%" 
+            << (enableValidateLayers ? " (validation layers enabled)" : "") << std::endl;
+
+        vkDestroyCommandPool(device , benchPool , allocator(VK_OBJECT_TYPE_COMMAND_POOL));
+    }
+
+    //基准测试中只录制不提交的渲染范围  渲染到第0张交换链图像
+    //附件取最近一帧帧图分配的  还没有渲染过时先渲染一帧
+    void beginBenchmarkRendering(VkCommandBuffer cmd){
+        if(lastMainTargets.depth == VK_NULL_HANDLE){
+            drawFrame();
+            vkDeviceWaitIdle(device);
+        }
+        beginMainRendering(cmd , 0 , lastMainTargets);
+    }
+
+    void endBenchmarkRendering(VkCommandBuffer cmd){
+        endMainRendering(cmd);
+    }
+
+    //对比两种渲染路径
+    //1. 交换链变化时需要重建的对象耗时  2. 每帧录制指令的平均耗时  3. 实际渲染的平均帧时间
+    void benchmarkRenderPath(){
+        const int rebuildRounds = 100;
+        const int frameCount = 500;
+
+        std::vector<bool> paths = {false};
+        if(deviceFeatures.has(CAP_DYNAMIC_RENDERING) && vkd.vkCmdBeginRenderingKHR != nullptr){
+            paths.push_back(true);
+        }
+
+        for(bool dynamicPath : paths){
+            vkDeviceWaitIdle(device);
+            destroyRenderPathObjects();
+
+            useDynamicRendering = dynamicPath;
+            if(!useDynamicRendering){
+                createRenderPass();
+            }
+            createGraphicsPipeline();
+            if(!useDynamicRendering){
+                createFramebuffers();
+            }
+
+            recordNanos = 0;
+            uint64_t start = currentTimeNanos();
+            for(int i = 0 ; i < frameCount ; i++){
+                drawFrame();
+            }//end for i
+            vkDeviceWaitIdle(device);
+            const double frameUs = (currentTimeNanos() - start) / 1000.0 / frameCount;
+            const double recordUs = recordNanos / 1000.0 / frameCount;
+
+            //交换链重建时 legacy 路径要重建每张图像的framebuffer  dynamic 路径没有需要重建的对象
+            //渲染之后才知道附件 重建用过的全部 framebuffer
+            start = currentTimeNanos();
+            for(int round = 0 ; !useDynamicRendering && round < rebuildRounds ; round++){
+                createFramebuffers();
+            }//end for round
+            const double rebuildUs = (currentTimeNanos() - start) / 1000.0 / rebuildRounds;
+
+            std::cout << "benchmark renderpath " << (useDynamicRendering ? "dynamic" : "legacy")
+                << " rebuild : " << rebuildUs << " us"
+                << " record : " << recordUs << " us"
+                << " frame : " << frameUs << " us" << std::endl;
+        }//end for each
+    }
+
+    //基准测试结束后 (设备空闲) 调用  读回剩余几帧的结果 输出每个pass 非零的平均管线统计 然后清空
+    //result 非空时 每个pass 的 GPU 时间与全部统计同时写入 (键为 pass.统计名)
+    void printPassStatistics(BenchmarkResult *result = nullptr){
+        for(uint32_t frame = 0 ; frame < MAX_FRAMES_IN_FLIGHT ; frame++){
+            gpuProfiler.collect(frame);
+        }//end for frame
+        for(const auto &entry : gpuProfiler.aggregated()){
+            const GpuScopeStats &scope = entry.second;
+            if(result != nullptr && scope.count > 0){
+                result->metric(entry.first + ".gpu_ms" , scope.gpuTotalMs / scope.count);
+            }
+            if(scope.statisticsCount == 0){
+                continue;
+            }
+            if(result != nullptr){
+                for(uint32_t statistic = 0 ; statistic < GPU_STATISTIC_COUNT ; statistic++){
+                    std::string key = gpuStatisticName(statistic);
+                    std::replace(key.begin() , key.end() , ' ' , '_');
+                    result->metric(entry.first + "." + key , scope.averageStatistic(statistic));
+                }//end for statistic
+            }
+            std::cout << " [" << entry.first;
+            for(uint32_t statistic = 0 ; statistic < GPU_STATISTIC_COUNT ; statistic++){
+                const uint64_t value = static_cast<uint64_t>(scope.averageStatistic(statistic));
+                if(value > 0){
+                    std::cout << " " << gpuStatisticName(statistic) << " : " << value;
+                }
+            }//end for statistic
+            std::cout << "]";
+        }//end for each
+        gpuProfiler.clearStats();
+    }
+
+    //深度预处理对比  多层重叠的三角形由远到近绘制 片元着色开销大
+    //每个pass 的片元着色器调用次数(需要 pipelineStatisticsQuery) 与平均帧时间
+    void benchmarkDepthPrepass(){
+        const int frameCount = 300;
+        const AppConfig savedConfig = config;
+        config.overdrawLayers = 16;
+        config.shadingIterations = 256;
+
+        if(!gpuProfiler.hasPipelineStatistics()){
+            std::cout << "pipelineStatisticsQuery not supported , only frame time is measured" << std::endl;
+        }
+
+        for(bool prepass : {false , true}){
+            vkDeviceWaitIdle(device);
+            destroyGraphicsPipeline();
+            config.depthPrepass = prepass;
+            createGraphicsPipeline();
+
+            for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ; i++){
+                drawFrame();
+            }//end for i
+            gpuProfiler.clearStats();
+
+            const uint64_t start = currentTimeNanos();
+            for(int i = 0 ; i < frameCount ; i++){
+                drawFrame();
+            }//end for i
+            vkDeviceWaitIdle(device);
+            const double frameUs = (currentTimeNanos() - start) / 1000.0 / frameCount;
+
+            std::cout << "benchmark depth " << (prepass ? "prepass" : "no prepass")
+                << " layers : " << config.overdrawLayers
+                << " frame : " << frameUs << " us";
+            BenchmarkResult &result = benchmarkReport.add("depth.prepass")
+                .param("prepass" , prepass ? "on" : "off")
+                .param("layers" , std::to_string(config.overdrawLayers))
+                .param("shadingIterations" , std::to_string(config.shadingIterations))
+                .metric("frame_us" , frameUs);
+            printPassStatistics(&result);
+            std::cout << std::endl;
+        }//end for each
+
+        destroyGraphicsPipeline();
+        config = savedConfig;
+        createGraphicsPipeline();
+    }
+
+    //光栅化吞吐量  --bench=raster  结果同时加入 benchmarkReport (--bench-json)
+    //size: 三角形面积 x 数量  overdraw: 全屏大三角形的层数  blend: 混合开关  cull: 剔除模式
+    //时间取主pass 的 GPU 时间 (没有时间戳时用帧时间)  片元数取管线统计 不支持时按面积估算
+    //网格模式的三角形数不超过格子数 每个三角形覆盖不同的像素  超过时跳过 (重叠的三角形深度相同 比较为 *_OR_EQUAL 会再次着色 测的是 overdraw)
+    void benchmarkRaster(){
+        const int frameCount = 60;
+        const AppConfig savedConfig = config;
+        config.shadingIterations = 0;
+        config.depthPrepass = false;
+        config.overdrawLayers = 1;
+        vkDeviceWaitIdle(device);
+        populateInstances(0);
+
+        if(!gpuProfiler.hasPipelineStatistics()){
+            std::cout << "pipelineStatisticsQuery not supported , fragments are estimated from triangle area" << std::endl;
+        }
+        const double screenPixels = static_cast<double>(swapChainExtent.width) * swapChainExtent.height;
+
+        //按当前 config 重建管线后测量一组
+        auto measure = [&](const std::string &sweep){
+            vkDeviceWaitIdle(device);
+            destroyGraphicsPipeline();
+            createGraphicsPipeline();
+
+            for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ; i++){
+                drawFrame();
+            }//end for i
+            gpuProfiler.clearStats();
+
+            const uint64_t start = currentTimeNanos();
+            for(int i = 0 ; i < frameCount ; i++){
+                drawFrame();
+            }//end for i
+            vkDeviceWaitIdle(device);
+            const double frameMs = (currentTimeNanos() - start) / 1e6 / frameCount;
+            for(uint32_t frame = 0 ; frame < MAX_FRAMES_IN_FLIGHT ; frame++){
+                gpuProfiler.collect(frame);
+            }//end for frame
+
+            const GpuScopeStats *scope = gpuProfiler.find("main");
+            const bool gpuTimed = scope != nullptr && scope->count > 0 && scope->gpuTotalMs > 0.0;
+            const double passMs = gpuTimed ? scope->gpuTotalMs / scope->count : frameMs;
+
+            const uint32_t layers = std::max(config.overdrawLayers , 1u);
+            const bool grid = config.gridTriangles > 0;
+            const double triangles = static_cast<double>(grid ? config.gridTriangles : 1) * layers;
+            const double estimatedPixels = grid
+                ? triangles * config.triangleArea
+                : layers * screenPixels * (layers > 1 ? 0.5 : 0.125);
+            const bool counted = scope != nullptr && scope->statisticsCount > 0;
+            const double fragments = counted ? scope->averageStatistic(GPU_STATISTIC_FRAGMENT_INVOCATIONS) : estimatedPixels;
+            const double trianglesOut = counted ? scope->averageStatistic(GPU_STATISTIC_CLIPPING_PRIMITIVES) : triangles;
+            const double seconds = passMs / 1000.0;
+
+            std::cout << "benchmark raster " << sweep
+                << " triangles : " << static_cast<uint64_t>(triangles)
+                << " area : " << (grid ? config.triangleArea : estimatedPixels / triangles) << " px"
+                << " layers : " << layers
+                << " blend : " << (config.blend ? "on" : "off")
+                << " cull : " << config.cullMode
+                << " pass : " << passMs << " ms" << (gpuTimed ? "" : " (frame time)")
+                << " triangles/s : " << (seconds > 0.0 ? triangles / seconds : 0.0)
+                << " fill rate : " << (seconds > 0.0 ? fragments / seconds / 1e6 : 0.0) << " Mpixels/s"
+                << (counted ? "" : " (estimated)")
+                << " rasterized triangles : " << static_cast<uint64_t>(trianglesOut) << std::endl;
+
+            benchmarkReport.add("raster." + sweep)
+                .param("triangles" , std::to_string(static_cast<uint64_t>(triangles)))
+                .param("triangleArea" , std::to_string(grid ? config.triangleArea : estimatedPixels / triangles))
+                .param("layers" , std::to_string(layers))
+                .param("blend" , config.blend ? "on" : "off")
+                .param("cull" , config.cullMode)
+                .param("fragmentSource" , counted ? "statistics" : "estimate")
+                .metric("pass_ms" , passMs)
+                .metric("triangles_per_sec" , seconds > 0.0 ? triangles / seconds : 0.0)
+                .metric("pixels_per_sec" , seconds > 0.0 ? fragments / seconds : 0.0)
+                .metric("fragments" , fragments)
+                .metric("rasterized_triangles" , trianglesOut);
+        };
+
+        //网格的格子数 (当前 config.triangleArea)
+        auto gridCells = [&]() -> uint32_t {
+            float scale = 1.0f;
+            uint32_t columns = 0;
+            triangleGridLayout(scale , columns);
+            return columns * columns;
+        };
+
+        //三角形大小 x 数量  放不进网格的组合跳过
+        config.cullMode = "none";
+        for(float area : {1.0f , 4.0f , 16.0f , 64.0f , 256.0f , 1024.0f}){
+            config.triangleArea = area;
+            const uint32_t cells = gridCells();
+            for(uint32_t count : {10000u , 100000u , 1000000u}){
+                if(count > cells){
+                    std::cout << "benchmark raster size triangles : " << count << " area : " << area
+                        << " px skipped (grid cells : " << cells << ")" << std::endl;
+                    continue;
+                }
+                config.gridTriangles = count;
+                measure("size");
+            }//end for each
+        }//end for each
+
+        //overdraw 层数 (单个大三角形)
+        config.gridTriangles = 0;
+        config.cullMode = "back";
+        for(uint32_t layers : {1u , 4u , 16u , 64u}){
+            config.overdrawLayers = layers;
+            measure("overdraw");
+        }//end for each
+
+        //混合单元的读改写
+        config.overdrawLayers = 16;
+        for(bool blend : {false , true}){
+            config.blend = blend;
+            measure("blend");
+        }//end for each
+
+        //剔除  front 时全部三角形在光栅化前被拒绝
+        config.blend = false;
+        config.overdrawLayers = 1;
+        config.triangleArea = 4.0f;
+        config.gridTriangles = std::min(100000u , gridCells());
+        for(const char *cull : {"none" , "back" , "front"}){
+            config.cullMode = cull;
+            measure("cull");
+        }//end for each
+
+        vkDeviceWaitIdle(device);
+        destroyGraphicsPipeline();
+        config = savedConfig;
+        createGraphicsPipeline();
+        populateInstances(config.instanceCount);
     }
 
-    //create vulkan instance
-    void createInstance(){
-        std::cout << "create vulkan instance " << std::endl;
-        //std::cout << "checkValidationLayerSupport " << checkValidationLayerSupport() << std::endl;
-        if(enableValidateLayers && !checkValidationLayerSupport()){
-            throw std::runtime_error("validate layer request but not available!");
-        }
+    //每次绘制参数的两条提交路径  每帧 drawCount 次绘制 片元开销可以忽略
+    //push constant 只测试放得进 push constant 范围的数据大小
+    void benchmarkPerDraw(){
+        const int frameCount = 300;
+        const uint32_t drawCount = 2000;
+        const AppConfig savedConfig = config;
+        config.overdrawLayers = drawCount;
+        config.shadingIterations = 0;
+        config.depthPrepass = false;
+        vkDeviceWaitIdle(device);
+        populateInstances(0);
 
-        getRequiredExtensions();
+        const uint32_t payloadSizes[] = {static_cast<uint32_t>(sizeof(DrawParams)) , 128 , 512};
+        for(uint32_t payloadBytes : payloadSizes){
+            for(const char *strategy : {"push" , "uniform"}){
+                if(perDrawStrategyFromName(strategy) == PER_DRAW_PUSH_CONSTANTS && payloadBytes > perDraw.pushConstantLimit()){
+                    continue;
+                }
+                vkDeviceWaitIdle(device);
+                destroyGraphicsPipeline();
+                config.perDraw = strategy;
+                scenePayloadBytes = payloadBytes;
+                createGraphicsPipeline();
+
+                for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ; i++){
+                    drawFrame();
+                }//end for i
+
+                recordNanos = 0;
+                const uint64_t start = currentTimeNanos();
+                for(int i = 0 ; i < frameCount ; i++){
+                    drawFrame();
+                }//end for i
+                vkDeviceWaitIdle(device);
+                const double seconds = (currentTimeNanos() - start) / 1e9;
+
+                std::cout << "benchmark perdraw " << strategy
+                    << " payload : " << payloadBytes << " bytes"
+                    << " draws : " << drawCount
+                    << " record : " << static_cast<double>(recordNanos) / frameCount / drawCount << " ns/draw"
+                    << " draws/s : " << (seconds > 0.0 ? drawCount * frameCount / seconds : 0.0)
+                    << (enableValidateLayers ? " (validation layers enabled)" : "") << std::endl;
+            }//end for each
+        }//end for each
 
-        VkApplicationInfo appInfo = {};
-        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-        appInfo.pApplicationName = "HelloTriangle";
-        appInfo.applicationVersion = VK_MAKE_VERSION(1,0,0);
-        appInfo.pEngineName = "NoEngine";
-        appInfo.apiVersion = VK_API_VERSION_1_0;
-        appInfo.engineVersion = VK_MAKE_VERSION(1, 0 , 0);
+        vkDeviceWaitIdle(device);
+        destroyGraphicsPipeline();
+        config = savedConfig;
+        scenePayloadBytes = sizeof(DrawParams);
+        createGraphicsPipeline();
+        populateInstances(config.instanceCount);
+    }
 
-        VkInstanceCreateInfo createInfo = {};
-        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-        createInfo.pApplicationInfo = &appInfo;
+    //渲染队列的排序耗时与状态切换次数  随机的 (管线 , 材质 , 顶点输入 , 深度) 组合  不录制
+    //对比 std::sort  单线程基数排序  多线程基数排序
+    void benchmarkRenderQueue(){
+        const uint32_t pipelineCount = 16;
+        const uint32_t materialCount = 256;
+        const uint32_t vertexInputCount = 4;
+        const int rounds = 5;
+        const uint32_t threads = std::max(1u , std::thread::hardware_concurrency());
+
+        for(uint32_t count = 1000 ; count <= 1000000 ; count *= 10){
+            RenderQueue queue;
+            std::vector<RadixSorter::Item> items(count);
+            for(uint32_t i = 0 ; i < count ; i++){
+                uint32_t hash = i * 2654435761u;
+                hash ^= hash >> 15;
+                hash *= 2246822519u;
+                hash ^= hash >> 13;
+
+                DrawPacket packet = {};
+                packet.pipeline = static_cast<uint16_t>(hash % pipelineCount);
+                packet.material = static_cast<uint16_t>((hash >> 8) % materialCount);
+                packet.vertexInput = static_cast<uint16_t>((hash >> 16) % vertexInputCount);
+                packet.vertexCount = 3;
+                packet.instanceCount = 1;
+                const float depth = static_cast<float>(hash & 0xFFFF) / 65535.0f;
+                packet.key = makeRenderKey(QUEUE_PASS_OPAQUE , packet.pipeline , packet.material , depth);
+                queue.push(packet);
+                items[i] = {packet.key , i};
+            }//end for i
+            const RenderStateCounters unsorted = queue.countStateChanges();
+
+            //每轮取最小值
+            auto measure = [&](auto sortOnce) -> double {
+                double best = 1e30;
+                for(int round = 0 ; round < rounds ; round++){
+                    const uint64_t start = currentTimeNanos();
+                    sortOnce();
+                    best = std::min(best , (currentTimeNanos() - start) / 1000.0);
+                }//end for round
+                return best;
+            };
+            const double stdUs = measure([&](){
+                std::vector<RadixSorter::Item> copy = items;
+                std::sort(copy.begin() , copy.end() , [](const RadixSorter::Item &a , const RadixSorter::Item &b){
+                    return a.key < b.key;
+                });
+            });
+            const double singleUs = measure([&](){ queue.sort(1); });
+            const double parallelUs = measure([&](){ queue.sort(threads); });
+            const RenderStateCounters sorted = queue.countStateChanges();
+
+            std::cout << "benchmark sort packets : " << count
+                << " std::sort : " << stdUs << " us"
+                << " radix : " << singleUs << " us"
+                << " radix x" << threads << " : " << parallelUs << " us"
+                << " state changes unsorted : " << unsorted.total()
+                << " (pipeline " << unsorted.pipelineBinds << " descriptor " << unsorted.descriptorBinds
+                << " vertex " << unsorted.vertexBufferBinds << ")"
+                << " sorted : " << sorted.total()
+                << " (pipeline " << sorted.pipelineBinds << " descriptor " << sorted.descriptorBinds
+                << " vertex " << sorted.vertexBufferBinds << ")" << std::endl;
+        }//end for count
+    }
 
-        //注入扩展层配置
-        auto extensions = getRequiredExtensions();
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-        createInfo.ppEnabledExtensionNames = extensions.data();
+    //Vulkan 调用的 CPU 开销  --bench=api  结果同时加入 benchmarkReport (--bench-json)
+    //录制类的测试只录制不提交  提交与 fence 的测试提交空的指令缓存
+    //全部经过分发表直接调用  开启验证层时结果无参考意义
+    void benchmarkApi(){
+        const uint32_t submitBatch = 16;
+        VkCommandPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolCreateInfo.queueFamilyIndex = findQueueFamilies(physicalDevice).graphicsIndex;
+        poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        VkCommandPool benchPool;
+        if(vkCreateCommandPool(device , &poolCreateInfo , allocator(VK_OBJECT_TYPE_COMMAND_POOL) , &benchPool) != VK_SUCCESS){
+            throw std::runtime_error("failed create benchmark command pool !");
+        }
 
-        //注入验证层
-        VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo = {};
-        if(enableValidateLayers){
-            createInfo.enabledLayerCount = static_cast<uint32_t>(validateLayers.size());
-            createInfo.ppEnabledLayerNames = validateLayers.data();
+        VkCommandBufferAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = benchPool;
+        allocateInfo.commandBufferCount = submitBatch;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
-            populateDebugMessengerCreateInfo(debugCreateInfo);
-            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debugCreateInfo;
-        }else{
-            createInfo.enabledLayerCount = 0;
-            createInfo.pNext = nullptr;
+        std::vector<VkCommandBuffer> cmds(submitBatch);
+        if(vkAllocateCommandBuffers(device , &allocateInfo , cmds.data()) != VK_SUCCESS){
+            throw std::runtime_error("failed create benchmark command buffer");
         }
 
-        if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create instance!");
+        vkDeviceWaitIdle(device);
+        benchmarkApiDraws(benchPool , cmds[0]);
+        benchmarkApiPipelineBinds(benchPool , cmds[0]);
+        benchmarkApiDescriptors(benchPool , cmds[0]);
+        benchmarkApiSubmit(benchPool , cmds);
+        benchmarkApiFences(benchPool , cmds[0]);
+        benchmarkApiMemory();
+        if(enableValidateLayers){
+            std::cout << "benchmark api : validation layers enabled , results are not representative" << std::endl;
         }
-        std::cout << "create instance success" << std::endl;
+
+        vkDestroyCommandPool(device , benchPool , allocator(VK_OBJECT_TYPE_COMMAND_POOL));
     }
 
-    void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &debugCreateInfo){
-        debugCreateInfo = {};
+    //在渲染范围内录制 多轮取最小值  setup 不计时  返回 body 中每次调用的平均耗时 (ns)
+    template<typename Setup , typename Body>
+    double measureRecording(VkCommandPool pool , VkCommandBuffer cmd , uint32_t calls , Setup setup , Body body){
+        const int rounds = 10;
+        double best = 1e30;
+        for(int round = 0 ; round < rounds ; round++){
+            vkd.vkResetCommandPool(device , pool , 0);
 
-        debugCreateInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-        debugCreateInfo.messageSeverity = 
-            VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT 
-            |VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT
-            |VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-        debugCreateInfo.messageType = 
-            VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT 
-            |VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT
-            |VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-        
-        debugCreateInfo.pfnUserCallback = debugCallback;
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkd.vkBeginCommandBuffer(cmd , &beginInfo);
+            beginBenchmarkRendering(cmd);
+            setup(cmd);
+
+            const uint64_t start = currentTimeNanos();
+            body(cmd);
+            const uint64_t elapsed = currentTimeNanos() - start;
+
+            endBenchmarkRendering(cmd);
+            vkd.vkEndCommandBuffer(cmd);
+            best = std::min(best , static_cast<double>(elapsed) / calls);
+        }//end for round
+        return best;
     }
 
-    std::vector<const char*> getRequiredExtensions(){
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
+    //基准测试用的主机可见 buffer
+    void createBenchmarkBuffer(VkDeviceSize size , VkBufferUsageFlags usage , VkBuffer &buffer , VkDeviceMemory &memory){
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = size;
+        bufferCreateInfo.usage = usage;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if(vkCreateBuffer(device , &bufferCreateInfo , allocator(VK_OBJECT_TYPE_BUFFER) , &buffer) != VK_SUCCESS){
+            throw std::runtime_error("failed to create benchmark buffer!");
+        }
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device , buffer , &requirements);
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = findMemoryType(memoryProperties , requirements.memoryTypeBits ,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if(vkAllocateMemory(device , &allocateInfo , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY) , &memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate benchmark buffer memory!");
+        }
+        vkBindBufferMemory(device , buffer , memory , 0);
+    }
 
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-        std::vector<const char*> extensions(glfwExtensions , glfwExtensions + glfwExtensionCount);
+    void destroyBenchmarkBuffer(VkBuffer buffer , VkDeviceMemory memory){
+        vkDestroyBuffer(device , buffer , allocator(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(device , memory , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
 
-        if(enableValidateLayers){
-            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-        }
-        return extensions;
+    //场景管线与每次绘制参数  录制绘制前的状态
+    void bindBenchmarkScene(VkCommandBuffer cmd){
+        vkd.vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , graphicsPipeline);
+        perDraw.bindFrame(cmd);
+        DrawParams params = {{0.0f , 0.0f , depthBuffer.depthValue(0.5f) , 1.0f} , 0 , 0};
+        vkd.vkCmdPushConstants(cmd , perDraw.pipelineLayout , VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT ,
+            0 , sizeof(DrawParams) , &params);
     }
-    
 
-    //检查验证层的支持
-    bool checkValidationLayerSupport(){
-        uint32_t layerCount = 0;
+    //vkCmdDraw 与 vkCmdDrawIndexed 的录制耗时
+    void benchmarkApiDraws(VkCommandPool pool , VkCommandBuffer cmd){
+        const uint32_t drawCount = 100000;
+        VkBuffer indexBuffer;
+        VkDeviceMemory indexMemory;
+        createBenchmarkBuffer(sizeof(uint16_t) * 4 , VK_BUFFER_USAGE_INDEX_BUFFER_BIT , indexBuffer , indexMemory);
+        void *mapped = nullptr;
+        vkMapMemory(device , indexMemory , 0 , VK_WHOLE_SIZE , 0 , &mapped);
+        const uint16_t indices[4] = {0 , 1 , 2 , 0};
+        std::memcpy(mapped , indices , sizeof(indices));
+        vkUnmapMemory(device , indexMemory);
+
+        auto setup = [this](VkCommandBuffer cmd){
+            bindBenchmarkScene(cmd);
+        };
+        const double drawNs = measureRecording(pool , cmd , drawCount , setup , [this , drawCount](VkCommandBuffer cmd){
+            for(uint32_t i = 0 ; i < drawCount ; i++){
+                vkd.vkCmdDraw(cmd , 3 , 1 , 0 , 0);
+            }//end for i
+        });
+        const double indexedNs = measureRecording(pool , cmd , drawCount , [this , indexBuffer](VkCommandBuffer cmd){
+            bindBenchmarkScene(cmd);
+            vkd.vkCmdBindIndexBuffer(cmd , indexBuffer , 0 , VK_INDEX_TYPE_UINT16);
+        } , [this , drawCount](VkCommandBuffer cmd){
+            for(uint32_t i = 0 ; i < drawCount ; i++){
+                vkd.vkCmdDrawIndexed(cmd , 3 , 1 , 0 , 0 , 0);
+            }//end for i
+        });
+        destroyBenchmarkBuffer(indexBuffer , indexMemory);
+
+        std::cout << "benchmark api draw : " << drawNs << " ns/call"
+            << " draw indexed : " << indexedNs << " ns/call" << std::endl;
+        benchmarkReport.add("api.draw").param("variant" , "draw")
+            .metric("ns_per_call" , drawNs).metric("calls_per_second" , drawNs > 0.0 ? 1e9 / drawNs : 0.0);
+        benchmarkReport.add("api.draw").param("variant" , "draw_indexed")
+            .metric("ns_per_call" , indexedNs).metric("calls_per_second" , indexedNs > 0.0 ? 1e9 / indexedNs : 0.0);
+    }
 
-        vkEnumerateInstanceLayerProperties(&layerCount , nullptr);
-        //std::cout << "validate layer count = " << layerCount << std::endl;
+    //管线绑定的开销  每次绑定后绘制一次 (驱动通常在绘制时才提交状态)
+    //same: 每次绑定同一条管线  alternate: 两条管线交替  减去只绘制的耗时得到绑定本身的开销
+    void benchmarkApiPipelineBinds(VkCommandPool pool , VkCommandBuffer cmd){
+        const uint32_t bindCount = 20000;
+        const bool savedPrepass = config.depthPrepass;
+        destroyGraphicsPipeline();
+        config.depthPrepass = true;
+        createGraphicsPipeline();
+        const VkPipeline pipelines[2] = {graphicsPipeline , depthPrepassPipeline};
 
-        std::vector<VkLayerProperties> availableLayers(layerCount);
-        VkResult result = vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
-        //std::cout << "vkEnumerateInstanceLayerProperties result = " << result << std::endl;
-        
-        // std::cout << "layer properties:" << std::endl;
-        // for(int i = 0 ; i < layerCount ;i++){
-        //     std::cout << '\t' << availableLayers[i].layerName << std::endl;
-        // }//end for i
+        auto setup = [this](VkCommandBuffer cmd){
+            bindBenchmarkScene(cmd);
+        };
+        const double drawOnlyNs = measureRecording(pool , cmd , bindCount , setup , [this , bindCount](VkCommandBuffer cmd){
+            for(uint32_t i = 0 ; i < bindCount ; i++){
+                vkd.vkCmdDraw(cmd , 3 , 1 , 0 , 0);
+            }//end for i
+        });
+        const double sameNs = measureRecording(pool , cmd , bindCount , setup , [this , bindCount , &pipelines](VkCommandBuffer cmd){
+            for(uint32_t i = 0 ; i < bindCount ; i++){
+                vkd.vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , pipelines[0]);
+                vkd.vkCmdDraw(cmd , 3 , 1 , 0 , 0);
+            }//end for i
+        });
+        const double alternateNs = measureRecording(pool , cmd , bindCount , setup , [this , bindCount , &pipelines](VkCommandBuffer cmd){
+            for(uint32_t i = 0 ; i < bindCount ; i++){
+                vkd.vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , pipelines[i & 1]);
+                vkd.vkCmdDraw(cmd , 3 , 1 , 0 , 0);
+            }//end for i
+        });
 
-        for(const std::string &layer : validateLayers){
-            bool layoutFound = false;
+        vkDeviceWaitIdle(device);
+        destroyGraphicsPipeline();
+        config.depthPrepass = savedPrepass;
+        createGraphicsPipeline();
 
-            for(VkLayerProperties &vkLayout : availableLayers){
-                std::string vkLayerName = vkLayout.layerName;
-                //std::cout << "compare = " << layer << " with " << vkLayerName << std::endl;
-                if(layer == vkLayerName){
-                    layoutFound = true;
-                    break;
-                }
-            }
+        std::cout << "benchmark api pipeline bind same : " << sameNs - drawOnlyNs << " ns/bind"
+            << " alternate : " << alternateNs - drawOnlyNs << " ns/bind"
+            << " (draw only : " << drawOnlyNs << " ns)" << std::endl;
+        benchmarkReport.add("api.pipeline_bind").param("variant" , "same")
+            .metric("ns_per_bind" , sameNs - drawOnlyNs).metric("ns_per_bind_and_draw" , sameNs);
+        benchmarkReport.add("api.pipeline_bind").param("variant" , "alternate")
+            .metric("ns_per_bind" , alternateNs - drawOnlyNs).metric("ns_per_bind_and_draw" , alternateNs);
+    }
 
-            if(!layoutFound){
-                std::cout << "Not found validate " << layer << std::endl;
-                return false;
+    //每次绘制换一组描述符 (3 个 storage buffer)
+    //update: 从每帧池分配 + vkUpdateDescriptorSets + 绑定  template: 分配 + 更新模板 + 绑定  push: vkCmdPushDescriptorSetKHR
+    //池的重置不计时
+    void benchmarkApiDescriptors(VkCommandPool pool , VkCommandBuffer cmd){
+        const uint32_t updateCount = 10000;
+        const uint32_t bindingCount = 3;
+        const VkDeviceSize range = 256;//不小于任何设备的 minStorageBufferOffsetAlignment
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+        createBenchmarkBuffer(range * 256 , VK_BUFFER_USAGE_STORAGE_BUFFER_BIT , buffer , memory);
+
+        std::vector<VkDescriptorSetLayoutBinding> bindings(bindingCount);
+        std::vector<VkDescriptorUpdateTemplateEntry> entries;
+        for(uint32_t b = 0 ; b < bindingCount ; b++){
+            bindings[b] = {};
+            bindings[b].binding = b;
+            bindings[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[b].descriptorCount = 1;
+            bindings[b].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+            entries.push_back(DescriptorUpdateTemplate::bufferEntry(b , VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ,
+                b * sizeof(VkDescriptorBufferInfo)));
+        }//end for b
+
+        const bool push = deviceFeatures.has(CAP_PUSH_DESCRIPTOR) && vkd.vkCmdPushDescriptorSetKHR != nullptr;
+        VkDescriptorSetLayout setLayouts[2] = {layoutCache.get(bindings) , VK_NULL_HANDLE};
+        if(push){
+            setLayouts[1] = layoutCache.get(bindings , VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR);
+        }
+        VkPipelineLayout layouts[2] = {VK_NULL_HANDLE , VK_NULL_HANDLE};
+        for(int i = 0 ; i < (push ? 2 : 1) ; i++){
+            VkPipelineLayoutCreateInfo layoutInfo = {};
+            layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layoutInfo.setLayoutCount = 1;
+            layoutInfo.pSetLayouts = &setLayouts[i];
+            if(vkCreatePipelineLayout(device , &layoutInfo , allocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT) , &layouts[i]) != VK_SUCCESS){
+                throw std::runtime_error("failed to create benchmark pipeline layout!");
             }
-        }//end for
+        }//end for i
 
-        return true;
-    }
+        DescriptorAllocator setAllocator;
+        setAllocator.init(device , &vkd , 1 , 1024);
+        DescriptorUpdateTemplate updateTemplate;
+        updateTemplate.create(device , &vkd , setLayouts[0] , entries);
+
+        //第 i 次绘制的描述符 在 buffer 中轮换偏移
+        VkDescriptorBufferInfo infos[bindingCount];
+        VkWriteDescriptorSet writes[bindingCount];
+        auto fill = [&](uint32_t i , VkDescriptorSet set){
+            for(uint32_t b = 0 ; b < bindingCount ; b++){
+                infos[b] = {buffer , ((i * bindingCount + b) % 256) * range , range};
+                writes[b] = {};
+                writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[b].dstSet = set;
+                writes[b].dstBinding = b;
+                writes[b].descriptorCount = 1;
+                writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[b].pBufferInfo = &infos[b];
+            }//end for b
+        };
+        auto resetPool = [&setAllocator](VkCommandBuffer){
+            setAllocator.beginFrame(0);
+        };
 
-    //game loop
-    void mainloop(){
-        while(!glfwWindowShouldClose(window)){
-            glfwPollEvents();
-            drawFrame();
-        }//end while
+        const double updateNs = measureRecording(pool , cmd , updateCount , resetPool , [&](VkCommandBuffer cmd){
+            for(uint32_t i = 0 ; i < updateCount ; i++){
+                VkDescriptorSet set = setAllocator.allocate(0 , setLayouts[0]);
+                fill(i , set);
+                vkd.vkUpdateDescriptorSets(device , bindingCount , writes , 0 , nullptr);
+                vkd.vkCmdBindDescriptorSets(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , layouts[0] , 0 , 1 , &set , 0 , nullptr);
+            }//end for i
+        });
+        const double templateNs = measureRecording(pool , cmd , updateCount , resetPool , [&](VkCommandBuffer cmd){
+            for(uint32_t i = 0 ; i < updateCount ; i++){
+                VkDescriptorSet set = setAllocator.allocate(0 , setLayouts[0]);
+                fill(i , set);
+                updateTemplate.update(set , infos);
+                vkd.vkCmdBindDescriptorSets(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , layouts[0] , 0 , 1 , &set , 0 , nullptr);
+            }//end for i
+        });
+        double pushNs = 0.0;
+        if(push){
+            pushNs = measureRecording(pool , cmd , updateCount , resetPool , [&](VkCommandBuffer cmd){
+                for(uint32_t i = 0 ; i < updateCount ; i++){
+                    fill(i , VK_NULL_HANDLE);
+                    vkd.vkCmdPushDescriptorSetKHR(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , layouts[1] , 0 , bindingCount , writes);
+                }//end for i
+            });
+        }
 
-        vkDeviceWaitIdle(device);
+        updateTemplate.destroy();
+        setAllocator.destroy();
+        for(VkPipelineLayout layout : layouts){
+            if(layout != VK_NULL_HANDLE){
+                vkDestroyPipelineLayout(device , layout , allocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+            }
+        }//end for each
+        destroyBenchmarkBuffer(buffer , memory);
+
+        const char *templatePath = vkd.vkCreateDescriptorUpdateTemplate != nullptr ? "native" : "fallback";
+        std::cout << "benchmark api descriptors (" << bindingCount << " buffers) update : " << updateNs << " ns/set"
+            << " template (" << templatePath << ") : " << templateNs << " ns/set";
+        if(push){
+            std::cout << " push : " << pushNs << " ns/set";
+        }else{
+            std::cout << " push : not supported";
+        }
+        std::cout << std::endl;
+        benchmarkReport.add("api.descriptors").param("variant" , "update").metric("ns_per_set" , updateNs);
+        benchmarkReport.add("api.descriptors").param("variant" , "template").param("path" , templatePath)
+            .metric("ns_per_set" , templateNs);
+        if(push){
+            benchmarkReport.add("api.descriptors").param("variant" , "push").metric("ns_per_set" , pushNs);
+        }
     }
 
-    //渲染一帧图像
-    void drawFrame(){
-        //wait fence
-        vkWaitForFences(device , 1 , &inFlightFences[currentFrame] , VK_TRUE , INT32_MAX);
+    //vkQueueSubmit: 一次提交 1 个指令缓存 / 一次提交 N 个 / N 次提交各 1 个  指令缓存为空
+    //submit 为提交调用本身的耗时  signal 为从提交到 fence 等待返回
+    void benchmarkApiSubmit(VkCommandPool pool , const std::vector<VkCommandBuffer> &cmds){
+        const int rounds = 200;
+        const uint32_t batch = static_cast<uint32_t>(cmds.size());
+        vkd.vkResetCommandPool(device , pool , 0);
+        for(VkCommandBuffer cmd : cmds){
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            vkd.vkBeginCommandBuffer(cmd , &beginInfo);
+            vkd.vkEndCommandBuffer(cmd);
+        }//end for each
 
-        vkResetFences(device , 1 , &inFlightFences[currentFrame]);
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        if(vkCreateFence(device , &fenceInfo , allocator(VK_OBJECT_TYPE_FENCE) , &fence) != VK_SUCCESS){
+            throw std::runtime_error("failed to create benchmark fence!");
+        }
 
-        uint32_t imageIndex;
+        struct Variant{
+            const char *name;
+            uint32_t submits;
+            uint32_t buffersPerSubmit;
+        };
+        const Variant variants[] = {{"1x1" , 1 , 1} , {"1xN" , 1 , batch} , {"Nx1" , batch , 1}};
+        std::cout << "benchmark api submit (N = " << batch << ")";
+        for(const Variant &variant : variants){
+            uint64_t submitNanos = 0;
+            uint64_t signalNanos = 0;
+            for(int round = 0 ; round < rounds ; round++){
+                const uint64_t start = currentTimeNanos();
+                for(uint32_t s = 0 ; s < variant.submits ; s++){
+                    VkSubmitInfo submitInfo = {};
+                    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                    submitInfo.commandBufferCount = variant.buffersPerSubmit;
+                    submitInfo.pCommandBuffers = &cmds[s];
+                    const bool last = s + 1 == variant.submits;
+                    if(vkd.vkQueueSubmit(graphicsQueue , 1 , &submitInfo , last ? fence : VK_NULL_HANDLE) != VK_SUCCESS){
+                        throw std::runtime_error("failed to submit benchmark command buffer!");
+                    }
+                }//end for s
+                const uint64_t submitted = currentTimeNanos();
+                vkd.vkWaitForFences(device , 1 , &fence , VK_TRUE , UINT64_MAX);
+                const uint64_t signaled = currentTimeNanos();
+                vkd.vkResetFences(device , 1 , &fence);
+                submitNanos += submitted - start;
+                signalNanos += signaled - start;
+            }//end for round
+            const double submitUs = submitNanos / 1000.0 / rounds;
+            const double signalUs = signalNanos / 1000.0 / rounds;
+            const uint32_t buffers = variant.submits * variant.buffersPerSubmit;
+            std::cout << " " << variant.name << " submit : " << submitUs << " us signal : " << signalUs << " us";
+            benchmarkReport.add("api.submit").param("variant" , variant.name)
+                .metric("command_buffers" , buffers)
+                .metric("submit_us" , submitUs)
+                .metric("submit_us_per_command_buffer" , submitUs / buffers)
+                .metric("submit_to_signal_us" , signalUs);
+        }//end for each
+        std::cout << std::endl;
 
-        vkAcquireNextImageKHR(device , swapChain , UINT64_MAX , 
-            imageAvailableSemaphores[currentFrame] , VK_NULL_HANDLE , &imageIndex);
+        vkDestroyFence(device , fence , allocator(VK_OBJECT_TYPE_FENCE));
+    }
 
-        //std::cout << "imageIndex = " << imageIndex << std::endl;
+    //fence: 提交空指令缓存后等待返回的延迟  vkResetFences  已触发的 fence 上 vkGetFenceStatus 与 vkWaitForFences
+    void benchmarkApiFences(VkCommandPool pool , VkCommandBuffer cmd){
+        const int rounds = 1000;
+        vkd.vkResetCommandPool(device , pool , 0);
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vkd.vkBeginCommandBuffer(cmd , &beginInfo);
+        vkd.vkEndCommandBuffer(cmd);
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        if(vkCreateFence(device , &fenceInfo , allocator(VK_OBJECT_TYPE_FENCE) , &fence) != VK_SUCCESS){
+            throw std::runtime_error("failed to create benchmark fence!");
+        }
 
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmd;
+
+        uint64_t waitNanos = 0;
+        uint64_t minWaitNanos = UINT64_MAX;
+        uint64_t statusNanos = 0;
+        uint64_t signaledWaitNanos = 0;
+        uint64_t resetNanos = 0;
+        for(int round = 0 ; round < rounds ; round++){
+            vkd.vkQueueSubmit(graphicsQueue , 1 , &submitInfo , fence);
+            uint64_t start = currentTimeNanos();
+            vkd.vkWaitForFences(device , 1 , &fence , VK_TRUE , UINT64_MAX);
+            const uint64_t wait = currentTimeNanos() - start;
+            waitNanos += wait;
+            minWaitNanos = std::min(minWaitNanos , wait);
+
+            start = currentTimeNanos();
+            vkd.vkGetFenceStatus(device , fence);
+            statusNanos += currentTimeNanos() - start;
+
+            start = currentTimeNanos();
+            vkd.vkWaitForFences(device , 1 , &fence , VK_TRUE , 0);
+            signaledWaitNanos += currentTimeNanos() - start;
+
+            start = currentTimeNanos();
+            vkd.vkResetFences(device , 1 , &fence);
+            resetNanos += currentTimeNanos() - start;
+        }//end for round
+        vkDestroyFence(device , fence , allocator(VK_OBJECT_TYPE_FENCE));
+
+        const double waitUs = waitNanos / 1000.0 / rounds;
+        std::cout << "benchmark api fence wait : " << waitUs << " us (min " << minWaitNanos / 1000.0 << " us)"
+            << " reset : " << static_cast<double>(resetNanos) / rounds << " ns"
+            << " status : " << static_cast<double>(statusNanos) / rounds << " ns"
+            << " wait signaled : " << static_cast<double>(signaledWaitNanos) / rounds << " ns" << std::endl;
+        benchmarkReport.add("api.fence")
+            .metric("wait_us" , waitUs)
+            .metric("wait_min_us" , minWaitNanos / 1000.0)
+            .metric("reset_ns" , static_cast<double>(resetNanos) / rounds)
+            .metric("status_ns" , static_cast<double>(statusNanos) / rounds)
+            .metric("wait_signaled_ns" , static_cast<double>(signaledWaitNanos) / rounds);
+    }
 
-        VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    //bufferCount 个 buffer 的设备内存  每个单独 vkAllocateMemory  与 一次分配后按对齐偏移绑定 (子分配)
+    //buffer 的创建与销毁不计时 (每轮重新创建 buffer 只能绑定一次)
+    void benchmarkApiMemory(){
+        const uint32_t bufferCount = 256;
+        const VkDeviceSize bufferSize = 64 * 1024;
+        const int rounds = 5;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+
+        std::vector<VkBuffer> buffers(bufferCount);
+        std::vector<VkDeviceMemory> memories(bufferCount);
+        VkMemoryRequirements requirements = {};
+        auto createBuffers = [&](){
+            VkBufferCreateInfo bufferCreateInfo = {};
+            bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferCreateInfo.size = bufferSize;
+            bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            for(VkBuffer &buffer : buffers){
+                if(vkCreateBuffer(device , &bufferCreateInfo , allocator(VK_OBJECT_TYPE_BUFFER) , &buffer) != VK_SUCCESS){
+                    throw std::runtime_error("failed to create benchmark buffer!");
+                }
+            }//end for each
+            vkGetBufferMemoryRequirements(device , buffers[0] , &requirements);
+        };
+        auto destroyBuffers = [&](){
+            for(VkBuffer buffer : buffers){
+                vkDestroyBuffer(device , buffer , allocator(VK_OBJECT_TYPE_BUFFER));
+            }//end for each
+        };
 
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
+        uint64_t dedicatedAllocNanos = 0;
+        uint64_t dedicatedFreeNanos = 0;
+        uint64_t subAllocNanos = 0;
+        uint64_t subFreeNanos = 0;
+        for(int round = 0 ; round < rounds ; round++){
+            createBuffers();
+            VkMemoryAllocateInfo allocateInfo = {};
+            allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocateInfo.allocationSize = requirements.size;
+            allocateInfo.memoryTypeIndex = findMemoryType(memoryProperties , requirements.memoryTypeBits ,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            uint64_t start = currentTimeNanos();
+            for(uint32_t i = 0 ; i < bufferCount ; i++){
+                if(vkAllocateMemory(device , &allocateInfo , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY) , &memories[i]) != VK_SUCCESS){
+                    throw std::runtime_error("failed to allocate benchmark memory!");
+                }
+                vkBindBufferMemory(device , buffers[i] , memories[i] , 0);
+            }//end for i
+            dedicatedAllocNanos += currentTimeNanos() - start;
+            destroyBuffers();
+            start = currentTimeNanos();
+            for(VkDeviceMemory memory : memories){
+                vkFreeMemory(device , memory , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY));
+            }//end for each
+            dedicatedFreeNanos += currentTimeNanos() - start;
+
+            createBuffers();
+            const VkDeviceSize stride = alignUp(requirements.size , requirements.alignment);
+            allocateInfo.allocationSize = stride * bufferCount;
+            VkDeviceMemory block;
+            start = currentTimeNanos();
+            if(vkAllocateMemory(device , &allocateInfo , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY) , &block) != VK_SUCCESS){
+                throw std::runtime_error("failed to allocate benchmark memory!");
+            }
+            for(uint32_t i = 0 ; i < bufferCount ; i++){
+                vkBindBufferMemory(device , buffers[i] , block , stride * i);
+            }//end for i
+            subAllocNanos += currentTimeNanos() - start;
+            destroyBuffers();
+            start = currentTimeNanos();
+            vkFreeMemory(device , block , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY));
+            subFreeNanos += currentTimeNanos() - start;
+        }//end for round
+
+        const double perBuffer = 1000.0 * rounds * bufferCount;
+        std::cout << "benchmark api memory (" << bufferCount << " x " << (bufferSize >> 10) << " KB)"
+            << " vkAllocateMemory : " << dedicatedAllocNanos / perBuffer << " us/buffer"
+            << " free : " << dedicatedFreeNanos / perBuffer << " us/buffer"
+            << " sub-allocation : " << subAllocNanos / perBuffer << " us/buffer"
+            << " free : " << subFreeNanos / perBuffer << " us/buffer" << std::endl;
+        benchmarkReport.add("api.memory").param("variant" , "dedicated")
+            .metric("buffers" , bufferCount).metric("buffer_bytes" , static_cast<double>(bufferSize))
+            .metric("alloc_us_per_buffer" , dedicatedAllocNanos / perBuffer)
+            .metric("free_us_per_buffer" , dedicatedFreeNanos / perBuffer);
+        benchmarkReport.add("api.memory").param("variant" , "suballocated")
+            .metric("buffers" , bufferCount).metric("buffer_bytes" , static_cast<double>(bufferSize))
+            .metric("alloc_us_per_buffer" , subAllocNanos / perBuffer)
+            .metric("free_us_per_buffer" , subFreeNanos / perBuffer);
+    }
 
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &cmdBuffers[imageIndex];
+    //每种采样数的附件内存与平均帧时间
+    void benchmarkMsaa(){
+        const int frameCount = 300;
+        const uint32_t savedSamples = config.msaaSamples;
+        const VkSampleCountFlags supported = supportedSampleCounts();
 
-        VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = signalSemaphores;
+        for(uint32_t samples = 1 ; samples <= 8 ; samples <<= 1){
+            if(!(supported & samples)){
+                continue;
+            }
+            config.msaaSamples = samples;
+            applyRenderConfig();
+
+            for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ; i++){
+                drawFrame();
+            }//end for i
+
+            const uint64_t start = currentTimeNanos();
+            for(int i = 0 ; i < frameCount ; i++){
+                drawFrame();
+            }//end for i
+            vkDeviceWaitIdle(device);
+            const double frameUs = (currentTimeNanos() - start) / 1000.0 / frameCount;
+
+            //深度与多重采样颜色是帧图的临时图像  统计的是一个飞行帧的
+            const VkDeviceSize allocated = depthBuffer.memorySize + renderGraph.stats.transientAllocated;
+            const VkDeviceSize committed = depthBuffer.committedSize() + renderGraph.transientCommittedSize();
+            std::cout << "benchmark msaa samples : " << samples
+                << " attachment memory : " << (allocated >> 10) << " KB"
+                << " committed : " << (committed >> 10) << " KB"
+                << (renderGraph.stats.transientLazy > 0 ? " (lazily allocated)" : "")
+                << " frame : " << frameUs << " us" << std::endl;
+        }//end for samples
+
+        config.msaaSamples = savedSamples;
+        applyRenderConfig();
+    }
 
-        if(vkQueueSubmit(graphicsQueue , 1 , &submitInfo , inFlightFences[currentFrame]) != VK_SUCCESS){
-            throw std::runtime_error("fail to submit draw command buffer!");
-        }
+    //实例数从 1 到 1M  每帧重写全部实例流
+    void benchmarkInstancing(){
+        const int frameCount = 100;
+        const uint32_t savedCount = config.instanceCount;
+
+        for(uint32_t count = 1 ; count <= 1000000 ; count *= 10){
+            vkDeviceWaitIdle(device);
+            populateInstances(count);
+
+            for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ; i++){
+                drawFrame();
+            }//end for i
+
+            instanceBuildNanos = 0;
+            const uint64_t start = currentTimeNanos();
+            for(int i = 0 ; i < frameCount ; i++){
+                drawFrame();
+            }//end for i
+            vkDeviceWaitIdle(device);
+            const double frameUs = (currentTimeNanos() - start) / 1000.0 / frameCount;
+            const double buildUs = instanceBuildNanos / 1000.0 / frameCount;
+
+            std::cout << "benchmark instancing instances : " << count
+                << " batches : " << instanceRenderer.stats.batches
+                << " pipeline binds : " << instanceQueue.counters.pipelineBinds
+                << " build : " << buildUs << " us"
+                << " frame : " << frameUs << " us"
+                << " instances/s : " << static_cast<uint64_t>(count / (frameUs / 1000000.0)) << std::endl;
+        }//end for count
 
-        VkPresentInfoKHR presentInfo = {};
-        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        vkDeviceWaitIdle(device);
+        populateInstances(savedCount);
+    }
 
-        presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = signalSemaphores;
+    //CPU剔除与GPU剔除 录制耗时随物体数的变化
+    void benchmarkCulling(){
+        const int frameCount = 100;
+        const std::string savedCulling = config.culling;
+        const uint32_t savedCount = config.instanceCount;
 
-        VkSwapchainKHR swapChains[] = {swapChain};
-        presentInfo.swapchainCount = 1;
-        presentInfo.pSwapchains = swapChains;
-        presentInfo.pImageIndices = &imageIndex;
+        std::vector<std::string> modes = {"cpu"};
+        if(gpuScene.gpuCullingAvailable()){
+            modes.push_back("gpu");
+        }
 
-        presentInfo.pResults = nullptr;
+        for(const std::string &mode : modes){
+            config.culling = mode;
+            chooseCulling();
+            if(config.culling == "off"){
+                break;
+            }
 
-        vkQueuePresentKHR(presentQueue , &presentInfo);
+            for(uint32_t count = 1000 ; count <= 1000000 ; count *= 10){
+                vkDeviceWaitIdle(device);
+                populateInstances(count);
+
+                for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT ; i++){
+                    drawFrame();
+                }//end for i
+
+                recordNanos = 0;
+                gpuProfiler.clearStats();
+                const uint64_t start = currentTimeNanos();
+                for(int i = 0 ; i < frameCount ; i++){
+                    drawFrame();
+                }//end for i
+                vkDeviceWaitIdle(device);
+                const double frameUs = (currentTimeNanos() - start) / 1000.0 / frameCount;
+                const double recordUs = recordNanos / 1000.0 / frameCount;
+
+                const uint32_t visible = gpuScene.visibleCount((currentFrame + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT);
+                std::cout << "benchmark culling " << mode
+                    << " objects : " << count
+                    << " visible : " << visible
+                    << " draw calls : " << gpuScene.stats.drawCalls
+                    << " record : " << recordUs << " us"
+                    << " frame : " << frameUs << " us";
+                BenchmarkResult &result = benchmarkReport.add("culling")
+                    .param("mode" , mode)
+                    .param("objects" , std::to_string(count))
+                    .metric("visible" , visible)
+                    .metric("draw_calls" , gpuScene.stats.drawCalls)
+                    .metric("record_us" , recordUs)
+                    .metric("frame_us" , frameUs);
+                printPassStatistics(&result);
+                std::cout << std::endl;
+            }//end for count
+        }//end for each
 
-        //效率较低 会使GPU长期处于闲置状态
-        //vkQueueWaitIdle(presentQueue);
+        vkDeviceWaitIdle(device);
+        config.culling = savedCulling;
+        config.instanceCount = savedCount;
+        chooseCulling();
+        populateInstances(savedCount);
+    }
 
-        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-        // std::cout << "currentFrame = " << currentFrame << std::endl;
+    //销毁与渲染路径相关的对象 renderPass / framebuffer / pipeline
+    void destroyRenderPathObjects(){
+        for(CachedFramebuffer &cached : swapChainFramebuffers){
+            vkDestroyFramebuffer(device , cached.framebuffer , allocator(VK_OBJECT_TYPE_FRAMEBUFFER));
+        }//end for each
+        swapChainFramebuffers.clear();
+
+        destroyGraphicsPipeline();
+        vkDestroyRenderPass(device , renderPass , allocator(VK_OBJECT_TYPE_RENDER_PASS));
+        vkDestroyRenderPass(device , renderPassLoad , allocator(VK_OBJECT_TYPE_RENDER_PASS));
+        renderPass = VK_NULL_HANDLE;
+        renderPassLoad = VK_NULL_HANDLE;
+    }
+
+    void destroyGraphicsPipeline(){
+        vkDestroyPipeline(device , graphicsPipeline , allocator(VK_OBJECT_TYPE_PIPELINE));
+        vkDestroyPipeline(device , depthPrepassPipeline , allocator(VK_OBJECT_TYPE_PIPELINE));
+        for(VkPipeline pipeline : instancedPipelines){
+            vkDestroyPipeline(device , pipeline , allocator(VK_OBJECT_TYPE_PIPELINE));
+        }//end for each
+        vkDestroyPipeline(device , instancedDepthPipeline , allocator(VK_OBJECT_TYPE_PIPELINE));
+        vkDestroyPipelineLayout(device , pipelineLayout , allocator(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        graphicsPipeline = VK_NULL_HANDLE;
+        depthPrepassPipeline = VK_NULL_HANDLE;
+        instancedPipelines.clear();
+        instancedDepthPipeline = VK_NULL_HANDLE;
     }
 
     //清理资源
     void cleanup(){
+        CPU_TRACE_FUNCTION();
         for(int i = 0 ; i < MAX_FRAMES_IN_FLIGHT  ;i++){
-            vkDestroySemaphore(device , imageAvailableSemaphores[i] , nullptr);
-            vkDestroySemaphore(device , renderFinishedSemaphores[i] , nullptr);
+            vkDestroySemaphore(device , imageAvailableSemaphores[i] , allocator(VK_OBJECT_TYPE_SEMAPHORE));
+            vkDestroySemaphore(device , renderFinishedSemaphores[i] , allocator(VK_OBJECT_TYPE_SEMAPHORE));
+            vkDestroySemaphore(device , asyncFinishedSemaphores[i] , allocator(VK_OBJECT_TYPE_SEMAPHORE));
 
-            vkDestroyFence(device , inFlightFences[i] , nullptr);
+            vkDestroyFence(device , inFlightFences[i] , allocator(VK_OBJECT_TYPE_FENCE));
         }
 
-        vkDestroyCommandPool(device , cmdPool , nullptr);
-
-        for(VkFramebuffer &framebuffer : swapChainFramebuffers){
-            vkDestroyFramebuffer(device ,framebuffer , nullptr);
-        }//end for each
+        vkDestroyCommandPool(device , cmdPool , allocator(VK_OBJECT_TYPE_COMMAND_POOL));
+        vkDestroyCommandPool(device , computeCmdPool , allocator(VK_OBJECT_TYPE_COMMAND_POOL));
 
-        vkDestroyPipeline(device , graphicsPipeline , nullptr);
-        vkDestroyPipelineLayout(device , pipelineLayout , nullptr);
-        vkDestroyRenderPass(device , renderPass , nullptr);
+        //设备已空闲 读回最后几帧的结果
+        for(uint32_t frame = 0 ; frame < MAX_FRAMES_IN_FLIGHT ; frame++){
+            gpuProfiler.collect(frame);
+        }//end for frame
+        if(!config.traceFile.empty()){
+            gpuProfiler.writeTrace(config.traceFile);
+        }
+        gpuProfiler.destroy();
+        frameReadback.destroy();
+
+        renderGraph.destroy();
+        instanceRenderer.destroy();
+        gpuScene.destroy();
+        frameDescriptors.destroy();
+        layoutCache.destroy();
+        destroyRenderPathObjects();
+        perDraw.destroy();
+        destroyRenderTargets();
+        destroyBindlessResources();
 
         for(VkImageView &imageView : swapChainImageViews){
-            vkDestroyImageView(device , imageView , nullptr);
+            vkDestroyImageView(device , imageView , allocator(VK_OBJECT_TYPE_IMAGE_VIEW));
         }//end for each
-        vkDestroySwapchainKHR(device , swapChain , nullptr);
+        if(offscreen){
+            for(size_t i = 0 ; i < swapChainImages.size() ; i++){
+                vkDestroyImage(device , swapChainImages[i] , allocator(VK_OBJECT_TYPE_IMAGE));
+                vkFreeMemory(device , offscreenMemories[i] , allocator(VK_OBJECT_TYPE_DEVICE_MEMORY));
+            }//end for i
+        }else{
+            vkDestroySwapchainKHR(device , swapChain , allocator(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+        }
 
-        vkDestroyDevice(device , nullptr);
+        vkDestroyDevice(device , allocator(VK_OBJECT_TYPE_DEVICE));
         if(enableValidateLayers){
-            destoryDebugUtilsMessengerEXT(instance ,debugMessenger , nullptr);
+            destoryDebugUtilsMessengerEXT(instance ,debugMessenger , allocator(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT));
         }
 
-        vkDestroySurfaceKHR(instance , surface ,nullptr);
-        vkDestroyInstance(instance , nullptr);
+        if(!offscreen){
+            vkDestroySurfaceKHR(instance , surface , allocator(VK_OBJECT_TYPE_SURFACE_KHR));
+        }
+        vkDestroyInstance(instance , allocator(VK_OBJECT_TYPE_INSTANCE));
+        debugLogger.stop();
+        if(config.trackHostAllocations && config.allocationReport){
+            hostAllocator.report(std::cout);
+        }
         
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        if(!offscreen){
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
 
     void setupDebugMessenger(){
+        CPU_TRACE_FUNCTION();
         if(!enableValidateLayers){
             return;
         }
@@ -899,7 +3775,7 @@ private:
         VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
         populateDebugMessengerCreateInfo(createInfo);
 
-        if(createDebugUtilsMessengerEXT(instance , &createInfo , nullptr , &debugMessenger) != VK_SUCCESS){
+        if(createDebugUtilsMessengerEXT(instance , &createInfo , allocator(VK_OBJECT_TYPE_DEBUG_UTILS_MESSENGER_EXT) , &debugMessenger) != VK_SUCCESS){
             throw std::runtime_error("failed to set up debug callback");
         }
     }
@@ -923,18 +3799,10 @@ private:
     }
 
     //debug 回调 输入日志
-    static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-        VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity ,VkDebugUtilsMessageTypeFlagsEXT messageType
-        ,const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData 
-        ,void *pUserData){
-        if(messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT && enableValidateLayers){
-                std::cerr << "validation layer : " << pCallbackData->pMessage << std::endl;
-        }
-        return VK_FALSE;
-    }
 
-    //选择物理设备GPU
+    //选择物理设备GPU  对所有可用设备评分 取最高分 或按 config.deviceSelector 指定
     void pickPhysicalDevice(){
+        CPU_TRACE_FUNCTION();
         uint32_t gpuCount = 0;
         vkEnumeratePhysicalDevices(instance , &gpuCount , nullptr);
         std::cout << "gpu count : " << gpuCount << std::endl;
@@ -942,15 +3810,228 @@ private:
         std::vector<VkPhysicalDevice> gpus(gpuCount);
         vkEnumeratePhysicalDevices(instance , &gpuCount , gpus.data());
 
-        for(VkPhysicalDevice &device : gpus){
-            if(isDeviceSuitable(device)){
-                physicalDevice = device;
+        std::vector<PhysicalDeviceScore> candidates;
+        for(uint32_t i = 0 ; i < gpuCount ; i++){
+            candidates.push_back(rateDeviceSuitability(gpus[i] , i));
+        }//end for i
+
+        for(const PhysicalDeviceScore &candidate : candidates){
+            std::cout << "\t[" << candidate.index << "] " << candidate.name
+                << " type : " << physicalDeviceTypeName(candidate.type)
+                << " uuid : " << candidate.uuid
+                << " score : " << candidate.score
+                << (candidate.suitable ? "" : " (not suitable)") << std::endl;
+        }//end for each
+
+        const PhysicalDeviceScore *chosen = nullptr;
+        const std::string &selector = config.deviceSelector;
+        if(!selector.empty()){
+            chosen = findSelectedDevice(candidates , selector);
+            if(chosen == nullptr){
+                throw std::runtime_error("no physical device matches selector " + selector);
+            }
+            if(!chosen->suitable){
+                throw std::runtime_error("selected physical device " + chosen->name + " is not suitable!");
+            }
+        }else{
+            for(const PhysicalDeviceScore &candidate : candidates){
+                if(candidate.suitable && (chosen == nullptr || candidate.score > chosen->score)){
+                    chosen = &candidate;
+                }
+            }//end for each
+        }
+
+        if(chosen == nullptr){
+            throw std::runtime_error("no found suitable physical device!");
+        }
+
+        physicalDevice = chosen->device;
+        std::cout << "pick physical device [" << chosen->index << "] " << chosen->name 
+            << " score : " << chosen->score
+            << (selector.empty() ? "" : " (selector " + selector + ")") << std::endl;
+    }
+
+    //按 序号 / UUID / "cpu" / 名称子串 匹配设备
+    const PhysicalDeviceScore* findSelectedDevice(const std::vector<PhysicalDeviceScore> &candidates ,
+            const std::string &selector){
+        const std::string key = toLowerCase(selector);
+
+        const bool allDigits = std::all_of(key.begin() , key.end() , [](unsigned char c){
+            return std::isdigit(c) != 0;
+        });
+        if(!key.empty() && allDigits){
+            //序号越界 (含 strtoul 溢出) 时继续按名称匹配
+            errno = 0;
+            const unsigned long index = std::strtoul(key.c_str() , nullptr , 10);
+            if(errno != ERANGE && index < candidates.size()){
+                return &candidates[index];
+            }
+        }
+
+        //软件实现 取评分最高的CPU设备
+        if(key == "cpu"){
+            const PhysicalDeviceScore *best = nullptr;
+            for(const PhysicalDeviceScore &candidate : candidates){
+                if(candidate.type == VK_PHYSICAL_DEVICE_TYPE_CPU && candidate.suitable
+                    && (best == nullptr || candidate.score > best->score)){
+                    best = &candidate;
+                }
+            }//end for each
+            return best;
+        }
+
+        std::string uuidKey = key;
+        uuidKey.erase(std::remove(uuidKey.begin() , uuidKey.end() , '-') , uuidKey.end());
+        for(const PhysicalDeviceScore &candidate : candidates){
+            std::string uuid = candidate.uuid;
+            uuid.erase(std::remove(uuid.begin() , uuid.end() , '-') , uuid.end());
+            if(!uuid.empty() && uuid == uuidKey){
+                return &candidate;
+            }
+        }//end for each
+
+        for(const PhysicalDeviceScore &candidate : candidates){
+            if(toLowerCase(candidate.name).find(key) != std::string::npos){
+                return &candidate;
+            }
+        }//end for each
+        return nullptr;
+    }
+
+    //设备评分  设备类型 > 显存 > 队列能力 / 硬件限制 / 可选特性
+    PhysicalDeviceScore rateDeviceSuitability(VkPhysicalDevice phDevice , uint32_t index){
+        VkPhysicalDeviceProperties properties;
+        VkPhysicalDeviceFeatures features;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+
+        vkGetPhysicalDeviceProperties(phDevice , &properties);
+        vkGetPhysicalDeviceFeatures(phDevice , &features);
+        vkGetPhysicalDeviceMemoryProperties(phDevice , &memoryProperties);
+
+        PhysicalDeviceScore result;
+        result.device = phDevice;
+        result.index = index;
+        result.name = properties.deviceName;
+        result.type = properties.deviceType;
+        result.uuid = queryDeviceUUID(phDevice , properties);
+        result.suitable = isDeviceSuitable(phDevice);
+
+        uint64_t score = 0;
+        switch(properties.deviceType){
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+                score += 100000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+                score += 50000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+                score += 20000;
+                break;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU:
+                score += 1000;
                 break;
+            default:
+                break;
+        }
+
+        //显存 取 DEVICE_LOCAL 堆的总量 (MB) 上限32G
+        VkDeviceSize localHeapSize = 0;
+        for(uint32_t i = 0 ; i < memoryProperties.memoryHeapCount ; i++){
+            if(memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT){
+                localHeapSize += memoryProperties.memoryHeaps[i].size;
+            }
+        }//end for i
+        score += std::min<VkDeviceSize>(localHeapSize >> 20 , 32768) / 16;
+
+        //队列能力 独立的计算/传输队列可用于异步计算与上传
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(phDevice , &queueFamilyCount , nullptr);
+        std::vector<VkQueueFamilyProperties> familyProperies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(phDevice , &queueFamilyCount , familyProperies.data());
+        bool hasAsyncCompute = false;
+        bool hasTransferOnly = false;
+        for(VkQueueFamilyProperties &prop : familyProperies){
+            if((prop.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(prop.queueFlags & VK_QUEUE_GRAPHICS_BIT)){
+                hasAsyncCompute = true;
+            }
+            if((prop.queueFlags & VK_QUEUE_TRANSFER_BIT) 
+                && !(prop.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))){
+                hasTransferOnly = true;
             }
         }//end for each
+        score += hasAsyncCompute ? 500 : 0;
+        score += hasTransferOnly ? 250 : 0;
 
-        if(physicalDevice == VK_NULL_HANDLE){
-            throw std::runtime_error("no found suitable physical device!");
+        QueueFamilyIndices indices = findQueueFamilies(phDevice);
+        if(indices.isComplete() && indices.graphicsIndex == indices.presentIndex){
+            score += 250;
+        }
+
+        //硬件限制
+        score += properties.limits.maxImageDimension2D / 16;
+        score += properties.limits.maxComputeSharedMemorySize / 1024;
+        score += std::min<uint32_t>(properties.limits.maxPushConstantsSize , 256);
+
+        //可选特性
+        const VkBool32 optionalFeatures[] = {
+            features.samplerAnisotropy,
+            features.multiDrawIndirect,
+            features.drawIndirectFirstInstance,
+            features.pipelineStatisticsQuery,
+            features.fillModeNonSolid,
+            features.shaderInt64,
+            features.textureCompressionBC
+        };
+        for(VkBool32 supported : optionalFeatures){
+            score += supported ? 100 : 0;
+        }//end for each
+
+        result.score = score;
+        return result;
+    }
+
+    //设备UUID 需要实例与设备都支持 vulkan 1.1  或 1.0 实例开启了 KHR 扩展
+    std::string queryDeviceUUID(VkPhysicalDevice phDevice , const VkPhysicalDeviceProperties &properties){
+        PFN_vkGetPhysicalDeviceProperties2 func = nullptr;
+        if(instanceApiVersion >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1){
+            func = (PFN_vkGetPhysicalDeviceProperties2)vkGetInstanceProcAddr(instance , "vkGetPhysicalDeviceProperties2");
+        }else if(instanceIdProperties){
+            func = (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(instance , "vkGetPhysicalDeviceProperties2KHR");
+        }
+        if(func == nullptr){
+            return "";
+        }
+
+        VkPhysicalDeviceIDProperties idProperties = {};
+        idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties2 = {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &idProperties;
+        func(phDevice , &properties2);
+
+        std::ostringstream uuid;
+        for(uint32_t i = 0 ; i < VK_UUID_SIZE ; i++){
+            if(i == 4 || i == 6 || i == 8 || i == 10){
+                uuid << '-';
+            }
+            uuid << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint32_t>(idProperties.deviceUUID[i]);
+        }//end for i
+        return uuid.str();
+    }
+
+    static const char* physicalDeviceTypeName(VkPhysicalDeviceType type){
+        switch(type){
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+                return "discrete";
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+                return "integrated";
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+                return "virtual";
+            case VK_PHYSICAL_DEVICE_TYPE_CPU:
+                return "cpu";
+            default:
+                return "other";
         }
     }
 
@@ -972,8 +4053,8 @@ private:
         QueueFamilyIndices indices = findQueueFamilies(phDevice);
         bool extensionsSupported = checkDeviceExtensionSupport(phDevice);
 
-        bool swapChainSupportAvailable = false;
-        if(extensionsSupported){
+        bool swapChainSupportAvailable = offscreen;
+        if(extensionsSupported && !offscreen){
             SwapChainSupportDetail swapSupportDetail = querySwapChainSupport(phDevice);
             swapChainSupportAvailable = (!swapSupportDetail.formats.empty()) && (!swapSupportDetail.presentModes.empty());
         }
@@ -983,6 +4064,10 @@ private:
 
     //检测设备扩展是否支持
     bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice){
+        const std::vector<const char *> required = requiredDeviceExtensions();
+        if(required.empty()){
+            return true;
+        }
         uint32_t extensionCount = 0;
 
         vkEnumerateDeviceExtensionProperties(physicalDevice , nullptr , &extensionCount , nullptr);
@@ -999,7 +4084,7 @@ private:
         //     std::cout << "\t" << prop.extensionName << std::endl;
         // }//end for each
 
-        std::set<std::string> requiredExtensions(deviceExtensions.begin() , deviceExtensions.end());
+        std::set<std::string> requiredExtensions(required.begin() , required.end());
         for(VkExtensionProperties prop : availableExtensions){
             requiredExtensions.erase(prop.extensionName);
         }//end for each
@@ -1007,6 +4092,11 @@ private:
         return requiredExtensions.empty();
     }
 
+    //离屏时不显示 不需要交换链扩展
+    std::vector<const char *> requiredDeviceExtensions() const{
+        return offscreen ? std::vector<const char *>() : deviceExtensions;
+    }
+
     //从物理设备上查询队列簇
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device){
         QueueFamilyIndices indices;
@@ -1022,19 +4112,27 @@ private:
         for(VkQueueFamilyProperties &prop : familyProperies){
             // std::cout << "VkQueueFamilyProperty : queueCount " 
             //         << prop.queueCount << " flag " << prop.queueFlags << std::endl;
-            if(prop.queueFlags & VK_QUEUE_GRAPHICS_BIT){
+            if((prop.queueFlags & VK_QUEUE_GRAPHICS_BIT) && indices.graphicsIndex < 0){
                 indices.graphicsIndex = index;
             }
 
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device , index , surface , &presentSupport);
+            //不带图形能力的计算队列簇 可与图形队列并行执行
+            if((prop.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(prop.queueFlags & VK_QUEUE_GRAPHICS_BIT) 
+                && indices.computeIndex < 0){
+                indices.computeIndex = index;
+            }
 
-            if(presentSupport){
-                indices.presentIndex = index;
+            //离屏时没有表面  显示队列即图形队列
+            VkBool32 presentSupport = false;
+            if(offscreen){
+                presentSupport = (prop.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+            }else{
+                vkGetPhysicalDeviceSurfaceSupportKHR(device , index , surface , &presentSupport);
             }
 
-            if(indices.isComplete()){
-                break;
+            //优先与图形队列使用同一个队列簇
+            if(presentSupport && (indices.presentIndex < 0 || static_cast<int>(index) == indices.graphicsIndex)){
+                indices.presentIndex = index;
             }
 
             index++;
@@ -1045,33 +4143,50 @@ private:
 
     //创建逻辑设备
     void createLogicalDevice() {
+        CPU_TRACE_FUNCTION();
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfoList;
 
         std::set<int> uniqueQueueFamilies = {indices.graphicsIndex , indices.presentIndex};
+        if(indices.computeIndex >= 0){
+            uniqueQueueFamilies.insert(indices.computeIndex);
+        }
+        static const float queuePriority = 1.0f;
         for(int queueFamiliesIndex : uniqueQueueFamilies){
             VkDeviceQueueCreateInfo queueCreateInfo = {};
             queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueCreateInfo.queueFamilyIndex = queueFamiliesIndex;
             queueCreateInfo.queueCount = 1;
-            float queueProperties = 1.0f;
-            queueCreateInfo.pQueuePriorities = &queueProperties;
+            queueCreateInfo.pQueuePriorities = &queuePriority;
             
             queueCreateInfoList.push_back(queueCreateInfo);
         }//end for each
 
-        VkPhysicalDeviceFeatures deviceFeatures = {};
+        //特性协商 按设备支持情况开启 1.1/1.2/1.3 特性
+        deviceFeatures.query(instance , physicalDevice , instanceApiVersion);
+        deviceFeatures.negotiate();
+        //深度预处理等基准测试统计片元着色器调用次数
+        deviceFeatures.enabledCore.pipelineStatisticsQuery = deviceFeatures.supportedCore.pipelineStatisticsQuery;
+        //GPU驱动的间接绘制 每个物体一条命令 firstInstance 指向物体
+        deviceFeatures.enabledCore.multiDrawIndirect = deviceFeatures.supportedCore.multiDrawIndirect;
+        deviceFeatures.enabledCore.drawIndirectFirstInstance = deviceFeatures.supportedCore.drawIndirectFirstInstance;
+        deviceFeatures.print();
         
         VkDeviceCreateInfo deviceCreateInfo = {};
         deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfoList.size());
         deviceCreateInfo.pQueueCreateInfos = queueCreateInfoList.data();
 
-        deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
+        deviceFeatures.fillDeviceCreateInfo(deviceCreateInfo);
 
         //set device extension
-        deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        const std::vector<const char *> required = requiredDeviceExtensions();
+        std::vector<const char*> enabledExtensions(required.begin() , required.end());
+        enabledExtensions.insert(enabledExtensions.end() , 
+            deviceFeatures.extensions.begin() , deviceFeatures.extensions.end());
+        deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         //validate layer
         if(enableValidateLayers){
@@ -1081,20 +4196,122 @@ private:
             deviceCreateInfo.enabledLayerCount = 0;
         }
         
-        if(vkCreateDevice(physicalDevice , &deviceCreateInfo , nullptr , &device) != VK_SUCCESS){
+        if(vkCreateDevice(physicalDevice , &deviceCreateInfo , allocator(VK_OBJECT_TYPE_DEVICE) , &device) != VK_SUCCESS){
             throw std::runtime_error("failed to create logical device !");
         }
 
+        vkd.load(device);
+
         //创建队列  grapics + present queue
         vkGetDeviceQueue(device , indices.graphicsIndex , 0 , &graphicsQueue);
         vkGetDeviceQueue(device , indices.presentIndex , 0 , &presentQueue);
+        if(indices.computeIndex >= 0){
+            vkGetDeviceQueue(device , indices.computeIndex , 0 , &computeQueue);
+        }
     }
 };
 
+//解析命令行  命令行参数优先于环境变量
+AppConfig parseCommandLine(int argc , char *argv[]){
+    AppConfig config;
+
+    const char *envDevice = std::getenv("VK_DEVICE");
+    if(envDevice != nullptr){
+        config.deviceSelector = envDevice;
+    }
+
+    for(int i = 1 ; i < argc ; i++){
+        std::string arg = argv[i];
+        if(arg.rfind("--device=" , 0) == 0){
+            config.deviceSelector = arg.substr(std::string("--device=").size());
+        }else if(arg == "--device" && i + 1 < argc){
+            config.deviceSelector = argv[++i];
+        }else if(arg.rfind("--bench=" , 0) == 0){
+            config.benchmark = arg.substr(std::string("--bench=").size());
+        }else if(arg.rfind("--bench-json=" , 0) == 0){
+            config.benchmarkJson = arg.substr(std::string("--bench-json=").size());
+        }else if(arg.rfind("--render-path=" , 0) == 0){
+            config.renderPath = arg.substr(std::string("--render-path=").size());
+        }else if(arg.rfind("--reverse-z=" , 0) == 0){
+            config.reverseZ = arg.substr(std::string("--reverse-z=").size()) != "off";
+        }else if(arg == "--depth-prepass"){
+            config.depthPrepass = true;
+        }else if(arg.rfind("--overdraw=" , 0) == 0){
+            config.overdrawLayers = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--overdraw=").size())));
+        }else if(arg.rfind("--triangles=" , 0) == 0){
+            config.gridTriangles = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--triangles=").size())));
+        }else if(arg.rfind("--triangle-size=" , 0) == 0){
+            config.triangleArea = std::stof(arg.substr(std::string("--triangle-size=").size()));
+        }else if(arg.rfind("--blend=" , 0) == 0){
+            config.blend = arg.substr(std::string("--blend=").size()) != "off";
+        }else if(arg.rfind("--cull=" , 0) == 0){
+            config.cullMode = arg.substr(std::string("--cull=").size());
+        }else if(arg.rfind("--msaa=" , 0) == 0){
+            config.msaaSamples = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--msaa=").size())));
+        }else if(arg.rfind("--culling=" , 0) == 0){
+            config.culling = arg.substr(std::string("--culling=").size());
+        }else if(arg == "--occlusion"){
+            config.occlusion = true;
+        }else if(arg.rfind("--instances=" , 0) == 0){
+            config.instanceCount = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--instances=").size())));
+        }else if(arg.rfind("--host-alloc=" , 0) == 0){
+            config.trackHostAllocations = arg.substr(std::string("--host-alloc=").size()) != "off";
+        }else if(arg == "--alloc-report"){
+            config.allocationReport = true;
+        }else if(arg == "--gpu-profile"){
+            config.gpuProfile = true;
+        }else if(arg.rfind("--validation=" , 0) == 0){
+            config.validation = arg.substr(std::string("--validation=").size()) != "off";
+        }else if(arg.rfind("--vk-log=" , 0) == 0){
+            config.logSeverity = arg.substr(std::string("--vk-log=").size());
+        }else if(arg.rfind("--vk-log-types=" , 0) == 0){
+            config.logTypes = arg.substr(std::string("--vk-log-types=").size());
+        }else if(arg.rfind("--vk-log-repeat=" , 0) == 0){
+            config.logRepeats = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--vk-log-repeat=").size())));
+        }else if(arg.rfind("--vk-log-rate=" , 0) == 0){
+            config.logRate = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--vk-log-rate=").size())));
+        }else if(arg.rfind("--dump-frames=" , 0) == 0){
+            config.dumpInterval = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--dump-frames=").size())));
+        }else if(arg.rfind("--dump-dir=" , 0) == 0){
+            config.dumpDir = arg.substr(std::string("--dump-dir=").size());
+        }else if(arg.rfind("--dump-format=" , 0) == 0){
+            config.dumpFormat = arg.substr(std::string("--dump-format=").size());
+        }else if(arg.rfind("--dump-count=" , 0) == 0){
+            config.dumpCount = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--dump-count=").size())));
+        }else if(arg.rfind("--regression=" , 0) == 0){
+            config.regressionDir = arg.substr(std::string("--regression=").size());
+        }else if(arg == "--regression-update"){
+            config.regressionUpdate = true;
+        }else if(arg.rfind("--regression-psnr=" , 0) == 0){
+            config.regressionPsnr = std::stod(arg.substr(std::string("--regression-psnr=").size()));
+        }else if(arg.rfind("--regression-ssim=" , 0) == 0){
+            config.regressionSsim = std::stod(arg.substr(std::string("--regression-ssim=").size()));
+        }else if(arg.rfind("--regression-tolerance=" , 0) == 0){
+            config.regressionTolerance = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--regression-tolerance=").size())));
+        }else if(arg.rfind("--regression-pixels=" , 0) == 0){
+            config.regressionPixels = std::stod(arg.substr(std::string("--regression-pixels=").size()));
+        }else if(arg.rfind("--cpu-trace=" , 0) == 0){
+            config.cpuTraceFile = arg.substr(std::string("--cpu-trace=").size());
+        }else if(arg.rfind("--trace=" , 0) == 0){
+            config.traceFile = arg.substr(std::string("--trace=").size());
+        }else if(arg.rfind("--per-draw=" , 0) == 0){
+            config.perDraw = arg.substr(std::string("--per-draw=").size());
+        }else if(arg.rfind("--shading=" , 0) == 0){
+            config.shadingIterations = static_cast<uint32_t>(std::stoul(arg.substr(std::string("--shading=").size())));
+        }else{
+            std::cout << "unknown argument " << arg << std::endl;
+        }
+    }//end for i
+    return config;
+}
+
 int main(int argc , char *argv[]){
     HelloTriangleApplication app;
+    app.config = parseCommandLine(argc , argv);
     try{
-        app.run();
+        if(app.run() != 0){
+            return EXIT_FAILURE;
+        }
     }catch(const std::exception &e){
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
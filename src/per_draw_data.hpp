@@ -0,0 +1,258 @@
+#ifndef _PER_DRAW_DATA_H_
+#define _PER_DRAW_DATA_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "device_dispatch.hpp"
+#include "vk_utils.hpp"
+
+//每次绘制的参数 (变换 颜色等) 的两条提交路径
+//  push constant   : 不超过 pushConstantSize 的小数据 直接写进指令流
+//  dynamic uniform : 较大的数据拷贝进每帧的 uniform 环形缓冲  用动态偏移重新绑定同一个描述符集
+//描述符集在初始化时分配一次 录制绘制指令时不会分配描述符集
+//管线布局: set 0 binding 0 为 UNIFORM_BUFFER_DYNAMIC  push constant 范围 [0 , pushConstantSize)
+
+enum PerDrawStrategy{
+    PER_DRAW_AUTO = 0,
+    PER_DRAW_PUSH_CONSTANTS,
+    PER_DRAW_DYNAMIC_UNIFORM
+};
+
+//每帧的提交统计
+struct PerDrawStats{
+    uint32_t pushed = 0;
+    uint32_t uniform = 0;
+    VkDeviceSize uniformBytes = 0;
+};
+
+class PerDrawData{
+public:
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+
+    //pushConstantSize 不超过设备的 maxPushConstantsSize  maxPayloadSize 为 uniform 路径单次绘制数据的上限
+    //bytesPerFrame 为每帧 uniform 环形缓冲的大小
+    void init(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd , uint32_t framesInFlight ,
+            VkShaderStageFlags stages , uint32_t maxPayloadSize = 512 , VkDeviceSize bytesPerFrame = 4 * 1024 * 1024){
+        this->device = device;
+        this->vkd = vkd;
+        this->stages = stages;
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice , &properties);
+        this->maxPayloadSize = std::min(maxPayloadSize , properties.limits.maxUniformBufferRange);
+        pushConstantSize = std::min(this->maxPayloadSize , properties.limits.maxPushConstantsSize) & ~3u;
+        alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment , 16);
+        frameSize = alignUp(std::max<VkDeviceSize>(bytesPerFrame , this->maxPayloadSize) , alignment);
+        frames = framesInFlight;
+
+        VkDescriptorSetLayoutBinding binding = {};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        binding.descriptorCount = 1;
+        binding.stageFlags = stages;
+
+        VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = {};
+        setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        setLayoutCreateInfo.bindingCount = 1;
+        setLayoutCreateInfo.pBindings = &binding;
+        if(vkCreateDescriptorSetLayout(device , &setLayoutCreateInfo , nullptr , &setLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create per draw descriptor set layout!");
+        }
+
+        VkPushConstantRange pushConstantRange = {};
+        pushConstantRange.stageFlags = stages;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = pushConstantSize;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &setLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        if(vkCreatePipelineLayout(device , &pipelineLayoutCreateInfo , nullptr , &pipelineLayout) != VK_SUCCESS){
+            throw std::runtime_error("failed to create per draw pipeline layout!");
+        }
+
+        createBuffer(physicalDevice);
+
+        VkDescriptorPoolSize poolSize = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC , 1};
+        VkDescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.maxSets = 1;
+        poolCreateInfo.poolSizeCount = 1;
+        poolCreateInfo.pPoolSizes = &poolSize;
+        if(vkCreateDescriptorPool(device , &poolCreateInfo , nullptr , &descriptorPool) != VK_SUCCESS){
+            throw std::runtime_error("failed to create per draw descriptor pool!");
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &setLayout;
+        if(vkAllocateDescriptorSets(device , &allocateInfo , &set) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate per draw descriptor set!");
+        }
+
+        //整个环形缓冲共用一个描述符  每帧的区域与每次绘制的数据都由动态偏移选择
+        VkDescriptorBufferInfo bufferInfo = {buffer , 0 , this->maxPayloadSize};
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(device , 1 , &write , 0 , nullptr);
+
+        std::cout << "create per draw data push constants : " << pushConstantSize
+            << " bytes uniform ring : " << frameSize / 1024 << " KB x " << frames << std::endl;
+    }
+
+    void destroy(){
+        if(device == VK_NULL_HANDLE){
+            return;
+        }
+        vkUnmapMemory(device , memory);
+        vkDestroyBuffer(device , buffer , nullptr);
+        vkFreeMemory(device , memory , nullptr);
+        vkDestroyDescriptorPool(device , descriptorPool , nullptr);
+        vkDestroyPipelineLayout(device , pipelineLayout , nullptr);
+        vkDestroyDescriptorSetLayout(device , setLayout , nullptr);
+        buffer = VK_NULL_HANDLE;
+        memory = VK_NULL_HANDLE;
+        mapped = nullptr;
+        descriptorPool = VK_NULL_HANDLE;
+        set = VK_NULL_HANDLE;
+        pipelineLayout = VK_NULL_HANDLE;
+        setLayout = VK_NULL_HANDLE;
+        device = VK_NULL_HANDLE;
+    }
+
+    bool isCreated() const{
+        return set != VK_NULL_HANDLE;
+    }
+
+    uint32_t pushConstantLimit() const{
+        return pushConstantSize;
+    }
+
+    //AUTO 时 放得进 push constant 范围的数据走 push constant
+    PerDrawStrategy resolve(uint32_t size , PerDrawStrategy strategy = PER_DRAW_AUTO) const{
+        if(strategy == PER_DRAW_AUTO){
+            return size <= pushConstantSize ? PER_DRAW_PUSH_CONSTANTS : PER_DRAW_DYNAMIC_UNIFORM;
+        }
+        if(strategy == PER_DRAW_PUSH_CONSTANTS && size > pushConstantSize){
+            throw std::runtime_error("per draw data does not fit in push constants!");
+        }
+        return strategy;
+    }
+
+    //飞行帧的 fence 等待之后调用  该帧的环形缓冲区域可以重新写入
+    void beginFrame(uint32_t frame){
+        frameBase = static_cast<uint32_t>(frameSize * frame);
+        frameOffset = 0;
+        lastStats = current;
+        current = PerDrawStats();
+    }
+
+    //绑定描述符集 (偏移为本帧区域的开头)  只用 push constant 的管线也需要绑定 以满足布局
+    void bindFrame(VkCommandBuffer cmd , VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const{
+        vkd->vkCmdBindDescriptorSets(cmd , bindPoint , pipelineLayout , 0 , 1 , &set , 1 , &frameBase);
+    }
+
+    //写入一次绘制的数据  返回实际使用的路径
+    PerDrawStrategy write(VkCommandBuffer cmd , const void *data , uint32_t size ,
+            PerDrawStrategy strategy = PER_DRAW_AUTO , VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS){
+        strategy = resolve(size , strategy);
+        if(strategy == PER_DRAW_PUSH_CONSTANTS){
+            vkd->vkCmdPushConstants(cmd , pipelineLayout , stages , 0 , size , data);
+            current.pushed++;
+            return strategy;
+        }
+
+        if(size > maxPayloadSize){
+            throw std::runtime_error("per draw data exceeds uniform range!");
+        }
+        if(frameOffset + maxPayloadSize > frameSize){
+            throw std::runtime_error("per draw uniform ring overflow!");
+        }
+        const uint32_t offset = frameBase + frameOffset;
+        std::memcpy(static_cast<char *>(mapped) + offset , data , size);
+        frameOffset += static_cast<uint32_t>(alignUp(size , alignment));
+        vkd->vkCmdBindDescriptorSets(cmd , bindPoint , pipelineLayout , 0 , 1 , &set , 1 , &offset);
+        current.uniform++;
+        current.uniformBytes += size;
+        return strategy;
+    }
+
+    //上一个完整帧的统计
+    const PerDrawStats &stats() const{
+        return lastStats;
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkShaderStageFlags stages = 0;
+
+    uint32_t pushConstantSize = 0;
+    uint32_t maxPayloadSize = 0;
+    VkDeviceSize alignment = 256;
+    VkDeviceSize frameSize = 0;
+    uint32_t frames = 0;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    void *mapped = nullptr;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    uint32_t frameBase = 0;
+    uint32_t frameOffset = 0;
+    PerDrawStats current;
+    PerDrawStats lastStats;
+
+    void createBuffer(VkPhysicalDevice physicalDevice){
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = frameSize * frames;
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if(vkCreateBuffer(device , &bufferCreateInfo , nullptr , &buffer) != VK_SUCCESS){
+            throw std::runtime_error("failed to create per draw uniform buffer!");
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device , buffer , &requirements);
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+
+        //优先 CPU 可写的显存
+        const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        int memoryType = findMemoryTypeIndex(memoryProperties , requirements.memoryTypeBits ,
+            hostVisible | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(memoryType < 0){
+            memoryType = static_cast<int>(findMemoryType(memoryProperties , requirements.memoryTypeBits , hostVisible));
+        }
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = static_cast<uint32_t>(memoryType);
+        if(vkAllocateMemory(device , &allocateInfo , nullptr , &memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate per draw uniform memory!");
+        }
+        vkBindBufferMemory(device , buffer , memory , 0);
+        vkMapMemory(device , memory , 0 , VK_WHOLE_SIZE , 0 , &mapped);
+    }
+};
+
+#endif
@@ -0,0 +1,1033 @@
+#ifndef _RENDER_GRAPH_H_
+#define _RENDER_GRAPH_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "device_dispatch.hpp"
+#include "gpu_profiler.hpp"
+#include "resource_state_tracker.hpp"
+#include "vk_utils.hpp"
+
+//帧图 (render graph)
+//每帧: reset() -> 导入/声明资源 -> addPass() 声明读写 -> compile() -> execute()
+//compile 完成:
+//  1. 剔除对输出没有贡献的pass
+//  2. 按资源状态变化推导转换 由 ResourceStateTracker 在每个pass之前合并为一次屏障提交
+//  3. 按生命周期为临时图像分配内存 同一内存类型的图像放在同一块内存中 生命周期不重叠的图像共用内存(别名)
+//  4. 异步计算pass 放入计算队列的指令缓存 图形队列在第一次使用其结果的阶段等待信号量
+//异步计算pass只能访问 buffer 或临时图像 且这些资源在本帧之前没有被图形队列访问过
+//否则退回图形队列执行; 临时图像每个飞行帧一组 (reset 的 frameSlot)
+//异步pass写入的buffer同样需要调用者按飞行帧分开 避免与上一帧的图形工作冲突
+
+typedef uint32_t RGHandle;
+const RGHandle RG_INVALID_HANDLE = ~0u;
+
+enum RGPassType{
+    RG_PASS_GRAPHICS,
+    RG_PASS_COMPUTE,
+    RG_PASS_ASYNC_COMPUTE,
+    RG_PASS_TRANSFER
+};
+
+//资源在pass中的用途
+enum RGAccessType{
+    RG_ACCESS_COLOR_ATTACHMENT,
+    RG_ACCESS_DEPTH_ATTACHMENT,
+    RG_ACCESS_DEPTH_READ,
+    RG_ACCESS_SAMPLED,
+    RG_ACCESS_STORAGE_READ,
+    RG_ACCESS_STORAGE_WRITE,
+    RG_ACCESS_UNIFORM,
+    RG_ACCESS_VERTEX,
+    RG_ACCESS_INDEX,
+    RG_ACCESS_INDIRECT,
+    RG_ACCESS_TRANSFER_SRC,
+    RG_ACCESS_TRANSFER_DST
+};
+
+struct RGAccessInfo{
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags stage = 0;
+    VkAccessFlags access = 0;
+    bool write = false;
+    VkImageUsageFlags imageUsage = 0;
+    VkBufferUsageFlags bufferUsage = 0;
+};
+
+static RGAccessInfo rgGetAccessInfo(RGAccessType type , RGPassType passType){
+    const VkPipelineStageFlags shaderStage = passType == RG_PASS_GRAPHICS
+        ? (VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+        : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    const VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+        | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+    RGAccessInfo info;
+    switch(type){
+        case RG_ACCESS_COLOR_ATTACHMENT:
+            info.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            info.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            info.access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            info.write = true;
+            info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            break;
+        case RG_ACCESS_DEPTH_ATTACHMENT:
+            info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            info.stage = depthStages;
+            info.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            info.write = true;
+            info.imageUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            break;
+        case RG_ACCESS_DEPTH_READ:
+            info.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            info.stage = depthStages;
+            info.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+            info.imageUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            break;
+        case RG_ACCESS_SAMPLED:
+            info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            info.stage = shaderStage;
+            info.access = VK_ACCESS_SHADER_READ_BIT;
+            info.imageUsage = VK_IMAGE_USAGE_SAMPLED_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            break;
+        case RG_ACCESS_STORAGE_READ:
+            info.layout = VK_IMAGE_LAYOUT_GENERAL;
+            info.stage = shaderStage;
+            info.access = VK_ACCESS_SHADER_READ_BIT;
+            info.imageUsage = VK_IMAGE_USAGE_STORAGE_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            break;
+        case RG_ACCESS_STORAGE_WRITE:
+            info.layout = VK_IMAGE_LAYOUT_GENERAL;
+            info.stage = shaderStage;
+            info.access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            info.write = true;
+            info.imageUsage = VK_IMAGE_USAGE_STORAGE_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+            break;
+        case RG_ACCESS_UNIFORM:
+            info.stage = shaderStage;
+            info.access = VK_ACCESS_UNIFORM_READ_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+            break;
+        case RG_ACCESS_VERTEX:
+            info.stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            info.access = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+            break;
+        case RG_ACCESS_INDEX:
+            info.stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            info.access = VK_ACCESS_INDEX_READ_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+            break;
+        case RG_ACCESS_INDIRECT:
+            info.stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+            info.access = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+            break;
+        case RG_ACCESS_TRANSFER_SRC:
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            info.access = VK_ACCESS_TRANSFER_READ_BIT;
+            info.imageUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            break;
+        case RG_ACCESS_TRANSFER_DST:
+            info.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            info.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+            info.write = true;
+            info.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            info.bufferUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            break;
+    }
+    return info;
+}
+
+//临时图像描述  由帧图创建并管理内存
+struct RGImageDesc{
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = {0 , 0};
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    VkImageUsageFlags extraUsage = 0;//除了pass声明推导出的用途之外 额外需要的用途  含 TRANSIENT_ATTACHMENT 时优先 lazily allocated 内存
+    uint32_t mipLevels = 1;
+    uint32_t arrayLayers = 1;
+};
+
+//资源在某一时刻的状态
+struct RGResourceState{
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkAccessFlags access = 0;
+    bool write = false;
+    bool asyncQueue = false;
+};
+
+struct RGResource{
+    std::string name;
+    bool isImage = true;
+    bool imported = false;
+
+    RGImageDesc desc;
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize size = VK_WHOLE_SIZE;
+
+    RGResourceState initialState;
+    bool output = false;
+    RGResourceState finalState;
+
+    //compile 时计算
+    int firstPass = -1;
+    int lastPass = -1;
+    bool asyncShared = false;//被异步pass访问 不参与内存别名
+    bool accessed = false;//本帧是否已经被访问过
+    VkImageUsageFlags usage = 0;
+    uint32_t memoryHeap = 0;//所在的内存块  不同内存块之间没有别名
+    VkDeviceSize memoryOffset = 0;
+    VkDeviceSize memorySize = 0;
+    RGResourceState state;
+};
+
+struct RGPassAccess{
+    RGHandle resource;
+    RGAccessType type;
+    bool write;
+};
+
+//compile 推导出的状态操作  execute 时交给 ResourceStateTracker
+struct RGStateOp{
+    RGHandle resource;
+    bool setOnly;//只更新状态 不生成屏障 (依赖由信号量提供)
+    RGResourceState state;
+};
+
+struct RGPass{
+    std::string name;
+    RGPassType type = RG_PASS_GRAPHICS;
+    std::vector<RGPassAccess> accesses;
+    std::function<void(VkCommandBuffer)> executeFn;
+    bool sideEffect = false;
+
+    //compile 结果
+    bool culled = false;
+    bool async = false;
+    std::vector<RGStateOp> stateOps;
+
+    RGPass& read(RGHandle resource , RGAccessType accessType){
+        accesses.push_back({resource , accessType , false});
+        return *this;
+    }
+
+    RGPass& write(RGHandle resource , RGAccessType accessType){
+        accesses.push_back({resource , accessType , true});
+        return *this;
+    }
+
+    //有副作用的pass(例如写回读缓存)不会被剔除
+    RGPass& setSideEffect(){
+        sideEffect = true;
+        return *this;
+    }
+
+    RGPass& setExecute(std::function<void(VkCommandBuffer)> fn){
+        executeFn = fn;
+        return *this;
+    }
+};
+
+//execute 的结果  用于提交
+struct RGExecuteResult{
+    bool asyncWork = false;//异步计算指令缓存中有内容 需要提交
+    VkPipelineStageFlags graphicsWaitStage = 0;//图形队列等待异步信号量的阶段
+};
+
+struct RGStats{
+    uint32_t passCount = 0;
+    uint32_t culledPasses = 0;
+    uint32_t asyncPasses = 0;
+    uint32_t barrierBatches = 0;//execute 之后有效
+    uint32_t imageBarriers = 0;
+    uint32_t bufferBarriers = 0;
+    uint32_t skippedTransitions = 0;
+    VkDeviceSize transientRequested = 0;//不做别名时需要的内存  (当前飞行帧)
+    VkDeviceSize transientAllocated = 0;//别名后实际分配的内存  (当前飞行帧)
+    VkDeviceSize transientLazy = 0;//其中 lazily allocated 的内存
+};
+
+class RenderGraph{
+public:
+    RGStats stats;
+
+    //asyncFamily < 0 或与图形队列簇相同时 不使用异步计算
+    //useSync2 为 false 或设备不支持时 屏障使用 vkCmdPipelineBarrier
+    void init(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd ,
+            int graphicsFamily , int asyncFamily , uint32_t retireFrames , bool useSync2){
+        this->device = device;
+        tracker.init(vkd , useSync2);
+        this->vkd = vkd;
+        this->graphicsFamily = graphicsFamily;
+        this->asyncFamily = asyncFamily;
+        this->retireFrames = retireFrames;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+    }
+
+    bool asyncEnabled() const{
+        return asyncFamily >= 0 && asyncFamily != graphicsFamily;
+    }
+
+    bool sync2Enabled() const{
+        return tracker.sync2Enabled();
+    }
+
+    //非空时 每个pass (含之前的屏障) 是一个 GPU 计时作用域
+    void setProfiler(GpuProfiler *profiler){
+        this->profiler = profiler;
+    }
+
+    void destroy(){
+        for(TransientSet &set : transientSets){
+            retireTransients(set);
+        }//end for each
+        transientSets.clear();
+        for(Garbage &garbage : garbageList){
+            destroyGarbage(garbage);
+        }//end for each
+        garbageList.clear();
+    }
+
+    //开始声明新的一帧  frameSlot 为飞行帧序号 每个飞行帧使用自己的一组临时图像
+    void reset(uint32_t frameSlot = 0){
+        resources.clear();
+        passes.clear();
+        frameIndex++;
+        this->frameSlot = frameSlot;
+        if(transientSets.size() <= frameSlot){
+            transientSets.resize(frameSlot + 1);
+        }
+    }
+
+    RGHandle importImage(const std::string &name , VkImage image , VkImageView view , const RGImageDesc &desc ,
+            const RGResourceState &initialState){
+        RGResource resource;
+        resource.name = name;
+        resource.isImage = true;
+        resource.imported = true;
+        resource.image = image;
+        resource.view = view;
+        resource.desc = desc;
+        resource.initialState = initialState;
+        return addResource(resource);
+    }
+
+    RGHandle importBuffer(const std::string &name , VkBuffer buffer , VkDeviceSize size ,
+            const RGResourceState &initialState){
+        RGResource resource;
+        resource.name = name;
+        resource.isImage = false;
+        resource.imported = true;
+        resource.buffer = buffer;
+        resource.size = size;
+        resource.initialState = initialState;
+        return addResource(resource);
+    }
+
+    //临时图像 只在本帧内有效 内容在第一次使用前未定义
+    RGHandle createImage(const std::string &name , const RGImageDesc &desc){
+        RGResource resource;
+        resource.name = name;
+        resource.isImage = true;
+        resource.imported = false;
+        resource.desc = desc;
+        return addResource(resource);
+    }
+
+    //标记为帧图的输出 执行完成后转换到 finalState
+    void markOutput(RGHandle handle , const RGResourceState &finalState){
+        resources[handle].output = true;
+        resources[handle].finalState = finalState;
+    }
+
+    RGHandle findResource(const std::string &name) const{
+        for(uint32_t i = 0 ; i < resources.size() ; i++){
+            if(resources[i].name == name){
+                return i;
+            }
+        }//end for i
+        return RG_INVALID_HANDLE;
+    }
+
+    RGPass& addPass(const std::string &name , RGPassType type){
+        RGPass pass;
+        pass.name = name;
+        pass.type = type;
+        passes.push_back(pass);
+        return passes.back();
+    }
+
+    VkImage image(RGHandle handle) const{
+        return resources[handle].image;
+    }
+
+    VkImageView imageView(RGHandle handle) const{
+        return resources[handle].view;
+    }
+
+    VkBuffer buffer(RGHandle handle) const{
+        return resources[handle].buffer;
+    }
+
+    void compile(){
+        stats = RGStats();
+        stats.passCount = static_cast<uint32_t>(passes.size());
+
+        collectGarbage();
+        cullPasses();
+        scheduleQueues();
+        computeLifetimes();
+        allocateTransients();
+        buildBarriers();
+    }
+
+    RGExecuteResult execute(VkCommandBuffer graphicsCmd , VkCommandBuffer asyncCmd){
+        RGExecuteResult result;
+        result.graphicsWaitStage = graphicsWaitStage;
+
+        tracker.reset();
+        tracker.resetStats();
+        for(const RGResource &resource : resources){
+            if(resource.firstPass < 0 && !resource.output){
+                continue;
+            }
+            if(resource.isImage){
+                tracker.registerImage(resource.image , resource.desc.aspect , resource.desc.mipLevels ,
+                    resource.desc.arrayLayers , toTrackedState(resource.initialState));
+            }else{
+                tracker.registerBuffer(resource.buffer , resource.size , toTrackedState(resource.initialState));
+            }
+        }//end for each
+
+        for(RGPass &pass : passes){
+            if(pass.culled){
+                continue;
+            }
+
+            VkCommandBuffer cmd = pass.async ? asyncCmd : graphicsCmd;
+            result.asyncWork |= pass.async;
+            GpuScope scope(profiler , cmd , pass.name , pass.async);
+            applyStateOps(cmd , pass.stateOps);
+            if(pass.executeFn){
+                pass.executeFn(cmd);
+            }
+        }//end for each
+
+        applyStateOps(graphicsCmd , finalStateOps);
+
+        stats.barrierBatches = tracker.stats.batches;
+        stats.imageBarriers = tracker.stats.imageBarriers;
+        stats.bufferBarriers = tracker.stats.bufferBarriers;
+        stats.skippedTransitions = tracker.stats.skipped;
+        return result;
+    }
+
+    void printStats() const{
+        std::cout << "render graph passes : " << stats.passCount
+            << " culled : " << stats.culledPasses
+            << " async : " << stats.asyncPasses
+            << " barrier batches : " << stats.barrierBatches
+            << " image barriers : " << stats.imageBarriers
+            << " buffer barriers : " << stats.bufferBarriers
+            << " skipped : " << stats.skippedTransitions
+            << (tracker.sync2Enabled() ? " (sync2)" : " (legacy barriers)")
+            << " transient memory : " << (stats.transientAllocated >> 10) << " KB"
+            << (stats.transientLazy > 0 ? " (" + std::to_string(stats.transientLazy >> 10) + " KB lazily allocated)" : "")
+            << " (without aliasing " << (stats.transientRequested >> 10) << " KB) per frame in flight" << std::endl;
+    }
+
+    //当前飞行帧的临时内存实际提交的大小  lazily allocated 内存由驱动按需提交
+    VkDeviceSize transientCommittedSize() const{
+        VkDeviceSize committed = 0;
+        if(frameSlot >= transientSets.size()){
+            return committed;
+        }
+        for(const TransientHeap &heap : transientSets[frameSlot].heaps){
+            if(!heap.lazilyAllocated){
+                committed += heap.size;
+                continue;
+            }
+            VkDeviceSize heapCommitted = 0;
+            vkGetDeviceMemoryCommitment(device , heap.memory , &heapCommitted);
+            committed += heapCommitted;
+        }//end for each
+        return committed;
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    DeviceDispatchTable *vkd = nullptr;
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    int graphicsFamily = -1;
+    int asyncFamily = -1;
+    uint32_t retireFrames = 3;
+    uint64_t frameIndex = 0;
+    uint32_t frameSlot = 0;
+
+    std::vector<RGResource> resources;
+    std::deque<RGPass> passes;
+
+    ResourceStateTracker tracker;
+    GpuProfiler *profiler = nullptr;
+    VkPipelineStageFlags graphicsWaitStage = 0;
+    std::vector<RGStateOp> finalStateOps;
+
+    //临时图像缓存  布局不变时跨帧复用
+    struct TransientImage{
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        uint32_t heap = 0;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+    //同一内存类型的临时图像共用一块内存
+    struct TransientHeap{
+        uint32_t memoryType = 0;
+        bool lazilyAllocated = false;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+    };
+    //一个飞行帧的临时图像  该飞行帧的 fence 等待之后才会重建 不与其他飞行帧共享内存
+    struct TransientSet{
+        std::string signature;
+        std::map<std::string , TransientImage> images;
+        std::vector<TransientHeap> heaps;
+        VkDeviceSize requestedSize = 0;
+    };
+    std::vector<TransientSet> transientSets;
+
+    //仍可能被飞行中的帧使用的对象 延迟 retireFrames 帧销毁
+    struct Garbage{
+        uint64_t frame = 0;
+        std::vector<VkImage> images;
+        std::vector<VkImageView> views;
+        std::vector<VkDeviceMemory> memories;
+    };
+    std::vector<Garbage> garbageList;
+
+    RGHandle addResource(const RGResource &resource){
+        if(findResource(resource.name) != RG_INVALID_HANDLE){
+            throw std::runtime_error("render graph resource redeclared " + resource.name);
+        }
+        resources.push_back(resource);
+        return static_cast<RGHandle>(resources.size() - 1);
+    }
+
+    bool isWriteAccess(const RGPassAccess &access , RGPassType passType) const{
+        return access.write || rgGetAccessInfo(access.type , passType).write;
+    }
+
+    //从后往前: 写入了被需要资源的pass才保留 保留的pass读取的资源成为被需要的资源
+    void cullPasses(){
+        std::set<RGHandle> needed;
+        for(RGHandle i = 0 ; i < resources.size() ; i++){
+            if(resources[i].output){
+                needed.insert(i);
+            }
+        }//end for i
+
+        for(int p = static_cast<int>(passes.size()) - 1 ; p >= 0 ; p--){
+            RGPass &pass = passes[p];
+            bool contributes = pass.sideEffect;
+            for(const RGPassAccess &access : pass.accesses){
+                if(isWriteAccess(access , pass.type) && needed.count(access.resource)){
+                    contributes = true;
+                }
+            }//end for each
+            pass.culled = !contributes;
+            if(pass.culled){
+                stats.culledPasses++;
+                continue;
+            }
+
+            //只写不读的资源 更早的写入者不再需要
+            for(const RGPassAccess &access : pass.accesses){
+                if(isWriteAccess(access , pass.type)){
+                    needed.erase(access.resource);
+                }
+            }//end for each
+            for(const RGPassAccess &access : pass.accesses){
+                if(!access.write){
+                    needed.insert(access.resource);
+                }
+            }//end for each
+        }//end for p
+    }
+
+    //异步pass 只有在不依赖本帧图形队列工作时 才放到计算队列
+    void scheduleQueues(){
+        std::set<RGHandle> touchedByGraphics;
+        for(RGPass &pass : passes){
+            if(pass.culled){
+                continue;
+            }
+
+            pass.async = false;
+            if(pass.type == RG_PASS_ASYNC_COMPUTE && asyncEnabled()){
+                pass.async = true;
+                for(const RGPassAccess &access : pass.accesses){
+                    const RGResource &resource = resources[access.resource];
+                    if(touchedByGraphics.count(access.resource) || (resource.isImage && resource.imported)){
+                        pass.async = false;
+                    }
+                }//end for each
+            }
+
+            if(pass.async){
+                stats.asyncPasses++;
+            }else{
+                for(const RGPassAccess &access : pass.accesses){
+                    touchedByGraphics.insert(access.resource);
+                }//end for each
+            }
+        }//end for each
+    }
+
+    void computeLifetimes(){
+        for(int p = 0 ; p < static_cast<int>(passes.size()) ; p++){
+            RGPass &pass = passes[p];
+            if(pass.culled){
+                continue;
+            }
+
+            for(const RGPassAccess &access : pass.accesses){
+                RGResource &resource = resources[access.resource];
+                if(resource.firstPass < 0){
+                    resource.firstPass = p;
+                }
+                resource.lastPass = p;
+                resource.asyncShared = resource.asyncShared || pass.async;
+                resource.usage |= rgGetAccessInfo(access.type , pass.type).imageUsage;
+            }//end for each
+        }//end for p
+    }
+
+    //异步pass与图形pass之间没有帧内的先后关系 其资源视为整帧存活
+    bool lifetimesOverlap(const RGResource &a , const RGResource &b) const{
+        if(a.asyncShared || b.asyncShared){
+            return true;
+        }
+        return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+    }
+
+    //临时图像的内存别名
+    //按大小从大到小放置 每个图像放在同一内存块中 与其生命周期重叠的已放置图像都不冲突的最低偏移
+    void allocateTransients(){
+        TransientSet &set = transientSets[frameSlot];
+        std::vector<RGHandle> transients;
+        std::ostringstream signature;
+        for(RGHandle i = 0 ; i < resources.size() ; i++){
+            const RGResource &resource = resources[i];
+            if(resource.imported || resource.firstPass < 0){
+                continue;
+            }
+            transients.push_back(i);
+            signature << resource.name << ":" << resource.desc.format << ":" << resource.desc.extent.width
+                << "x" << resource.desc.extent.height << ":" << resource.desc.samples << ":" << resource.desc.mipLevels << ":" << resource.desc.arrayLayers << ":"
+                << (resource.usage | resource.desc.extraUsage) << ":" << resource.firstPass << "-" << resource.lastPass
+                << (resource.asyncShared ? ":async" : "") << ";";
+        }//end for i
+
+        if(signature.str() != set.signature){
+            retireTransients(set);
+            set.signature = signature.str();
+            createTransients(set , transients);
+        }
+
+        for(RGHandle handle : transients){
+            RGResource &resource = resources[handle];
+            const TransientImage &transient = set.images[resource.name];
+            resource.image = transient.image;
+            resource.view = transient.view;
+            resource.memoryHeap = transient.heap;
+            resource.memoryOffset = transient.offset;
+            resource.memorySize = transient.size;
+        }//end for each
+
+        stats.transientRequested = set.requestedSize;
+        for(const TransientHeap &heap : set.heaps){
+            stats.transientAllocated += heap.size;
+            stats.transientLazy += heap.lazilyAllocated ? heap.size : 0;
+        }//end for each
+    }
+
+    void createTransients(TransientSet &set , const std::vector<RGHandle> &transients){
+        if(transients.empty()){
+            return;
+        }
+
+        std::vector<VkMemoryRequirements> requirements(transients.size());
+        for(size_t i = 0 ; i < transients.size() ; i++){
+            RGResource &resource = resources[transients[i]];
+            const VkImageUsageFlags usage = resource.usage | resource.desc.extraUsage;
+
+            VkImageCreateInfo imageCreateInfo = {};
+            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageCreateInfo.format = resource.desc.format;
+            imageCreateInfo.extent = {resource.desc.extent.width , resource.desc.extent.height , 1};
+            imageCreateInfo.mipLevels = resource.desc.mipLevels;
+            imageCreateInfo.arrayLayers = resource.desc.arrayLayers;
+            imageCreateInfo.samples = resource.desc.samples;
+            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageCreateInfo.usage = usage;
+            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            //异步计算时 两个队列簇共享 省去队列所有权转移
+            uint32_t families[] = {static_cast<uint32_t>(graphicsFamily) , static_cast<uint32_t>(asyncFamily)};
+            if(asyncEnabled()){
+                imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+                imageCreateInfo.queueFamilyIndexCount = 2;
+                imageCreateInfo.pQueueFamilyIndices = families;
+            }else{
+                imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            }
+
+            TransientImage transient;
+            if(vkCreateImage(device , &imageCreateInfo , nullptr , &transient.image) != VK_SUCCESS){
+                throw std::runtime_error("render graph failed to create image " + resource.name);
+            }
+            vkGetImageMemoryRequirements(device , transient.image , &requirements[i]);
+            transient.size = requirements[i].size;
+
+            //只在渲染内使用的附件优先 lazily allocated (tile based GPU 上不占显存)  否则显存
+            int memoryType = -1;
+            if(usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT){
+                memoryType = findMemoryTypeIndex(memoryProperties , requirements[i].memoryTypeBits ,
+                    VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+            }
+            const bool lazilyAllocated = memoryType >= 0;
+            if(!lazilyAllocated){
+                memoryType = static_cast<int>(findMemoryType(memoryProperties , requirements[i].memoryTypeBits ,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+            }
+
+            transient.heap = static_cast<uint32_t>(set.heaps.size());
+            for(uint32_t h = 0 ; h < set.heaps.size() ; h++){
+                if(set.heaps[h].memoryType == static_cast<uint32_t>(memoryType)){
+                    transient.heap = h;
+                    break;
+                }
+            }//end for h
+            if(transient.heap == set.heaps.size()){
+                TransientHeap heap;
+                heap.memoryType = static_cast<uint32_t>(memoryType);
+                heap.lazilyAllocated = lazilyAllocated;
+                set.heaps.push_back(heap);
+            }
+            set.images[resource.name] = transient;
+        }//end for i
+
+        std::vector<size_t> order(transients.size());
+        for(size_t i = 0 ; i < order.size() ; i++){
+            order[i] = i;
+        }
+        std::sort(order.begin() , order.end() , [&requirements](size_t a , size_t b){
+            return requirements[a].size > requirements[b].size;
+        });
+
+        set.requestedSize = 0;
+        std::vector<size_t> placed;
+        for(size_t i : order){
+            const RGResource &resource = resources[transients[i]];
+            const VkMemoryRequirements &req = requirements[i];
+            TransientImage &transient = set.images[resource.name];
+            set.requestedSize += req.size;
+
+            //候选偏移: 0 以及同一内存块中每个已放置图像的末尾
+            std::vector<VkDeviceSize> candidates = {0};
+            for(size_t j : placed){
+                const TransientImage &other = set.images[resources[transients[j]].name];
+                if(other.heap == transient.heap){
+                    candidates.push_back(alignUp(other.offset + requirements[j].size , req.alignment));
+                }
+            }//end for each
+            std::sort(candidates.begin() , candidates.end());
+
+            VkDeviceSize offset = 0;
+            for(VkDeviceSize candidate : candidates){
+                bool conflict = false;
+                for(size_t j : placed){
+                    const RGResource &other = resources[transients[j]];
+                    const TransientImage &otherTransient = set.images[other.name];
+                    if(otherTransient.heap != transient.heap){
+                        continue;
+                    }
+                    const bool memoryOverlap = candidate < otherTransient.offset + requirements[j].size
+                        && otherTransient.offset < candidate + req.size;
+                    if(memoryOverlap && lifetimesOverlap(resource , other)){
+                        conflict = true;
+                        break;
+                    }
+                }//end for each
+                if(!conflict){
+                    offset = candidate;
+                    break;
+                }
+            }//end for each
+
+            transient.offset = offset;
+            TransientHeap &heap = set.heaps[transient.heap];
+            heap.size = std::max(heap.size , offset + req.size);
+            placed.push_back(i);
+        }//end for each
+
+        for(TransientHeap &heap : set.heaps){
+            VkMemoryAllocateInfo allocateInfo = {};
+            allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocateInfo.allocationSize = heap.size;
+            allocateInfo.memoryTypeIndex = heap.memoryType;
+            if(vkAllocateMemory(device , &allocateInfo , nullptr , &heap.memory) != VK_SUCCESS){
+                throw std::runtime_error("render graph failed to allocate transient memory");
+            }
+        }//end for each
+
+        for(RGHandle handle : transients){
+            const RGResource &resource = resources[handle];
+            TransientImage &transient = set.images[resource.name];
+            vkBindImageMemory(device , transient.image , set.heaps[transient.heap].memory , transient.offset);
+
+            VkImageViewCreateInfo viewCreateInfo = {};
+            viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewCreateInfo.image = transient.image;
+            viewCreateInfo.viewType = resource.desc.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            viewCreateInfo.format = resource.desc.format;
+            viewCreateInfo.subresourceRange.aspectMask = resource.desc.aspect;
+            viewCreateInfo.subresourceRange.levelCount = resource.desc.mipLevels;
+            viewCreateInfo.subresourceRange.layerCount = resource.desc.arrayLayers;
+            if(vkCreateImageView(device , &viewCreateInfo , nullptr , &transient.view) != VK_SUCCESS){
+                throw std::runtime_error("render graph failed to create image view " + resource.name);
+            }
+        }//end for each
+    }
+
+    void retireTransients(TransientSet &set){
+        Garbage garbage;
+        garbage.frame = frameIndex;
+        for(auto &entry : set.images){
+            garbage.images.push_back(entry.second.image);
+            garbage.views.push_back(entry.second.view);
+        }//end for each
+        for(TransientHeap &heap : set.heaps){
+            garbage.memories.push_back(heap.memory);
+        }//end for each
+        garbageList.push_back(garbage);
+
+        set.images.clear();
+        set.heaps.clear();
+        set.requestedSize = 0;
+        set.signature.clear();
+    }
+
+    void collectGarbage(){
+        for(auto it = garbageList.begin() ; it != garbageList.end() ;){
+            if(frameIndex >= it->frame + retireFrames){
+                destroyGarbage(*it);
+                it = garbageList.erase(it);
+            }else{
+                ++it;
+            }
+        }//end for
+    }
+
+    void destroyGarbage(Garbage &garbage){
+        for(VkImageView view : garbage.views){
+            vkDestroyImageView(device , view , nullptr);
+        }
+        for(VkImage image : garbage.images){
+            vkDestroyImage(device , image , nullptr);
+        }
+        for(VkDeviceMemory memory : garbage.memories){
+            vkFreeMemory(device , memory , nullptr);
+        }
+    }
+
+    //临时图像第一次使用时 需要等待之前占用同一块内存的图像的最后一次使用
+    RGResourceState aliasInitialState(RGHandle handle) const{
+        const RGResource &resource = resources[handle];
+        RGResourceState state;
+        state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        state.stage = 0;
+        for(const RGResource &other : resources){
+            if(other.imported || other.firstPass < 0 || &other == &resource || lifetimesOverlap(resource , other)){
+                continue;
+            }
+            const bool memoryOverlap = resource.memoryHeap == other.memoryHeap
+                && resource.memoryOffset < other.memoryOffset + other.memorySize
+                && other.memoryOffset < resource.memoryOffset + resource.memorySize;
+            if(memoryOverlap){
+                state.stage |= other.state.stage;
+                state.access |= other.state.write ? other.state.access : 0;
+                state.write = state.write || other.state.write;
+            }
+        }//end for each
+        if(state.stage == 0){
+            state.stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        }
+        return state;
+    }
+
+    //按pass顺序推演资源状态 生成交给 tracker 的状态操作
+    void buildBarriers(){
+        graphicsWaitStage = 0;
+        for(RGHandle i = 0 ; i < resources.size() ; i++){
+            resources[i].state = resources[i].initialState;
+            resources[i].accessed = false;
+        }//end for i
+
+        for(int p = 0 ; p < static_cast<int>(passes.size()) ; p++){
+            RGPass &pass = passes[p];
+            pass.stateOps.clear();
+            if(pass.culled){
+                continue;
+            }
+
+            //同一个pass中对同一资源的多次访问合并
+            std::map<RGHandle , RGResourceState> required;
+            for(const RGPassAccess &access : pass.accesses){
+                const RGAccessInfo info = rgGetAccessInfo(access.type , pass.type);
+                auto it = required.find(access.resource);
+                if(it == required.end()){
+                    RGResourceState state;
+                    state.layout = info.layout;
+                    state.stage = info.stage;
+                    state.access = info.access;
+                    state.write = info.write || access.write;
+                    state.asyncQueue = pass.async;
+                    required[access.resource] = state;
+                }else{
+                    if(it->second.layout != info.layout){
+                        it->second.layout = VK_IMAGE_LAYOUT_GENERAL;
+                    }
+                    it->second.stage |= info.stage;
+                    it->second.access |= info.access;
+                    it->second.write = it->second.write || info.write || access.write;
+                }
+            }//end for each
+
+            for(auto &entry : required){
+                RGResource &resource = resources[entry.first];
+                if(!resource.imported && resource.firstPass == p){
+                    //别名内存上一任使用者的状态  内容不保留
+                    resource.state = aliasInitialState(entry.first);
+                    pass.stateOps.push_back({entry.first , true , resource.state});
+                }
+                transition(entry.first , entry.second , pass.stateOps);
+            }//end for each
+        }//end for p
+
+        finalStateOps.clear();
+        for(RGHandle i = 0 ; i < resources.size() ; i++){
+            if(resources[i].output){
+                RGResourceState finalState = resources[i].finalState;
+                finalState.asyncQueue = false;
+                transition(i , finalState , finalStateOps);
+            }
+        }//end for i
+    }
+
+    void transition(RGHandle handle , const RGResourceState &next , std::vector<RGStateOp> &ops){
+        RGResource &resource = resources[handle];
+        RGResourceState &prev = resource.state;
+        const bool layoutChange = resource.isImage && prev.layout != next.layout;
+        const bool crossQueue = resource.accessed && prev.asyncQueue != next.asyncQueue;
+        const bool firstAsyncAccess = !resource.accessed && next.asyncQueue;
+        resource.accessed = true;
+
+        if(firstAsyncAccess){
+            //计算队列不支持图形阶段 与上一帧的同步由调用者按飞行帧区分资源保证
+            RGResourceState unsynchronized = prev;
+            unsynchronized.stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            unsynchronized.access = 0;
+            unsynchronized.write = false;
+            ops.push_back({handle , true , unsynchronized});
+        }
+
+        //跨队列时 信号量已经提供了内存依赖  只剩布局转换
+        if(crossQueue){
+            if(next.asyncQueue){
+                throw std::runtime_error("render graph async pass depends on graphics work " + resource.name);
+            }
+            graphicsWaitStage |= next.stage;
+            if(!layoutChange){
+                ops.push_back({handle , true , next});
+                prev = next;
+                return;
+            }
+            RGResourceState waited = prev;
+            waited.stage = next.stage;
+            waited.access = 0;
+            waited.write = false;
+            ops.push_back({handle , true , waited});
+        }
+
+        ops.push_back({handle , false , next});
+
+        //读后读 记录读的阶段 之后的写需要等待  新的读是否已经可见 由 tracker 按上一次写判断
+        if(!layoutChange && !prev.write && !next.write && !crossQueue){
+            prev.stage |= next.stage;
+            prev.access |= next.access;
+        }else{
+            prev = next;
+        }
+    }
+
+    static TrackedState toTrackedState(const RGResourceState &state){
+        TrackedState tracked;
+        tracked.layout = state.layout;
+        tracked.stage = static_cast<VkPipelineStageFlags2KHR>(state.stage);
+        tracked.access = static_cast<VkAccessFlags2KHR>(state.access);
+        if(!state.write){
+            //只读状态下的写标记没有意义 去掉避免产生多余的可用性操作
+            tracked.access &= ~static_cast<VkAccessFlags2KHR>(VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+                | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
+                | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+        }
+        return tracked;
+    }
+
+    //登记本批的转换 然后一次提交
+    void applyStateOps(VkCommandBuffer cmd , const std::vector<RGStateOp> &ops){
+        for(const RGStateOp &op : ops){
+            const RGResource &resource = resources[op.resource];
+            const TrackedState state = toTrackedState(op.state);
+            if(resource.isImage){
+                if(op.setOnly){
+                    tracker.setImageState(resource.image , state);
+                }else{
+                    tracker.transitionImage(resource.image , state.layout , state.stage , state.access);
+                }
+            }else{
+                if(op.setOnly){
+                    tracker.setBufferState(resource.buffer , 0 , VK_WHOLE_SIZE , state);
+                }else{
+                    tracker.transitionBuffer(resource.buffer , 0 , VK_WHOLE_SIZE , state.stage , state.access);
+                }
+            }
+        }//end for each
+        tracker.flush(cmd);
+    }
+};
+
+#endif
@@ -0,0 +1,402 @@
+#ifndef _RENDER_QUEUE_H_
+#define _RENDER_QUEUE_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "device_dispatch.hpp"
+
+//渲染队列
+//绘制先收集为紧凑的 DrawPacket  每个带一个 64 位排序键  排序后按顺序录制
+//录制时只在状态变化时重新绑定 (管线 材质描述符集 顶点buffer)
+//排序键 (高位优先):
+//  pass      4 位   深度预处理 不透明 ...
+//  pipeline 12 位
+//  material 16 位
+//  depth    32 位   浮点数的位模式 转换后按大小有序
+//同一管线 同一材质的绘制相邻  切换次数最少
+
+//排序键的 pass 字段
+enum QueuePass{
+    QUEUE_PASS_DEPTH_PREPASS = 0,
+    QUEUE_PASS_OPAQUE,
+    QUEUE_PASS_TRANSPARENT
+};
+
+static const uint32_t RENDER_KEY_PASS_BITS = 4;
+static const uint32_t RENDER_KEY_PIPELINE_BITS = 12;
+static const uint32_t RENDER_KEY_MATERIAL_BITS = 16;
+
+//float 转为按数值有序的无符号整数  负数取反 正数翻转符号位
+static uint32_t sortableDepth(float depth){
+    uint32_t bits;
+    std::memcpy(&bits , &depth , sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+static uint64_t makeRenderKey(uint32_t pass , uint32_t pipeline , uint32_t material , float depth){
+    const uint64_t passBits = pass & ((1u << RENDER_KEY_PASS_BITS) - 1);
+    const uint64_t pipelineBits = pipeline & ((1u << RENDER_KEY_PIPELINE_BITS) - 1);
+    const uint64_t materialBits = material & ((1u << RENDER_KEY_MATERIAL_BITS) - 1);
+    return (passBits << 60) | (pipelineBits << 48) | (materialBits << 32) | sortableDepth(depth);
+}
+
+//一次绘制  状态以下标引用 RenderQueueResources 中的对象
+struct DrawPacket{
+    uint64_t key;
+    uint16_t pipeline;
+    uint16_t material;
+    uint16_t vertexInput;
+    uint16_t reserved;
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+//一组顶点 buffer 绑定 (例如一帧的实例流)
+struct RenderQueueVertexInput{
+    static const uint32_t MAX_BINDINGS = 4;
+    VkBuffer buffers[MAX_BINDINGS] = {};
+    VkDeviceSize offsets[MAX_BINDINGS] = {};
+    uint32_t count = 0;
+};
+
+//录制时使用的状态对象  materialSets 为空时不绑定材质描述符集
+struct RenderQueueResources{
+    std::vector<VkPipeline> pipelines;
+    std::vector<VkDescriptorSet> materialSets;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    uint32_t materialSetIndex = 0;
+    std::vector<RenderQueueVertexInput> vertexInputs;
+};
+
+//一次录制的状态切换次数
+struct RenderStateCounters{
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+
+    uint32_t total() const{
+        return pipelineBinds + descriptorBinds + vertexBufferBinds;
+    }
+};
+
+//并行 LSD 基数排序  每趟 8 位 共 8 趟
+//每个线程负责一段: 统计本段的直方图 -> 所有线程的直方图求前缀和得到每段每个桶的起点 -> 各自分散写入
+//某一位上所有键都相同的趟直接跳过 (排序键的高位通常只有少数取值)
+//工作线程在第一次并行排序时创建 之后常驻 (随 RenderQueue 销毁)  每次排序只唤醒需要的线程
+class RadixSorter{
+public:
+    struct Item{
+        uint64_t key;
+        uint32_t index;
+    };
+
+    RadixSorter() = default;
+    RadixSorter(const RadixSorter &) = delete;
+    RadixSorter& operator=(const RadixSorter &) = delete;
+
+    ~RadixSorter(){
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+        }
+        jobCondition.notify_all();
+        for(std::thread &worker : workers){
+            worker.join();
+        }//end for each
+    }
+
+    //items 排序后写回  threadCount 为 0 时使用硬件线程数  元素较少时单线程
+    void sort(std::vector<Item> &items , uint32_t threadCount = 0){
+        const size_t count = items.size();
+        if(count < 2){
+            return;
+        }
+        if(threadCount == 0){
+            threadCount = std::max(1u , std::thread::hardware_concurrency());
+        }
+        if(count < PARALLEL_THRESHOLD){
+            threadCount = 1;
+        }
+        threadCount = static_cast<uint32_t>(std::min<size_t>(threadCount , count));
+        scratch.resize(count);
+
+        //键的各位在置换下不变  先判断哪些趟是有效的
+        const uint64_t first = items[0].key;
+        uint64_t differing = 0;
+        for(size_t i = 1 ; i < count ; i++){
+            differing |= items[i].key ^ first;
+        }//end for i
+        passes.clear();
+        for(uint32_t pass = 0 ; pass < PASS_COUNT ; pass++){
+            if((differing >> (pass * 8)) & 0xFF){
+                passes.push_back(pass);
+            }
+        }//end for pass
+        if(passes.empty()){
+            return;
+        }
+
+        histograms.assign(threadCount , std::vector<size_t>(BUCKET_COUNT));
+        src = items.data();
+        dst = scratch.data();
+
+        if(threadCount == 1){
+            for(uint32_t pass : passes){
+                runPass(0 , 1 , pass , true);
+                std::swap(src , dst);
+            }//end for each
+        }else{
+            //上一次排序的线程都已结束 可以安全地重置屏障
+            barrier.reset(threadCount);
+            while(workers.size() + 1 < threadCount){
+                const uint32_t t = static_cast<uint32_t>(workers.size()) + 1;
+                workers.emplace_back([this , t](){
+                    workerLoop(t);
+                });
+            }//end while
+            {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                jobThreads = threadCount;
+                jobPending = threadCount - 1;
+                jobGeneration++;
+            }
+            jobCondition.notify_all();
+
+            sortWorker(0 , threadCount);
+
+            std::unique_lock<std::mutex> lock(jobMutex);
+            doneCondition.wait(lock , [this](){ return jobPending == 0; });
+        }
+
+        //奇数趟时结果在 scratch 中
+        if(src != items.data()){
+            std::memcpy(items.data() , src , count * sizeof(Item));
+        }
+    }
+
+private:
+    static const uint32_t PASS_COUNT = 8;
+    static const uint32_t BUCKET_COUNT = 256;
+    static const size_t PARALLEL_THRESHOLD = 16384;
+
+    //可重复使用的线程屏障
+    class Barrier{
+    public:
+        explicit Barrier(uint32_t count) : count(count){}
+
+        //只能在没有线程等待时调用
+        void reset(uint32_t count){
+            std::lock_guard<std::mutex> lock(mutex);
+            this->count = count;
+            arrived = 0;
+        }
+
+        void wait(){
+            std::unique_lock<std::mutex> lock(mutex);
+            const uint64_t generation = this->generation;
+            if(++arrived == count){
+                arrived = 0;
+                this->generation++;
+                condition.notify_all();
+                return;
+            }
+            condition.wait(lock , [this , generation](){ return this->generation != generation; });
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        uint32_t count;
+        uint32_t arrived = 0;
+        uint64_t generation = 0;
+    };
+
+    std::vector<Item> scratch;
+    std::vector<uint32_t> passes;
+    std::vector<std::vector<size_t>> histograms;
+    Item *src = nullptr;
+    Item *dst = nullptr;
+
+    //常驻工作线程 (1 号起)  0 号为调用 sort 的线程
+    std::vector<std::thread> workers;
+    Barrier barrier{1};
+    std::mutex jobMutex;
+    std::condition_variable jobCondition;
+    std::condition_variable doneCondition;
+    uint64_t jobGeneration = 0;
+    uint32_t jobThreads = 0;//本次排序参与的线程数
+    uint32_t jobPending = 0;//尚未结束的工作线程数
+    bool stopping = false;
+
+    void workerLoop(uint32_t thread){
+        uint64_t generation = 0;
+        for(;;){
+            uint32_t threadCount = 0;
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobCondition.wait(lock , [this , generation](){ return stopping || jobGeneration != generation; });
+                if(stopping){
+                    return;
+                }
+                generation = jobGeneration;
+                threadCount = jobThreads;
+            }
+            if(thread >= threadCount){
+                continue;
+            }
+
+            sortWorker(thread , threadCount);
+
+            bool last = false;
+            {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                last = --jobPending == 0;
+            }
+            if(last){
+                doneCondition.notify_one();
+            }
+        }//end for
+    }
+
+    void sortWorker(uint32_t thread , uint32_t threadCount){
+        for(uint32_t pass : passes){
+            runPass(thread , threadCount , pass , false , &barrier);
+            //0 号线程交换读写缓冲  其余线程等待交换完成
+            if(thread == 0){
+                std::swap(src , dst);
+            }
+            barrier.wait();
+        }//end for each
+    }
+
+    //一趟排序  单线程时 barrier 为空
+    void runPass(uint32_t thread , uint32_t threadCount , uint32_t pass , bool single , Barrier *barrier = nullptr){
+        const size_t count = scratch.size();
+        const size_t begin = count * thread / threadCount;
+        const size_t end = count * (thread + 1) / threadCount;
+        const uint32_t shift = pass * 8;
+
+        std::vector<size_t> &histogram = histograms[thread];
+        std::fill(histogram.begin() , histogram.end() , 0);
+        for(size_t i = begin ; i < end ; i++){
+            histogram[(src[i].key >> shift) & 0xFF]++;
+        }//end for i
+        if(!single){
+            barrier->wait();
+        }
+
+        //本段每个桶的起点 = 所有更小的桶 + 前面各段中同一个桶
+        size_t offsets[BUCKET_COUNT];
+        size_t base = 0;
+        for(uint32_t bucket = 0 ; bucket < BUCKET_COUNT ; bucket++){
+            size_t before = 0;
+            size_t total = 0;
+            for(uint32_t t = 0 ; t < threadCount ; t++){
+                if(t < thread){
+                    before += histograms[t][bucket];
+                }
+                total += histograms[t][bucket];
+            }//end for t
+            offsets[bucket] = base + before;
+            base += total;
+        }//end for bucket
+
+        for(size_t i = begin ; i < end ; i++){
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }//end for i
+        if(!single){
+            barrier->wait();
+        }
+    }
+};
+
+class RenderQueue{
+public:
+    RenderStateCounters counters;//最近一次 record 的统计
+
+    void clear(){
+        packets.clear();
+        order.clear();
+    }
+
+    void push(const DrawPacket &packet){
+        packets.push_back(packet);
+    }
+
+    size_t size() const{
+        return packets.size();
+    }
+
+    //按排序键排序  threadCount 见 RadixSorter::sort
+    void sort(uint32_t threadCount = 0){
+        order.resize(packets.size());
+        for(size_t i = 0 ; i < packets.size() ; i++){
+            order[i].key = packets[i].key;
+            order[i].index = static_cast<uint32_t>(i);
+        }//end for i
+        sorter.sort(order , threadCount);
+    }
+
+    //按排序后的顺序录制 (未排序时按提交顺序)  只绑定变化的状态
+    void record(VkCommandBuffer cmd , DeviceDispatchTable *vkd , const RenderQueueResources &resources){
+        walk(resources.materialSets.empty() , [&](const DrawPacket &packet , const DrawPacket *previous){
+            if(previous == nullptr || previous->pipeline != packet.pipeline){
+                vkd->vkCmdBindPipeline(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , resources.pipelines[packet.pipeline]);
+            }
+            if(!resources.materialSets.empty() && (previous == nullptr || previous->material != packet.material)){
+                vkd->vkCmdBindDescriptorSets(cmd , VK_PIPELINE_BIND_POINT_GRAPHICS , resources.layout ,
+                    resources.materialSetIndex , 1 , &resources.materialSets[packet.material] , 0 , nullptr);
+            }
+            if(previous == nullptr || previous->vertexInput != packet.vertexInput){
+                const RenderQueueVertexInput &input = resources.vertexInputs[packet.vertexInput];
+                vkd->vkCmdBindVertexBuffers(cmd , 0 , input.count , input.buffers , input.offsets);
+            }
+            vkd->vkCmdDraw(cmd , packet.vertexCount , packet.instanceCount , packet.firstVertex , packet.firstInstance);
+        });
+    }
+
+    //只统计状态切换次数 不录制
+    RenderStateCounters countStateChanges(bool bindMaterials = true){
+        walk(!bindMaterials , [](const DrawPacket & , const DrawPacket *){});
+        return counters;
+    }
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<RadixSorter::Item> order;
+    RadixSorter sorter;
+
+    template<typename Visit>
+    void walk(bool skipMaterials , Visit visit){
+        counters = RenderStateCounters();
+        const bool sorted = order.size() == packets.size();
+        const DrawPacket *previous = nullptr;
+        for(size_t i = 0 ; i < packets.size() ; i++){
+            const DrawPacket &packet = packets[sorted ? order[i].index : i];
+            if(previous == nullptr || previous->pipeline != packet.pipeline){
+                counters.pipelineBinds++;
+            }
+            if(!skipMaterials && (previous == nullptr || previous->material != packet.material)){
+                counters.descriptorBinds++;
+            }
+            if(previous == nullptr || previous->vertexInput != packet.vertexInput){
+                counters.vertexBufferBinds++;
+            }
+            counters.draws++;
+            visit(packet , previous);
+            previous = &packet;
+        }//end for i
+    }
+};
+
+#endif
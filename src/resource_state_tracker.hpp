@@ -0,0 +1,629 @@
+#ifndef _RESOURCE_STATE_TRACKER_H_
+#define _RESOURCE_STATE_TRACKER_H_
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "device_dispatch.hpp"
+
+//资源状态跟踪
+//记录每个图像子资源(mip/layer) 与每段buffer区间当前的 布局/访问/阶段
+//transition 只登记目标状态  flush 时一次性生成屏障 用一次 vkCmdPipelineBarrier2 提交
+//  1. 读后读且布局不变 新的读已在上一次写之后可见的范围内时不生成屏障 只累积读的阶段 之后的写会等待全部的读
+//     不在可见范围内时 生成从上一次写到新阶段的屏障 (布局转换也算一次写)
+//  2. flush 之前对同一子资源的多次转换 合并为一次 (中间状态没有被使用)
+//  3. 相邻且转换相同的子资源/区间 合并为一个屏障
+//不支持 synchronization2 时退回 vkCmdPipelineBarrier  阶段与访问标记取并集
+
+struct TrackedState{
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2KHR stage = VK_PIPELINE_STAGE_2_NONE_KHR;
+    VkAccessFlags2KHR access = VK_ACCESS_2_NONE_KHR;
+};
+
+static bool isWriteAccess2(VkAccessFlags2KHR access){
+    const VkAccessFlags2KHR writeMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR
+        | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR
+        | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR
+        | VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR
+        | VK_ACCESS_2_HOST_WRITE_BIT_KHR
+        | VK_ACCESS_2_MEMORY_WRITE_BIT_KHR
+        | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+    return (access & writeMask) != 0;
+}
+
+//上一次写 (或布局转换) 与之后已经通过屏障可见的范围
+//write 为之后的读需要等待的源  visible 为已经建立依赖的阶段/访问
+struct WriteScope{
+    VkPipelineStageFlags2KHR writeStage = VK_PIPELINE_STAGE_2_NONE_KHR;
+    VkAccessFlags2KHR writeAccess = VK_ACCESS_2_NONE_KHR;
+    VkPipelineStageFlags2KHR visibleStage = VK_PIPELINE_STAGE_2_NONE_KHR;
+    VkAccessFlags2KHR visibleAccess = VK_ACCESS_2_NONE_KHR;
+};
+
+struct ResourceStateStats{
+    uint32_t batches = 0;//实际提交的屏障命令数
+    uint32_t imageBarriers = 0;
+    uint32_t bufferBarriers = 0;
+    uint32_t skipped = 0;//读后读 或合并掉的转换
+};
+
+class ResourceStateTracker{
+public:
+    ResourceStateStats stats;
+
+    void init(DeviceDispatchTable *vkd , bool useSync2){
+        this->vkd = vkd;
+        this->useSync2 = useSync2 && vkd->vkCmdPipelineBarrier2KHR != nullptr;
+    }
+
+    bool sync2Enabled() const{
+        return useSync2;
+    }
+
+    //清空所有跟踪的资源
+    void reset(){
+        images.clear();
+        buffers.clear();
+        dirtyImages.clear();
+        dirtyBuffers.clear();
+    }
+
+    void resetStats(){
+        stats = ResourceStateStats();
+    }
+
+    void registerImage(VkImage image , VkImageAspectFlags aspect , uint32_t mipLevels , uint32_t arrayLayers ,
+            const TrackedState &initialState){
+        TrackedImage tracked;
+        tracked.aspect = aspect;
+        tracked.mipLevels = std::max(mipLevels , 1u);
+        tracked.arrayLayers = std::max(arrayLayers , 1u);
+        tracked.subresources.resize(tracked.mipLevels * tracked.arrayLayers);
+        for(Subresource &sub : tracked.subresources){
+            sub.current = initialState;
+            sub.scope = scopeOf(initialState);
+        }
+        images[image] = tracked;
+    }
+
+    void registerBuffer(VkBuffer buffer , VkDeviceSize size , const TrackedState &initialState){
+        TrackedBuffer tracked;
+        tracked.size = size;
+        BufferSegment segment;
+        segment.offset = 0;
+        segment.size = size;
+        segment.current = initialState;
+        segment.scope = scopeOf(initialState);
+        tracked.segments.push_back(segment);
+        buffers[buffer] = tracked;
+    }
+
+    void unregisterImage(VkImage image){
+        images.erase(image);
+        dirtyImages.erase(std::remove(dirtyImages.begin() , dirtyImages.end() , image) , dirtyImages.end());
+    }
+
+    void unregisterBuffer(VkBuffer buffer){
+        buffers.erase(buffer);
+        dirtyBuffers.erase(std::remove(dirtyBuffers.begin() , dirtyBuffers.end() , buffer) , dirtyBuffers.end());
+    }
+
+    bool isTracked(VkImage image) const{
+        return images.count(image) > 0;
+    }
+
+    bool isTracked(VkBuffer buffer) const{
+        return buffers.count(buffer) > 0;
+    }
+
+    //登记图像子资源范围的目标状态  (VK_REMAINING_* 表示到末尾)
+    void transitionImage(VkImage image , const VkImageSubresourceRange &range , VkImageLayout layout ,
+            VkPipelineStageFlags2KHR stage , VkAccessFlags2KHR access){
+        TrackedImage &tracked = findImage(image);
+        bool dirty = false;
+        forEachSubresource(tracked , range , [&](Subresource &sub){
+            dirty |= requestState(sub.current , sub.pending , sub.scope , sub.dirty , sub.extendRead , layout , stage , access);
+        });
+        if(dirty && std::find(dirtyImages.begin() , dirtyImages.end() , image) == dirtyImages.end()){
+            dirtyImages.push_back(image);
+        }
+    }
+
+    void transitionImage(VkImage image , VkImageLayout layout , VkPipelineStageFlags2KHR stage , VkAccessFlags2KHR access){
+        transitionImage(image , wholeRange(findImage(image).aspect) , layout , stage , access);
+    }
+
+    //登记buffer区间的目标状态
+    void transitionBuffer(VkBuffer buffer , VkDeviceSize offset , VkDeviceSize size ,
+            VkPipelineStageFlags2KHR stage , VkAccessFlags2KHR access){
+        TrackedBuffer &tracked = findBuffer(buffer);
+        bool dirty = false;
+        forEachSegment(tracked , offset , size , [&](BufferSegment &segment){
+            dirty |= requestState(segment.current , segment.pending , segment.scope , segment.dirty , segment.extendRead ,
+                VK_IMAGE_LAYOUT_UNDEFINED , stage , access);
+        });
+        if(dirty && std::find(dirtyBuffers.begin() , dirtyBuffers.end() , buffer) == dirtyBuffers.end()){
+            dirtyBuffers.push_back(buffer);
+        }
+    }
+
+    //直接设置当前状态 不生成屏障 (依赖已由信号量等外部同步提供)
+    void setImageState(VkImage image , const VkImageSubresourceRange &range , const TrackedState &state){
+        TrackedImage &tracked = findImage(image);
+        forEachSubresource(tracked , range , [&](Subresource &sub){
+            sub.current = state;
+            sub.scope = scopeOf(state);
+            sub.dirty = false;
+        });
+    }
+
+    void setImageState(VkImage image , const TrackedState &state){
+        setImageState(image , wholeRange(findImage(image).aspect) , state);
+    }
+
+    void setBufferState(VkBuffer buffer , VkDeviceSize offset , VkDeviceSize size , const TrackedState &state){
+        TrackedBuffer &tracked = findBuffer(buffer);
+        forEachSegment(tracked , offset , size , [&](BufferSegment &segment){
+            segment.current = state;
+            segment.scope = scopeOf(state);
+            segment.dirty = false;
+        });
+    }
+
+    //查询 mip/layer 的当前状态 (flush 之后的)
+    TrackedState imageState(VkImage image , uint32_t mipLevel = 0 , uint32_t arrayLayer = 0){
+        TrackedImage &tracked = findImage(image);
+        return tracked.subresources[mipLevel * tracked.arrayLayers + arrayLayer].current;
+    }
+
+    //生成并提交所有登记的屏障
+    void flush(VkCommandBuffer cmd){
+        imageBarriers.clear();
+        bufferBarriers.clear();
+
+        for(VkImage image : dirtyImages){
+            auto it = images.find(image);
+            if(it != images.end()){
+                buildImageBarriers(image , it->second);
+            }
+        }//end for each
+        for(VkBuffer buffer : dirtyBuffers){
+            auto it = buffers.find(buffer);
+            if(it != buffers.end()){
+                buildBufferBarriers(buffer , it->second);
+            }
+        }//end for each
+        dirtyImages.clear();
+        dirtyBuffers.clear();
+
+        if(imageBarriers.empty() && bufferBarriers.empty()){
+            return;
+        }
+
+        stats.batches++;
+        stats.imageBarriers += static_cast<uint32_t>(imageBarriers.size());
+        stats.bufferBarriers += static_cast<uint32_t>(bufferBarriers.size());
+
+        if(useSync2){
+            VkDependencyInfoKHR dependencyInfo = {};
+            dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+            dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+            dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+            dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+            dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+            vkd->vkCmdPipelineBarrier2KHR(cmd , &dependencyInfo);
+        }else{
+            flushLegacy(cmd);
+        }
+    }
+
+private:
+    struct Subresource{
+        TrackedState current;//stage/access 为写 或累积的读
+        TrackedState pending;
+        WriteScope scope;
+        bool dirty = false;
+        bool extendRead = false;//pending 是布局不变的读 屏障的源为上一次写
+    };
+
+    struct TrackedImage{
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        uint32_t mipLevels = 1;
+        uint32_t arrayLayers = 1;
+        std::vector<Subresource> subresources;//下标 mip * arrayLayers + layer
+    };
+
+    struct BufferSegment{
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        TrackedState current;
+        TrackedState pending;
+        WriteScope scope;
+        bool dirty = false;
+        bool extendRead = false;
+    };
+
+    struct TrackedBuffer{
+        VkDeviceSize size = 0;
+        std::vector<BufferSegment> segments;//按offset排序 首尾相接
+    };
+
+    DeviceDispatchTable *vkd = nullptr;
+    bool useSync2 = false;
+
+    std::map<VkImage , TrackedImage> images;
+    std::map<VkBuffer , TrackedBuffer> buffers;
+    std::vector<VkImage> dirtyImages;
+    std::vector<VkBuffer> dirtyBuffers;
+
+    std::vector<VkImageMemoryBarrier2KHR> imageBarriers;
+    std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers;
+
+    static VkImageSubresourceRange wholeRange(VkImageAspectFlags aspect){
+        VkImageSubresourceRange range = {};
+        range.aspectMask = aspect;
+        range.baseMipLevel = 0;
+        range.levelCount = VK_REMAINING_MIP_LEVELS;
+        range.baseArrayLayer = 0;
+        range.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        return range;
+    }
+
+    TrackedImage& findImage(VkImage image){
+        auto it = images.find(image);
+        if(it == images.end()){
+            throw std::runtime_error("resource state tracker: image is not registered");
+        }
+        return it->second;
+    }
+
+    TrackedBuffer& findBuffer(VkBuffer buffer){
+        auto it = buffers.find(buffer);
+        if(it == buffers.end()){
+            throw std::runtime_error("resource state tracker: buffer is not registered");
+        }
+        return it->second;
+    }
+
+    template<typename Fn>
+    static void forEachSubresource(TrackedImage &tracked , const VkImageSubresourceRange &range , Fn fn){
+        const uint32_t levelEnd = range.levelCount == VK_REMAINING_MIP_LEVELS
+            ? tracked.mipLevels : std::min(tracked.mipLevels , range.baseMipLevel + range.levelCount);
+        const uint32_t layerEnd = range.layerCount == VK_REMAINING_ARRAY_LAYERS
+            ? tracked.arrayLayers : std::min(tracked.arrayLayers , range.baseArrayLayer + range.layerCount);
+        for(uint32_t mip = range.baseMipLevel ; mip < levelEnd ; mip++){
+            for(uint32_t layer = range.baseArrayLayer ; layer < layerEnd ; layer++){
+                fn(tracked.subresources[mip * tracked.arrayLayers + layer]);
+            }//end for layer
+        }//end for mip
+    }
+
+    //在区间边界处拆分段 然后遍历被覆盖的段
+    template<typename Fn>
+    static void forEachSegment(TrackedBuffer &tracked , VkDeviceSize offset , VkDeviceSize size , Fn fn){
+        const VkDeviceSize end = size == VK_WHOLE_SIZE ? tracked.size : std::min(tracked.size , offset + size);
+        splitSegment(tracked , offset);
+        splitSegment(tracked , end);
+        for(BufferSegment &segment : tracked.segments){
+            if(segment.offset >= offset && segment.offset + segment.size <= end){
+                fn(segment);
+            }
+        }//end for each
+    }
+
+    static void splitSegment(TrackedBuffer &tracked , VkDeviceSize position){
+        for(size_t i = 0 ; i < tracked.segments.size() ; i++){
+            BufferSegment &segment = tracked.segments[i];
+            if(position > segment.offset && position < segment.offset + segment.size){
+                BufferSegment tail = segment;
+                tail.offset = position;
+                tail.size = segment.offset + segment.size - position;
+                segment.size = position - segment.offset;
+                tracked.segments.insert(tracked.segments.begin() + i + 1 , tail);
+                return;
+            }
+        }//end for i
+    }
+
+    //外部设置的状态 (登记时的初始状态 / 信号量等同步之后) 作为上一次写
+    //只读状态以它的阶段为源  之后其他阶段的读仍需要屏障
+    static WriteScope scopeOf(const TrackedState &state){
+        WriteScope scope;
+        scope.writeStage = state.stage;
+        if(isWriteAccess2(state.access)){
+            scope.writeAccess = state.access;
+        }else{
+            scope.visibleStage = state.stage;
+            scope.visibleAccess = state.access;
+        }
+        return scope;
+    }
+
+    //新的读是否已在上一次写之后可见的范围内
+    static bool isVisible(const WriteScope &scope , VkPipelineStageFlags2KHR stage , VkAccessFlags2KHR access){
+        if(scope.writeStage == VK_PIPELINE_STAGE_2_NONE_KHR){
+            return true;
+        }
+        const bool stageCovered = (scope.visibleStage & VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR) != 0
+            || (stage & ~scope.visibleStage) == 0;
+        const bool accessCovered = (scope.visibleAccess & VK_ACCESS_2_MEMORY_READ_BIT_KHR) != 0
+            || (access & ~scope.visibleAccess) == 0;
+        return stageCovered && accessCovered;
+    }
+
+    //登记目标状态  返回是否需要在flush时处理
+    bool requestState(TrackedState &current , TrackedState &pending , const WriteScope &scope , bool &dirty , bool &extendRead ,
+            VkImageLayout layout , VkPipelineStageFlags2KHR stage , VkAccessFlags2KHR access){
+        const bool write = isWriteAccess2(access);
+        if(dirty){
+            //上一次登记的状态还没有被使用 合并
+            stats.skipped++;
+            if(pending.layout == layout && !write && !isWriteAccess2(pending.access)){
+                pending.stage |= stage;
+                pending.access |= access;
+            }else{
+                pending.layout = layout;
+                pending.stage = stage;
+                pending.access = access;
+                extendRead = false;
+            }
+            return true;
+        }
+
+        //读后读 布局不变  已经可见时不需要屏障
+        if(current.layout == layout && !write && !isWriteAccess2(current.access)){
+            if(isVisible(scope , stage , access)){
+                current.stage |= stage;
+                current.access |= access;
+                stats.skipped++;
+                return false;
+            }
+            extendRead = true;
+        }
+
+        pending.layout = layout;
+        pending.stage = stage;
+        pending.access = access;
+        dirty = true;
+        return true;
+    }
+
+    //屏障的源  布局不变的读从上一次写开始 其他情况从当前状态开始
+    static void barrierSource(const TrackedState &current , const WriteScope &scope , bool extendRead ,
+            VkPipelineStageFlags2KHR &stage , VkAccessFlags2KHR &access){
+        if(extendRead){
+            stage = scope.writeStage;
+            access = scope.writeAccess;
+        }else{
+            stage = current.stage;
+            access = srcAccessOf(current);
+        }
+    }
+
+    //屏障提交后更新当前状态与可见范围
+    static void applyPending(TrackedState &current , const TrackedState &pending , WriteScope &scope , bool extendRead){
+        if(extendRead){
+            current.stage |= pending.stage;
+            current.access |= pending.access;
+            scope.visibleStage |= pending.stage;
+            scope.visibleAccess |= pending.access;
+            return;
+        }
+        if(isWriteAccess2(pending.access)){
+            scope = WriteScope();
+            scope.writeStage = pending.stage;
+            scope.writeAccess = pending.access;
+        }else if(isWriteAccess2(current.access)){
+            scope.writeStage = current.stage;
+            scope.writeAccess = current.access;
+            scope.visibleStage = pending.stage;
+            scope.visibleAccess = pending.access;
+        }else if(current.layout != pending.layout){
+            //布局转换发生在屏障的目标阶段之前 之后的读从这些阶段开始等待
+            scope.writeStage = pending.stage;
+            scope.writeAccess = VK_ACCESS_2_NONE_KHR;
+            scope.visibleStage = pending.stage;
+            scope.visibleAccess = pending.access;
+        }else{
+            scope.visibleStage |= pending.stage;
+            scope.visibleAccess |= pending.access;
+        }
+        current = pending;
+    }
+
+    static bool sameScope(const WriteScope &a , const WriteScope &b){
+        return a.writeStage == b.writeStage && a.writeAccess == b.writeAccess
+            && a.visibleStage == b.visibleStage && a.visibleAccess == b.visibleAccess;
+    }
+
+    static bool sameTransition(const TrackedState &a , const TrackedState &b){
+        return a.layout == b.layout && a.stage == b.stage && a.access == b.access;
+    }
+
+    static VkAccessFlags2KHR srcAccessOf(const TrackedState &state){
+        //只有写入需要可用性操作
+        return isWriteAccess2(state.access) ? state.access : VK_ACCESS_2_NONE_KHR;
+    }
+
+    void buildImageBarriers(VkImage image , TrackedImage &tracked){
+        //每个mip内 连续且转换相同的layer合并  然后合并layer范围相同的相邻mip
+        std::vector<VkImageMemoryBarrier2KHR> mipBarriers;
+        for(uint32_t mip = 0 ; mip < tracked.mipLevels ; mip++){
+            uint32_t layer = 0;
+            while(layer < tracked.arrayLayers){
+                Subresource &first = tracked.subresources[mip * tracked.arrayLayers + layer];
+                if(!first.dirty){
+                    layer++;
+                    continue;
+                }
+                uint32_t count = 1;
+                while(layer + count < tracked.arrayLayers){
+                    Subresource &next = tracked.subresources[mip * tracked.arrayLayers + layer + count];
+                    if(!next.dirty || !sameTransition(next.current , first.current)
+                        || !sameTransition(next.pending , first.pending)
+                        || next.extendRead != first.extendRead || !sameScope(next.scope , first.scope)){
+                        break;
+                    }
+                    count++;
+                }
+
+                VkImageMemoryBarrier2KHR barrier = {};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+                barrierSource(first.current , first.scope , first.extendRead , barrier.srcStageMask , barrier.srcAccessMask);
+                barrier.dstStageMask = first.pending.stage;
+                barrier.dstAccessMask = first.pending.access;
+                barrier.oldLayout = first.current.layout;
+                barrier.newLayout = first.pending.layout;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = image;
+                barrier.subresourceRange.aspectMask = tracked.aspect;
+                barrier.subresourceRange.baseMipLevel = mip;
+                barrier.subresourceRange.levelCount = 1;
+                barrier.subresourceRange.baseArrayLayer = layer;
+                barrier.subresourceRange.layerCount = count;
+
+                VkImageMemoryBarrier2KHR *last = mipBarriers.empty() ? nullptr : &mipBarriers.back();
+                if(last != nullptr && last->subresourceRange.baseMipLevel + last->subresourceRange.levelCount == mip
+                    && last->subresourceRange.baseArrayLayer == layer && last->subresourceRange.layerCount == count
+                    && last->srcStageMask == barrier.srcStageMask && last->srcAccessMask == barrier.srcAccessMask
+                    && last->dstStageMask == barrier.dstStageMask && last->dstAccessMask == barrier.dstAccessMask
+                    && last->oldLayout == barrier.oldLayout && last->newLayout == barrier.newLayout){
+                    last->subresourceRange.levelCount++;
+                }else{
+                    mipBarriers.push_back(barrier);
+                }
+
+                for(uint32_t i = 0 ; i < count ; i++){
+                    Subresource &sub = tracked.subresources[mip * tracked.arrayLayers + layer + i];
+                    applyPending(sub.current , sub.pending , sub.scope , sub.extendRead);
+                    sub.dirty = false;
+                    sub.extendRead = false;
+                }//end for i
+                layer += count;
+            }//end while
+        }//end for mip
+        imageBarriers.insert(imageBarriers.end() , mipBarriers.begin() , mipBarriers.end());
+    }
+
+    void buildBufferBarriers(VkBuffer buffer , TrackedBuffer &tracked){
+        size_t firstBarrier = bufferBarriers.size();
+        for(BufferSegment &segment : tracked.segments){
+            if(!segment.dirty){
+                continue;
+            }
+
+            VkBufferMemoryBarrier2KHR barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+            barrierSource(segment.current , segment.scope , segment.extendRead , barrier.srcStageMask , barrier.srcAccessMask);
+            barrier.dstStageMask = segment.pending.stage;
+            barrier.dstAccessMask = segment.pending.access;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = buffer;
+            barrier.offset = segment.offset;
+            barrier.size = segment.size;
+
+            VkBufferMemoryBarrier2KHR *last = bufferBarriers.size() > firstBarrier ? &bufferBarriers.back() : nullptr;
+            if(last != nullptr && last->offset + last->size == barrier.offset
+                && last->srcStageMask == barrier.srcStageMask && last->srcAccessMask == barrier.srcAccessMask
+                && last->dstStageMask == barrier.dstStageMask && last->dstAccessMask == barrier.dstAccessMask){
+                last->size += barrier.size;
+            }else{
+                bufferBarriers.push_back(barrier);
+            }
+
+            applyPending(segment.current , segment.pending , segment.scope , segment.extendRead);
+            segment.dirty = false;
+            segment.extendRead = false;
+        }//end for each
+
+        mergeSegments(tracked);
+    }
+
+    //状态相同的相邻段合并 避免段数无限增长
+    static void mergeSegments(TrackedBuffer &tracked){
+        std::vector<BufferSegment> merged;
+        for(const BufferSegment &segment : tracked.segments){
+            if(!merged.empty() && !merged.back().dirty && !segment.dirty
+                && sameTransition(merged.back().current , segment.current) && sameScope(merged.back().scope , segment.scope)){
+                merged.back().size += segment.size;
+            }else{
+                merged.push_back(segment);
+            }
+        }//end for each
+        tracked.segments.swap(merged);
+    }
+
+    //synchronization2 之前的阶段/访问位 与 2 版本的低32位相同  只有2版本才有的位退化为全部
+    static VkPipelineStageFlags toLegacyStage(VkPipelineStageFlags2KHR stage , VkPipelineStageFlags noneStage){
+        if(stage == VK_PIPELINE_STAGE_2_NONE_KHR){
+            return noneStage;
+        }
+        if((stage >> 32) != 0){
+            return VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        }
+        return static_cast<VkPipelineStageFlags>(stage);
+    }
+
+    static VkAccessFlags toLegacyAccess(VkAccessFlags2KHR access){
+        VkAccessFlags legacy = static_cast<VkAccessFlags>(access & 0xFFFFFFFFull);
+        if((access >> 32) != 0){
+            legacy |= isWriteAccess2(access) ? (VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT) : VK_ACCESS_MEMORY_READ_BIT;
+        }
+        return legacy;
+    }
+
+    void flushLegacy(VkCommandBuffer cmd){
+        VkPipelineStageFlags srcStage = 0;
+        VkPipelineStageFlags dstStage = 0;
+
+        std::vector<VkImageMemoryBarrier> legacyImageBarriers(imageBarriers.size());
+        for(size_t i = 0 ; i < imageBarriers.size() ; i++){
+            const VkImageMemoryBarrier2KHR &barrier = imageBarriers[i];
+            srcStage |= toLegacyStage(barrier.srcStageMask , VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+            dstStage |= toLegacyStage(barrier.dstStageMask , VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+            VkImageMemoryBarrier &legacy = legacyImageBarriers[i];
+            legacy = {};
+            legacy.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            legacy.srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+            legacy.dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+            legacy.oldLayout = barrier.oldLayout;
+            legacy.newLayout = barrier.newLayout;
+            legacy.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+            legacy.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+            legacy.image = barrier.image;
+            legacy.subresourceRange = barrier.subresourceRange;
+        }//end for i
+
+        std::vector<VkBufferMemoryBarrier> legacyBufferBarriers(bufferBarriers.size());
+        for(size_t i = 0 ; i < bufferBarriers.size() ; i++){
+            const VkBufferMemoryBarrier2KHR &barrier = bufferBarriers[i];
+            srcStage |= toLegacyStage(barrier.srcStageMask , VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+            dstStage |= toLegacyStage(barrier.dstStageMask , VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+            VkBufferMemoryBarrier &legacy = legacyBufferBarriers[i];
+            legacy = {};
+            legacy.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            legacy.srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+            legacy.dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+            legacy.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+            legacy.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+            legacy.buffer = barrier.buffer;
+            legacy.offset = barrier.offset;
+            legacy.size = barrier.size;
+        }//end for i
+
+        vkd->vkCmdPipelineBarrier(cmd , srcStage , dstStage , 0 , 0 , nullptr ,
+            static_cast<uint32_t>(legacyBufferBarriers.size()) , legacyBufferBarriers.data() ,
+            static_cast<uint32_t>(legacyImageBarriers.size()) , legacyImageBarriers.data());
+    }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef _SHADER_LIBRARY_H_
+#define _SHADER_LIBRARY_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+//SPIR-V 文件缓存
+//preload 在后台线程读取文件并检查 SPIR-V 头  与实例 设备的创建并行
+//get 返回已读取的代码  还在读取时等待  没有预读的文件在调用线程同步读取
+//读取失败的错误在 get 时抛出 (预读列表中可以有当前配置用不到的文件)
+
+static const uint32_t SPIRV_MAGIC = 0x07230203;
+
+class ShaderLibrary{
+public:
+    ~ShaderLibrary(){
+        wait();
+    }
+
+    //后台线程按顺序读取 paths
+    void preload(const std::vector<std::string> &paths){
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(const std::string &path : paths){
+                entries[path];
+            }//end for each
+        }
+        loader = std::thread([this , paths](){
+            preloadBegin = currentTimeNanos();
+            for(const std::string &path : paths){
+                Entry entry;
+                load(path , entry);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    entries[path] = std::move(entry);
+                }
+                loaded.notify_all();
+            }//end for each
+            preloadEnd = currentTimeNanos();
+        });
+    }
+
+    //等待后台读取结束
+    void wait(){
+        if(loader.joinable()){
+            loader.join();
+        }
+    }
+
+    const std::vector<char> &get(const std::string &path){
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = entries.find(path);
+        if(it == entries.end()){
+            Entry &entry = entries[path];
+            load(path , entry);
+            it = entries.find(path);
+        }
+        Entry &entry = it->second;
+        loaded.wait(lock , [&entry](){ return entry.ready; });
+        if(!entry.error.empty()){
+            throw std::runtime_error(entry.error);
+        }
+        return entry.code;
+    }
+
+    //后台读取的开始与结束时刻 (currentTimeNanos)  wait 之后有效
+    uint64_t preloadBeginTime() const{
+        return preloadBegin;
+    }
+
+    uint64_t preloadEndTime() const{
+        return preloadEnd;
+    }
+
+private:
+    struct Entry{
+        std::vector<char> code;
+        std::string error;
+        bool ready = false;
+    };
+
+    std::map<std::string , Entry> entries;//元素的地址不随插入改变
+    std::mutex mutex;
+    std::condition_variable loaded;
+    std::thread loader;
+    uint64_t preloadBegin = 0;
+    uint64_t preloadEnd = 0;
+
+    //读取并检查 长度须为 4 的倍数 且以 SPIR-V 魔数开头
+    static void load(const std::string &path , Entry &entry){
+        try{
+            entry.code = readFile(path);
+            uint32_t magic = 0;
+            if(entry.code.size() >= sizeof(magic)){
+                std::memcpy(&magic , entry.code.data() , sizeof(magic));
+            }
+            if(entry.code.size() % 4 != 0 || magic != SPIRV_MAGIC){
+                entry.code.clear();
+                entry.error = "invalid spir-v file " + path;
+            }
+        }catch(const std::exception &e){
+            entry.error = e.what();
+        }
+        entry.ready = true;
+    }
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef _STARTUP_PROFILE_H_
+#define _STARTUP_PROFILE_H_
+
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+//启动耗时
+//记录初始化每一步的墙钟时间  后台线程的步骤单独标记 (与主线程并行 不计入主线程合计)
+//首帧显示时记录 time to first frame: 从进程启动到第一次 vkQueuePresentKHR 返回
+
+struct StartupStep{
+    std::string name;
+    uint64_t begin;//相对进程启动 ns
+    uint64_t end;
+    bool background;
+};
+
+class StartupProfile{
+public:
+    //originNanos 为进程启动时刻 (currentTimeNanos 的时钟)
+    explicit StartupProfile(uint64_t originNanos) : originNanos(originNanos){}
+
+    //线程安全
+    void record(const std::string &name , uint64_t beginNanos , uint64_t endNanos , bool background = false){
+        std::lock_guard<std::mutex> lock(mutex);
+        steps.push_back({name , beginNanos - originNanos , endNanos - originNanos , background});
+    }
+
+    //计时执行一步
+    template<typename Fn>
+    void run(const std::string &name , Fn fn , bool background = false){
+        const uint64_t begin = currentTimeNanos();
+        fn();
+        record(name , begin , currentTimeNanos() , background);
+    }
+
+    //只有第一次调用有效
+    void markFirstFrame(){
+        if(firstFrameNanos == 0){
+            firstFrameNanos = currentTimeNanos() - originNanos;
+        }
+    }
+
+    bool hasFirstFrame() const{
+        return firstFrameNanos != 0;
+    }
+
+    uint64_t timeToFirstFrame() const{
+        return firstFrameNanos;
+    }
+
+    void report(std::ostream &out){
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t mainThreadNanos = 0;
+        out << "startup steps :" << std::endl;
+        for(const StartupStep &step : steps){
+            if(!step.background){
+                mainThreadNanos += step.end - step.begin;
+            }
+            out << "  " << std::left << std::setw(28) << step.name << std::right
+                << " start : " << std::setw(9) << std::fixed << std::setprecision(2) << step.begin / 1e6 << " ms"
+                << " duration : " << std::setw(9) << (step.end - step.begin) / 1e6 << " ms"
+                << (step.background ? " (background)" : "") << std::endl;
+        }//end for each
+        out << "startup main thread steps : " << mainThreadNanos / 1e6 << " ms" << std::endl;
+        if(firstFrameNanos != 0){
+            out << "time to first frame : " << firstFrameNanos / 1e6 << " ms" << std::endl;
+        }
+        out << std::defaultfloat << std::setprecision(6);
+    }
+
+private:
+    uint64_t originNanos;
+    uint64_t firstFrameNanos = 0;
+    std::vector<StartupStep> steps;
+    std::mutex mutex;
+};
+
+#endif
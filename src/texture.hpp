@@ -0,0 +1,164 @@
+#ifndef _TEXTURE_H_
+#define _TEXTURE_H_
+
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include "device_dispatch.hpp"
+#include "vk_utils.hpp"
+
+//RGBA8 二维纹理  像素经 staging buffer 拷贝到显存  创建完成后处于 SHADER_READ_ONLY_OPTIMAL
+//上传使用一次性的指令缓存 并等待队列空闲  只在初始化时使用
+class Texture2D{
+public:
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkExtent2D extent = {0 , 0};
+
+    void create(VkDevice device , VkPhysicalDevice physicalDevice , DeviceDispatchTable *vkd , VkCommandPool cmdPool ,
+            VkQueue queue , uint32_t width , uint32_t height , const uint32_t *pixels){
+        this->device = device;
+        extent = {width , height};
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+        const VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * sizeof(uint32_t);
+
+        //staging buffer
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = size;
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer staging;
+        if(vkCreateBuffer(device , &bufferCreateInfo , nullptr , &staging) != VK_SUCCESS){
+            throw std::runtime_error("failed to create texture staging buffer!");
+        }
+        VkMemoryRequirements bufferRequirements;
+        vkGetBufferMemoryRequirements(device , staging , &bufferRequirements);
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = bufferRequirements.size;
+        allocateInfo.memoryTypeIndex = findMemoryType(memoryProperties , bufferRequirements.memoryTypeBits ,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        VkDeviceMemory stagingMemory;
+        if(vkAllocateMemory(device , &allocateInfo , nullptr , &stagingMemory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate texture staging memory!");
+        }
+        vkBindBufferMemory(device , staging , stagingMemory , 0);
+        void *mapped = nullptr;
+        vkMapMemory(device , stagingMemory , 0 , size , 0 , &mapped);
+        std::memcpy(mapped , pixels , static_cast<size_t>(size));
+        vkUnmapMemory(device , stagingMemory);
+
+        //image
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        imageCreateInfo.extent = {width , height , 1};
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if(vkCreateImage(device , &imageCreateInfo , nullptr , &image) != VK_SUCCESS){
+            throw std::runtime_error("failed to create texture image!");
+        }
+        VkMemoryRequirements imageRequirements;
+        vkGetImageMemoryRequirements(device , image , &imageRequirements);
+        allocateInfo.allocationSize = imageRequirements.size;
+        allocateInfo.memoryTypeIndex = findMemoryType(memoryProperties , imageRequirements.memoryTypeBits ,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if(vkAllocateMemory(device , &allocateInfo , nullptr , &memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate texture memory!");
+        }
+        vkBindImageMemory(device , image , memory , 0);
+
+        //拷贝 UNDEFINED -> TRANSFER_DST -> SHADER_READ_ONLY
+        VkCommandBufferAllocateInfo cmdAllocateInfo = {};
+        cmdAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cmdAllocateInfo.commandPool = cmdPool;
+        cmdAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        cmdAllocateInfo.commandBufferCount = 1;
+        VkCommandBuffer cmd;
+        vkd->vkAllocateCommandBuffers(device , &cmdAllocateInfo , &cmd);
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkd->vkBeginCommandBuffer(cmd , &beginInfo);
+
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT , 0 , 1 , 0 , 1};
+        vkd->vkCmdPipelineBarrier(cmd , VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT , VK_PIPELINE_STAGE_TRANSFER_BIT ,
+            0 , 0 , nullptr , 0 , nullptr , 1 , &barrier);
+
+        VkBufferImageCopy region = {};
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT , 0 , 0 , 1};
+        region.imageExtent = {width , height , 1};
+        vkd->vkCmdCopyBufferToImage(cmd , staging , image , VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL , 1 , &region);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkd->vkCmdPipelineBarrier(cmd , VK_PIPELINE_STAGE_TRANSFER_BIT , VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT ,
+            0 , 0 , nullptr , 0 , nullptr , 1 , &barrier);
+        vkd->vkEndCommandBuffer(cmd);
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmd;
+        if(vkd->vkQueueSubmit(queue , 1 , &submitInfo , VK_NULL_HANDLE) != VK_SUCCESS){
+            throw std::runtime_error("failed to submit texture upload!");
+        }
+        vkd->vkQueueWaitIdle(queue);
+        vkd->vkFreeCommandBuffers(device , cmdPool , 1 , &cmd);
+        vkDestroyBuffer(device , staging , nullptr);
+        vkFreeMemory(device , stagingMemory , nullptr);
+
+        VkImageViewCreateInfo viewCreateInfo = {};
+        viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewCreateInfo.image = image;
+        viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT , 0 , 1 , 0 , 1};
+        if(vkCreateImageView(device , &viewCreateInfo , nullptr , &view) != VK_SUCCESS){
+            throw std::runtime_error("failed to create texture view!");
+        }
+    }
+
+    void destroy(){
+        if(device == VK_NULL_HANDLE){
+            return;
+        }
+        vkDestroyImageView(device , view , nullptr);
+        vkDestroyImage(device , image , nullptr);
+        vkFreeMemory(device , memory , nullptr);
+        view = VK_NULL_HANDLE;
+        image = VK_NULL_HANDLE;
+        memory = VK_NULL_HANDLE;
+        device = VK_NULL_HANDLE;
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+};
+
+#endif
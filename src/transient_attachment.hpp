@@ -0,0 +1,121 @@
+#ifndef _TRANSIENT_ATTACHMENT_H_
+#define _TRANSIENT_ATTACHMENT_H_
+
+#include <vulkan/vulkan.h>
+
+#include <stdexcept>
+
+#include "vk_utils.hpp"
+
+//只在一次渲染内使用的附件 (storeOp DONT_CARE)  例如深度 与 MSAA 颜色
+//创建为 TRANSIENT_ATTACHMENT  设备有 LAZILY_ALLOCATED 内存时使用它
+//tile based GPU 上内容只存在于片上内存 不会真正分配显存
+//extraUsage 非0 时(例如之后还要采样) 内容需要保存 不再是 transient  改为普通显存
+class TransientAttachment{
+public:
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    bool lazilyAllocated = false;
+    VkDeviceSize memorySize = 0;//申请的大小
+
+    void create(VkDevice device , VkPhysicalDevice physicalDevice , VkFormat format , VkImageAspectFlags aspect ,
+            VkExtent2D extent , VkSampleCountFlagBits samples , VkImageUsageFlags attachmentUsage ,
+            VkImageUsageFlags extraUsage = 0){
+        this->device = device;
+        this->format = format;
+        this->aspect = aspect;
+        this->samples = samples;
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice , &memoryProperties);
+
+        VkImageCreateInfo imageCreateInfo = {};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = format;
+        imageCreateInfo.extent = {extent.width , extent.height , 1};
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = samples;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = attachmentUsage | (extraUsage != 0 ? extraUsage : static_cast<VkImageUsageFlags>(VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT));
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if(vkCreateImage(device , &imageCreateInfo , nullptr , &image) != VK_SUCCESS){
+            throw std::runtime_error("failed to create transient attachment image!");
+        }
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device , image , &requirements);
+
+        int memoryType = extraUsage != 0 ? -1 : findMemoryTypeIndex(memoryProperties , requirements.memoryTypeBits ,
+            VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+        lazilyAllocated = memoryType >= 0;
+        if(!lazilyAllocated){
+            memoryType = static_cast<int>(findMemoryType(memoryProperties , requirements.memoryTypeBits ,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        }
+
+        VkMemoryAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = requirements.size;
+        allocateInfo.memoryTypeIndex = static_cast<uint32_t>(memoryType);
+        if(vkAllocateMemory(device , &allocateInfo , nullptr , &memory) != VK_SUCCESS){
+            throw std::runtime_error("failed to allocate transient attachment memory!");
+        }
+        memorySize = requirements.size;
+        vkBindImageMemory(device , image , memory , 0);
+
+        VkImageViewCreateInfo viewCreateInfo = {};
+        viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewCreateInfo.image = image;
+        viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewCreateInfo.format = format;
+        viewCreateInfo.subresourceRange.aspectMask = aspect;
+        viewCreateInfo.subresourceRange.baseMipLevel = 0;
+        viewCreateInfo.subresourceRange.levelCount = 1;
+        viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+        viewCreateInfo.subresourceRange.layerCount = 1;
+        if(vkCreateImageView(device , &viewCreateInfo , nullptr , &view) != VK_SUCCESS){
+            throw std::runtime_error("failed to create transient attachment view!");
+        }
+    }
+
+    bool isCreated() const{
+        return image != VK_NULL_HANDLE;
+    }
+
+    //实际占用的显存  lazily allocated 内存由驱动按需提交
+    VkDeviceSize committedSize() const{
+        if(!lazilyAllocated){
+            return memorySize;
+        }
+        VkDeviceSize committed = 0;
+        vkGetDeviceMemoryCommitment(device , memory , &committed);
+        return committed;
+    }
+
+    void destroy(){
+        if(device == VK_NULL_HANDLE){
+            return;
+        }
+        vkDestroyImageView(device , view , nullptr);
+        vkDestroyImage(device , image , nullptr);
+        vkFreeMemory(device , memory , nullptr);
+        view = VK_NULL_HANDLE;
+        image = VK_NULL_HANDLE;
+        memory = VK_NULL_HANDLE;
+        memorySize = 0;
+        device = VK_NULL_HANDLE;
+    }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+};
+
+#endif
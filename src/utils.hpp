@@ -5,6 +5,10 @@
 #include <vector>
 #include <fstream>
 #include <vector>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
 
 static const std::vector<const char *> convertVectorStringToC(const std::vector<std::string> &list){
     std::vector<const char *> result;
@@ -14,6 +18,19 @@ static const std::vector<const char *> convertVectorStringToC(const std::vector<
     return result;
 }
 
+//单调时钟 纳秒
+static uint64_t currentTimeNanos(){
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static std::string toLowerCase(const std::string &str){
+    std::string result = str;
+    std::transform(result.begin() , result.end() , result.begin() , 
+        [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
 //读取文件为原始二进制格式
 static std::vector<char> readFile(const std::string &path){
 
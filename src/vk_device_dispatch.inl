@@ -0,0 +1,561 @@
+// generated by tools/gen_device_dispatch.py from vulkan_core.h , do not edit
+// VK_DEVICE_FUNCTION(name) 需在包含前定义
+
+#if defined(VK_VERSION_1_0)
+VK_DEVICE_FUNCTION(vkDestroyDevice)
+VK_DEVICE_FUNCTION(vkGetDeviceQueue)
+VK_DEVICE_FUNCTION(vkQueueSubmit)
+VK_DEVICE_FUNCTION(vkQueueWaitIdle)
+VK_DEVICE_FUNCTION(vkDeviceWaitIdle)
+VK_DEVICE_FUNCTION(vkAllocateMemory)
+VK_DEVICE_FUNCTION(vkFreeMemory)
+VK_DEVICE_FUNCTION(vkMapMemory)
+VK_DEVICE_FUNCTION(vkUnmapMemory)
+VK_DEVICE_FUNCTION(vkFlushMappedMemoryRanges)
+VK_DEVICE_FUNCTION(vkInvalidateMappedMemoryRanges)
+VK_DEVICE_FUNCTION(vkGetDeviceMemoryCommitment)
+VK_DEVICE_FUNCTION(vkBindBufferMemory)
+VK_DEVICE_FUNCTION(vkBindImageMemory)
+VK_DEVICE_FUNCTION(vkGetBufferMemoryRequirements)
+VK_DEVICE_FUNCTION(vkGetImageMemoryRequirements)
+VK_DEVICE_FUNCTION(vkGetImageSparseMemoryRequirements)
+VK_DEVICE_FUNCTION(vkQueueBindSparse)
+VK_DEVICE_FUNCTION(vkCreateFence)
+VK_DEVICE_FUNCTION(vkDestroyFence)
+VK_DEVICE_FUNCTION(vkResetFences)
+VK_DEVICE_FUNCTION(vkGetFenceStatus)
+VK_DEVICE_FUNCTION(vkWaitForFences)
+VK_DEVICE_FUNCTION(vkCreateSemaphore)
+VK_DEVICE_FUNCTION(vkDestroySemaphore)
+VK_DEVICE_FUNCTION(vkCreateEvent)
+VK_DEVICE_FUNCTION(vkDestroyEvent)
+VK_DEVICE_FUNCTION(vkGetEventStatus)
+VK_DEVICE_FUNCTION(vkSetEvent)
+VK_DEVICE_FUNCTION(vkResetEvent)
+VK_DEVICE_FUNCTION(vkCreateQueryPool)
+VK_DEVICE_FUNCTION(vkDestroyQueryPool)
+VK_DEVICE_FUNCTION(vkGetQueryPoolResults)
+VK_DEVICE_FUNCTION(vkCreateBuffer)
+VK_DEVICE_FUNCTION(vkDestroyBuffer)
+VK_DEVICE_FUNCTION(vkCreateBufferView)
+VK_DEVICE_FUNCTION(vkDestroyBufferView)
+VK_DEVICE_FUNCTION(vkCreateImage)
+VK_DEVICE_FUNCTION(vkDestroyImage)
+VK_DEVICE_FUNCTION(vkGetImageSubresourceLayout)
+VK_DEVICE_FUNCTION(vkCreateImageView)
+VK_DEVICE_FUNCTION(vkDestroyImageView)
+VK_DEVICE_FUNCTION(vkCreateShaderModule)
+VK_DEVICE_FUNCTION(vkDestroyShaderModule)
+VK_DEVICE_FUNCTION(vkCreatePipelineCache)
+VK_DEVICE_FUNCTION(vkDestroyPipelineCache)
+VK_DEVICE_FUNCTION(vkGetPipelineCacheData)
+VK_DEVICE_FUNCTION(vkMergePipelineCaches)
+VK_DEVICE_FUNCTION(vkCreateGraphicsPipelines)
+VK_DEVICE_FUNCTION(vkCreateComputePipelines)
+VK_DEVICE_FUNCTION(vkDestroyPipeline)
+VK_DEVICE_FUNCTION(vkCreatePipelineLayout)
+VK_DEVICE_FUNCTION(vkDestroyPipelineLayout)
+VK_DEVICE_FUNCTION(vkCreateSampler)
+VK_DEVICE_FUNCTION(vkDestroySampler)
+VK_DEVICE_FUNCTION(vkCreateDescriptorSetLayout)
+VK_DEVICE_FUNCTION(vkDestroyDescriptorSetLayout)
+VK_DEVICE_FUNCTION(vkCreateDescriptorPool)
+VK_DEVICE_FUNCTION(vkDestroyDescriptorPool)
+VK_DEVICE_FUNCTION(vkResetDescriptorPool)
+VK_DEVICE_FUNCTION(vkAllocateDescriptorSets)
+VK_DEVICE_FUNCTION(vkFreeDescriptorSets)
+VK_DEVICE_FUNCTION(vkUpdateDescriptorSets)
+VK_DEVICE_FUNCTION(vkCreateFramebuffer)
+VK_DEVICE_FUNCTION(vkDestroyFramebuffer)
+VK_DEVICE_FUNCTION(vkCreateRenderPass)
+VK_DEVICE_FUNCTION(vkDestroyRenderPass)
+VK_DEVICE_FUNCTION(vkGetRenderAreaGranularity)
+VK_DEVICE_FUNCTION(vkCreateCommandPool)
+VK_DEVICE_FUNCTION(vkDestroyCommandPool)
+VK_DEVICE_FUNCTION(vkResetCommandPool)
+VK_DEVICE_FUNCTION(vkAllocateCommandBuffers)
+VK_DEVICE_FUNCTION(vkFreeCommandBuffers)
+VK_DEVICE_FUNCTION(vkBeginCommandBuffer)
+VK_DEVICE_FUNCTION(vkEndCommandBuffer)
+VK_DEVICE_FUNCTION(vkResetCommandBuffer)
+VK_DEVICE_FUNCTION(vkCmdBindPipeline)
+VK_DEVICE_FUNCTION(vkCmdSetViewport)
+VK_DEVICE_FUNCTION(vkCmdSetScissor)
+VK_DEVICE_FUNCTION(vkCmdSetLineWidth)
+VK_DEVICE_FUNCTION(vkCmdSetDepthBias)
+VK_DEVICE_FUNCTION(vkCmdSetBlendConstants)
+VK_DEVICE_FUNCTION(vkCmdSetDepthBounds)
+VK_DEVICE_FUNCTION(vkCmdSetStencilCompareMask)
+VK_DEVICE_FUNCTION(vkCmdSetStencilWriteMask)
+VK_DEVICE_FUNCTION(vkCmdSetStencilReference)
+VK_DEVICE_FUNCTION(vkCmdBindDescriptorSets)
+VK_DEVICE_FUNCTION(vkCmdBindIndexBuffer)
+VK_DEVICE_FUNCTION(vkCmdBindVertexBuffers)
+VK_DEVICE_FUNCTION(vkCmdDraw)
+VK_DEVICE_FUNCTION(vkCmdDrawIndexed)
+VK_DEVICE_FUNCTION(vkCmdDrawIndirect)
+VK_DEVICE_FUNCTION(vkCmdDrawIndexedIndirect)
+VK_DEVICE_FUNCTION(vkCmdDispatch)
+VK_DEVICE_FUNCTION(vkCmdDispatchIndirect)
+VK_DEVICE_FUNCTION(vkCmdCopyBuffer)
+VK_DEVICE_FUNCTION(vkCmdCopyImage)
+VK_DEVICE_FUNCTION(vkCmdBlitImage)
+VK_DEVICE_FUNCTION(vkCmdCopyBufferToImage)
+VK_DEVICE_FUNCTION(vkCmdCopyImageToBuffer)
+VK_DEVICE_FUNCTION(vkCmdUpdateBuffer)
+VK_DEVICE_FUNCTION(vkCmdFillBuffer)
+VK_DEVICE_FUNCTION(vkCmdClearColorImage)
+VK_DEVICE_FUNCTION(vkCmdClearDepthStencilImage)
+VK_DEVICE_FUNCTION(vkCmdClearAttachments)
+VK_DEVICE_FUNCTION(vkCmdResolveImage)
+VK_DEVICE_FUNCTION(vkCmdSetEvent)
+VK_DEVICE_FUNCTION(vkCmdResetEvent)
+VK_DEVICE_FUNCTION(vkCmdWaitEvents)
+VK_DEVICE_FUNCTION(vkCmdPipelineBarrier)
+VK_DEVICE_FUNCTION(vkCmdBeginQuery)
+VK_DEVICE_FUNCTION(vkCmdEndQuery)
+VK_DEVICE_FUNCTION(vkCmdResetQueryPool)
+VK_DEVICE_FUNCTION(vkCmdWriteTimestamp)
+VK_DEVICE_FUNCTION(vkCmdCopyQueryPoolResults)
+VK_DEVICE_FUNCTION(vkCmdPushConstants)
+VK_DEVICE_FUNCTION(vkCmdBeginRenderPass)
+VK_DEVICE_FUNCTION(vkCmdNextSubpass)
+VK_DEVICE_FUNCTION(vkCmdEndRenderPass)
+VK_DEVICE_FUNCTION(vkCmdExecuteCommands)
+#endif //VK_VERSION_1_0
+
+#if defined(VK_VERSION_1_1)
+VK_DEVICE_FUNCTION(vkBindBufferMemory2)
+VK_DEVICE_FUNCTION(vkBindImageMemory2)
+VK_DEVICE_FUNCTION(vkGetDeviceGroupPeerMemoryFeatures)
+VK_DEVICE_FUNCTION(vkCmdSetDeviceMask)
+VK_DEVICE_FUNCTION(vkCmdDispatchBase)
+VK_DEVICE_FUNCTION(vkGetImageMemoryRequirements2)
+VK_DEVICE_FUNCTION(vkGetBufferMemoryRequirements2)
+VK_DEVICE_FUNCTION(vkGetImageSparseMemoryRequirements2)
+VK_DEVICE_FUNCTION(vkTrimCommandPool)
+VK_DEVICE_FUNCTION(vkGetDeviceQueue2)
+VK_DEVICE_FUNCTION(vkCreateSamplerYcbcrConversion)
+VK_DEVICE_FUNCTION(vkDestroySamplerYcbcrConversion)
+VK_DEVICE_FUNCTION(vkCreateDescriptorUpdateTemplate)
+VK_DEVICE_FUNCTION(vkDestroyDescriptorUpdateTemplate)
+VK_DEVICE_FUNCTION(vkUpdateDescriptorSetWithTemplate)
+VK_DEVICE_FUNCTION(vkGetDescriptorSetLayoutSupport)
+#endif //VK_VERSION_1_1
+
+#if defined(VK_VERSION_1_2)
+VK_DEVICE_FUNCTION(vkCmdDrawIndirectCount)
+VK_DEVICE_FUNCTION(vkCmdDrawIndexedIndirectCount)
+VK_DEVICE_FUNCTION(vkCreateRenderPass2)
+VK_DEVICE_FUNCTION(vkCmdBeginRenderPass2)
+VK_DEVICE_FUNCTION(vkCmdNextSubpass2)
+VK_DEVICE_FUNCTION(vkCmdEndRenderPass2)
+VK_DEVICE_FUNCTION(vkResetQueryPool)
+VK_DEVICE_FUNCTION(vkGetSemaphoreCounterValue)
+VK_DEVICE_FUNCTION(vkWaitSemaphores)
+VK_DEVICE_FUNCTION(vkSignalSemaphore)
+VK_DEVICE_FUNCTION(vkGetBufferDeviceAddress)
+VK_DEVICE_FUNCTION(vkGetBufferOpaqueCaptureAddress)
+VK_DEVICE_FUNCTION(vkGetDeviceMemoryOpaqueCaptureAddress)
+#endif //VK_VERSION_1_2
+
+#if defined(VK_KHR_swapchain)
+VK_DEVICE_FUNCTION(vkCreateSwapchainKHR)
+VK_DEVICE_FUNCTION(vkDestroySwapchainKHR)
+VK_DEVICE_FUNCTION(vkGetSwapchainImagesKHR)
+VK_DEVICE_FUNCTION(vkAcquireNextImageKHR)
+VK_DEVICE_FUNCTION(vkQueuePresentKHR)
+VK_DEVICE_FUNCTION(vkGetDeviceGroupPresentCapabilitiesKHR)
+VK_DEVICE_FUNCTION(vkGetDeviceGroupSurfacePresentModesKHR)
+VK_DEVICE_FUNCTION(vkAcquireNextImage2KHR)
+#endif //VK_KHR_swapchain
+
+#if defined(VK_KHR_display_swapchain)
+VK_DEVICE_FUNCTION(vkCreateSharedSwapchainsKHR)
+#endif //VK_KHR_display_swapchain
+
+#if defined(VK_KHR_device_group)
+VK_DEVICE_FUNCTION(vkGetDeviceGroupPeerMemoryFeaturesKHR)
+VK_DEVICE_FUNCTION(vkCmdSetDeviceMaskKHR)
+VK_DEVICE_FUNCTION(vkCmdDispatchBaseKHR)
+#endif //VK_KHR_device_group
+
+#if defined(VK_KHR_maintenance1)
+VK_DEVICE_FUNCTION(vkTrimCommandPoolKHR)
+#endif //VK_KHR_maintenance1
+
+#if defined(VK_KHR_external_memory_fd)
+VK_DEVICE_FUNCTION(vkGetMemoryFdKHR)
+VK_DEVICE_FUNCTION(vkGetMemoryFdPropertiesKHR)
+#endif //VK_KHR_external_memory_fd
+
+#if defined(VK_KHR_external_semaphore_fd)
+VK_DEVICE_FUNCTION(vkImportSemaphoreFdKHR)
+VK_DEVICE_FUNCTION(vkGetSemaphoreFdKHR)
+#endif //VK_KHR_external_semaphore_fd
+
+#if defined(VK_KHR_push_descriptor)
+VK_DEVICE_FUNCTION(vkCmdPushDescriptorSetKHR)
+VK_DEVICE_FUNCTION(vkCmdPushDescriptorSetWithTemplateKHR)
+#endif //VK_KHR_push_descriptor
+
+#if defined(VK_KHR_descriptor_update_template)
+VK_DEVICE_FUNCTION(vkCreateDescriptorUpdateTemplateKHR)
+VK_DEVICE_FUNCTION(vkDestroyDescriptorUpdateTemplateKHR)
+VK_DEVICE_FUNCTION(vkUpdateDescriptorSetWithTemplateKHR)
+#endif //VK_KHR_descriptor_update_template
+
+#if defined(VK_KHR_create_renderpass2)
+VK_DEVICE_FUNCTION(vkCreateRenderPass2KHR)
+VK_DEVICE_FUNCTION(vkCmdBeginRenderPass2KHR)
+VK_DEVICE_FUNCTION(vkCmdNextSubpass2KHR)
+VK_DEVICE_FUNCTION(vkCmdEndRenderPass2KHR)
+#endif //VK_KHR_create_renderpass2
+
+#if defined(VK_KHR_shared_presentable_image)
+VK_DEVICE_FUNCTION(vkGetSwapchainStatusKHR)
+#endif //VK_KHR_shared_presentable_image
+
+#if defined(VK_KHR_external_fence_fd)
+VK_DEVICE_FUNCTION(vkImportFenceFdKHR)
+VK_DEVICE_FUNCTION(vkGetFenceFdKHR)
+#endif //VK_KHR_external_fence_fd
+
+#if defined(VK_KHR_performance_query)
+VK_DEVICE_FUNCTION(vkAcquireProfilingLockKHR)
+VK_DEVICE_FUNCTION(vkReleaseProfilingLockKHR)
+#endif //VK_KHR_performance_query
+
+#if defined(VK_KHR_get_memory_requirements2)
+VK_DEVICE_FUNCTION(vkGetImageMemoryRequirements2KHR)
+VK_DEVICE_FUNCTION(vkGetBufferMemoryRequirements2KHR)
+VK_DEVICE_FUNCTION(vkGetImageSparseMemoryRequirements2KHR)
+#endif //VK_KHR_get_memory_requirements2
+
+#if defined(VK_KHR_sampler_ycbcr_conversion)
+VK_DEVICE_FUNCTION(vkCreateSamplerYcbcrConversionKHR)
+VK_DEVICE_FUNCTION(vkDestroySamplerYcbcrConversionKHR)
+#endif //VK_KHR_sampler_ycbcr_conversion
+
+#if defined(VK_KHR_bind_memory2)
+VK_DEVICE_FUNCTION(vkBindBufferMemory2KHR)
+VK_DEVICE_FUNCTION(vkBindImageMemory2KHR)
+#endif //VK_KHR_bind_memory2
+
+#if defined(VK_KHR_maintenance3)
+VK_DEVICE_FUNCTION(vkGetDescriptorSetLayoutSupportKHR)
+#endif //VK_KHR_maintenance3
+
+#if defined(VK_KHR_draw_indirect_count)
+VK_DEVICE_FUNCTION(vkCmdDrawIndirectCountKHR)
+VK_DEVICE_FUNCTION(vkCmdDrawIndexedIndirectCountKHR)
+#endif //VK_KHR_draw_indirect_count
+
+#if defined(VK_KHR_timeline_semaphore)
+VK_DEVICE_FUNCTION(vkGetSemaphoreCounterValueKHR)
+VK_DEVICE_FUNCTION(vkWaitSemaphoresKHR)
+VK_DEVICE_FUNCTION(vkSignalSemaphoreKHR)
+#endif //VK_KHR_timeline_semaphore
+
+#if defined(VK_KHR_fragment_shading_rate)
+VK_DEVICE_FUNCTION(vkCmdSetFragmentShadingRateKHR)
+#endif //VK_KHR_fragment_shading_rate
+
+#if defined(VK_KHR_buffer_device_address)
+VK_DEVICE_FUNCTION(vkGetBufferDeviceAddressKHR)
+VK_DEVICE_FUNCTION(vkGetBufferOpaqueCaptureAddressKHR)
+VK_DEVICE_FUNCTION(vkGetDeviceMemoryOpaqueCaptureAddressKHR)
+#endif //VK_KHR_buffer_device_address
+
+#if defined(VK_KHR_deferred_host_operations)
+VK_DEVICE_FUNCTION(vkCreateDeferredOperationKHR)
+VK_DEVICE_FUNCTION(vkDestroyDeferredOperationKHR)
+VK_DEVICE_FUNCTION(vkGetDeferredOperationMaxConcurrencyKHR)
+VK_DEVICE_FUNCTION(vkGetDeferredOperationResultKHR)
+VK_DEVICE_FUNCTION(vkDeferredOperationJoinKHR)
+#endif //VK_KHR_deferred_host_operations
+
+#if defined(VK_KHR_pipeline_executable_properties)
+VK_DEVICE_FUNCTION(vkGetPipelineExecutablePropertiesKHR)
+VK_DEVICE_FUNCTION(vkGetPipelineExecutableStatisticsKHR)
+VK_DEVICE_FUNCTION(vkGetPipelineExecutableInternalRepresentationsKHR)
+#endif //VK_KHR_pipeline_executable_properties
+
+#if defined(VK_KHR_synchronization2)
+VK_DEVICE_FUNCTION(vkCmdSetEvent2KHR)
+VK_DEVICE_FUNCTION(vkCmdResetEvent2KHR)
+VK_DEVICE_FUNCTION(vkCmdWaitEvents2KHR)
+VK_DEVICE_FUNCTION(vkCmdPipelineBarrier2KHR)
+VK_DEVICE_FUNCTION(vkCmdWriteTimestamp2KHR)
+VK_DEVICE_FUNCTION(vkQueueSubmit2KHR)
+VK_DEVICE_FUNCTION(vkCmdWriteBufferMarker2AMD)
+VK_DEVICE_FUNCTION(vkGetQueueCheckpointData2NV)
+#endif //VK_KHR_synchronization2
+
+#if defined(VK_KHR_copy_commands2)
+VK_DEVICE_FUNCTION(vkCmdCopyBuffer2KHR)
+VK_DEVICE_FUNCTION(vkCmdCopyImage2KHR)
+VK_DEVICE_FUNCTION(vkCmdCopyBufferToImage2KHR)
+VK_DEVICE_FUNCTION(vkCmdCopyImageToBuffer2KHR)
+VK_DEVICE_FUNCTION(vkCmdBlitImage2KHR)
+VK_DEVICE_FUNCTION(vkCmdResolveImage2KHR)
+#endif //VK_KHR_copy_commands2
+
+#if defined(VK_EXT_debug_marker)
+VK_DEVICE_FUNCTION(vkDebugMarkerSetObjectTagEXT)
+VK_DEVICE_FUNCTION(vkDebugMarkerSetObjectNameEXT)
+VK_DEVICE_FUNCTION(vkCmdDebugMarkerBeginEXT)
+VK_DEVICE_FUNCTION(vkCmdDebugMarkerEndEXT)
+VK_DEVICE_FUNCTION(vkCmdDebugMarkerInsertEXT)
+#endif //VK_EXT_debug_marker
+
+#if defined(VK_EXT_transform_feedback)
+VK_DEVICE_FUNCTION(vkCmdBindTransformFeedbackBuffersEXT)
+VK_DEVICE_FUNCTION(vkCmdBeginTransformFeedbackEXT)
+VK_DEVICE_FUNCTION(vkCmdEndTransformFeedbackEXT)
+VK_DEVICE_FUNCTION(vkCmdBeginQueryIndexedEXT)
+VK_DEVICE_FUNCTION(vkCmdEndQueryIndexedEXT)
+VK_DEVICE_FUNCTION(vkCmdDrawIndirectByteCountEXT)
+#endif //VK_EXT_transform_feedback
+
+#if defined(VK_NVX_binary_import)
+VK_DEVICE_FUNCTION(vkCreateCuModuleNVX)
+VK_DEVICE_FUNCTION(vkCreateCuFunctionNVX)
+VK_DEVICE_FUNCTION(vkDestroyCuModuleNVX)
+VK_DEVICE_FUNCTION(vkDestroyCuFunctionNVX)
+VK_DEVICE_FUNCTION(vkCmdCuLaunchKernelNVX)
+#endif //VK_NVX_binary_import
+
+#if defined(VK_NVX_image_view_handle)
+VK_DEVICE_FUNCTION(vkGetImageViewHandleNVX)
+VK_DEVICE_FUNCTION(vkGetImageViewAddressNVX)
+#endif //VK_NVX_image_view_handle
+
+#if defined(VK_AMD_draw_indirect_count)
+VK_DEVICE_FUNCTION(vkCmdDrawIndirectCountAMD)
+VK_DEVICE_FUNCTION(vkCmdDrawIndexedIndirectCountAMD)
+#endif //VK_AMD_draw_indirect_count
+
+#if defined(VK_AMD_shader_info)
+VK_DEVICE_FUNCTION(vkGetShaderInfoAMD)
+#endif //VK_AMD_shader_info
+
+#if defined(VK_EXT_conditional_rendering)
+VK_DEVICE_FUNCTION(vkCmdBeginConditionalRenderingEXT)
+VK_DEVICE_FUNCTION(vkCmdEndConditionalRenderingEXT)
+#endif //VK_EXT_conditional_rendering
+
+#if defined(VK_NV_clip_space_w_scaling)
+VK_DEVICE_FUNCTION(vkCmdSetViewportWScalingNV)
+#endif //VK_NV_clip_space_w_scaling
+
+#if defined(VK_EXT_display_control)
+VK_DEVICE_FUNCTION(vkDisplayPowerControlEXT)
+VK_DEVICE_FUNCTION(vkRegisterDeviceEventEXT)
+VK_DEVICE_FUNCTION(vkRegisterDisplayEventEXT)
+VK_DEVICE_FUNCTION(vkGetSwapchainCounterEXT)
+#endif //VK_EXT_display_control
+
+#if defined(VK_GOOGLE_display_timing)
+VK_DEVICE_FUNCTION(vkGetRefreshCycleDurationGOOGLE)
+VK_DEVICE_FUNCTION(vkGetPastPresentationTimingGOOGLE)
+#endif //VK_GOOGLE_display_timing
+
+#if defined(VK_EXT_discard_rectangles)
+VK_DEVICE_FUNCTION(vkCmdSetDiscardRectangleEXT)
+#endif //VK_EXT_discard_rectangles
+
+#if defined(VK_EXT_hdr_metadata)
+VK_DEVICE_FUNCTION(vkSetHdrMetadataEXT)
+#endif //VK_EXT_hdr_metadata
+
+#if defined(VK_EXT_debug_utils)
+VK_DEVICE_FUNCTION(vkSetDebugUtilsObjectNameEXT)
+VK_DEVICE_FUNCTION(vkSetDebugUtilsObjectTagEXT)
+VK_DEVICE_FUNCTION(vkQueueBeginDebugUtilsLabelEXT)
+VK_DEVICE_FUNCTION(vkQueueEndDebugUtilsLabelEXT)
+VK_DEVICE_FUNCTION(vkQueueInsertDebugUtilsLabelEXT)
+VK_DEVICE_FUNCTION(vkCmdBeginDebugUtilsLabelEXT)
+VK_DEVICE_FUNCTION(vkCmdEndDebugUtilsLabelEXT)
+VK_DEVICE_FUNCTION(vkCmdInsertDebugUtilsLabelEXT)
+#endif //VK_EXT_debug_utils
+
+#if defined(VK_EXT_sample_locations)
+VK_DEVICE_FUNCTION(vkCmdSetSampleLocationsEXT)
+#endif //VK_EXT_sample_locations
+
+#if defined(VK_EXT_image_drm_format_modifier)
+VK_DEVICE_FUNCTION(vkGetImageDrmFormatModifierPropertiesEXT)
+#endif //VK_EXT_image_drm_format_modifier
+
+#if defined(VK_EXT_validation_cache)
+VK_DEVICE_FUNCTION(vkCreateValidationCacheEXT)
+VK_DEVICE_FUNCTION(vkDestroyValidationCacheEXT)
+VK_DEVICE_FUNCTION(vkMergeValidationCachesEXT)
+VK_DEVICE_FUNCTION(vkGetValidationCacheDataEXT)
+#endif //VK_EXT_validation_cache
+
+#if defined(VK_NV_shading_rate_image)
+VK_DEVICE_FUNCTION(vkCmdBindShadingRateImageNV)
+VK_DEVICE_FUNCTION(vkCmdSetViewportShadingRatePaletteNV)
+VK_DEVICE_FUNCTION(vkCmdSetCoarseSampleOrderNV)
+#endif //VK_NV_shading_rate_image
+
+#if defined(VK_NV_ray_tracing)
+VK_DEVICE_FUNCTION(vkCreateAccelerationStructureNV)
+VK_DEVICE_FUNCTION(vkDestroyAccelerationStructureNV)
+VK_DEVICE_FUNCTION(vkGetAccelerationStructureMemoryRequirementsNV)
+VK_DEVICE_FUNCTION(vkBindAccelerationStructureMemoryNV)
+VK_DEVICE_FUNCTION(vkCmdBuildAccelerationStructureNV)
+VK_DEVICE_FUNCTION(vkCmdCopyAccelerationStructureNV)
+VK_DEVICE_FUNCTION(vkCmdTraceRaysNV)
+VK_DEVICE_FUNCTION(vkCreateRayTracingPipelinesNV)
+VK_DEVICE_FUNCTION(vkGetRayTracingShaderGroupHandlesKHR)
+VK_DEVICE_FUNCTION(vkGetRayTracingShaderGroupHandlesNV)
+VK_DEVICE_FUNCTION(vkGetAccelerationStructureHandleNV)
+VK_DEVICE_FUNCTION(vkCmdWriteAccelerationStructuresPropertiesNV)
+VK_DEVICE_FUNCTION(vkCompileDeferredNV)
+#endif //VK_NV_ray_tracing
+
+#if defined(VK_EXT_external_memory_host)
+VK_DEVICE_FUNCTION(vkGetMemoryHostPointerPropertiesEXT)
+#endif //VK_EXT_external_memory_host
+
+#if defined(VK_AMD_buffer_marker)
+VK_DEVICE_FUNCTION(vkCmdWriteBufferMarkerAMD)
+#endif //VK_AMD_buffer_marker
+
+#if defined(VK_EXT_calibrated_timestamps)
+VK_DEVICE_FUNCTION(vkGetCalibratedTimestampsEXT)
+#endif //VK_EXT_calibrated_timestamps
+
+#if defined(VK_NV_mesh_shader)
+VK_DEVICE_FUNCTION(vkCmdDrawMeshTasksNV)
+VK_DEVICE_FUNCTION(vkCmdDrawMeshTasksIndirectNV)
+VK_DEVICE_FUNCTION(vkCmdDrawMeshTasksIndirectCountNV)
+#endif //VK_NV_mesh_shader
+
+#if defined(VK_NV_scissor_exclusive)
+VK_DEVICE_FUNCTION(vkCmdSetExclusiveScissorNV)
+#endif //VK_NV_scissor_exclusive
+
+#if defined(VK_NV_device_diagnostic_checkpoints)
+VK_DEVICE_FUNCTION(vkCmdSetCheckpointNV)
+VK_DEVICE_FUNCTION(vkGetQueueCheckpointDataNV)
+#endif //VK_NV_device_diagnostic_checkpoints
+
+#if defined(VK_INTEL_performance_query)
+VK_DEVICE_FUNCTION(vkInitializePerformanceApiINTEL)
+VK_DEVICE_FUNCTION(vkUninitializePerformanceApiINTEL)
+VK_DEVICE_FUNCTION(vkCmdSetPerformanceMarkerINTEL)
+VK_DEVICE_FUNCTION(vkCmdSetPerformanceStreamMarkerINTEL)
+VK_DEVICE_FUNCTION(vkCmdSetPerformanceOverrideINTEL)
+VK_DEVICE_FUNCTION(vkAcquirePerformanceConfigurationINTEL)
+VK_DEVICE_FUNCTION(vkReleasePerformanceConfigurationINTEL)
+VK_DEVICE_FUNCTION(vkQueueSetPerformanceConfigurationINTEL)
+VK_DEVICE_FUNCTION(vkGetPerformanceParameterINTEL)
+#endif //VK_INTEL_performance_query
+
+#if defined(VK_AMD_display_native_hdr)
+VK_DEVICE_FUNCTION(vkSetLocalDimmingAMD)
+#endif //VK_AMD_display_native_hdr
+
+#if defined(VK_EXT_buffer_device_address)
+VK_DEVICE_FUNCTION(vkGetBufferDeviceAddressEXT)
+#endif //VK_EXT_buffer_device_address
+
+#if defined(VK_EXT_line_rasterization)
+VK_DEVICE_FUNCTION(vkCmdSetLineStippleEXT)
+#endif //VK_EXT_line_rasterization
+
+#if defined(VK_EXT_host_query_reset)
+VK_DEVICE_FUNCTION(vkResetQueryPoolEXT)
+#endif //VK_EXT_host_query_reset
+
+#if defined(VK_EXT_extended_dynamic_state)
+VK_DEVICE_FUNCTION(vkCmdSetCullModeEXT)
+VK_DEVICE_FUNCTION(vkCmdSetFrontFaceEXT)
+VK_DEVICE_FUNCTION(vkCmdSetPrimitiveTopologyEXT)
+VK_DEVICE_FUNCTION(vkCmdSetViewportWithCountEXT)
+VK_DEVICE_FUNCTION(vkCmdSetScissorWithCountEXT)
+VK_DEVICE_FUNCTION(vkCmdBindVertexBuffers2EXT)
+VK_DEVICE_FUNCTION(vkCmdSetDepthTestEnableEXT)
+VK_DEVICE_FUNCTION(vkCmdSetDepthWriteEnableEXT)
+VK_DEVICE_FUNCTION(vkCmdSetDepthCompareOpEXT)
+VK_DEVICE_FUNCTION(vkCmdSetDepthBoundsTestEnableEXT)
+VK_DEVICE_FUNCTION(vkCmdSetStencilTestEnableEXT)
+VK_DEVICE_FUNCTION(vkCmdSetStencilOpEXT)
+#endif //VK_EXT_extended_dynamic_state
+
+#if defined(VK_NV_device_generated_commands)
+VK_DEVICE_FUNCTION(vkGetGeneratedCommandsMemoryRequirementsNV)
+VK_DEVICE_FUNCTION(vkCmdPreprocessGeneratedCommandsNV)
+VK_DEVICE_FUNCTION(vkCmdExecuteGeneratedCommandsNV)
+VK_DEVICE_FUNCTION(vkCmdBindPipelineShaderGroupNV)
+VK_DEVICE_FUNCTION(vkCreateIndirectCommandsLayoutNV)
+VK_DEVICE_FUNCTION(vkDestroyIndirectCommandsLayoutNV)
+#endif //VK_NV_device_generated_commands
+
+#if defined(VK_EXT_private_data)
+VK_DEVICE_FUNCTION(vkCreatePrivateDataSlotEXT)
+VK_DEVICE_FUNCTION(vkDestroyPrivateDataSlotEXT)
+VK_DEVICE_FUNCTION(vkSetPrivateDataEXT)
+VK_DEVICE_FUNCTION(vkGetPrivateDataEXT)
+#endif //VK_EXT_private_data
+
+#if defined(VK_NV_fragment_shading_rate_enums)
+VK_DEVICE_FUNCTION(vkCmdSetFragmentShadingRateEnumNV)
+#endif //VK_NV_fragment_shading_rate_enums
+
+#if defined(VK_EXT_vertex_input_dynamic_state)
+VK_DEVICE_FUNCTION(vkCmdSetVertexInputEXT)
+#endif //VK_EXT_vertex_input_dynamic_state
+
+#if defined(VK_HUAWEI_subpass_shading)
+VK_DEVICE_FUNCTION(vkCmdSubpassShadingHUAWEI)
+#endif //VK_HUAWEI_subpass_shading
+
+#if defined(VK_EXT_extended_dynamic_state2)
+VK_DEVICE_FUNCTION(vkCmdSetPatchControlPointsEXT)
+VK_DEVICE_FUNCTION(vkCmdSetRasterizerDiscardEnableEXT)
+VK_DEVICE_FUNCTION(vkCmdSetDepthBiasEnableEXT)
+VK_DEVICE_FUNCTION(vkCmdSetLogicOpEXT)
+VK_DEVICE_FUNCTION(vkCmdSetPrimitiveRestartEnableEXT)
+#endif //VK_EXT_extended_dynamic_state2
+
+#if defined(VK_EXT_color_write_enable)
+VK_DEVICE_FUNCTION(vkCmdSetColorWriteEnableEXT)
+#endif //VK_EXT_color_write_enable
+
+#if defined(VK_EXT_multi_draw)
+VK_DEVICE_FUNCTION(vkCmdDrawMultiEXT)
+VK_DEVICE_FUNCTION(vkCmdDrawMultiIndexedEXT)
+#endif //VK_EXT_multi_draw
+
+#if defined(VK_KHR_acceleration_structure)
+VK_DEVICE_FUNCTION(vkCreateAccelerationStructureKHR)
+VK_DEVICE_FUNCTION(vkDestroyAccelerationStructureKHR)
+VK_DEVICE_FUNCTION(vkCmdBuildAccelerationStructuresKHR)
+VK_DEVICE_FUNCTION(vkCmdBuildAccelerationStructuresIndirectKHR)
+VK_DEVICE_FUNCTION(vkBuildAccelerationStructuresKHR)
+VK_DEVICE_FUNCTION(vkCopyAccelerationStructureKHR)
+VK_DEVICE_FUNCTION(vkCopyAccelerationStructureToMemoryKHR)
+VK_DEVICE_FUNCTION(vkCopyMemoryToAccelerationStructureKHR)
+VK_DEVICE_FUNCTION(vkWriteAccelerationStructuresPropertiesKHR)
+VK_DEVICE_FUNCTION(vkCmdCopyAccelerationStructureKHR)
+VK_DEVICE_FUNCTION(vkCmdCopyAccelerationStructureToMemoryKHR)
+VK_DEVICE_FUNCTION(vkCmdCopyMemoryToAccelerationStructureKHR)
+VK_DEVICE_FUNCTION(vkGetAccelerationStructureDeviceAddressKHR)
+VK_DEVICE_FUNCTION(vkCmdWriteAccelerationStructuresPropertiesKHR)
+VK_DEVICE_FUNCTION(vkGetDeviceAccelerationStructureCompatibilityKHR)
+VK_DEVICE_FUNCTION(vkGetAccelerationStructureBuildSizesKHR)
+#endif //VK_KHR_acceleration_structure
+
+#if defined(VK_KHR_ray_tracing_pipeline)
+VK_DEVICE_FUNCTION(vkCmdTraceRaysKHR)
+VK_DEVICE_FUNCTION(vkCreateRayTracingPipelinesKHR)
+VK_DEVICE_FUNCTION(vkGetRayTracingCaptureReplayShaderGroupHandlesKHR)
+VK_DEVICE_FUNCTION(vkCmdTraceRaysIndirectKHR)
+VK_DEVICE_FUNCTION(vkGetRayTracingShaderGroupStackSizeKHR)
+VK_DEVICE_FUNCTION(vkCmdSetRayTracingPipelineStackSizeKHR)
+#endif //VK_KHR_ray_tracing_pipeline
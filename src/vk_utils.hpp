@@ -0,0 +1,34 @@
+#ifndef _VK_UTILS_H_
+#define _VK_UTILS_H_
+
+#include <vulkan/vulkan.h>
+
+#include <stdexcept>
+
+//在 typeBits 中找满足 properties 的内存类型  找不到返回 -1
+static int findMemoryTypeIndex(const VkPhysicalDeviceMemoryProperties &memoryProperties ,
+        uint32_t typeBits , VkMemoryPropertyFlags properties){
+    for(uint32_t i = 0 ; i < memoryProperties.memoryTypeCount ; i++){
+        if((typeBits & (1u << i)) &&
+            (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties){
+            return static_cast<int>(i);
+        }
+    }//end for i
+    return -1;
+}
+
+//同上 找不到时抛出异常
+static uint32_t findMemoryType(const VkPhysicalDeviceMemoryProperties &memoryProperties ,
+        uint32_t typeBits , VkMemoryPropertyFlags properties){
+    const int index = findMemoryTypeIndex(memoryProperties , typeBits , properties);
+    if(index < 0){
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+    return static_cast<uint32_t>(index);
+}
+
+static VkDeviceSize alignUp(VkDeviceSize value , VkDeviceSize alignment){
+    return alignment > 0 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+#endif
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+# 从 vulkan_core.h 生成设备级函数列表 (X-macro)
+# 设备级函数: 第一个参数为 VkDevice / VkQueue / VkCommandBuffer
+# usage: python3 tools/gen_device_dispatch.py include/vulkan/vulkan_core.h src/vk_device_dispatch.inl
+
+import re
+import sys
+
+FEATURE_RE = re.compile(r'^#define (VK_VERSION_\d_\d|VK_[A-Z]+_[a-z0-9_]+) 1\s*$')
+PFN_RE = re.compile(r'^typedef\s+\w+\s+\(VKAPI_PTR \*PFN_(vk\w+)\)\((\w+)')
+DEVICE_HANDLES = ('VkDevice', 'VkQueue', 'VkCommandBuffer')
+SKIP = ('vkGetDeviceProcAddr',)
+
+
+def parse(header_path):
+    sections = []
+    current = None
+    with open(header_path) as header:
+        for line in header:
+            feature = FEATURE_RE.match(line)
+            if feature:
+                current = (feature.group(1), [])
+                sections.append(current)
+                continue
+            pfn = PFN_RE.match(line)
+            if pfn and current is not None:
+                name, first_param = pfn.groups()
+                if first_param in DEVICE_HANDLES and name not in SKIP:
+                    current[1].append(name)
+    return [s for s in sections if s[1]]
+
+
+def main():
+    if len(sys.argv) != 3:
+        print('usage: gen_device_dispatch.py <vulkan_core.h> <output.inl>')
+        return 1
+
+    sections = parse(sys.argv[1])
+    lines = [
+        '// generated by tools/gen_device_dispatch.py from vulkan_core.h , do not edit',
+        '// VK_DEVICE_FUNCTION(name) 需在包含前定义',
+        '',
+    ]
+    count = 0
+    for feature, names in sections:
+        lines.append('#if defined(%s)' % feature)
+        for name in names:
+            lines.append('VK_DEVICE_FUNCTION(%s)' % name)
+            count += 1
+        lines.append('#endif //%s' % feature)
+        lines.append('')
+
+    with open(sys.argv[2], 'w', newline='\n') as out:
+        out.write('\n'.join(lines))
+    print('generated %d device functions in %d sections' % (count, len(sections)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())